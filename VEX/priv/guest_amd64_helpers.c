@@ -1013,6 +1013,15 @@ static inline Bool isU64 ( IRExpr* e, ULong n )
           && e->Iex.Const.con->Ico.U64 == n;
 }
 
+/* If E is a 64-bit constant, put its value in *N and return True. */
+static inline Bool getU64 ( IRExpr* e, /*OUT*/ULong* n )
+{
+   if (e->tag != Iex_Const || e->Iex.Const.con->tag != Ico_U64)
+      return False;
+   *n = e->Iex.Const.con->Ico.U64;
+   return True;
+}
+
 /* Returns N if W64 is a value of the form 1 << N for N in 1 to 31,
    and zero in any other case. */
 static Int isU64_1_shl_N_literal ( ULong w64 )
@@ -1057,6 +1066,375 @@ static Int isU64_1_shl_N_minus_1 ( IRExpr* e )
   return isU64_1_shl_N_literal(w64 + 1);
 }
 
+/* Table-driven fallback for specialising amd64g_calculate_condition
+   and amd64g_calculate_rflags_c.  The hand-written cases in
+   guest_amd64_spechelper below give the best code for the common
+   (CC_OP, condition) pairs.  Everything else comes here: each flag
+   needed by the condition is rebuilt from the thunk, following the
+   ACTIONS_* macros above, and the flags are then combined as
+   amd64g_calculate_condition would.  All flag values built here are
+   :: Ity_I64 and are either 0 or 1. */
+
+typedef
+   enum {
+      SF_COPY=0, SF_ADD, SF_SUB, SF_ADC, SF_SBB, SF_LOGIC, SF_INC, SF_DEC,
+      SF_SHL, SF_SHR, SF_ROL, SF_ROR, SF_UMUL, SF_SMUL, SF_ANDN,
+      SF_BLSI, SF_BLSMSK, SF_BLSR, SF_ADCX, SF_ADOX
+   }
+   SpecFamily;
+
+/* For each CC_OP, in the order of the enum in guest_amd64_defs.h:
+   which family of flag rules it follows, and its data size. */
+static const struct { UChar family; UChar sz; }
+   spec_cc_op_info[AMD64G_CC_OP_NUMBER] = {
+      { SF_COPY,  64 },
+      { SF_ADD,    8 }, { SF_ADD,   16 }, { SF_ADD,   32 }, { SF_ADD,   64 },
+      { SF_SUB,    8 }, { SF_SUB,   16 }, { SF_SUB,   32 }, { SF_SUB,   64 },
+      { SF_ADC,    8 }, { SF_ADC,   16 }, { SF_ADC,   32 }, { SF_ADC,   64 },
+      { SF_SBB,    8 }, { SF_SBB,   16 }, { SF_SBB,   32 }, { SF_SBB,   64 },
+      { SF_LOGIC,  8 }, { SF_LOGIC, 16 }, { SF_LOGIC, 32 }, { SF_LOGIC, 64 },
+      { SF_INC,    8 }, { SF_INC,   16 }, { SF_INC,   32 }, { SF_INC,   64 },
+      { SF_DEC,    8 }, { SF_DEC,   16 }, { SF_DEC,   32 }, { SF_DEC,   64 },
+      { SF_SHL,    8 }, { SF_SHL,   16 }, { SF_SHL,   32 }, { SF_SHL,   64 },
+      { SF_SHR,    8 }, { SF_SHR,   16 }, { SF_SHR,   32 }, { SF_SHR,   64 },
+      { SF_ROL,    8 }, { SF_ROL,   16 }, { SF_ROL,   32 }, { SF_ROL,   64 },
+      { SF_ROR,    8 }, { SF_ROR,   16 }, { SF_ROR,   32 }, { SF_ROR,   64 },
+      { SF_UMUL,   8 }, { SF_UMUL,  16 }, { SF_UMUL,  32 }, { SF_UMUL,  64 },
+      { SF_SMUL,   8 }, { SF_SMUL,  16 }, { SF_SMUL,  32 }, { SF_SMUL,  64 },
+      { SF_ANDN,  32 }, { SF_ANDN,  64 },
+      { SF_BLSI,  32 }, { SF_BLSI,  64 },
+      { SF_BLSMSK,32 }, { SF_BLSMSK,64 },
+      { SF_BLSR,  32 }, { SF_BLSR,  64 },
+      { SF_ADCX,  32 }, { SF_ADCX,  64 },
+      { SF_ADOX,  32 }, { SF_ADOX,  64 }
+   };
+
+STATIC_ASSERT(AMD64G_CC_OP_ADOX64 == AMD64G_CC_OP_NUMBER - 1);
+
+#define unop(_op,_a1) IRExpr_Unop((_op),(_a1))
+#define binop(_op,_a1,_a2) IRExpr_Binop((_op),(_a1),(_a2))
+#define mkU64(_n) IRExpr_Const(IRConst_U64(_n))
+#define mkU8(_n)  IRExpr_Const(IRConst_U8(_n))
+
+/* 1 if the low SZ bits of E are zero. */
+static IRExpr* spec_is_zero ( IRExpr* e, Int sz )
+{
+   return spec_b1(binop(Iop_CmpEQ64, spec_top(e, sz), mkU64(0)));
+}
+
+/* Even parity of the low 8 bits of E: fold the byte to a nibble, then
+   look the nibble up in a 16-entry bit table (0x9669 has bit N set
+   when N has an even number of set bits). */
+static IRExpr* spec_parity ( IRExpr* e )
+{
+   IRExpr* nib
+      = binop(Iop_And64,
+              binop(Iop_Xor64, e,
+                    binop(Iop_Shr64, deepCopyIRExpr(e), mkU8(4))),
+              mkU64(0xF));
+   return spec_bit(binop(Iop_Shr64, mkU64(0x9669), unop(Iop_64to8, nib)),
+                   0);
+}
+
+/* The unsigned "carry out" of ARGL + ARGR' + OLDC, where ARGR' is the
+   thunk's DEP2 (ARGR ^ OLDC) and RES the truncated sum.  Mirrors
+   ACTIONS_ADC and ACTIONS_ADX. */
+static IRExpr* spec_carry_with ( IRExpr* oldc, IRExpr* argL, IRExpr* res,
+                                 Int sz )
+{
+   return IRExpr_ITE(
+             binop(Iop_CmpNE64, oldc, mkU64(0)),
+             spec_b1(binop(Iop_CmpLE64U, spec_top(res, sz),
+                                         spec_top(argL, sz))),
+             spec_b1(binop(Iop_CmpLT64U, spec_top(deepCopyIRExpr(res), sz),
+                                         spec_top(deepCopyIRExpr(argL), sz))));
+}
+
+/* The arithmetic result of the thunk, for the families that have
+   one.  A fresh tree each time, so the callers are free to use it
+   more than once. */
+static IRExpr* spec_result ( SpecFamily fam, Int sz,
+                             IRExpr* dep1, IRExpr* dep2, IRExpr* ndep )
+{
+   IRExpr *oldc, *argR;
+   switch (fam) {
+      case SF_ADD:
+         return binop(Iop_Add64, dep1, dep2);
+      case SF_SUB:
+         return binop(Iop_Sub64, dep1, dep2);
+      case SF_ADC:
+         oldc = binop(Iop_And64, ndep, mkU64(AMD64G_CC_MASK_C));
+         argR = binop(Iop_Xor64, dep2, oldc);
+         return binop(Iop_Add64, binop(Iop_Add64, dep1, argR),
+                                 deepCopyIRExpr(oldc));
+      case SF_SBB:
+         oldc = binop(Iop_And64, ndep, mkU64(AMD64G_CC_MASK_C));
+         argR = binop(Iop_Xor64, dep2, oldc);
+         return binop(Iop_Sub64, binop(Iop_Sub64, dep1, argR),
+                                 deepCopyIRExpr(oldc));
+      case SF_UMUL: case SF_SMUL:
+         /* The low half of the product is the same either way. */
+         return binop(Iop_Mul64, dep1, dep2);
+      default:
+         /* DEP1 holds the result. */
+         return dep1;
+   }
+}
+
+/* Build flag FLAG (one of AMD64G_CC_SHIFT_{C,P,Z,S,O}) from the thunk,
+   or return NULL if that isn't possible. */
+static IRExpr* spec_amd64_flag ( Int flag, ULong cc_op,
+                                 IRExpr* dep1, IRExpr* dep2, IRExpr* ndep )
+{
+   SpecFamily fam;
+   Int        sz;
+   IRExpr     *argR, *oldc, *res;
+
+   if (cc_op >= AMD64G_CC_OP_NUMBER)
+      return NULL;
+   fam = spec_cc_op_info[cc_op].family;
+   sz  = spec_cc_op_info[cc_op].sz;
+
+   switch (fam) {
+      case SF_COPY:
+         return spec_bit(dep1, flag);
+      case SF_ROL: case SF_ROR:
+         /* Only C and O are computed; the rest come from NDEP. */
+         if (flag != AMD64G_CC_SHIFT_C && flag != AMD64G_CC_SHIFT_O)
+            return spec_bit(ndep, flag);
+         break;
+      case SF_ADCX:
+         if (flag != AMD64G_CC_SHIFT_C)
+            return spec_bit(ndep, flag);
+         break;
+      case SF_ADOX:
+         if (flag != AMD64G_CC_SHIFT_O)
+            return spec_bit(ndep, flag);
+         break;
+      default:
+         break;
+   }
+
+   switch (flag) {
+
+      case AMD64G_CC_SHIFT_Z:
+         if (fam == SF_BLSMSK)
+            return mkU64(0);
+         return spec_is_zero(spec_result(fam, sz, dep1, dep2, ndep), sz);
+
+      case AMD64G_CC_SHIFT_S:
+         return spec_bit(spec_result(fam, sz, dep1, dep2, ndep), sz - 1);
+
+      case AMD64G_CC_SHIFT_P:
+         if (fam == SF_ANDN || fam == SF_BLSI || fam == SF_BLSMSK
+             || fam == SF_BLSR)
+            return mkU64(0);
+         return spec_parity(spec_result(fam, sz, dep1, dep2, ndep));
+
+      case AMD64G_CC_SHIFT_C:
+         switch (fam) {
+            case SF_ADD:
+               return spec_b1(binop(Iop_CmpLT64U,
+                                    spec_top(binop(Iop_Add64, dep1, dep2), sz),
+                                    spec_top(dep1, sz)));
+            case SF_SUB:
+               return spec_b1(binop(Iop_CmpLT64U, spec_top(dep1, sz),
+                                                  spec_top(dep2, sz)));
+            case SF_ADC:
+               return spec_carry_with(
+                         binop(Iop_And64, ndep, mkU64(AMD64G_CC_MASK_C)),
+                         dep1, spec_result(fam, sz, dep1, dep2, ndep), sz);
+            case SF_SBB:
+               oldc = binop(Iop_And64, ndep, mkU64(AMD64G_CC_MASK_C));
+               argR = binop(Iop_Xor64, dep2, oldc);
+               return IRExpr_ITE(
+                         binop(Iop_CmpNE64, deepCopyIRExpr(oldc), mkU64(0)),
+                         spec_b1(binop(Iop_CmpLE64U, spec_top(dep1, sz),
+                                                     spec_top(argR, sz))),
+                         spec_b1(binop(Iop_CmpLT64U,
+                                       spec_top(dep1, sz),
+                                       spec_top(deepCopyIRExpr(argR), sz))));
+            case SF_LOGIC: case SF_ANDN:
+               return mkU64(0);
+            case SF_INC: case SF_DEC:
+               return binop(Iop_And64, ndep, mkU64(AMD64G_CC_MASK_C));
+            case SF_SHL:
+               return spec_bit(dep2, sz - 1);
+            case SF_SHR:
+               return spec_bit(dep2, 0);
+            case SF_ROL:
+               return spec_bit(dep1, 0);
+            case SF_ROR:
+               return spec_bit(dep1, sz - 1);
+            case SF_UMUL:
+               if (sz == 64)
+                  return spec_b1(binop(Iop_CmpNE64,
+                                       unop(Iop_128HIto64,
+                                            binop(Iop_MullU64, dep1, dep2)),
+                                       mkU64(0)));
+               /* The double-length product fits in 64 bits. */
+               return spec_b1(binop(Iop_CmpNE64,
+                                    binop(Iop_Shr64,
+                                          binop(Iop_Mul64,
+                                                binop(Iop_Shr64,
+                                                      spec_top(dep1, sz),
+                                                      mkU8(64 - sz)),
+                                                binop(Iop_Shr64,
+                                                      spec_top(dep2, sz),
+                                                      mkU8(64 - sz))),
+                                          mkU8(sz)),
+                                    mkU64(0)));
+            case SF_SMUL:
+               if (sz == 64)
+                  return spec_b1(binop(Iop_CmpNE64,
+                                       unop(Iop_128HIto64,
+                                            binop(Iop_MullS64, dep1, dep2)),
+                                       binop(Iop_Sar64,
+                                             binop(Iop_Mul64, dep1, dep2),
+                                             mkU8(63))));
+               /* Overflow iff the double-length product isn't the
+                  sign extension of its low half. */
+               res = binop(Iop_Mul64,
+                           binop(Iop_Sar64, spec_top(dep1, sz), mkU8(64 - sz)),
+                           binop(Iop_Sar64, spec_top(dep2, sz), mkU8(64 - sz)));
+               return spec_b1(binop(Iop_CmpNE64,
+                                    res,
+                                    binop(Iop_Sar64,
+                                          spec_top(deepCopyIRExpr(res), sz),
+                                          mkU8(64 - sz))));
+            case SF_BLSI:
+               return spec_b1(binop(Iop_CmpNE64, spec_top(dep2, sz),
+                                                 mkU64(0)));
+            case SF_BLSMSK: case SF_BLSR:
+               return spec_b1(binop(Iop_CmpEQ64, spec_top(dep2, sz),
+                                                 mkU64(0)));
+            case SF_ADCX:
+               oldc = spec_bit(ndep, AMD64G_CC_SHIFT_C);
+               res  = binop(Iop_Add64,
+                            binop(Iop_Add64, dep1,
+                                  binop(Iop_Xor64, dep2, oldc)),
+                            deepCopyIRExpr(oldc));
+               return spec_carry_with(deepCopyIRExpr(oldc), dep1, res, sz);
+            default:
+               return NULL;
+         }
+
+      case AMD64G_CC_SHIFT_O:
+         switch (fam) {
+            case SF_ADD: case SF_ADC:
+               argR = fam == SF_ADD
+                         ? dep2
+                         : binop(Iop_Xor64, dep2,
+                                 binop(Iop_And64, ndep,
+                                       mkU64(AMD64G_CC_MASK_C)));
+               return spec_bit(
+                         binop(Iop_And64,
+                               unop(Iop_Not64, binop(Iop_Xor64, dep1, argR)),
+                               binop(Iop_Xor64, dep1,
+                                     spec_result(fam, sz, dep1, dep2, ndep))),
+                         sz - 1);
+            case SF_SUB: case SF_SBB:
+               argR = fam == SF_SUB
+                         ? dep2
+                         : binop(Iop_Xor64, dep2,
+                                 binop(Iop_And64, ndep,
+                                       mkU64(AMD64G_CC_MASK_C)));
+               return spec_bit(
+                         binop(Iop_And64,
+                               binop(Iop_Xor64, dep1, argR),
+                               binop(Iop_Xor64, dep1,
+                                     spec_result(fam, sz, dep1, dep2, ndep))),
+                         sz - 1);
+            case SF_LOGIC: case SF_ANDN: case SF_BLSI: case SF_BLSMSK:
+            case SF_BLSR:
+               return mkU64(0);
+            case SF_INC: case SF_DEC:
+               return spec_b1(binop(Iop_CmpEQ64, spec_top(dep1, sz),
+                                    mkU64(fam == SF_INC
+                                             ? 0x8000000000000000ULL
+                                             : (0x7FFFFFFFFFFFFFFFULL
+                                                >> (64 - sz))
+                                               << (64 - sz))));
+            case SF_SHL: case SF_SHR:
+               return spec_bit(binop(Iop_Xor64, dep2, dep1), sz - 1);
+            case SF_ROL:
+               return binop(Iop_Xor64, spec_bit(dep1, sz - 1),
+                                       spec_bit(dep1, 0));
+            case SF_ROR:
+               return binop(Iop_Xor64, spec_bit(dep1, sz - 1),
+                                       spec_bit(dep1, sz - 2));
+            case SF_UMUL: case SF_SMUL:
+               return spec_amd64_flag(AMD64G_CC_SHIFT_C,
+                                      cc_op, dep1, dep2, ndep);
+            case SF_ADOX:
+               oldc = spec_bit(ndep, AMD64G_CC_SHIFT_O);
+               res  = binop(Iop_Add64,
+                            binop(Iop_Add64, dep1,
+                                  binop(Iop_Xor64, dep2, oldc)),
+                            deepCopyIRExpr(oldc));
+               return spec_carry_with(deepCopyIRExpr(oldc), dep1, res, sz);
+            default:
+               return NULL;
+         }
+
+      default:
+         return NULL;
+   }
+}
+
+/* Build COND after CC_OP from the individual flags, or return NULL if
+   any of them can't be built. */
+static IRExpr* spec_amd64_condition ( ULong cond, ULong cc_op,
+                                      IRExpr* dep1, IRExpr* dep2,
+                                      IRExpr* ndep )
+{
+   IRExpr *res, *f1, *f2, *f3;
+   switch (cond & ~1ULL) {
+      case AMD64CondO:
+         res = spec_amd64_flag(AMD64G_CC_SHIFT_O, cc_op, dep1, dep2, ndep);
+         break;
+      case AMD64CondB:
+         res = spec_amd64_flag(AMD64G_CC_SHIFT_C, cc_op, dep1, dep2, ndep);
+         break;
+      case AMD64CondZ:
+         res = spec_amd64_flag(AMD64G_CC_SHIFT_Z, cc_op, dep1, dep2, ndep);
+         break;
+      case AMD64CondS:
+         res = spec_amd64_flag(AMD64G_CC_SHIFT_S, cc_op, dep1, dep2, ndep);
+         break;
+      case AMD64CondP:
+         res = spec_amd64_flag(AMD64G_CC_SHIFT_P, cc_op, dep1, dep2, ndep);
+         break;
+      case AMD64CondBE:
+         f1  = spec_amd64_flag(AMD64G_CC_SHIFT_C, cc_op, dep1, dep2, ndep);
+         f2  = spec_amd64_flag(AMD64G_CC_SHIFT_Z, cc_op, dep1, dep2, ndep);
+         res = f1 && f2 ? binop(Iop_Or64, f1, f2) : NULL;
+         break;
+      case AMD64CondL:
+         f1  = spec_amd64_flag(AMD64G_CC_SHIFT_S, cc_op, dep1, dep2, ndep);
+         f2  = spec_amd64_flag(AMD64G_CC_SHIFT_O, cc_op, dep1, dep2, ndep);
+         res = f1 && f2 ? binop(Iop_Xor64, f1, f2) : NULL;
+         break;
+      case AMD64CondLE:
+         f1  = spec_amd64_flag(AMD64G_CC_SHIFT_S, cc_op, dep1, dep2, ndep);
+         f2  = spec_amd64_flag(AMD64G_CC_SHIFT_O, cc_op, dep1, dep2, ndep);
+         f3  = spec_amd64_flag(AMD64G_CC_SHIFT_Z, cc_op, dep1, dep2, ndep);
+         res = f1 && f2 && f3
+                  ? binop(Iop_Or64, binop(Iop_Xor64, f1, f2), f3) : NULL;
+         break;
+      default:
+         return NULL;
+   }
+   if (res && (cond & 1))
+      res = spec_not(res);
+   return res;
+}
+
+#undef unop
+#undef binop
+#undef mkU64
+#undef mkU8
+
 IRExpr* guest_amd64_spechelper ( const HChar* function_name,
                                  IRExpr** args,
                                  IRStmt** precedingStmts,
@@ -1085,12 +1463,13 @@ IRExpr* guest_amd64_spechelper ( const HChar* function_name,
 
    if (vex_streq(function_name, "amd64g_calculate_condition")) {
       /* specialise calls to above "calculate condition" function */
-      IRExpr *cond, *cc_op, *cc_dep1, *cc_dep2;
+      IRExpr *cond, *cc_op, *cc_dep1, *cc_dep2, *cc_ndep;
       vassert(arity == 5);
       cond    = args[0];
       cc_op   = args[1];
       cc_dep1 = args[2];
       cc_dep2 = args[3];
+      cc_ndep = args[4];
 
       /*---------------- ADDQ ----------------*/
 
@@ -1904,6 +2283,16 @@ IRExpr* guest_amd64_spechelper ( const HChar* function_name,
             );
       }
 
+      /*---------------- everything else ----------------*/
+
+      ULong cond_n, cc_op_n;
+      if (getU64(cond, &cond_n) && getU64(cc_op, &cc_op_n)) {
+         IRExpr* res = spec_amd64_condition(cond_n, cc_op_n,
+                                            cc_dep1, cc_dep2, cc_ndep);
+         if (res)
+            return res;
+      }
+
       return NULL;
    }
 
@@ -1966,11 +2355,13 @@ IRExpr* guest_amd64_spechelper ( const HChar* function_name,
          return cc_ndep;
       }
 
-#     if 0
-      if (cc_op->tag == Iex_Const) {
-         vex_printf("CFLAG "); ppIRExpr(cc_op); vex_printf("\n");
+      ULong cc_op_n;
+      if (getU64(cc_op, &cc_op_n)) {
+         IRExpr* res = spec_amd64_flag(AMD64G_CC_SHIFT_C, cc_op_n,
+                                       cc_dep1, cc_dep2, cc_ndep);
+         if (res)
+            return res;
       }
-#     endif
 
       return NULL;
    }
@@ -4721,9 +4721,113 @@ void dis_SCAS ( Int sz, IRTemp t_inc, Prefix pfx )
 }
 
 
+/* Number of iterations of a REP-prefixed string insn that are done
+   by each run through its translation, before it loops back to
+   itself. */
+#define REP_UNROLL 8
+
+/* Number of bytes that REP MOVS and REP STOS move at once, using
+   16-byte loads and stores, when they have at least that much left to
+   do. */
+#define REP_CHUNK_BYTES 64
+
+/* Generate IR for the bulk part of a forwards REP MOVS or REP STOS:
+   if the direction flag is clear, RCX covers at least REP_CHUNK_BYTES
+   and (for MOVS) the destination does not start within
+   REP_CHUNK_BYTES after the source, move REP_CHUNK_BYTES in 16-byte
+   pieces and advance RCX/RSI/RDI to match.  Otherwise do nothing.
+   Either way, what's left is finished off an element at a time by the
+   caller.  The loads and stores are guarded rather than branched
+   around, so that tools see them as ordinary (16-byte) memory
+   accesses. */
+static
+void dis_REP_chunk ( Bool isMOVS, Int sz )
+{
+   const Int nVecs  = REP_CHUNK_BYTES / 16;
+   const Int nElems = REP_CHUNK_BYTES / sz;
+   IRTemp tc    = newTemp(Ity_I64);  /* RCX */
+   IRTemp td    = newTemp(Ity_I64);  /* RDI */
+   IRTemp ts    = newTemp(Ity_I64);  /* RSI */
+   IRTemp guard = newTemp(Ity_I1);
+   IRTemp vals[REP_CHUNK_BYTES / 16];
+   IRExpr* ok;
+   Int i;
+
+   vassert(sz == 1 || sz == 2 || sz == 4 || sz == 8);
+   assign( tc, getIReg64(R_RCX) );
+   assign( td, getIReg64(R_RDI) );
+   assign( ts, getIReg64(R_RSI) );
+
+   ok = binop(Iop_And64,
+              unop(Iop_1Uto64,
+                   binop(Iop_CmpEQ64, IRExpr_Get(OFFB_DFLAG, Ity_I64),
+                                      mkU64(1))),
+              unop(Iop_1Uto64,
+                   binop(Iop_CmpLE64U, mkU64(nElems), mkexpr(tc))));
+   if (isMOVS) {
+      /* Byte-at-a-time copying where the destination starts shortly
+         after the source replicates the leading bytes; that has to
+         be done the slow way. */
+      ok = binop(Iop_And64, ok,
+                 unop(Iop_1Uto64,
+                      binop(Iop_CmpLE64U,
+                            mkU64(REP_CHUNK_BYTES),
+                            binop(Iop_Sub64, mkexpr(td), mkexpr(ts)))));
+   }
+   assign( guard, binop(Iop_CmpNE64, ok, mkU64(0)) );
+
+   if (isMOVS) {
+      for (i = 0; i < nVecs; i++) {
+         vals[i] = newTemp(Ity_V128);
+         stmt( IRStmt_LoadG( Iend_LE, ILGop_IdentV128, vals[i],
+                             binop(Iop_Add64, mkexpr(ts), mkU64(16 * i)),
+                             mkV128(0x0000), mkexpr(guard) ) );
+      }
+   } else {
+      /* Replicate the low sz bytes of RAX across a vector. */
+      IRTemp t64 = newTemp(Ity_I64);
+      IRExpr* e  = widenUto64(getIRegRAX(sz));
+      Int sh;
+      for (sh = 8 * sz; sh < 64; sh *= 2) {
+         IRTemp t = newTemp(Ity_I64);
+         assign( t, e );
+         e = binop(Iop_Or64, mkexpr(t),
+                             binop(Iop_Shl64, mkexpr(t), mkU8(sh)));
+      }
+      assign( t64, e );
+      vals[0] = newTemp(Ity_V128);
+      assign( vals[0], binop(Iop_64HLtoV128, mkexpr(t64), mkexpr(t64)) );
+      for (i = 1; i < nVecs; i++)
+         vals[i] = vals[0];
+   }
+
+   for (i = 0; i < nVecs; i++) {
+      stmt( IRStmt_StoreG( Iend_LE,
+                           binop(Iop_Add64, mkexpr(td), mkU64(16 * i)),
+                           mkexpr(vals[i]), mkexpr(guard) ) );
+   }
+
+   putIReg64( R_RCX, binop(Iop_Sub64, mkexpr(tc),
+                           IRExpr_ITE(mkexpr(guard), mkU64(nElems),
+                                                     mkU64(0))) );
+   putIReg64( R_RDI, binop(Iop_Add64, mkexpr(td),
+                           IRExpr_ITE(mkexpr(guard), mkU64(REP_CHUNK_BYTES),
+                                                     mkU64(0))) );
+   if (isMOVS) {
+      putIReg64( R_RSI, binop(Iop_Add64, mkexpr(ts),
+                              IRExpr_ITE(mkexpr(guard),
+                                         mkU64(REP_CHUNK_BYTES),
+                                         mkU64(0))) );
+   }
+}
+
 /* Wrap the appropriate string op inside a REP/REPE/REPNE.  We assume
    the insn is the last one in the basic block, and so emit a jump to
-   the next insn, rather than just falling through. */
+   the next insn, rather than just falling through.  To cut down the
+   number of trips round the loop, REP_UNROLL iterations are done
+   each time, each one leaving through a side exit if RCX runs out or
+   the REPE/REPNE condition fails; forwards REP MOVS/STOS also get a
+   vectorised bulk part. */
 static 
 void dis_REP_op ( /*MOD*/DisResult* dres,
                   AMD64Condcode cond,
@@ -4734,31 +4838,46 @@ void dis_REP_op ( /*MOD*/DisResult* dres,
    IRTemp t_inc = newTemp(Ity_I64);
    IRTemp tc;
    IRExpr* cmp;
+   Int i;
 
    /* Really we ought to inspect the override prefixes, but we don't.
       The following assertion catches any resulting sillyness. */
    vassert(pfx == clearSegBits(pfx));
 
-   if (haveASO(pfx)) {
-      tc = newTemp(Ity_I32);  /*  ECX  */
-      assign( tc, getIReg32(R_RCX) );
-      cmp = binop(Iop_CmpEQ32, mkexpr(tc), mkU32(0));
-   } else {
-      tc = newTemp(Ity_I64);  /*  RCX  */
-      assign( tc, getIReg64(R_RCX) );
-      cmp = binop(Iop_CmpEQ64, mkexpr(tc), mkU64(0));
-   }
+   if (!haveASO(pfx) && (dis_OP == dis_MOVS || dis_OP == dis_STOS))
+      dis_REP_chunk(dis_OP == dis_MOVS, sz);
 
-   stmt( IRStmt_Exit( cmp, Ijk_Boring,
-                      IRConst_U64(rip_next), OFFB_RIP ) );
+   dis_string_op_increment(sz, t_inc);
 
-   if (haveASO(pfx))
-      putIReg32(R_RCX, binop(Iop_Sub32, mkexpr(tc), mkU32(1)) );
-  else
-      putIReg64(R_RCX, binop(Iop_Sub64, mkexpr(tc), mkU64(1)) );
+   for (i = 0; i < REP_UNROLL; i++) {
+      if (haveASO(pfx)) {
+         tc = newTemp(Ity_I32);  /*  ECX  */
+         assign( tc, getIReg32(R_RCX) );
+         cmp = binop(Iop_CmpEQ32, mkexpr(tc), mkU32(0));
+      } else {
+         tc = newTemp(Ity_I64);  /*  RCX  */
+         assign( tc, getIReg64(R_RCX) );
+         cmp = binop(Iop_CmpEQ64, mkexpr(tc), mkU64(0));
+      }
 
-   dis_string_op_increment(sz, t_inc);
-   dis_OP (sz, t_inc, pfx);
+      stmt( IRStmt_Exit( cmp, Ijk_Boring,
+                         IRConst_U64(rip_next), OFFB_RIP ) );
+
+      if (haveASO(pfx))
+         putIReg32(R_RCX, binop(Iop_Sub32, mkexpr(tc), mkU32(1)) );
+      else
+         putIReg64(R_RCX, binop(Iop_Sub64, mkexpr(tc), mkU64(1)) );
+
+      dis_OP (sz, t_inc, pfx);
+
+      if (cond != AMD64CondAlways && i < REP_UNROLL-1) {
+         stmt( IRStmt_Exit( mk_amd64g_calculate_condition(
+                               (AMD64Condcode)(1 ^ (Int)cond)),
+                            Ijk_Boring,
+                            IRConst_U64(rip_next),
+                            OFFB_RIP ) );
+      }
+   }
 
    if (cond == AMD64CondAlways) {
       jmp_lit(dres, Ijk_Boring, rip);
@@ -1309,6 +1309,215 @@ static Bool isU64 ( IRExpr* e, ULong n )
               && e->Iex.Const.con->Ico.U64 == n );
 }
 
+/* If E is a 64-bit constant, put its value in *N and return True. */
+static Bool getU64 ( IRExpr* e, /*OUT*/ULong* n )
+{
+   if (e->tag != Iex_Const || e->Iex.Const.con->tag != Ico_U64)
+      return False;
+   *n = e->Iex.Const.con->Ico.U64;
+   return True;
+}
+
+/* Table-driven fallback for specialising the NZCV helpers.  The
+   hand-written cases in guest_arm64_spechelper below give the best
+   code for the common (CC_OP, condition) pairs.  Everything else
+   comes here: each flag is rebuilt from the thunk as
+   arm64g_calculate_flag_{n,z,c,v} would compute it, and the flags are
+   then combined as in arm64g_calculate_condition.  All values built
+   here are :: Ity_I64 and are either 0 or 1. */
+
+#define unop(_op,_a1) IRExpr_Unop((_op),(_a1))
+#define binop(_op,_a1,_a2) IRExpr_Binop((_op),(_a1),(_a2))
+#define mkU64(_n) IRExpr_Const(IRConst_U64(_n))
+#define mkU8(_n)  IRExpr_Const(IRConst_U8(_n))
+
+/* The arithmetic result of the thunk; a fresh tree on each call. */
+static IRExpr* spec_result ( ULong cc_op,
+                             IRExpr* dep1, IRExpr* dep2, IRExpr* dep3 )
+{
+   switch (cc_op) {
+      case ARM64G_CC_OP_ADD32: case ARM64G_CC_OP_ADD64:
+         return binop(Iop_Add64, dep1, dep2);
+      case ARM64G_CC_OP_SUB32: case ARM64G_CC_OP_SUB64:
+         return binop(Iop_Sub64, dep1, dep2);
+      case ARM64G_CC_OP_ADC32: case ARM64G_CC_OP_ADC64:
+         return binop(Iop_Add64, binop(Iop_Add64, dep1, dep2), dep3);
+      case ARM64G_CC_OP_SBC32: case ARM64G_CC_OP_SBC64:
+         return binop(Iop_Sub64, binop(Iop_Sub64, dep1, dep2),
+                                 binop(Iop_Xor64, dep3, mkU64(1)));
+      default:
+         /* LOGIC: DEP1 holds the result. */
+         return dep1;
+   }
+}
+
+/* Build flag FLAG (one of ARM64G_CC_SHIFT_{N,Z,C,V}) from the thunk,
+   or return NULL if CC_OP isn't valid. */
+static IRExpr* spec_arm64_flag ( Int flag, ULong cc_op,
+                                 IRExpr* dep1, IRExpr* dep2, IRExpr* dep3 )
+{
+   Int sz;
+   switch (cc_op) {
+      case ARM64G_CC_OP_COPY:
+         return spec_bit(dep1, flag);
+      case ARM64G_CC_OP_ADD32: case ARM64G_CC_OP_SUB32:
+      case ARM64G_CC_OP_ADC32: case ARM64G_CC_OP_SBC32:
+      case ARM64G_CC_OP_LOGIC32:
+         sz = 32;
+         break;
+      case ARM64G_CC_OP_ADD64: case ARM64G_CC_OP_SUB64:
+      case ARM64G_CC_OP_ADC64: case ARM64G_CC_OP_SBC64:
+      case ARM64G_CC_OP_LOGIC64:
+         sz = 64;
+         break;
+      default:
+         return NULL;
+   }
+
+   switch (flag) {
+
+      case ARM64G_CC_SHIFT_N:
+         return spec_bit(spec_result(cc_op, dep1, dep2, dep3), sz - 1);
+
+      case ARM64G_CC_SHIFT_Z:
+         return spec_b1(binop(Iop_CmpEQ64,
+                              spec_top(spec_result(cc_op, dep1, dep2, dep3),
+                                       sz),
+                              mkU64(0)));
+
+      case ARM64G_CC_SHIFT_C:
+         switch (cc_op) {
+            case ARM64G_CC_OP_ADD32: case ARM64G_CC_OP_ADD64:
+               return spec_b1(binop(Iop_CmpLT64U,
+                                    spec_top(spec_result(cc_op, dep1, dep2,
+                                                         dep3), sz),
+                                    spec_top(dep1, sz)));
+            case ARM64G_CC_OP_SUB32: case ARM64G_CC_OP_SUB64:
+               return spec_b1(binop(Iop_CmpLE64U, spec_top(dep2, sz),
+                                                  spec_top(dep1, sz)));
+            case ARM64G_CC_OP_ADC32: case ARM64G_CC_OP_ADC64:
+               return IRExpr_ITE(
+                         binop(Iop_CmpNE64, dep3, mkU64(0)),
+                         spec_b1(binop(Iop_CmpLE64U,
+                                       spec_top(spec_result(cc_op, dep1, dep2,
+                                                            dep3), sz),
+                                       spec_top(dep1, sz))),
+                         spec_b1(binop(Iop_CmpLT64U,
+                                       spec_top(spec_result(cc_op, dep1, dep2,
+                                                            dep3), sz),
+                                       spec_top(dep1, sz))));
+            case ARM64G_CC_OP_SBC32: case ARM64G_CC_OP_SBC64:
+               return IRExpr_ITE(
+                         binop(Iop_CmpNE64, dep3, mkU64(0)),
+                         spec_b1(binop(Iop_CmpLE64U, spec_top(dep2, sz),
+                                                     spec_top(dep1, sz))),
+                         spec_b1(binop(Iop_CmpLT64U, spec_top(dep2, sz),
+                                                     spec_top(dep1, sz))));
+            default:
+               /* C after LOGIC is zero. */
+               return mkU64(0);
+         }
+
+      case ARM64G_CC_SHIFT_V:
+         switch (cc_op) {
+            case ARM64G_CC_OP_ADD32: case ARM64G_CC_OP_ADD64:
+            case ARM64G_CC_OP_ADC32: case ARM64G_CC_OP_ADC64:
+               return spec_bit(
+                         binop(Iop_And64,
+                               binop(Iop_Xor64,
+                                     spec_result(cc_op, dep1, dep2, dep3),
+                                     dep1),
+                               binop(Iop_Xor64,
+                                     spec_result(cc_op, dep1, dep2, dep3),
+                                     dep2)),
+                         sz - 1);
+            case ARM64G_CC_OP_SUB32: case ARM64G_CC_OP_SUB64:
+            case ARM64G_CC_OP_SBC32: case ARM64G_CC_OP_SBC64:
+               return spec_bit(
+                         binop(Iop_And64,
+                               binop(Iop_Xor64, dep1, dep2),
+                               binop(Iop_Xor64, dep1,
+                                     spec_result(cc_op, dep1, dep2, dep3))),
+                         sz - 1);
+            default:
+               /* V after LOGIC is zero. */
+               return mkU64(0);
+         }
+
+      default:
+         return NULL;
+   }
+}
+
+/* Build COND after CC_OP from the individual flags, or return NULL if
+   that isn't possible. */
+static IRExpr* spec_arm64_condition ( ULong cond, ULong cc_op,
+                                      IRExpr* dep1, IRExpr* dep2,
+                                      IRExpr* dep3 )
+{
+   IRExpr *res, *nf, *zf, *cf, *vf;
+
+   if (cond == ARM64CondAL || cond == ARM64CondNV)
+      return mkU64(1);
+
+   nf = spec_arm64_flag(ARM64G_CC_SHIFT_N, cc_op, dep1, dep2, dep3);
+   if (!nf)
+      return NULL;
+
+   switch (cond & ~1ULL) {
+      case ARM64CondEQ:
+         res = spec_arm64_flag(ARM64G_CC_SHIFT_Z, cc_op, dep1, dep2, dep3);
+         break;
+      case ARM64CondCS:
+         res = spec_arm64_flag(ARM64G_CC_SHIFT_C, cc_op, dep1, dep2, dep3);
+         break;
+      case ARM64CondMI:
+         res = nf;
+         break;
+      case ARM64CondVS:
+         res = spec_arm64_flag(ARM64G_CC_SHIFT_V, cc_op, dep1, dep2, dep3);
+         break;
+      case ARM64CondHI:
+         cf  = spec_arm64_flag(ARM64G_CC_SHIFT_C, cc_op, dep1, dep2, dep3);
+         zf  = spec_arm64_flag(ARM64G_CC_SHIFT_Z, cc_op, dep1, dep2, dep3);
+         res = binop(Iop_And64, cf, spec_not(zf));
+         break;
+      case ARM64CondGE:
+         vf  = spec_arm64_flag(ARM64G_CC_SHIFT_V, cc_op, dep1, dep2, dep3);
+         res = spec_not(binop(Iop_Xor64, nf, vf));
+         break;
+      case ARM64CondGT:
+         vf  = spec_arm64_flag(ARM64G_CC_SHIFT_V, cc_op, dep1, dep2, dep3);
+         zf  = spec_arm64_flag(ARM64G_CC_SHIFT_Z, cc_op, dep1, dep2, dep3);
+         res = spec_not(binop(Iop_Or64, zf, binop(Iop_Xor64, nf, vf)));
+         break;
+      default:
+         return NULL;
+   }
+   if (cond & 1)
+      res = spec_not(res);
+   return res;
+}
+
+/* Find the expression bound to TMP by one of the N_PRECEDING statements
+   before the helper call, or return NULL. */
+static IRExpr* spec_binding ( IRTemp tmp, IRStmt** preceding,
+                              Int n_preceding )
+{
+   Int j;
+   for (j = n_preceding - 1; j >= 0; j--) {
+      IRStmt* st = preceding[j];
+      if (st->tag == Ist_WrTmp && st->Ist.WrTmp.tmp == tmp)
+         return st->Ist.WrTmp.data;
+   }
+   return NULL;
+}
+
+#undef unop
+#undef binop
+#undef mkU64
+#undef mkU8
+
 IRExpr* guest_arm64_spechelper ( const HChar* function_name,
                                  IRExpr** args,
                                  IRStmt** precedingStmts,
@@ -1341,12 +1550,12 @@ IRExpr* guest_arm64_spechelper ( const HChar* function_name,
          Not sure whether this is strictly necessary, but: the
          replacement IR must produce only the values 0 or 1.  Bits
          63:1 are required to be zero. */
-      IRExpr *cond_n_op, *cc_dep1, *cc_dep2  ; //, *cc_ndep;
+      IRExpr *cond_n_op, *cc_dep1, *cc_dep2, *cc_ndep;
       vassert(arity == 4);
       cond_n_op = args[0]; /* (ARM64Condcode << 4)  |  ARM64G_CC_OP_* */
       cc_dep1   = args[1];
       cc_dep2   = args[2];
-      //cc_ndep   = args[3];
+      cc_ndep   = args[3];
 
       /*---------------- SUB64 ----------------*/
 
@@ -1577,6 +1786,57 @@ IRExpr* guest_arm64_spechelper ( const HChar* function_name,
                       mkU64(1));
       }
 
+      /*---------------- everything else ----------------*/
+
+      ULong cond_n_op_n;
+      if (getU64(cond_n_op, &cond_n_op_n)) {
+         return spec_arm64_condition(cond_n_op_n >> 4, cond_n_op_n & 0xF,
+                                     cc_dep1, cc_dep2, cc_ndep);
+      }
+
+      /* After CCMP/CCMN, the thunk is
+            CC_OP   = ITE(c, OP_{ADD,SUB}{32,64}, OP_COPY)
+            CC_DEP1 = ITE(c, argL, nzcv << 28)
+            CC_DEP2 = ITE(c, argR, 0)
+         so a following conditional gets (Or64(t, cond << 4), ..) where
+         t is bound to the ITE.  Specialise both arms and select between
+         them with c.  Both arms can use DEP1 and DEP2 as they are, since
+         those hold the matching values whenever an arm is selected. */
+      if (cond_n_op->tag == Iex_RdTmp) {
+         IRExpr* pair = spec_binding(cond_n_op->Iex.RdTmp.tmp,
+                                     precedingStmts, n_precedingStmts);
+         ULong   cond_n;
+         if (pair && pair->tag == Iex_Binop
+             && pair->Iex.Binop.op == Iop_Or64
+             && pair->Iex.Binop.arg1->tag == Iex_RdTmp
+             && getU64(pair->Iex.Binop.arg2, &cond_n)
+             && (cond_n & ~0xF0ULL) == 0) {
+            IRExpr* ite = spec_binding(pair->Iex.Binop.arg1->Iex.RdTmp.tmp,
+                                       precedingStmts, n_precedingStmts);
+            ULong   op_t, op_f;
+            if (ite && ite->tag == Iex_ITE
+                && getU64(ite->Iex.ITE.iftrue, &op_t)
+                && getU64(ite->Iex.ITE.iffalse, &op_f)
+                && op_t < ARM64G_CC_OP_NUMBER
+                && op_f < ARM64G_CC_OP_NUMBER) {
+               IRExpr* res_t
+                  = guest_arm64_spechelper(
+                       function_name,
+                       mkIRExprVec_4(mkU64(cond_n | op_t),
+                                     cc_dep1, cc_dep2, cc_ndep),
+                       precedingStmts, n_precedingStmts);
+               IRExpr* res_f
+                  = guest_arm64_spechelper(
+                       function_name,
+                       mkIRExprVec_4(mkU64(cond_n | op_f),
+                                     cc_dep1, cc_dep2, cc_ndep),
+                       precedingStmts, n_precedingStmts);
+               if (res_t && res_f)
+                  return IRExpr_ITE(ite->Iex.ITE.cond, res_t, res_f);
+            }
+         }
+      }
+
 //ZZ       /*----------------- AL -----------------*/
 //ZZ 
 //ZZ       /* A critically important case for Thumb code.
@@ -1745,6 +2005,43 @@ IRExpr* guest_arm64_spechelper ( const HChar* function_name,
 //ZZ 
 //ZZ    }
 
+   /* --------- specialising "arm64g_calculate_flag_c" --------- */
+
+   if (vex_streq(function_name, "arm64g_calculate_flag_c")) {
+      /* Thunk args are (cc_op, dep1, dep2, dep3). */
+      ULong cc_op_n;
+      vassert(arity == 4);
+      if (getU64(args[0], &cc_op_n))
+         return spec_arm64_flag(ARM64G_CC_SHIFT_C, cc_op_n,
+                                args[1], args[2], args[3]);
+   }
+
+   /* --------- specialising "arm64g_calculate_flags_nzcv" --------- */
+
+   if (vex_streq(function_name, "arm64g_calculate_flags_nzcv")) {
+      /* Thunk args are (cc_op, dep1, dep2, dep3).  The result has N Z C
+         V in bits 31:28 and zero elsewhere. */
+      static const Int shifts[4]
+         = { ARM64G_CC_SHIFT_N, ARM64G_CC_SHIFT_Z,
+             ARM64G_CC_SHIFT_C, ARM64G_CC_SHIFT_V };
+      IRExpr* res = NULL;
+      ULong   cc_op_n;
+      vassert(arity == 4);
+      if (!getU64(args[0], &cc_op_n))
+         return NULL;
+      if (cc_op_n == ARM64G_CC_OP_COPY)
+         return binop(Iop_And64, args[1], mkU64(0xF0000000ULL));
+      for (i = 0; i < 4; i++) {
+         IRExpr* f = spec_arm64_flag(shifts[i], cc_op_n,
+                                     args[1], args[2], args[3]);
+         if (!f)
+            return NULL;
+         f   = binop(Iop_Shl64, f, mkU8(shifts[i]));
+         res = res ? binop(Iop_Or64, res, f) : f;
+      }
+      return res;
+   }
+
 #  undef unop
 #  undef binop
 #  undef mkU64
@@ -756,6 +756,13 @@ static IROp mkVecCMPEQ ( UInt size ) {
    return ops[size];
 }
 
+static IROp mkVecCMPNEZ ( UInt size ) {
+   const IROp ops[4]
+      = { Iop_CmpNEZ8x16, Iop_CmpNEZ16x8, Iop_CmpNEZ32x4, Iop_CmpNEZ64x2 };
+   vassert(size < 4);
+   return ops[size];
+}
+
 static IROp mkVecCMPGTU ( UInt size ) {
    const IROp ops[4]
       = { Iop_CmpGT8Ux16, Iop_CmpGT16Ux8, Iop_CmpGT32Ux4, Iop_CmpGT64Ux2 };
@@ -7863,6 +7870,18 @@ IRTemp math_WIDEN_LO_OR_HI_LANES ( Bool zWiden, Bool fromUpperHalf,
    IRTemp src = newTempV128();
    IRTemp res = newTempV128();
    assign(src, srcE);
+   if (!fromUpperHalf) {
+      /* The lower half can be widened directly, which the back end can
+         do in a single SXTL/UXTL. */
+      const IROp opsS[3]
+         = { Iop_Widen8Sto16x8, Iop_Widen16Sto32x4, Iop_Widen32Sto64x2 };
+      const IROp opsU[3]
+         = { Iop_Widen8Uto16x8, Iop_Widen16Uto32x4, Iop_Widen32Uto64x2 };
+      vassert(sizeNarrow < 3);
+      assign(res, unop(zWiden ? opsU[sizeNarrow] : opsS[sizeNarrow],
+                       unop(Iop_V128to64, mkexpr(src))));
+      return res;
+   }
    switch (sizeNarrow) {
       case X10:
          assign(res,
@@ -10053,9 +10072,7 @@ Bool dis_AdvSIMD_scalar_three_same(/*MB_OUT*/DisResult* dres, UInt insn)
       IRTemp  res  = newTempV128();
       assign(res,
              isEQ ? binop(Iop_CmpEQ64x2, argL, argR)
-                  : unop(Iop_NotV128, binop(Iop_CmpEQ64x2,
-                                            binop(Iop_AndV128, argL, argR), 
-                                            mkV128(0x0000))));
+                  : unop(Iop_CmpNEZ64x2, binop(Iop_AndV128, argL, argR)));
       putQReg128(dd, unop(Iop_ZeroHI64ofV128, mkexpr(res)));
       DIP("%s %s, %s, %s\n", isEQ ? "cmeq" : "cmtst",
           nameQRegLO(dd, Ity_I64),
@@ -11801,9 +11818,8 @@ Bool dis_AdvSIMD_three_same(/*MB_OUT*/DisResult* dres, UInt insn)
       IRTemp  res  = newTempV128();
       assign(res,
              isEQ ? binop(mkVecCMPEQ(size), argL, argR)
-                  : unop(Iop_NotV128, binop(mkVecCMPEQ(size),
-                                            binop(Iop_AndV128, argL, argR), 
-                                            mkV128(0x0000))));
+                  : unop(mkVecCMPNEZ(size),
+                         binop(Iop_AndV128, argL, argR)));
       putQReg128(dd, math_MAYBE_ZERO_HI64(bitQ, res));
       const HChar* nm  = isEQ ? "cmeq" : "cmtst";
       const HChar* arr = nameArr_Q_SZ(bitQ, size);
@@ -199,6 +199,42 @@ IRSB* bb_to_IR (
       );
 
 
+/* ---------------------------------------------------------------
+   Building blocks for the table-driven flag specialisers in
+   guest_{amd64,arm64}_helpers.c.  All values are :: Ity_I64; the
+   flag values are 0 or 1.
+   --------------------------------------------------------------- */
+
+/* Move the low SZ bits of E to the top of the word, so that 64-bit
+   comparisons of the result behave like SZ-bit comparisons of E. */
+static inline IRExpr* spec_top ( IRExpr* e, Int sz )
+{
+   return sz == 64
+             ? e
+             : IRExpr_Binop(Iop_Shl64, e, IRExpr_Const(IRConst_U8(64 - sz)));
+}
+
+/* Bit N of E, as 0 or 1. */
+static inline IRExpr* spec_bit ( IRExpr* e, Int n )
+{
+   if (n > 0)
+      e = IRExpr_Binop(Iop_Shr64, e, IRExpr_Const(IRConst_U8(n)));
+   return IRExpr_Binop(Iop_And64, e, IRExpr_Const(IRConst_U64(1)));
+}
+
+/* An :: Ity_I1 value as 0 or 1. */
+static inline IRExpr* spec_b1 ( IRExpr* e1 )
+{
+   return IRExpr_Unop(Iop_1Uto64, e1);
+}
+
+/* The negation of a flag value. */
+static inline IRExpr* spec_not ( IRExpr* e )
+{
+   return IRExpr_Binop(Iop_Xor64, e, IRExpr_Const(IRConst_U64(1)));
+}
+
+
 #endif /* ndef __VEX_GUEST_GENERIC_BB_TO_IR_H */
 
 /*--------------------------------------------------------------------*/
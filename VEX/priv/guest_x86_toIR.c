@@ -3278,9 +3278,17 @@ void dis_SCAS ( Int sz, IRTemp t_inc )
 }
 
 
+/* Number of iterations of a REP-prefixed string insn that are done
+   by each run through its translation, before it loops back to
+   itself. */
+#define REP_UNROLL 8
+
 /* Wrap the appropriate string op inside a REP/REPE/REPNE.
    We assume the insn is the last one in the basic block, and so emit a jump
-   to the next insn, rather than just falling through. */
+   to the next insn, rather than just falling through.  To cut down the
+   number of trips round the loop, REP_UNROLL iterations are done each
+   time, each one leaving through a side exit if ECX runs out or the
+   REPE/REPNE condition fails. */
 static 
 void dis_REP_op ( /*MOD*/DisResult* dres,
                   X86Condcode cond,
@@ -3288,18 +3296,30 @@ void dis_REP_op ( /*MOD*/DisResult* dres,
                   Int sz, Addr32 eip, Addr32 eip_next, const HChar* name )
 {
    IRTemp t_inc = newTemp(Ity_I32);
-   IRTemp tc    = newTemp(Ity_I32);  /*  ECX  */
+   IRTemp tc;
+   Int    i;
 
-   assign( tc, getIReg(4,R_ECX) );
+   dis_string_op_increment(sz, t_inc);
 
-   stmt( IRStmt_Exit( binop(Iop_CmpEQ32,mkexpr(tc),mkU32(0)),
-                      Ijk_Boring,
-                      IRConst_U32(eip_next), OFFB_EIP ) );
+   for (i = 0; i < REP_UNROLL; i++) {
+      tc = newTemp(Ity_I32);  /*  ECX  */
+      assign( tc, getIReg(4,R_ECX) );
 
-   putIReg(4, R_ECX, binop(Iop_Sub32, mkexpr(tc), mkU32(1)) );
+      stmt( IRStmt_Exit( binop(Iop_CmpEQ32,mkexpr(tc),mkU32(0)),
+                         Ijk_Boring,
+                         IRConst_U32(eip_next), OFFB_EIP ) );
 
-   dis_string_op_increment(sz, t_inc);
-   dis_OP (sz, t_inc);
+      putIReg(4, R_ECX, binop(Iop_Sub32, mkexpr(tc), mkU32(1)) );
+
+      dis_OP (sz, t_inc);
+
+      if (cond != X86CondAlways && i < REP_UNROLL-1) {
+         stmt( IRStmt_Exit( mk_x86g_calculate_condition(
+                               (X86Condcode)(1 ^ (Int)cond)),
+                            Ijk_Boring,
+                            IRConst_U32(eip_next), OFFB_EIP ) );
+      }
+   }
 
    if (cond == X86CondAlways) {
       jmp_lit(dres, Ijk_Boring, eip);
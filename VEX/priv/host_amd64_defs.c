@@ -88,6 +88,13 @@ const RRegUniverse* getRRegUniverse_AMD64 ( void )
    ru->regs[ru->size++] = hregAMD64_XMM11();
    ru->regs[ru->size++] = hregAMD64_XMM12();
    ru->allocable_end[HRcVec128] = ru->size - 1;
+
+   ru->allocable_start[HRcVec256] = ru->size;
+   ru->regs[ru->size++] = hregAMD64_YMM13();
+   ru->regs[ru->size++] = hregAMD64_YMM14();
+   ru->regs[ru->size++] = hregAMD64_YMM15();
+   ru->regs[ru->size++] = hregAMD64_YMM2();
+   ru->allocable_end[HRcVec256] = ru->size - 1;
    ru->allocable = ru->size;
 
    /* And other regs, not available to the allocator. */
@@ -127,6 +134,10 @@ UInt ppHRegAMD64 ( HReg reg )
          r = hregEncoding(reg);
          vassert(r >= 0 && r < 16);
          return vex_printf("%%xmm%d", r);
+      case HRcVec256:
+         r = hregEncoding(reg);
+         vassert(r >= 0 && r < 16);
+         return vex_printf("%%ymm%d", r);
       default:
          vpanic("ppHRegAMD64");
    }
@@ -203,6 +214,18 @@ AMD64AMode* AMD64AMode_IRRS ( UInt imm32, HReg base, HReg indEx, Int shift ) {
    return am;
 }
 
+AMD64AMode* dopyAMD64AMode ( AMD64AMode* am ) {
+   switch (am->tag) {
+      case Aam_IR:
+         return AMD64AMode_IR( am->Aam.IR.imm, am->Aam.IR.reg );
+      case Aam_IRRS:
+         return AMD64AMode_IRRS( am->Aam.IRRS.imm, am->Aam.IRRS.base,
+                                 am->Aam.IRRS.index, am->Aam.IRRS.shift );
+      default:
+         vpanic("dopyAMD64AMode");
+   }
+}
+
 void ppAMD64AMode ( AMD64AMode* am ) {
    switch (am->tag) {
       case Aam_IR: 
@@ -588,6 +611,79 @@ const HChar* showAMD64SseOp ( AMD64SseOp op ) {
    }
 }
 
+const HChar* showAMD64AvxOp ( AMD64AvxOp op ) {
+   switch (op) {
+      case Aavx_MOV:      return "vmovdqu";
+      case Aavx_AND:      return "vpand";
+      case Aavx_OR:       return "vpor";
+      case Aavx_XOR:      return "vpxor";
+      case Aavx_ADD8:     return "vpaddb";
+      case Aavx_ADD16:    return "vpaddw";
+      case Aavx_ADD32:    return "vpaddd";
+      case Aavx_ADD64:    return "vpaddq";
+      case Aavx_QADD8U:   return "vpaddusb";
+      case Aavx_QADD16U:  return "vpaddusw";
+      case Aavx_QADD8S:   return "vpaddsb";
+      case Aavx_QADD16S:  return "vpaddsw";
+      case Aavx_SUB8:     return "vpsubb";
+      case Aavx_SUB16:    return "vpsubw";
+      case Aavx_SUB32:    return "vpsubd";
+      case Aavx_SUB64:    return "vpsubq";
+      case Aavx_QSUB8U:   return "vpsubusb";
+      case Aavx_QSUB16U:  return "vpsubusw";
+      case Aavx_QSUB8S:   return "vpsubsb";
+      case Aavx_QSUB16S:  return "vpsubsw";
+      case Aavx_MUL16:    return "vpmullw";
+      case Aavx_MUL32:    return "vpmulld";
+      case Aavx_MULHI16U: return "vpmulhuw";
+      case Aavx_MULHI16S: return "vpmulhw";
+      case Aavx_AVG8U:    return "vpavgb";
+      case Aavx_AVG16U:   return "vpavgw";
+      case Aavx_MAX8S:    return "vpmaxsb";
+      case Aavx_MAX16S:   return "vpmaxsw";
+      case Aavx_MAX32S:   return "vpmaxsd";
+      case Aavx_MAX8U:    return "vpmaxub";
+      case Aavx_MAX16U:   return "vpmaxuw";
+      case Aavx_MAX32U:   return "vpmaxud";
+      case Aavx_MIN8S:    return "vpminsb";
+      case Aavx_MIN16S:   return "vpminsw";
+      case Aavx_MIN32S:   return "vpminsd";
+      case Aavx_MIN8U:    return "vpminub";
+      case Aavx_MIN16U:   return "vpminuw";
+      case Aavx_MIN32U:   return "vpminud";
+      case Aavx_CMPEQ8:   return "vpcmpeqb";
+      case Aavx_CMPEQ16:  return "vpcmpeqw";
+      case Aavx_CMPEQ32:  return "vpcmpeqd";
+      case Aavx_CMPEQ64:  return "vpcmpeqq";
+      case Aavx_CMPGT8S:  return "vpcmpgtb";
+      case Aavx_CMPGT16S: return "vpcmpgtw";
+      case Aavx_CMPGT32S: return "vpcmpgtd";
+      case Aavx_CMPGT64S: return "vpcmpgtq";
+      case Aavx_PSHUFB:   return "vpshufb";
+      case Aavx_ADD32F:   return "vaddps";
+      case Aavx_SUB32F:   return "vsubps";
+      case Aavx_MUL32F:   return "vmulps";
+      case Aavx_DIV32F:   return "vdivps";
+      case Aavx_MAX32F:   return "vmaxps";
+      case Aavx_MIN32F:   return "vminps";
+      case Aavx_ADD64F:   return "vaddpd";
+      case Aavx_SUB64F:   return "vsubpd";
+      case Aavx_MUL64F:   return "vmulpd";
+      case Aavx_DIV64F:   return "vdivpd";
+      case Aavx_MAX64F:   return "vmaxpd";
+      case Aavx_MIN64F:   return "vminpd";
+      case Aavx_SHL16:    return "vpsllw";
+      case Aavx_SHL32:    return "vpslld";
+      case Aavx_SHL64:    return "vpsllq";
+      case Aavx_SHR16:    return "vpsrlw";
+      case Aavx_SHR32:    return "vpsrld";
+      case Aavx_SHR64:    return "vpsrlq";
+      case Aavx_SAR16:    return "vpsraw";
+      case Aavx_SAR32:    return "vpsrad";
+      default: vpanic("showAMD64AvxOp");
+   }
+}
+
 AMD64Instr* AMD64Instr_Imm64 ( ULong imm64, HReg dst ) {
    AMD64Instr* i      = LibVEX_Alloc_inline(sizeof(AMD64Instr));
    i->tag             = Ain_Imm64;
@@ -677,13 +773,14 @@ AMD64Instr* AMD64Instr_Push( AMD64RMI* src ) {
    return i;
 }
 AMD64Instr* AMD64Instr_Call ( AMD64CondCode cond, Addr64 target, Int regparms,
-                              RetLoc rloc ) {
+                              RetLoc rloc, Bool cold ) {
    AMD64Instr* i        = LibVEX_Alloc_inline(sizeof(AMD64Instr));
    i->tag               = Ain_Call;
    i->Ain.Call.cond     = cond;
    i->Ain.Call.target   = target;
    i->Ain.Call.regparms = regparms;
    i->Ain.Call.rloc     = rloc;
+   i->Ain.Call.cold     = cold;
    vassert(regparms >= 0 && regparms <= 6);
    vassert(is_sane_RetLoc(rloc));
    return i;
@@ -1006,23 +1103,70 @@ AMD64Instr* AMD64Instr_SseShuf ( Int order, HReg src, HReg dst ) {
    vassert(order >= 0 && order <= 0xFF);
    return i;
 }
-//uu AMD64Instr* AMD64Instr_AvxLdSt ( Bool isLoad,
-//uu                                  HReg reg, AMD64AMode* addr ) {
-//uu    AMD64Instr* i         = LibVEX_Alloc_inline(sizeof(AMD64Instr));
-//uu    i->tag                = Ain_AvxLdSt;
-//uu    i->Ain.AvxLdSt.isLoad = isLoad;
-//uu    i->Ain.AvxLdSt.reg    = reg;
-//uu    i->Ain.AvxLdSt.addr   = addr;
-//uu    return i;
-//uu }
-//uu AMD64Instr* AMD64Instr_AvxReRg ( AMD64SseOp op, HReg re, HReg rg ) {
-//uu    AMD64Instr* i      = LibVEX_Alloc_inline(sizeof(AMD64Instr));
-//uu    i->tag             = Ain_AvxReRg;
-//uu    i->Ain.AvxReRg.op  = op;
-//uu    i->Ain.AvxReRg.src = re;
-//uu    i->Ain.AvxReRg.dst = rg;
-//uu    return i;
-//uu }
+AMD64Instr* AMD64Instr_AvxLdSt ( Bool isLoad,
+                                 HReg reg, AMD64AMode* addr ) {
+   AMD64Instr* i         = LibVEX_Alloc_inline(sizeof(AMD64Instr));
+   i->tag                = Ain_AvxLdSt;
+   i->Ain.AvxLdSt.isLoad = isLoad;
+   i->Ain.AvxLdSt.reg    = reg;
+   i->Ain.AvxLdSt.addr   = addr;
+   return i;
+}
+AMD64Instr* AMD64Instr_AvxReRg ( AMD64AvxOp op, HReg srcL, HReg srcR,
+                                 HReg dst ) {
+   AMD64Instr* i       = LibVEX_Alloc_inline(sizeof(AMD64Instr));
+   i->tag              = Ain_AvxReRg;
+   i->Ain.AvxReRg.op   = op;
+   i->Ain.AvxReRg.srcL = srcL;
+   i->Ain.AvxReRg.srcR = srcR;
+   i->Ain.AvxReRg.dst  = dst;
+   vassert(op != Aavx_MOV || sameHReg(srcL, srcR));
+   vassert(op < Aavx_SHL16);
+   return i;
+}
+AMD64Instr* AMD64Instr_AvxShift ( AMD64AvxOp op, UInt amt, HReg src,
+                                  HReg dst ) {
+   AMD64Instr* i       = LibVEX_Alloc_inline(sizeof(AMD64Instr));
+   i->tag              = Ain_AvxShift;
+   i->Ain.AvxShift.op  = op;
+   i->Ain.AvxShift.amt = amt;
+   i->Ain.AvxShift.src = src;
+   i->Ain.AvxShift.dst = dst;
+   vassert(op >= Aavx_SHL16 && op <= Aavx_SAR32);
+   vassert(amt < 64);
+   return i;
+}
+AMD64Instr* AMD64Instr_AvxInsV128 ( HReg hi, HReg lo, HReg dst ) {
+   AMD64Instr* i         = LibVEX_Alloc_inline(sizeof(AMD64Instr));
+   i->tag                = Ain_AvxInsV128;
+   i->Ain.AvxInsV128.hi  = hi;
+   i->Ain.AvxInsV128.lo  = lo;
+   i->Ain.AvxInsV128.dst = dst;
+   return i;
+}
+AMD64Instr* AMD64Instr_AvxExtV128 ( UInt lane, HReg src, HReg dst ) {
+   AMD64Instr* i          = LibVEX_Alloc_inline(sizeof(AMD64Instr));
+   i->tag                 = Ain_AvxExtV128;
+   i->Ain.AvxExtV128.lane = lane;
+   i->Ain.AvxExtV128.src  = src;
+   i->Ain.AvxExtV128.dst  = dst;
+   vassert(lane <= 1);
+   return i;
+}
+AMD64Instr* AMD64Instr_AvxCMov ( AMD64CondCode cond, HReg src, HReg dst ) {
+   AMD64Instr* i        = LibVEX_Alloc_inline(sizeof(AMD64Instr));
+   i->tag               = Ain_AvxCMov;
+   i->Ain.AvxCMov.cond  = cond;
+   i->Ain.AvxCMov.src   = src;
+   i->Ain.AvxCMov.dst   = dst;
+   vassert(cond != Acc_ALWAYS);
+   return i;
+}
+AMD64Instr* AMD64Instr_VZeroUpper ( void ) {
+   AMD64Instr* i = LibVEX_Alloc_inline(sizeof(AMD64Instr));
+   i->tag        = Ain_VZeroUpper;
+   return i;
+}
 AMD64Instr* AMD64Instr_EvCheck ( AMD64AMode* amCounter,
                                  AMD64AMode* amFailAddr ) {
    AMD64Instr* i             = LibVEX_Alloc_inline(sizeof(AMD64Instr));
@@ -1036,6 +1180,12 @@ AMD64Instr* AMD64Instr_ProfInc ( void ) {
    i->tag        = Ain_ProfInc;
    return i;
 }
+AMD64Instr* AMD64Instr_PCMark ( Addr64 guest_pc ) {
+   AMD64Instr* i          = LibVEX_Alloc_inline(sizeof(AMD64Instr));
+   i->tag                 = Ain_PCMark;
+   i->Ain.PCMark.guest_pc = guest_pc;
+   return i;
+}
 
 void ppAMD64Instr ( const AMD64Instr* i, Bool mode64 ) 
 {
@@ -1105,7 +1255,8 @@ void ppAMD64Instr ( const AMD64Instr* i, Bool mode64 )
                        ? "" : showAMD64CondCode(i->Ain.Call.cond),
                     i->Ain.Call.regparms );
          ppRetLoc(i->Ain.Call.rloc);
-         vex_printf("] 0x%llx", i->Ain.Call.target);
+         vex_printf("]%s 0x%llx", i->Ain.Call.cold ? "(cold)" : "",
+                    i->Ain.Call.target);
          break;
 
       case Ain_XDirect:
@@ -1358,24 +1509,58 @@ void ppAMD64Instr ( const AMD64Instr* i, Bool mode64 )
          vex_printf(",");
          ppHRegAMD64(i->Ain.SseShuf.dst);
          return;
-      //uu case Ain_AvxLdSt:
-      //uu    vex_printf("vmovups ");
-      //uu    if (i->Ain.AvxLdSt.isLoad) {
-      //uu       ppAMD64AMode(i->Ain.AvxLdSt.addr);
-      //uu       vex_printf(",");
-      //uu       ppHRegAMD64(i->Ain.AvxLdSt.reg);
-      //uu    } else {
-      //uu       ppHRegAMD64(i->Ain.AvxLdSt.reg);
-      //uu       vex_printf(",");
-      //uu       ppAMD64AMode(i->Ain.AvxLdSt.addr);
-      //uu    }
-      //uu    return;
-      //uu case Ain_AvxReRg:
-      //uu    vex_printf("v%s ", showAMD64SseOp(i->Ain.SseReRg.op));
-      //uu    ppHRegAMD64(i->Ain.AvxReRg.src);
-      //uu    vex_printf(",");
-      //uu    ppHRegAMD64(i->Ain.AvxReRg.dst);
-      //uu    return;
+      case Ain_AvxLdSt:
+         vex_printf("vmovdqu ");
+         if (i->Ain.AvxLdSt.isLoad) {
+            ppAMD64AMode(i->Ain.AvxLdSt.addr);
+            vex_printf(",");
+            ppHRegAMD64(i->Ain.AvxLdSt.reg);
+         } else {
+            ppHRegAMD64(i->Ain.AvxLdSt.reg);
+            vex_printf(",");
+            ppAMD64AMode(i->Ain.AvxLdSt.addr);
+         }
+         return;
+      case Ain_AvxReRg:
+         vex_printf("%s ", showAMD64AvxOp(i->Ain.AvxReRg.op));
+         if (i->Ain.AvxReRg.op != Aavx_MOV) {
+            ppHRegAMD64(i->Ain.AvxReRg.srcR);
+            vex_printf(",");
+         }
+         ppHRegAMD64(i->Ain.AvxReRg.srcL);
+         vex_printf(",");
+         ppHRegAMD64(i->Ain.AvxReRg.dst);
+         return;
+      case Ain_AvxShift:
+         vex_printf("%s $%u,", showAMD64AvxOp(i->Ain.AvxShift.op),
+                    i->Ain.AvxShift.amt);
+         ppHRegAMD64(i->Ain.AvxShift.src);
+         vex_printf(",");
+         ppHRegAMD64(i->Ain.AvxShift.dst);
+         return;
+      case Ain_AvxInsV128:
+         vex_printf("vinserti128 $1,");
+         ppHRegAMD64(i->Ain.AvxInsV128.hi);
+         vex_printf(",");
+         ppHRegAMD64(i->Ain.AvxInsV128.lo);
+         vex_printf(",");
+         ppHRegAMD64(i->Ain.AvxInsV128.dst);
+         return;
+      case Ain_AvxExtV128:
+         vex_printf("vextracti128 $%u,", i->Ain.AvxExtV128.lane);
+         ppHRegAMD64(i->Ain.AvxExtV128.src);
+         vex_printf(",");
+         ppHRegAMD64(i->Ain.AvxExtV128.dst);
+         return;
+      case Ain_AvxCMov:
+         vex_printf("vcmov%s ", showAMD64CondCode(i->Ain.AvxCMov.cond));
+         ppHRegAMD64(i->Ain.AvxCMov.src);
+         vex_printf(",");
+         ppHRegAMD64(i->Ain.AvxCMov.dst);
+         return;
+      case Ain_VZeroUpper:
+         vex_printf("vzeroupper");
+         return;
       case Ain_EvCheck:
          vex_printf("(evCheck) decl ");
          ppAMD64AMode(i->Ain.EvCheck.amCounter);
@@ -1386,6 +1571,9 @@ void ppAMD64Instr ( const AMD64Instr* i, Bool mode64 )
       case Ain_ProfInc:
          vex_printf("(profInc) movabsq $NotKnownYet, %%r11; incq (%%r11)");
          return;
+      case Ain_PCMark:
+         vex_printf("(pcMark) 0x%llx", i->Ain.PCMark.guest_pc);
+         return;
       default:
          vpanic("ppAMD64Instr");
    }
@@ -1488,6 +1676,10 @@ void getRegUsage_AMD64Instr ( HRegUsage* u, const AMD64Instr* i, Bool mode64 )
          addHRegUse(u, HRmWrite, hregAMD64_XMM10());
          addHRegUse(u, HRmWrite, hregAMD64_XMM11());
          addHRegUse(u, HRmWrite, hregAMD64_XMM12());
+         addHRegUse(u, HRmWrite, hregAMD64_YMM13());
+         addHRegUse(u, HRmWrite, hregAMD64_YMM14());
+         addHRegUse(u, HRmWrite, hregAMD64_YMM15());
+         addHRegUse(u, HRmWrite, hregAMD64_YMM2());
 
          /* Now we have to state any parameter-carrying registers
             which might be read.  This depends on the regparmness. */
@@ -1690,30 +1882,54 @@ void getRegUsage_AMD64Instr ( HRegUsage* u, const AMD64Instr* i, Bool mode64 )
          addHRegUse(u, HRmRead,  i->Ain.SseShuf.src);
          addHRegUse(u, HRmWrite, i->Ain.SseShuf.dst);
          return;
-      //uu case Ain_AvxLdSt:
-      //uu addRegUsage_AMD64AMode(u, i->Ain.AvxLdSt.addr);
-      //uu addHRegUse(u, i->Ain.AvxLdSt.isLoad ? HRmWrite : HRmRead,
-      //uu               i->Ain.AvxLdSt.reg);
-      //uu return;
-      //uu case Ain_AvxReRg:
-      //uu    if ( (i->Ain.AvxReRg.op == Asse_XOR
-      //uu          || i->Ain.AvxReRg.op == Asse_CMPEQ32)
-      //uu         && i->Ain.AvxReRg.src == i->Ain.AvxReRg.dst) {
-      //uu       /* See comments on the case for Ain_SseReRg. */
-      //uu       addHRegUse(u, HRmWrite, i->Ain.AvxReRg.dst);
-      //uu    } else {
-      //uu       addHRegUse(u, HRmRead, i->Ain.AvxReRg.src);
-      //uu       addHRegUse(u, i->Ain.AvxReRg.op == Asse_MOV 
-      //uu                        ? HRmWrite : HRmModify, 
-      //uu                     i->Ain.AvxReRg.dst);
-      //uu
-      //uu       if (i->Ain.AvxReRg.op == Asse_MOV) {
-      //uu          u->isRegRegMove = True;
-      //uu          u->regMoveSrc   = i->Ain.AvxReRg.src;
-      //uu          u->regMoveDst   = i->Ain.AvxReRg.dst;
-      //uu       }
-      //uu    }
-      //uu    return;
+      case Ain_AvxLdSt:
+         addRegUsage_AMD64AMode(u, i->Ain.AvxLdSt.addr);
+         addHRegUse(u, i->Ain.AvxLdSt.isLoad ? HRmWrite : HRmRead,
+                       i->Ain.AvxLdSt.reg);
+         return;
+      case Ain_AvxReRg:
+         if ( (i->Ain.AvxReRg.op == Aavx_XOR
+               || i->Ain.AvxReRg.op == Aavx_CMPEQ32)
+              && sameHReg(i->Ain.AvxReRg.srcL, i->Ain.AvxReRg.srcR)) {
+            /* See comments on the case for Ain_SseReRg. */
+            addHRegUse(u, HRmWrite, i->Ain.AvxReRg.dst);
+         } else {
+            addHRegUse(u, HRmRead,  i->Ain.AvxReRg.srcL);
+            addHRegUse(u, HRmRead,  i->Ain.AvxReRg.srcR);
+            addHRegUse(u, HRmWrite, i->Ain.AvxReRg.dst);
+
+            if (i->Ain.AvxReRg.op == Aavx_MOV) {
+               u->isRegRegMove = True;
+               u->regMoveSrc   = i->Ain.AvxReRg.srcL;
+               u->regMoveDst   = i->Ain.AvxReRg.dst;
+            }
+         }
+         return;
+      case Ain_AvxShift:
+         addHRegUse(u, HRmRead,  i->Ain.AvxShift.src);
+         addHRegUse(u, HRmWrite, i->Ain.AvxShift.dst);
+         return;
+      case Ain_AvxInsV128:
+         addHRegUse(u, HRmRead,  i->Ain.AvxInsV128.hi);
+         addHRegUse(u, HRmRead,  i->Ain.AvxInsV128.lo);
+         addHRegUse(u, HRmWrite, i->Ain.AvxInsV128.dst);
+         return;
+      case Ain_AvxExtV128:
+         addHRegUse(u, HRmRead,  i->Ain.AvxExtV128.src);
+         addHRegUse(u, HRmWrite, i->Ain.AvxExtV128.dst);
+         return;
+      case Ain_AvxCMov:
+         addHRegUse(u, HRmRead,   i->Ain.AvxCMov.src);
+         addHRegUse(u, HRmModify, i->Ain.AvxCMov.dst);
+         return;
+      case Ain_VZeroUpper:
+         /* Only the allocatable 256-bit regs can hold anything
+            interesting in their upper halves. */
+         addHRegUse(u, HRmWrite, hregAMD64_YMM13());
+         addHRegUse(u, HRmWrite, hregAMD64_YMM14());
+         addHRegUse(u, HRmWrite, hregAMD64_YMM15());
+         addHRegUse(u, HRmWrite, hregAMD64_YMM2());
+         return;
       case Ain_EvCheck:
          /* We expect both amodes only to mention %rbp, so this is in
             fact pointless, since %rbp isn't allocatable, but anyway.. */
@@ -1723,6 +1939,8 @@ void getRegUsage_AMD64Instr ( HRegUsage* u, const AMD64Instr* i, Bool mode64 )
       case Ain_ProfInc:
          addHRegUse(u, HRmWrite, hregAMD64_R11());
          return;
+      case Ain_PCMark:
+         return;
       default:
          ppAMD64Instr(i, mode64);
          vpanic("getRegUsage_AMD64Instr");
@@ -1905,14 +2123,34 @@ void mapRegs_AMD64Instr ( HRegRemap* m, AMD64Instr* i, Bool mode64 )
          mapReg(m, &i->Ain.SseShuf.src);
          mapReg(m, &i->Ain.SseShuf.dst);
          return;
-      //uu case Ain_AvxLdSt:
-      //uu    mapReg(m, &i->Ain.AvxLdSt.reg);
-      //uu    mapRegs_AMD64AMode(m, i->Ain.AvxLdSt.addr);
-      //uu    break;
-      //uu case Ain_AvxReRg:
-      //uu    mapReg(m, &i->Ain.AvxReRg.src);
-      //uu    mapReg(m, &i->Ain.AvxReRg.dst);
-      //uu    return;
+      case Ain_AvxLdSt:
+         mapReg(m, &i->Ain.AvxLdSt.reg);
+         mapRegs_AMD64AMode(m, i->Ain.AvxLdSt.addr);
+         return;
+      case Ain_AvxReRg:
+         mapReg(m, &i->Ain.AvxReRg.srcL);
+         mapReg(m, &i->Ain.AvxReRg.srcR);
+         mapReg(m, &i->Ain.AvxReRg.dst);
+         return;
+      case Ain_AvxShift:
+         mapReg(m, &i->Ain.AvxShift.src);
+         mapReg(m, &i->Ain.AvxShift.dst);
+         return;
+      case Ain_AvxInsV128:
+         mapReg(m, &i->Ain.AvxInsV128.hi);
+         mapReg(m, &i->Ain.AvxInsV128.lo);
+         mapReg(m, &i->Ain.AvxInsV128.dst);
+         return;
+      case Ain_AvxExtV128:
+         mapReg(m, &i->Ain.AvxExtV128.src);
+         mapReg(m, &i->Ain.AvxExtV128.dst);
+         return;
+      case Ain_AvxCMov:
+         mapReg(m, &i->Ain.AvxCMov.src);
+         mapReg(m, &i->Ain.AvxCMov.dst);
+         return;
+      case Ain_VZeroUpper:
+         return;
       case Ain_EvCheck:
          /* We expect both amodes only to mention %rbp, so this is in
             fact pointless, since %rbp isn't allocatable, but anyway.. */
@@ -1922,6 +2160,8 @@ void mapRegs_AMD64Instr ( HRegRemap* m, AMD64Instr* i, Bool mode64 )
       case Ain_ProfInc:
          /* hardwires r11 -- nothing to modify. */
          return;
+      case Ain_PCMark:
+         return;
       default:
          ppAMD64Instr(i, mode64);
          vpanic("mapRegs_AMD64Instr");
@@ -1948,6 +2188,9 @@ void genSpill_AMD64 ( /*OUT*/HInstr** i1, /*OUT*/HInstr** i2,
       case HRcVec128:
          *i1 = AMD64Instr_SseLdSt ( False/*store*/, 16, rreg, am );
          return;
+      case HRcVec256:
+         *i1 = AMD64Instr_AvxLdSt ( False/*store*/, rreg, am );
+         return;
       default: 
          ppHRegClass(hregClass(rreg));
          vpanic("genSpill_AMD64: unimplemented regclass");
@@ -1970,6 +2213,9 @@ void genReload_AMD64 ( /*OUT*/HInstr** i1, /*OUT*/HInstr** i2,
       case HRcVec128:
          *i1 = AMD64Instr_SseLdSt ( True/*load*/, 16, rreg, am );
          return;
+      case HRcVec256:
+         *i1 = AMD64Instr_AvxLdSt ( True/*load*/, rreg, am );
+         return;
       default: 
          ppHRegClass(hregClass(rreg));
          vpanic("genReload_AMD64: unimplemented regclass");
@@ -1983,6 +2229,8 @@ AMD64Instr* genMove_AMD64(HReg from, HReg to, Bool mode64)
       return AMD64Instr_Alu64R(Aalu_MOV, AMD64RMI_Reg(from), to);
    case HRcVec128:
       return AMD64Instr_SseReRg(Asse_MOV, from, to);
+   case HRcVec256:
+      return AMD64Instr_AvxReRg(Aavx_MOV, from, from, to);
    default:
       ppHRegClass(hregClass(from));
       vpanic("genMove_AMD64: unimplemented regclass");
@@ -2027,6 +2275,412 @@ AMD64Instr* directReload_AMD64( AMD64Instr* i, HReg vreg, Short spill_off )
 }
 
 
+/* Rematerialisation support for the register allocator.  The guest
+   state is only ever accessed through %rbp, so an amode based on
+   %rbp with a constant offset is a known part of the guest state. */
+
+static Bool isGuestStateAMode ( const AMD64AMode* am, /*OUT*/Int* off )
+{
+   if (am->tag == Aam_IR && sameHReg(am->Aam.IR.reg, hregAMD64_RBP())) {
+      *off = (Int)am->Aam.IR.imm;
+      return True;
+   }
+   return False;
+}
+
+Bool isRematDef_AMD64 ( const AMD64Instr* i, /*OUT*/Int* gsOff,
+                        /*OUT*/Int* gsLen )
+{
+   switch (i->tag) {
+      case Ain_Imm64:
+         *gsLen = 0;
+         return True;
+      case Ain_Alu64R:
+         if (i->Ain.Alu64R.op != Aalu_MOV)
+            return False;
+         if (i->Ain.Alu64R.src->tag == Armi_Imm) {
+            *gsLen = 0;
+            return True;
+         }
+         if (i->Ain.Alu64R.src->tag == Armi_Mem
+             && isGuestStateAMode(i->Ain.Alu64R.src->Armi.Mem.am, gsOff)) {
+            *gsLen = 8;
+            return True;
+         }
+         return False;
+      case Ain_LoadEX:
+         if (isGuestStateAMode(i->Ain.LoadEX.src, gsOff)) {
+            *gsLen = i->Ain.LoadEX.szSmall;
+            return True;
+         }
+         return False;
+      case Ain_SseLdSt:
+         if (i->Ain.SseLdSt.isLoad
+             && isGuestStateAMode(i->Ain.SseLdSt.addr, gsOff)) {
+            *gsLen = i->Ain.SseLdSt.sz;
+            return True;
+         }
+         return False;
+      case Ain_SseLdzLO:
+         if (isGuestStateAMode(i->Ain.SseLdzLO.addr, gsOff)) {
+            *gsLen = i->Ain.SseLdzLO.sz;
+            return True;
+         }
+         return False;
+      case Ain_AvxLdSt:
+         if (i->Ain.AvxLdSt.isLoad
+             && isGuestStateAMode(i->Ain.AvxLdSt.addr, gsOff)) {
+            *gsLen = 32;
+            return True;
+         }
+         return False;
+      default:
+         return False;
+   }
+}
+
+AMD64Instr* genRemat_AMD64 ( const AMD64Instr* i, HReg to )
+{
+   switch (i->tag) {
+      case Ain_Imm64:
+         return AMD64Instr_Imm64(i->Ain.Imm64.imm64, to);
+      case Ain_Alu64R: {
+         const AMD64RMI* src = i->Ain.Alu64R.src;
+         return AMD64Instr_Alu64R(
+                   Aalu_MOV,
+                   src->tag == Armi_Imm
+                      ? AMD64RMI_Imm(src->Armi.Imm.imm32)
+                      : AMD64RMI_Mem(dopyAMD64AMode(src->Armi.Mem.am)),
+                   to);
+      }
+      case Ain_LoadEX:
+         return AMD64Instr_LoadEX(i->Ain.LoadEX.szSmall, i->Ain.LoadEX.syned,
+                                  dopyAMD64AMode(i->Ain.LoadEX.src), to);
+      case Ain_SseLdSt:
+         return AMD64Instr_SseLdSt(True/*load*/, i->Ain.SseLdSt.sz, to,
+                                   dopyAMD64AMode(i->Ain.SseLdSt.addr));
+      case Ain_SseLdzLO:
+         return AMD64Instr_SseLdzLO(i->Ain.SseLdzLO.sz, to,
+                                    dopyAMD64AMode(i->Ain.SseLdzLO.addr));
+      case Ain_AvxLdSt:
+         return AMD64Instr_AvxLdSt(True/*load*/, to,
+                                   dopyAMD64AMode(i->Ain.AvxLdSt.addr));
+      default:
+         ppAMD64Instr(i, True);
+         vpanic("genRemat_AMD64");
+   }
+}
+
+/* Instructions not listed here do not write memory at all, except for
+   Push, which only writes the stack. */
+Bool writesGuestState_AMD64 ( const AMD64Instr* i, /*OUT*/Int* off,
+                              /*OUT*/Int* len )
+{
+   const AMD64AMode* am;
+   Int szB;
+   switch (i->tag) {
+      case Ain_Alu64M:
+         am = i->Ain.Alu64M.dst; szB = 8; break;
+      case Ain_Store:
+         am = i->Ain.Store.dst; szB = i->Ain.Store.sz; break;
+      case Ain_CStore:
+         am = i->Ain.CStore.addr; szB = i->Ain.CStore.szB; break;
+      case Ain_ACAS:
+         am = i->Ain.ACAS.addr; szB = i->Ain.ACAS.sz; break;
+      case Ain_DACAS:
+         am = i->Ain.DACAS.addr; szB = 2 * i->Ain.DACAS.sz; break;
+      case Ain_A87PushPop:
+         if (i->Ain.A87PushPop.isPush)
+            return False;
+         am = i->Ain.A87PushPop.addr; szB = i->Ain.A87PushPop.szB; break;
+      case Ain_A87StSW:
+         am = i->Ain.A87StSW.addr; szB = 2; break;
+      case Ain_SseLdSt:
+         if (i->Ain.SseLdSt.isLoad)
+            return False;
+         am = i->Ain.SseLdSt.addr; szB = i->Ain.SseLdSt.sz; break;
+      case Ain_SseCStore:
+         am = i->Ain.SseCStore.addr; szB = 16; break;
+      case Ain_AvxLdSt:
+         if (i->Ain.AvxLdSt.isLoad)
+            return False;
+         am = i->Ain.AvxLdSt.addr; szB = 32; break;
+      case Ain_XDirect:
+         am = i->Ain.XDirect.amRIP; szB = 8; break;
+      case Ain_XIndir:
+         am = i->Ain.XIndir.amRIP; szB = 8; break;
+      case Ain_XAssisted:
+         am = i->Ain.XAssisted.amRIP; szB = 8; break;
+      case Ain_Call:
+      case Ain_EvCheck:
+         /* Helpers may be passed the guest state pointer. */
+         *len = 0;
+         return True;
+      default:
+         return False;
+   }
+   if (isGuestStateAMode(am, off)) {
+      *len = szB;
+      return True;
+   }
+   if (am->tag == Aam_IRRS && sameHReg(am->Aam.IRRS.base, hregAMD64_RBP())) {
+      /* An indexed guest state access: which bytes is not known. */
+      *len = 0;
+      return True;
+   }
+   return False;
+}
+
+
+/* Peephole rewrites of register allocated code.  None of them changes
+   %rflags: the instructions removed are moves, which do not set it, and
+   the ones rewritten compute the same values as before. */
+
+static inline Bool isDeadAfter ( HReg r, ULong deadAfter )
+{
+   return toBool((deadAfter >> hregIndex(r)) & 1);
+}
+
+static Bool amodeMentions ( const AMD64AMode* am, HReg r )
+{
+   switch (am->tag) {
+      case Aam_IR:
+         return sameHReg(am->Aam.IR.reg, r);
+      case Aam_IRRS:
+         return sameHReg(am->Aam.IRRS.base, r)
+                || sameHReg(am->Aam.IRRS.index, r);
+      default:
+         vpanic("amodeMentions(amd64)");
+   }
+}
+
+static Bool sameGuestStateAMode ( const AMD64AMode* am1,
+                                  const AMD64AMode* am2 )
+{
+   Int off1, off2;
+   return isGuestStateAMode(am1, &off1) && isGuestStateAMode(am2, &off2)
+          && off1 == off2;
+}
+
+/* Is |i| a 64-bit reg-reg move?  If so, its source and destination. */
+static Bool isMove64 ( const AMD64Instr* i, /*OUT*/HReg* src, /*OUT*/HReg* dst )
+{
+   if (i->tag == Ain_Alu64R && i->Ain.Alu64R.op == Aalu_MOV
+       && i->Ain.Alu64R.src->tag == Armi_Reg) {
+      *src = i->Ain.Alu64R.src->Armi.Reg.reg;
+      *dst = i->Ain.Alu64R.dst;
+      return True;
+   }
+   return False;
+}
+
+/* Does |i| set register |r| to a constant which fits in a sign-extended
+   32-bit immediate?  If so, that constant. */
+static Bool isSmallConst ( const AMD64Instr* i, HReg r, /*OUT*/UInt* imm32 )
+{
+   if (i->tag == Ain_Alu64R && i->Ain.Alu64R.op == Aalu_MOV
+       && i->Ain.Alu64R.src->tag == Armi_Imm
+       && sameHReg(i->Ain.Alu64R.dst, r)) {
+      *imm32 = i->Ain.Alu64R.src->Armi.Imm.imm32;
+      return True;
+   }
+   if (i->tag == Ain_Imm64 && sameHReg(i->Ain.Imm64.dst, r)) {
+      ULong w64 = i->Ain.Imm64.imm64;
+      if (w64 == (ULong)(Long)(Int)(UInt)w64) {
+         *imm32 = (UInt)w64;
+         return True;
+      }
+   }
+   return False;
+}
+
+/* Does |i| leave the top 32 bits of register |r| zero? */
+static Bool zeroesTop32 ( const AMD64Instr* i, HReg r )
+{
+   switch (i->tag) {
+      case Ain_LoadEX:
+         return !i->Ain.LoadEX.syned && sameHReg(i->Ain.LoadEX.dst, r);
+      case Ain_MovxLQ:
+         return !i->Ain.MovxLQ.syned && sameHReg(i->Ain.MovxLQ.dst, r);
+      case Ain_Alu32R:
+         return i->Ain.Alu32R.op != Aalu_CMP
+                && sameHReg(i->Ain.Alu32R.dst, r);
+      case Ain_Set64:
+         return sameHReg(i->Ain.Set64.dst, r);
+      default:
+         return False;
+   }
+}
+
+/* Rewrites the last instruction |last| so that it reads |newSrc|
+   instead of |r|.  |newSrc| is a register or a constant.  Returns NULL
+   if that is not possible. */
+static AMD64Instr* forwardInto ( const AMD64Instr* last, HReg r,
+                                 const AMD64RMI* newSrc )
+{
+   switch (last->tag) {
+      case Ain_Alu64R:
+         if (last->Ain.Alu64R.src->tag != Armi_Reg
+             || !sameHReg(last->Ain.Alu64R.src->Armi.Reg.reg, r)
+             || sameHReg(last->Ain.Alu64R.dst, r))
+            return NULL;
+         switch (last->Ain.Alu64R.op) {
+            case Aalu_MOV: case Aalu_CMP: case Aalu_ADD: case Aalu_SUB:
+            case Aalu_AND: case Aalu_OR: case Aalu_XOR:
+               break;
+            default:
+               if (newSrc->tag != Armi_Reg)
+                  return NULL;
+         }
+         return AMD64Instr_Alu64R(last->Ain.Alu64R.op,
+                                  newSrc->tag == Armi_Reg
+                                     ? AMD64RMI_Reg(newSrc->Armi.Reg.reg)
+                                     : AMD64RMI_Imm(newSrc->Armi.Imm.imm32),
+                                  last->Ain.Alu64R.dst);
+      case Ain_Alu64M:
+         if (last->Ain.Alu64M.op != Aalu_MOV
+             || last->Ain.Alu64M.src->tag != Ari_Reg
+             || !sameHReg(last->Ain.Alu64M.src->Ari.Reg.reg, r)
+             || amodeMentions(last->Ain.Alu64M.dst, r))
+            return NULL;
+         return AMD64Instr_Alu64M(Aalu_MOV,
+                                  newSrc->tag == Armi_Reg
+                                     ? AMD64RI_Reg(newSrc->Armi.Reg.reg)
+                                     : AMD64RI_Imm(newSrc->Armi.Imm.imm32),
+                                  last->Ain.Alu64M.dst);
+      case Ain_Store:
+         if (newSrc->tag != Armi_Reg
+             || !sameHReg(last->Ain.Store.src, r)
+             || amodeMentions(last->Ain.Store.dst, r))
+            return NULL;
+         return AMD64Instr_Store(last->Ain.Store.sz, newSrc->Armi.Reg.reg,
+                                 last->Ain.Store.dst);
+      default:
+         return NULL;
+   }
+}
+
+/* Is this a guest PC marker?  If so, which guest insn does it start? */
+Bool isPCMark_AMD64 ( const AMD64Instr* i, /*OUT*/Addr* guest_pc )
+{
+   if (i->tag != Ain_PCMark)
+      return False;
+   *guest_pc = (Addr)i->Ain.PCMark.guest_pc;
+   return True;
+}
+
+Bool peephole_AMD64 ( AMD64Instr** tail, /*MOD*/Int* n_tail,
+                      ULong deadAfter, /*MOD*/PeepholeStats* stats )
+{
+   Int         n    = *n_tail;
+   AMD64Instr* last = tail[n-1];
+   AMD64Instr* prev = n >= 2 ? tail[n-2] : NULL;
+   HReg        src, dst;
+   UInt        imm32;
+
+   /* movq %r,%r  ==>  nothing */
+   if ((isMove64(last, &src, &dst) && sameHReg(src, dst))
+       || (last->tag == Ain_SseReRg && last->Ain.SseReRg.op == Asse_MOV
+           && sameHReg(last->Ain.SseReRg.src, last->Ain.SseReRg.dst))) {
+      *n_tail = n - 1;
+      stats->n_self_moves++;
+      return True;
+   }
+
+   if (prev == NULL)
+      return False;
+
+   /* movq %a,off(%rbp) ; movq off(%rbp),%b  ==>
+      movq %a,off(%rbp) ; movq %a,%b   (or nothing, if a == b) */
+   if (prev->tag == Ain_Alu64M && prev->Ain.Alu64M.op == Aalu_MOV
+       && prev->Ain.Alu64M.src->tag == Ari_Reg
+       && last->tag == Ain_Alu64R && last->Ain.Alu64R.op == Aalu_MOV
+       && last->Ain.Alu64R.src->tag == Armi_Mem
+       && sameGuestStateAMode(prev->Ain.Alu64M.dst,
+                              last->Ain.Alu64R.src->Armi.Mem.am)) {
+      src = prev->Ain.Alu64M.src->Ari.Reg.reg;
+      if (sameHReg(src, last->Ain.Alu64R.dst))
+         *n_tail = n - 1;
+      else
+         tail[n-1] = AMD64Instr_Alu64R(Aalu_MOV, AMD64RMI_Reg(src),
+                                       last->Ain.Alu64R.dst);
+      stats->n_reload_fwds++;
+      return True;
+   }
+   if (prev->tag == Ain_SseLdSt && !prev->Ain.SseLdSt.isLoad
+       && prev->Ain.SseLdSt.sz == 16
+       && last->tag == Ain_SseLdSt && last->Ain.SseLdSt.isLoad
+       && last->Ain.SseLdSt.sz == 16
+       && sameGuestStateAMode(prev->Ain.SseLdSt.addr,
+                              last->Ain.SseLdSt.addr)) {
+      src = prev->Ain.SseLdSt.reg;
+      if (sameHReg(src, last->Ain.SseLdSt.reg))
+         *n_tail = n - 1;
+      else
+         tail[n-1] = AMD64Instr_SseReRg(Asse_MOV, src, last->Ain.SseLdSt.reg);
+      stats->n_reload_fwds++;
+      return True;
+   }
+
+   /* movq %s,%t ; op %t,x  ==>  op %s,x   (if t is dead afterwards) */
+   if (isMove64(prev, &src, &dst) && isDeadAfter(dst, deadAfter)) {
+      AMD64Instr* fwd = forwardInto(last, dst, AMD64RMI_Reg(src));
+      if (fwd != NULL) {
+         tail[n-2] = fwd;
+         *n_tail = n - 1;
+         stats->n_copy_fwds++;
+         return True;
+      }
+   }
+
+   /* movq $imm,%t ; op %t,x  ==>  op $imm,x   (if t is dead afterwards) */
+   if ((prev->tag == Ain_Alu64R || prev->tag == Ain_Imm64)) {
+      dst = prev->tag == Ain_Alu64R ? prev->Ain.Alu64R.dst
+                                    : prev->Ain.Imm64.dst;
+      if (isSmallConst(prev, dst, &imm32) && isDeadAfter(dst, deadAfter)) {
+         AMD64Instr* fwd = forwardInto(last, dst, AMD64RMI_Imm(imm32));
+         if (fwd != NULL) {
+            tail[n-2] = fwd;
+            *n_tail = n - 1;
+            stats->n_imm_fwds++;
+            return True;
+         }
+      }
+   }
+
+   /* movl x,%t ; movzlq %t,%d  ==>  movl x,%d   (if t is dead afterwards,
+      or t == d) */
+   if (last->tag == Ain_MovxLQ && !last->Ain.MovxLQ.syned) {
+      src = last->Ain.MovxLQ.src;
+      dst = last->Ain.MovxLQ.dst;
+      if (zeroesTop32(prev, src)) {
+         if (sameHReg(src, dst)) {
+            *n_tail = n - 1;
+            stats->n_zext_folds++;
+            return True;
+         }
+         if (isDeadAfter(src, deadAfter)) {
+            if (prev->tag == Ain_LoadEX) {
+               tail[n-2] = AMD64Instr_LoadEX(prev->Ain.LoadEX.szSmall, False,
+                                             prev->Ain.LoadEX.src, dst);
+               *n_tail = n - 1;
+               stats->n_zext_folds++;
+               return True;
+            }
+            if (prev->tag == Ain_MovxLQ) {
+               tail[n-2] = AMD64Instr_MovxLQ(False, prev->Ain.MovxLQ.src, dst);
+               *n_tail = n - 1;
+               stats->n_zext_folds++;
+               return True;
+            }
+         }
+      }
+   }
+
+   return False;
+}
+
+
 /* --------- The amd64 assembler (bleh.) --------- */
 
 /* Produce the low three bits of an integer register number. */
@@ -2073,6 +2727,17 @@ inline static UInt vregEnc3210 ( HReg r )
    return n;
 }
 
+/* Produce a complete 4-bit 256-bit-vector register number. */
+inline static UInt dvregEnc3210 ( HReg r )
+{
+   UInt n;
+   vassert(hregClass(r) == HRcVec256);
+   vassert(!hregIsVirtual(r));
+   n = hregEncoding(r);
+   vassert(n <= 15);
+   return n;
+}
+
 inline static UChar mkModRegRM ( UInt mod, UInt reg, UInt regmem )
 {
    vassert(mod < 4);
@@ -2254,12 +2919,6 @@ static UChar* doAMode_R_enc_reg ( UChar* p, UInt gregEnc3210, HReg ereg )
    return doAMode_R__wrk(p, gregEnc3210, iregEnc3210(ereg));
 }
 
-static UChar* doAMode_R_reg_enc ( UChar* p, HReg greg, UInt eregEnc3210 )
-{
-   vassert(eregEnc3210 < 16);
-   return doAMode_R__wrk(p, iregEnc3210(greg), eregEnc3210);
-}
-
 static UChar* doAMode_R_enc_enc ( UChar* p, UInt gregEnc3210, UInt eregEnc3210 )
 {
    vassert( (gregEnc3210|eregEnc3210) < 16);
@@ -2329,12 +2988,6 @@ static UChar rexAMode_R_enc_reg ( UInt gregEnc3210, HReg ereg )
    return rexAMode_R__wrk(gregEnc3210, iregEnc3210(ereg));
 }
 
-static UChar rexAMode_R_reg_enc ( HReg greg, UInt eregEnc3210 )
-{
-   vassert(eregEnc3210 < 16);
-   return rexAMode_R__wrk(iregEnc3210(greg), eregEnc3210);
-}
-
 static UChar rexAMode_R_enc_enc ( UInt gregEnc3210, UInt eregEnc3210 )
 {
    vassert((gregEnc3210|eregEnc3210) < 16);
@@ -2342,85 +2995,95 @@ static UChar rexAMode_R_enc_enc ( UInt gregEnc3210, UInt eregEnc3210 )
 }
 
 
-//uu /* May 2012: this VEX prefix stuff is currently unused, but has
-//uu    verified correct (I reckon).  Certainly it has been known to
-//uu    produce correct VEX prefixes during testing. */
-//uu 
-//uu /* Assemble a 2 or 3 byte VEX prefix from parts.  rexR, rexX, rexB and
-//uu    notVvvvv need to be not-ed before packing.  mmmmm, rexW, L and pp go
-//uu    in verbatim.  There's no range checking on the bits. */
-//uu static UInt packVexPrefix ( UInt rexR, UInt rexX, UInt rexB,
-//uu                             UInt mmmmm, UInt rexW, UInt notVvvv,
-//uu                             UInt L, UInt pp )
-//uu {
-//uu    UChar byte0 = 0;
-//uu    UChar byte1 = 0;
-//uu    UChar byte2 = 0;
-//uu    if (rexX == 0 && rexB == 0 && mmmmm == 1 && rexW == 0) {
-//uu       /* 2 byte encoding is possible. */
-//uu       byte0 = 0xC5;
-//uu       byte1 = ((rexR ^ 1) << 7) | ((notVvvv ^ 0xF) << 3) 
-//uu               | (L << 2) | pp;
-//uu    } else {
-//uu       /* 3 byte encoding is needed. */
-//uu       byte0 = 0xC4;
-//uu       byte1 = ((rexR ^ 1) << 7) | ((rexX ^ 1) << 6)
-//uu               | ((rexB ^ 1) << 5) | mmmmm;
-//uu       byte2 = (rexW << 7) | ((notVvvv ^ 0xF) << 3) | (L << 2) | pp;
-//uu    }
-//uu    return (((UInt)byte2) << 16) | (((UInt)byte1) << 8) | ((UInt)byte0);
-//uu }
-//uu 
-//uu /* Make up a VEX prefix for a (greg,amode) pair.  First byte in bits
-//uu    7:0 of result, second in 15:8, third (for a 3 byte prefix) in
-//uu    23:16.  Has m-mmmm set to indicate a prefix of 0F, pp set to
-//uu    indicate no SIMD prefix, W=0 (ignore), L=1 (size=256), and
-//uu    vvvv=1111 (unused 3rd reg). */
-//uu static UInt vexAMode_M ( HReg greg, AMD64AMode* am )
-//uu {
-//uu    UChar L       = 1; /* size = 256 */
-//uu    UChar pp      = 0; /* no SIMD prefix */
-//uu    UChar mmmmm   = 1; /* 0F */
-//uu    UChar notVvvv = 0; /* unused */
-//uu    UChar rexW    = 0;
-//uu    UChar rexR    = 0;
-//uu    UChar rexX    = 0;
-//uu    UChar rexB    = 0;
-//uu    /* Same logic as in rexAMode_M. */
-//uu    if (am->tag == Aam_IR) {
-//uu       rexR = iregEnc3(greg);
-//uu       rexX = 0; /* not relevant */
-//uu       rexB = iregEnc3(am->Aam.IR.reg);
-//uu    }
-//uu    else if (am->tag == Aam_IRRS) {
-//uu       rexR = iregEnc3(greg);
-//uu       rexX = iregEnc3(am->Aam.IRRS.index);
-//uu       rexB = iregEnc3(am->Aam.IRRS.base);
-//uu    } else {
-//uu       vassert(0);
-//uu    }
-//uu    return packVexPrefix( rexR, rexX, rexB, mmmmm, rexW, notVvvv, L, pp );
-//uu }
-//uu 
-//uu static UChar* emitVexPrefix ( UChar* p, UInt vex )
-//uu {
-//uu    switch (vex & 0xFF) {
-//uu       case 0xC5:
-//uu          *p++ = 0xC5;
-//uu          *p++ = (vex >> 8) & 0xFF;
-//uu          vassert(0 == (vex >> 16));
-//uu          break;
-//uu       case 0xC4:
-//uu          *p++ = 0xC4;
-//uu          *p++ = (vex >> 8) & 0xFF;
-//uu          *p++ = (vex >> 16) & 0xFF;
-//uu          vassert(0 == (vex >> 24));
-//uu          break;
-//uu       default:
-//uu          vassert(0);
-//uu    }
-//uu    return p;
-//uu }
+/* Assemble a 2 or 3 byte VEX prefix from parts, and emit it.  rexR,
+   rexX and rexB are the REX bits for the ModRM/SIB registers and vvvv
+   is the number of the extra source register (0 if unused); these
+   are inverted when packed.  mmmmm (1 = 0F, 2 = 0F38, 3 = 0F3A), rexW,
+   L (1 = 256 bits) and pp (0 = none, 1 = 66, 2 = F3, 3 = F2) go in
+   verbatim. */
+static UChar* emitVexPrefix ( UChar* p, UInt rexR, UInt rexX, UInt rexB,
+                              UInt mmmmm, UInt rexW, UInt vvvv,
+                              UInt L, UInt pp )
+{
+   vassert((rexR|rexX|rexB|rexW|L) <= 1);
+   vassert(mmmmm >= 1 && mmmmm <= 3);
+   vassert(vvvv <= 15 && pp <= 3);
+   if (rexX == 0 && rexB == 0 && mmmmm == 1 && rexW == 0) {
+      /* 2 byte encoding is possible. */
+      *p++ = 0xC5;
+      *p++ = toUChar(((rexR ^ 1) << 7) | ((vvvv ^ 0xF) << 3)
+                     | (L << 2) | pp);
+   } else {
+      /* 3 byte encoding is needed. */
+      *p++ = 0xC4;
+      *p++ = toUChar(((rexR ^ 1) << 7) | ((rexX ^ 1) << 6)
+                     | ((rexB ^ 1) << 5) | mmmmm);
+      *p++ = toUChar((rexW << 7) | ((vvvv ^ 0xF) << 3) | (L << 2) | pp);
+   }
+   return p;
+}
+
+/* Emit a VEX-encoded (W=0) reg-reg instruction: prefix, opcode and
+   ModRM, with the given register numbers in the ModRM reg and rm
+   fields and in VEX.vvvv. */
+static UChar* emitVexRR ( UChar* p, UInt mmmmm, UInt pp, UInt L, UInt opc,
+                          UInt gregEnc3210, UInt vvvv, UInt eregEnc3210 )
+{
+   p = emitVexPrefix(p, (gregEnc3210 >> 3) & 1, 0, (eregEnc3210 >> 3) & 1,
+                        mmmmm, 0, vvvv, L, pp);
+   *p++ = toUChar(opc);
+   return doAMode_R_enc_enc(p, gregEnc3210, eregEnc3210);
+}
+
+/* Same, but for a (greg,amode) pair. */
+static UChar* emitVexRM ( UChar* p, UInt mmmmm, UInt pp, UInt L, UInt opc,
+                          UInt gregEnc3210, UInt vvvv, AMD64AMode* am )
+{
+   UChar rex = rexAMode_M_enc(gregEnc3210, am);
+   p = emitVexPrefix(p, (rex >> 2) & 1, (rex >> 1) & 1, rex & 1,
+                        mmmmm, 0, vvvv, L, pp);
+   *p++ = toUChar(opc);
+   return doAMode_M_enc(p, gregEnc3210, am);
+}
+
+/* Emit a 0F-map SSE instruction with register operands.  pp is the
+   mandatory prefix, coded as for VEX.pp, and rexW the REX.W bit.  If
+   the host has AVX2 the VEX.128 form is used instead of the legacy
+   one, since legacy SSE code mixed with the 256-bit code of a block
+   pays for AVX/SSE transitions.  vvvv is then the extra VEX source:
+   the destination for the ops that merge into it, 0 for the rest. */
+static UChar* emitSseRR ( UChar* p, UInt pp, UInt rexW, UInt opc,
+                          UInt gregEnc3210, UInt vvvv, UInt eregEnc3210 )
+{
+   if (amd64_host_has_avx2) {
+      p = emitVexPrefix(p, (gregEnc3210 >> 3) & 1, 0,
+                           (eregEnc3210 >> 3) & 1, 1/*0F*/, rexW, vvvv,
+                           0/*128 bits*/, pp);
+   } else {
+      UChar rex = rexAMode_R_enc_enc(gregEnc3210, eregEnc3210);
+      if (pp > 0)
+         *p++ = toUChar(pp == 1 ? 0x66 : (pp == 2 ? 0xF3 : 0xF2));
+      *p++ = rexW ? rex : clearWBit(rex);
+      *p++ = 0x0F;
+   }
+   *p++ = toUChar(opc);
+   return doAMode_R_enc_enc(p, gregEnc3210, eregEnc3210);
+}
+
+/* Same, but for a (greg,amode) pair, and always with REX.W clear. */
+static UChar* emitSseRM ( UChar* p, UInt pp, UInt opc,
+                          UInt gregEnc3210, UInt vvvv, AMD64AMode* am )
+{
+   if (amd64_host_has_avx2)
+      return emitVexRM(p, 1/*0F*/, pp, 0/*128 bits*/, opc,
+                       gregEnc3210, vvvv, am);
+   if (pp > 0)
+      *p++ = toUChar(pp == 1 ? 0x66 : (pp == 2 ? 0xF3 : 0xF2));
+   *p++ = clearWBit(rexAMode_M_enc(gregEnc3210, am));
+   *p++ = 0x0F;
+   *p++ = toUChar(opc);
+   return doAMode_M_enc(p, gregEnc3210, am);
+}
 
 
 /* Emit ffree %st(N) */
@@ -2436,9 +3099,11 @@ static UChar* do_ffree_st ( UChar* p, Int n )
    Note that buf is not the insn's final place, and therefore it is
    imperative to emit position-independent code.  If the emitted
    instruction was a profiler inc, set *is_profInc to True, else
-   leave it unchanged. */
+   leave it unchanged.  Rarely executed code may be put in the cold
+   area |cold| instead, if it is not NULL. */
 
 Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
+                      /*MB_MOD*/ColdCode* cold,
                       UChar* buf, Int nbuf, const AMD64Instr* i, 
                       Bool mode64, VexEndness endness_host,
                       const void* disp_cp_chain_me_to_slowEP,
@@ -2866,6 +3531,55 @@ Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
    case Ain_Call: {
       /* As per detailed comment for Ain_Call in getRegUsage_AMD64Instr
          above, %r11 is used as an address temporary. */
+      /* A conditional call which rarely happens, and with no fixup
+         actions, is moved out of line, if there is room for it.  The
+         hot path is then just a not-taken branch:
+               j{cond} stub                  (6 bytes)
+            back:
+         and the stub, in the cold area, is
+            stub:
+               movabsq $target, %r11         (7 or 10 bytes)
+               call* %r11                    (3 bytes)
+               jmp back                      (5 bytes)
+         Both branch displacements are fixed up later, by
+         resolveColdBranch_AMD64. */
+      if (i->Ain.Call.cold
+          && i->Ain.Call.cond != Acc_ALWAYS
+          && i->Ain.Call.rloc.pri == RLPri_None
+          && hasRoomColdCode(cold, 18, 2)) {
+         Int    stub = cold->used;
+         UChar* c    = &cold->buf[stub];
+         //   j{cond} stub
+         addColdFixup(cold, False/*atCold*/, cold->hot_base + (p - buf), stub);
+         *p++ = 0x0F;
+         *p++ = toUChar(0x80 + (0xF & i->Ain.Call.cond));
+         p = emit32(p, 0);
+         // stub:
+         if (fitsIn32Bits(i->Ain.Call.target)) {
+            //   movl sign-extend(imm32), %r11
+            *c++ = 0x49;
+            *c++ = 0xC7;
+            *c++ = 0xC3;
+            c = emit32(c, (UInt)i->Ain.Call.target);
+         } else {
+            //   movabsq $target, %r11
+            *c++ = 0x49;
+            *c++ = 0xBB;
+            c = emit64(c, i->Ain.Call.target);
+         }
+         //   call* %r11
+         *c++ = 0x41;
+         *c++ = 0xFF;
+         *c++ = 0xD3;
+         //   jmp back
+         addColdFixup(cold, True/*atCold*/, c - cold->buf,
+                      cold->hot_base + (p - buf));
+         *c++ = 0xE9;
+         c = emit32(c, 0);
+         cold->used = c - cold->buf;
+         vassert(cold->used <= N_COLDCODE_BYTES);
+         goto done;
+      }
       /* If we don't need to do any fixup actions in the case that the
          call doesn't happen, just do the simple thing and emit
          straight-line code.  This is usually the case. */
@@ -3483,19 +4197,13 @@ Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
    case Ain_SseUComIS:
       /* ucomi[sd] %srcL, %srcR ;  pushfq ; popq %dst */
       /* ucomi[sd] %srcL, %srcR */
-      if (i->Ain.SseUComIS.sz == 8) {
-         *p++ = 0x66;
-      } else {
+      if (i->Ain.SseUComIS.sz != 8) {
          goto bad;
          vassert(i->Ain.SseUComIS.sz == 4);
       }
-      *p++ = clearWBit (
-             rexAMode_R_enc_enc( vregEnc3210(i->Ain.SseUComIS.srcL),
-                                 vregEnc3210(i->Ain.SseUComIS.srcR) ));
-      *p++ = 0x0F;
-      *p++ = 0x2E;
-      p = doAMode_R_enc_enc(p, vregEnc3210(i->Ain.SseUComIS.srcL),
-                               vregEnc3210(i->Ain.SseUComIS.srcR) );
+      p = emitSseRR(p, 1/*66*/, 0, 0x2E,
+                    vregEnc3210(i->Ain.SseUComIS.srcL), 0,
+                    vregEnc3210(i->Ain.SseUComIS.srcR));
       /* pushfq */
       *p++ = 0x9C;
       /* popq %dst */
@@ -3505,57 +4213,42 @@ Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
 
    case Ain_SseSI2SF:
       /* cvssi2s[sd] %src, %dst */
-      rex = rexAMode_R_enc_reg( vregEnc3210(i->Ain.SseSI2SF.dst),
-                                i->Ain.SseSI2SF.src );
-      *p++ = toUChar(i->Ain.SseSI2SF.szD==4 ? 0xF3 : 0xF2);
-      *p++ = toUChar(i->Ain.SseSI2SF.szS==4 ? clearWBit(rex) : rex);
-      *p++ = 0x0F;
-      *p++ = 0x2A;
-      p = doAMode_R_enc_reg( p, vregEnc3210(i->Ain.SseSI2SF.dst),
-                                i->Ain.SseSI2SF.src );
+      p = emitSseRR(p, i->Ain.SseSI2SF.szD==4 ? 2/*F3*/ : 3/*F2*/,
+                    i->Ain.SseSI2SF.szS==4 ? 0 : 1, 0x2A,
+                    vregEnc3210(i->Ain.SseSI2SF.dst),
+                    vregEnc3210(i->Ain.SseSI2SF.dst),
+                    iregEnc3210(i->Ain.SseSI2SF.src));
       goto done;
 
    case Ain_SseSF2SI:
       /* cvss[sd]2si %src, %dst */
-      rex = rexAMode_R_reg_enc( i->Ain.SseSF2SI.dst,
-                                vregEnc3210(i->Ain.SseSF2SI.src) );
-      *p++ = toUChar(i->Ain.SseSF2SI.szS==4 ? 0xF3 : 0xF2);
-      *p++ = toUChar(i->Ain.SseSF2SI.szD==4 ? clearWBit(rex) : rex);
-      *p++ = 0x0F;
-      *p++ = 0x2D;
-      p = doAMode_R_reg_enc( p, i->Ain.SseSF2SI.dst,
-                                vregEnc3210(i->Ain.SseSF2SI.src) );
+      p = emitSseRR(p, i->Ain.SseSF2SI.szS==4 ? 2/*F3*/ : 3/*F2*/,
+                    i->Ain.SseSF2SI.szD==4 ? 0 : 1, 0x2D,
+                    iregEnc3210(i->Ain.SseSF2SI.dst), 0,
+                    vregEnc3210(i->Ain.SseSF2SI.src));
       goto done;
 
    case Ain_SseSDSS:
       /* cvtsd2ss/cvtss2sd %src, %dst */
-      *p++ = toUChar(i->Ain.SseSDSS.from64 ? 0xF2 : 0xF3);
-      *p++ = clearWBit(
-              rexAMode_R_enc_enc( vregEnc3210(i->Ain.SseSDSS.dst),
-                                  vregEnc3210(i->Ain.SseSDSS.src) ));
-      *p++ = 0x0F;
-      *p++ = 0x5A;
-      p = doAMode_R_enc_enc( p, vregEnc3210(i->Ain.SseSDSS.dst),
-                                vregEnc3210(i->Ain.SseSDSS.src) );
+      p = emitSseRR(p, i->Ain.SseSDSS.from64 ? 3/*F2*/ : 2/*F3*/, 0, 0x5A,
+                    vregEnc3210(i->Ain.SseSDSS.dst),
+                    vregEnc3210(i->Ain.SseSDSS.dst),
+                    vregEnc3210(i->Ain.SseSDSS.src));
       goto done;
 
    case Ain_SseLdSt:
       if (i->Ain.SseLdSt.sz == 8) {
-         *p++ = 0xF2;
+         xtra = 3/*F2*/;
       } else
       if (i->Ain.SseLdSt.sz == 4) {
-         *p++ = 0xF3;
-      } else
-      if (i->Ain.SseLdSt.sz != 16) {
-         vassert(0);
+         xtra = 2/*F3*/;
+      } else {
+         vassert(i->Ain.SseLdSt.sz == 16);
+         xtra = 0;
       }
-      *p++ = clearWBit(
-             rexAMode_M_enc(vregEnc3210(i->Ain.SseLdSt.reg),
-                            i->Ain.SseLdSt.addr));
-      *p++ = 0x0F; 
-      *p++ = toUChar(i->Ain.SseLdSt.isLoad ? 0x10 : 0x11);
-      p = doAMode_M_enc(p, vregEnc3210(i->Ain.SseLdSt.reg),
-                           i->Ain.SseLdSt.addr);
+      p = emitSseRM(p, xtra, i->Ain.SseLdSt.isLoad ? 0x10 : 0x11,
+                    vregEnc3210(i->Ain.SseLdSt.reg), 0,
+                    i->Ain.SseLdSt.addr);
       goto done;
 
    case Ain_SseCStore: {
@@ -3570,13 +4263,8 @@ Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
       *p++ = 0; /* # of bytes to jump over; don't know how many yet. */
 
       /* Now the store. */
-      *p++ = clearWBit(
-             rexAMode_M_enc(vregEnc3210(i->Ain.SseCStore.src),
-                            i->Ain.SseCStore.addr));
-      *p++ = 0x0F; 
-      *p++ = toUChar(0x11);
-      p = doAMode_M_enc(p, vregEnc3210(i->Ain.SseCStore.src),
-                           i->Ain.SseCStore.addr);
+      p = emitSseRM(p, 0, 0x11, vregEnc3210(i->Ain.SseCStore.src), 0,
+                    i->Ain.SseCStore.addr);
 
       /* Fix up the conditional branch */
       Int delta = p - ptmp;
@@ -3597,13 +4285,8 @@ Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
       *p++ = 0; /* # of bytes to jump over; don't know how many yet. */
 
       /* Now the load. */
-      *p++ = clearWBit(
-             rexAMode_M_enc(vregEnc3210(i->Ain.SseCLoad.dst),
-                            i->Ain.SseCLoad.addr));
-      *p++ = 0x0F; 
-      *p++ = toUChar(0x10);
-      p = doAMode_M_enc(p, vregEnc3210(i->Ain.SseCLoad.dst),
-                           i->Ain.SseCLoad.addr);
+      p = emitSseRM(p, 0, 0x10, vregEnc3210(i->Ain.SseCLoad.dst), 0,
+                    i->Ain.SseCLoad.addr);
 
       /* Fix up the conditional branch */
       Int delta = p - ptmp;
@@ -3615,195 +4298,172 @@ Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
    case Ain_SseLdzLO:
       vassert(i->Ain.SseLdzLO.sz == 4 || i->Ain.SseLdzLO.sz == 8);
       /* movs[sd] amode, %xmm-dst */
-      *p++ = toUChar(i->Ain.SseLdzLO.sz==4 ? 0xF3 : 0xF2);
-      *p++ = clearWBit(
-             rexAMode_M_enc(vregEnc3210(i->Ain.SseLdzLO.reg), 
-                            i->Ain.SseLdzLO.addr));
-      *p++ = 0x0F; 
-      *p++ = 0x10; 
-      p = doAMode_M_enc(p, vregEnc3210(i->Ain.SseLdzLO.reg), 
-                           i->Ain.SseLdzLO.addr);
+      p = emitSseRM(p, i->Ain.SseLdzLO.sz==4 ? 2/*F3*/ : 3/*F2*/, 0x10,
+                    vregEnc3210(i->Ain.SseLdzLO.reg), 0,
+                    i->Ain.SseLdzLO.addr);
       goto done;
 
    case Ain_Sse32Fx4:
       xtra = 0;
-      *p++ = clearWBit(
-             rexAMode_R_enc_enc( vregEnc3210(i->Ain.Sse32Fx4.dst),
-                                 vregEnc3210(i->Ain.Sse32Fx4.src) ));
-      *p++ = 0x0F;
       switch (i->Ain.Sse32Fx4.op) {
-         case Asse_ADDF:   *p++ = 0x58; break;
-         case Asse_DIVF:   *p++ = 0x5E; break;
-         case Asse_MAXF:   *p++ = 0x5F; break;
-         case Asse_MINF:   *p++ = 0x5D; break;
-         case Asse_MULF:   *p++ = 0x59; break;
-         case Asse_RCPF:   *p++ = 0x53; break;
-         case Asse_RSQRTF: *p++ = 0x52; break;
-         case Asse_SQRTF:  *p++ = 0x51; break;
-         case Asse_SUBF:   *p++ = 0x5C; break;
-         case Asse_CMPEQF: *p++ = 0xC2; xtra = 0x100; break;
-         case Asse_CMPLTF: *p++ = 0xC2; xtra = 0x101; break;
-         case Asse_CMPLEF: *p++ = 0xC2; xtra = 0x102; break;
-         case Asse_CMPUNF: *p++ = 0xC2; xtra = 0x103; break;
+         case Asse_ADDF:   opc = 0x58; break;
+         case Asse_DIVF:   opc = 0x5E; break;
+         case Asse_MAXF:   opc = 0x5F; break;
+         case Asse_MINF:   opc = 0x5D; break;
+         case Asse_MULF:   opc = 0x59; break;
+         case Asse_RCPF:   opc = 0x53; break;
+         case Asse_RSQRTF: opc = 0x52; break;
+         case Asse_SQRTF:  opc = 0x51; break;
+         case Asse_SUBF:   opc = 0x5C; break;
+         case Asse_CMPEQF: opc = 0xC2; xtra = 0x100; break;
+         case Asse_CMPLTF: opc = 0xC2; xtra = 0x101; break;
+         case Asse_CMPLEF: opc = 0xC2; xtra = 0x102; break;
+         case Asse_CMPUNF: opc = 0xC2; xtra = 0x103; break;
          default: goto bad;
       }
-      p = doAMode_R_enc_enc(p, vregEnc3210(i->Ain.Sse32Fx4.dst),
-                               vregEnc3210(i->Ain.Sse32Fx4.src) );
+      /* The unary ops take no VEX.vvvv source. */
+      p = emitSseRR(p, 0, 0, opc, vregEnc3210(i->Ain.Sse32Fx4.dst),
+                    (opc == 0x51 || opc == 0x52 || opc == 0x53)
+                       ? 0 : vregEnc3210(i->Ain.Sse32Fx4.dst),
+                    vregEnc3210(i->Ain.Sse32Fx4.src));
       if (xtra & 0x100)
          *p++ = toUChar(xtra & 0xFF);
       goto done;
 
    case Ain_Sse64Fx2:
       xtra = 0;
-      *p++ = 0x66;
-      *p++ = clearWBit(
-             rexAMode_R_enc_enc( vregEnc3210(i->Ain.Sse64Fx2.dst),
-                                 vregEnc3210(i->Ain.Sse64Fx2.src) ));
-      *p++ = 0x0F;
       switch (i->Ain.Sse64Fx2.op) {
-         case Asse_ADDF:   *p++ = 0x58; break;
-         case Asse_DIVF:   *p++ = 0x5E; break;
-         case Asse_MAXF:   *p++ = 0x5F; break;
-         case Asse_MINF:   *p++ = 0x5D; break;
-         case Asse_MULF:   *p++ = 0x59; break;
-         case Asse_SQRTF:  *p++ = 0x51; break;
-         case Asse_SUBF:   *p++ = 0x5C; break;
-         case Asse_CMPEQF: *p++ = 0xC2; xtra = 0x100; break;
-         case Asse_CMPLTF: *p++ = 0xC2; xtra = 0x101; break;
-         case Asse_CMPLEF: *p++ = 0xC2; xtra = 0x102; break;
-         case Asse_CMPUNF: *p++ = 0xC2; xtra = 0x103; break;
+         case Asse_ADDF:   opc = 0x58; break;
+         case Asse_DIVF:   opc = 0x5E; break;
+         case Asse_MAXF:   opc = 0x5F; break;
+         case Asse_MINF:   opc = 0x5D; break;
+         case Asse_MULF:   opc = 0x59; break;
+         case Asse_SQRTF:  opc = 0x51; break;
+         case Asse_SUBF:   opc = 0x5C; break;
+         case Asse_CMPEQF: opc = 0xC2; xtra = 0x100; break;
+         case Asse_CMPLTF: opc = 0xC2; xtra = 0x101; break;
+         case Asse_CMPLEF: opc = 0xC2; xtra = 0x102; break;
+         case Asse_CMPUNF: opc = 0xC2; xtra = 0x103; break;
          default: goto bad;
       }
-      p = doAMode_R_enc_enc(p, vregEnc3210(i->Ain.Sse64Fx2.dst),
-                               vregEnc3210(i->Ain.Sse64Fx2.src) );
+      /* The unary op takes no VEX.vvvv source. */
+      p = emitSseRR(p, 1/*66*/, 0, opc, vregEnc3210(i->Ain.Sse64Fx2.dst),
+                    opc == 0x51 ? 0 : vregEnc3210(i->Ain.Sse64Fx2.dst),
+                    vregEnc3210(i->Ain.Sse64Fx2.src));
       if (xtra & 0x100)
          *p++ = toUChar(xtra & 0xFF);
       goto done;
 
    case Ain_Sse32FLo:
       xtra = 0;
-      *p++ = 0xF3;
-      *p++ = clearWBit(
-             rexAMode_R_enc_enc( vregEnc3210(i->Ain.Sse32FLo.dst),
-                                 vregEnc3210(i->Ain.Sse32FLo.src) ));
-      *p++ = 0x0F;
       switch (i->Ain.Sse32FLo.op) {
-         case Asse_ADDF:   *p++ = 0x58; break;
-         case Asse_DIVF:   *p++ = 0x5E; break;
-         case Asse_MAXF:   *p++ = 0x5F; break;
-         case Asse_MINF:   *p++ = 0x5D; break;
-         case Asse_MULF:   *p++ = 0x59; break;
-         case Asse_RCPF:   *p++ = 0x53; break;
-         case Asse_RSQRTF: *p++ = 0x52; break;
-         case Asse_SQRTF:  *p++ = 0x51; break;
-         case Asse_SUBF:   *p++ = 0x5C; break;
-         case Asse_CMPEQF: *p++ = 0xC2; xtra = 0x100; break;
-         case Asse_CMPLTF: *p++ = 0xC2; xtra = 0x101; break;
-         case Asse_CMPLEF: *p++ = 0xC2; xtra = 0x102; break;
-         case Asse_CMPUNF: *p++ = 0xC2; xtra = 0x103; break;
+         case Asse_ADDF:   opc = 0x58; break;
+         case Asse_DIVF:   opc = 0x5E; break;
+         case Asse_MAXF:   opc = 0x5F; break;
+         case Asse_MINF:   opc = 0x5D; break;
+         case Asse_MULF:   opc = 0x59; break;
+         case Asse_RCPF:   opc = 0x53; break;
+         case Asse_RSQRTF: opc = 0x52; break;
+         case Asse_SQRTF:  opc = 0x51; break;
+         case Asse_SUBF:   opc = 0x5C; break;
+         case Asse_CMPEQF: opc = 0xC2; xtra = 0x100; break;
+         case Asse_CMPLTF: opc = 0xC2; xtra = 0x101; break;
+         case Asse_CMPLEF: opc = 0xC2; xtra = 0x102; break;
+         case Asse_CMPUNF: opc = 0xC2; xtra = 0x103; break;
          default: goto bad;
       }
-      p = doAMode_R_enc_enc(p, vregEnc3210(i->Ain.Sse32FLo.dst),
-                               vregEnc3210(i->Ain.Sse32FLo.src) );
+      p = emitSseRR(p, 2/*F3*/, 0, opc, vregEnc3210(i->Ain.Sse32FLo.dst),
+                    vregEnc3210(i->Ain.Sse32FLo.dst), vregEnc3210(i->Ain.Sse32FLo.src));
       if (xtra & 0x100)
          *p++ = toUChar(xtra & 0xFF);
       goto done;
 
    case Ain_Sse64FLo:
       xtra = 0;
-      *p++ = 0xF2;
-      *p++ = clearWBit(
-             rexAMode_R_enc_enc( vregEnc3210(i->Ain.Sse64FLo.dst),
-                                 vregEnc3210(i->Ain.Sse64FLo.src) ));
-      *p++ = 0x0F;
       switch (i->Ain.Sse64FLo.op) {
-         case Asse_ADDF:   *p++ = 0x58; break;
-         case Asse_DIVF:   *p++ = 0x5E; break;
-         case Asse_MAXF:   *p++ = 0x5F; break;
-         case Asse_MINF:   *p++ = 0x5D; break;
-         case Asse_MULF:   *p++ = 0x59; break;
-         case Asse_SQRTF:  *p++ = 0x51; break;
-         case Asse_SUBF:   *p++ = 0x5C; break;
-         case Asse_CMPEQF: *p++ = 0xC2; xtra = 0x100; break;
-         case Asse_CMPLTF: *p++ = 0xC2; xtra = 0x101; break;
-         case Asse_CMPLEF: *p++ = 0xC2; xtra = 0x102; break;
-         case Asse_CMPUNF: *p++ = 0xC2; xtra = 0x103; break;
+         case Asse_ADDF:   opc = 0x58; break;
+         case Asse_DIVF:   opc = 0x5E; break;
+         case Asse_MAXF:   opc = 0x5F; break;
+         case Asse_MINF:   opc = 0x5D; break;
+         case Asse_MULF:   opc = 0x59; break;
+         case Asse_SQRTF:  opc = 0x51; break;
+         case Asse_SUBF:   opc = 0x5C; break;
+         case Asse_CMPEQF: opc = 0xC2; xtra = 0x100; break;
+         case Asse_CMPLTF: opc = 0xC2; xtra = 0x101; break;
+         case Asse_CMPLEF: opc = 0xC2; xtra = 0x102; break;
+         case Asse_CMPUNF: opc = 0xC2; xtra = 0x103; break;
          default: goto bad;
       }
-      p = doAMode_R_enc_enc(p, vregEnc3210(i->Ain.Sse64FLo.dst),
-                               vregEnc3210(i->Ain.Sse64FLo.src) );
+      p = emitSseRR(p, 3/*F2*/, 0, opc, vregEnc3210(i->Ain.Sse64FLo.dst),
+                    vregEnc3210(i->Ain.Sse64FLo.dst), vregEnc3210(i->Ain.Sse64FLo.src));
       if (xtra & 0x100)
          *p++ = toUChar(xtra & 0xFF);
       goto done;
 
    case Ain_SseReRg:
-#     define XX(_n) *p++ = (_n)
-
-      rex = clearWBit(
-            rexAMode_R_enc_enc( vregEnc3210(i->Ain.SseReRg.dst),
-                                vregEnc3210(i->Ain.SseReRg.src) ));
-
       switch (i->Ain.SseReRg.op) {
-         case Asse_MOV:     /*movups*/ XX(rex); XX(0x0F); XX(0x10); break;
-         case Asse_OR:                 XX(rex); XX(0x0F); XX(0x56); break;
-         case Asse_XOR:                XX(rex); XX(0x0F); XX(0x57); break;
-         case Asse_AND:                XX(rex); XX(0x0F); XX(0x54); break;
-         case Asse_ANDN:               XX(rex); XX(0x0F); XX(0x55); break;
-         case Asse_PACKSSD:  XX(0x66); XX(rex); XX(0x0F); XX(0x6B); break;
-         case Asse_PACKSSW:  XX(0x66); XX(rex); XX(0x0F); XX(0x63); break;
-         case Asse_PACKUSW:  XX(0x66); XX(rex); XX(0x0F); XX(0x67); break;
-         case Asse_ADD8:     XX(0x66); XX(rex); XX(0x0F); XX(0xFC); break;
-         case Asse_ADD16:    XX(0x66); XX(rex); XX(0x0F); XX(0xFD); break;
-         case Asse_ADD32:    XX(0x66); XX(rex); XX(0x0F); XX(0xFE); break;
-         case Asse_ADD64:    XX(0x66); XX(rex); XX(0x0F); XX(0xD4); break;
-         case Asse_QADD8S:   XX(0x66); XX(rex); XX(0x0F); XX(0xEC); break;
-         case Asse_QADD16S:  XX(0x66); XX(rex); XX(0x0F); XX(0xED); break;
-         case Asse_QADD8U:   XX(0x66); XX(rex); XX(0x0F); XX(0xDC); break;
-         case Asse_QADD16U:  XX(0x66); XX(rex); XX(0x0F); XX(0xDD); break;
-         case Asse_AVG8U:    XX(0x66); XX(rex); XX(0x0F); XX(0xE0); break;
-         case Asse_AVG16U:   XX(0x66); XX(rex); XX(0x0F); XX(0xE3); break;
-         case Asse_CMPEQ8:   XX(0x66); XX(rex); XX(0x0F); XX(0x74); break;
-         case Asse_CMPEQ16:  XX(0x66); XX(rex); XX(0x0F); XX(0x75); break;
-         case Asse_CMPEQ32:  XX(0x66); XX(rex); XX(0x0F); XX(0x76); break;
-         case Asse_CMPGT8S:  XX(0x66); XX(rex); XX(0x0F); XX(0x64); break;
-         case Asse_CMPGT16S: XX(0x66); XX(rex); XX(0x0F); XX(0x65); break;
-         case Asse_CMPGT32S: XX(0x66); XX(rex); XX(0x0F); XX(0x66); break;
-         case Asse_MAX16S:   XX(0x66); XX(rex); XX(0x0F); XX(0xEE); break;
-         case Asse_MAX8U:    XX(0x66); XX(rex); XX(0x0F); XX(0xDE); break;
-         case Asse_MIN16S:   XX(0x66); XX(rex); XX(0x0F); XX(0xEA); break;
-         case Asse_MIN8U:    XX(0x66); XX(rex); XX(0x0F); XX(0xDA); break;
-         case Asse_MULHI16U: XX(0x66); XX(rex); XX(0x0F); XX(0xE4); break;
-         case Asse_MULHI16S: XX(0x66); XX(rex); XX(0x0F); XX(0xE5); break;
-         case Asse_MUL16:    XX(0x66); XX(rex); XX(0x0F); XX(0xD5); break;
-         case Asse_SHL16:    XX(0x66); XX(rex); XX(0x0F); XX(0xF1); break;
-         case Asse_SHL32:    XX(0x66); XX(rex); XX(0x0F); XX(0xF2); break;
-         case Asse_SHL64:    XX(0x66); XX(rex); XX(0x0F); XX(0xF3); break;
-         case Asse_SAR16:    XX(0x66); XX(rex); XX(0x0F); XX(0xE1); break;
-         case Asse_SAR32:    XX(0x66); XX(rex); XX(0x0F); XX(0xE2); break;
-         case Asse_SHR16:    XX(0x66); XX(rex); XX(0x0F); XX(0xD1); break;
-         case Asse_SHR32:    XX(0x66); XX(rex); XX(0x0F); XX(0xD2); break;
-         case Asse_SHR64:    XX(0x66); XX(rex); XX(0x0F); XX(0xD3); break;
-         case Asse_SUB8:     XX(0x66); XX(rex); XX(0x0F); XX(0xF8); break;
-         case Asse_SUB16:    XX(0x66); XX(rex); XX(0x0F); XX(0xF9); break;
-         case Asse_SUB32:    XX(0x66); XX(rex); XX(0x0F); XX(0xFA); break;
-         case Asse_SUB64:    XX(0x66); XX(rex); XX(0x0F); XX(0xFB); break;
-         case Asse_QSUB8S:   XX(0x66); XX(rex); XX(0x0F); XX(0xE8); break;
-         case Asse_QSUB16S:  XX(0x66); XX(rex); XX(0x0F); XX(0xE9); break;
-         case Asse_QSUB8U:   XX(0x66); XX(rex); XX(0x0F); XX(0xD8); break;
-         case Asse_QSUB16U:  XX(0x66); XX(rex); XX(0x0F); XX(0xD9); break;
-         case Asse_UNPCKHB:  XX(0x66); XX(rex); XX(0x0F); XX(0x68); break;
-         case Asse_UNPCKHW:  XX(0x66); XX(rex); XX(0x0F); XX(0x69); break;
-         case Asse_UNPCKHD:  XX(0x66); XX(rex); XX(0x0F); XX(0x6A); break;
-         case Asse_UNPCKHQ:  XX(0x66); XX(rex); XX(0x0F); XX(0x6D); break;
-         case Asse_UNPCKLB:  XX(0x66); XX(rex); XX(0x0F); XX(0x60); break;
-         case Asse_UNPCKLW:  XX(0x66); XX(rex); XX(0x0F); XX(0x61); break;
-         case Asse_UNPCKLD:  XX(0x66); XX(rex); XX(0x0F); XX(0x62); break;
-         case Asse_UNPCKLQ:  XX(0x66); XX(rex); XX(0x0F); XX(0x6C); break;
+         case Asse_MOV:      xtra = 0; opc = 0x10; break;
+         case Asse_OR:       xtra = 0; opc = 0x56; break;
+         case Asse_XOR:      xtra = 0; opc = 0x57; break;
+         case Asse_AND:      xtra = 0; opc = 0x54; break;
+         case Asse_ANDN:     xtra = 0; opc = 0x55; break;
+         case Asse_PACKSSD:  xtra = 1; opc = 0x6B; break;
+         case Asse_PACKSSW:  xtra = 1; opc = 0x63; break;
+         case Asse_PACKUSW:  xtra = 1; opc = 0x67; break;
+         case Asse_ADD8:     xtra = 1; opc = 0xFC; break;
+         case Asse_ADD16:    xtra = 1; opc = 0xFD; break;
+         case Asse_ADD32:    xtra = 1; opc = 0xFE; break;
+         case Asse_ADD64:    xtra = 1; opc = 0xD4; break;
+         case Asse_QADD8S:   xtra = 1; opc = 0xEC; break;
+         case Asse_QADD16S:  xtra = 1; opc = 0xED; break;
+         case Asse_QADD8U:   xtra = 1; opc = 0xDC; break;
+         case Asse_QADD16U:  xtra = 1; opc = 0xDD; break;
+         case Asse_AVG8U:    xtra = 1; opc = 0xE0; break;
+         case Asse_AVG16U:   xtra = 1; opc = 0xE3; break;
+         case Asse_CMPEQ8:   xtra = 1; opc = 0x74; break;
+         case Asse_CMPEQ16:  xtra = 1; opc = 0x75; break;
+         case Asse_CMPEQ32:  xtra = 1; opc = 0x76; break;
+         case Asse_CMPGT8S:  xtra = 1; opc = 0x64; break;
+         case Asse_CMPGT16S: xtra = 1; opc = 0x65; break;
+         case Asse_CMPGT32S: xtra = 1; opc = 0x66; break;
+         case Asse_MAX16S:   xtra = 1; opc = 0xEE; break;
+         case Asse_MAX8U:    xtra = 1; opc = 0xDE; break;
+         case Asse_MIN16S:   xtra = 1; opc = 0xEA; break;
+         case Asse_MIN8U:    xtra = 1; opc = 0xDA; break;
+         case Asse_MULHI16U: xtra = 1; opc = 0xE4; break;
+         case Asse_MULHI16S: xtra = 1; opc = 0xE5; break;
+         case Asse_MUL16:    xtra = 1; opc = 0xD5; break;
+         case Asse_SHL16:    xtra = 1; opc = 0xF1; break;
+         case Asse_SHL32:    xtra = 1; opc = 0xF2; break;
+         case Asse_SHL64:    xtra = 1; opc = 0xF3; break;
+         case Asse_SAR16:    xtra = 1; opc = 0xE1; break;
+         case Asse_SAR32:    xtra = 1; opc = 0xE2; break;
+         case Asse_SHR16:    xtra = 1; opc = 0xD1; break;
+         case Asse_SHR32:    xtra = 1; opc = 0xD2; break;
+         case Asse_SHR64:    xtra = 1; opc = 0xD3; break;
+         case Asse_SUB8:     xtra = 1; opc = 0xF8; break;
+         case Asse_SUB16:    xtra = 1; opc = 0xF9; break;
+         case Asse_SUB32:    xtra = 1; opc = 0xFA; break;
+         case Asse_SUB64:    xtra = 1; opc = 0xFB; break;
+         case Asse_QSUB8S:   xtra = 1; opc = 0xE8; break;
+         case Asse_QSUB16S:  xtra = 1; opc = 0xE9; break;
+         case Asse_QSUB8U:   xtra = 1; opc = 0xD8; break;
+         case Asse_QSUB16U:  xtra = 1; opc = 0xD9; break;
+         case Asse_UNPCKHB:  xtra = 1; opc = 0x68; break;
+         case Asse_UNPCKHW:  xtra = 1; opc = 0x69; break;
+         case Asse_UNPCKHD:  xtra = 1; opc = 0x6A; break;
+         case Asse_UNPCKHQ:  xtra = 1; opc = 0x6D; break;
+         case Asse_UNPCKLB:  xtra = 1; opc = 0x60; break;
+         case Asse_UNPCKLW:  xtra = 1; opc = 0x61; break;
+         case Asse_UNPCKLD:  xtra = 1; opc = 0x62; break;
+         case Asse_UNPCKLQ:  xtra = 1; opc = 0x6C; break;
          default: goto bad;
       }
-      p = doAMode_R_enc_enc(p, vregEnc3210(i->Ain.SseReRg.dst),
-                               vregEnc3210(i->Ain.SseReRg.src) );
-#     undef XX
+      /* The move (movups) takes no VEX.vvvv source. */
+      p = emitSseRR(p, xtra, 0, opc, vregEnc3210(i->Ain.SseReRg.dst),
+                    i->Ain.SseReRg.op == Asse_MOV
+                       ? 0 : vregEnc3210(i->Ain.SseReRg.dst),
+                    vregEnc3210(i->Ain.SseReRg.src));
       goto done;
 
    case Ain_SseCMov:
@@ -3813,38 +4473,163 @@ Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
       ptmp = p;
 
       /* movaps %src, %dst */
-      *p++ = clearWBit(
-             rexAMode_R_enc_enc( vregEnc3210(i->Ain.SseCMov.dst),
-                                 vregEnc3210(i->Ain.SseCMov.src) ));
-      *p++ = 0x0F; 
-      *p++ = 0x28; 
-      p = doAMode_R_enc_enc(p, vregEnc3210(i->Ain.SseCMov.dst),
-                               vregEnc3210(i->Ain.SseCMov.src) );
+      p = emitSseRR(p, 0, 0, 0x28, vregEnc3210(i->Ain.SseCMov.dst), 0,
+                    vregEnc3210(i->Ain.SseCMov.src));
 
       /* Fill in the jump offset. */
       *(ptmp-1) = toUChar(p - ptmp);
       goto done;
 
    case Ain_SseShuf:
-      *p++ = 0x66; 
-      *p++ = clearWBit(
-             rexAMode_R_enc_enc( vregEnc3210(i->Ain.SseShuf.dst),
-                                 vregEnc3210(i->Ain.SseShuf.src) ));
-      *p++ = 0x0F; 
-      *p++ = 0x70; 
-      p = doAMode_R_enc_enc(p, vregEnc3210(i->Ain.SseShuf.dst),
-                               vregEnc3210(i->Ain.SseShuf.src) );
+      p = emitSseRR(p, 1/*66*/, 0, 0x70, vregEnc3210(i->Ain.SseShuf.dst), 0,
+                    vregEnc3210(i->Ain.SseShuf.src));
       *p++ = (UChar)(i->Ain.SseShuf.order);
       goto done;
 
-   //uu case Ain_AvxLdSt: {
-   //uu    UInt vex = vexAMode_M( dvreg2ireg(i->Ain.AvxLdSt.reg),
-   //uu                           i->Ain.AvxLdSt.addr );
-   //uu    p = emitVexPrefix(p, vex);
-   //uu    *p++ = toUChar(i->Ain.AvxLdSt.isLoad ? 0x10 : 0x11);
-   //uu    p = doAMode_M(p, dvreg2ireg(i->Ain.AvxLdSt.reg), i->Ain.AvxLdSt.addr);
-   //uu      goto done;
-   //uu }
+   case Ain_AvxLdSt:
+      /* vmovdqu, which has no alignment constraints */
+      p = emitVexRM(p, 1/*0F*/, 2/*F3*/, 1,
+                    i->Ain.AvxLdSt.isLoad ? 0x6F : 0x7F,
+                    dvregEnc3210(i->Ain.AvxLdSt.reg), 0,
+                    i->Ain.AvxLdSt.addr);
+      goto done;
+
+   case Ain_AvxReRg: {
+      UInt mmmmm = 1/*0F*/, pp = 1/*66*/;
+      opc = 0;
+      switch (i->Ain.AvxReRg.op) {
+         case Aavx_MOV:
+            /* vmovdqu %src, %dst */
+            p = emitVexRR(p, 1/*0F*/, 2/*F3*/, 1, 0x6F,
+                          dvregEnc3210(i->Ain.AvxReRg.dst), 0,
+                          dvregEnc3210(i->Ain.AvxReRg.srcL));
+            goto done;
+         case Aavx_AND:      opc = 0xDB; break;
+         case Aavx_OR:       opc = 0xEB; break;
+         case Aavx_XOR:      opc = 0xEF; break;
+         case Aavx_ADD8:     opc = 0xFC; break;
+         case Aavx_ADD16:    opc = 0xFD; break;
+         case Aavx_ADD32:    opc = 0xFE; break;
+         case Aavx_ADD64:    opc = 0xD4; break;
+         case Aavx_QADD8S:   opc = 0xEC; break;
+         case Aavx_QADD16S:  opc = 0xED; break;
+         case Aavx_QADD8U:   opc = 0xDC; break;
+         case Aavx_QADD16U:  opc = 0xDD; break;
+         case Aavx_SUB8:     opc = 0xF8; break;
+         case Aavx_SUB16:    opc = 0xF9; break;
+         case Aavx_SUB32:    opc = 0xFA; break;
+         case Aavx_SUB64:    opc = 0xFB; break;
+         case Aavx_QSUB8S:   opc = 0xE8; break;
+         case Aavx_QSUB16S:  opc = 0xE9; break;
+         case Aavx_QSUB8U:   opc = 0xD8; break;
+         case Aavx_QSUB16U:  opc = 0xD9; break;
+         case Aavx_MUL16:    opc = 0xD5; break;
+         case Aavx_MULHI16U: opc = 0xE4; break;
+         case Aavx_MULHI16S: opc = 0xE5; break;
+         case Aavx_AVG8U:    opc = 0xE0; break;
+         case Aavx_AVG16U:   opc = 0xE3; break;
+         case Aavx_MAX16S:   opc = 0xEE; break;
+         case Aavx_MAX8U:    opc = 0xDE; break;
+         case Aavx_MIN16S:   opc = 0xEA; break;
+         case Aavx_MIN8U:    opc = 0xDA; break;
+         case Aavx_CMPEQ8:   opc = 0x74; break;
+         case Aavx_CMPEQ16:  opc = 0x75; break;
+         case Aavx_CMPEQ32:  opc = 0x76; break;
+         case Aavx_CMPGT8S:  opc = 0x64; break;
+         case Aavx_CMPGT16S: opc = 0x65; break;
+         case Aavx_CMPGT32S: opc = 0x66; break;
+         case Aavx_MUL32:    mmmmm = 2; opc = 0x40; break;
+         case Aavx_MAX8S:    mmmmm = 2; opc = 0x3C; break;
+         case Aavx_MAX16U:   mmmmm = 2; opc = 0x3E; break;
+         case Aavx_MAX32S:   mmmmm = 2; opc = 0x3D; break;
+         case Aavx_MAX32U:   mmmmm = 2; opc = 0x3F; break;
+         case Aavx_MIN8S:    mmmmm = 2; opc = 0x38; break;
+         case Aavx_MIN16U:   mmmmm = 2; opc = 0x3A; break;
+         case Aavx_MIN32S:   mmmmm = 2; opc = 0x39; break;
+         case Aavx_MIN32U:   mmmmm = 2; opc = 0x3B; break;
+         case Aavx_CMPEQ64:  mmmmm = 2; opc = 0x29; break;
+         case Aavx_CMPGT64S: mmmmm = 2; opc = 0x37; break;
+         case Aavx_PSHUFB:   mmmmm = 2; opc = 0x00; break;
+         case Aavx_ADD32F:   pp = 0; opc = 0x58; break;
+         case Aavx_MUL32F:   pp = 0; opc = 0x59; break;
+         case Aavx_SUB32F:   pp = 0; opc = 0x5C; break;
+         case Aavx_MIN32F:   pp = 0; opc = 0x5D; break;
+         case Aavx_DIV32F:   pp = 0; opc = 0x5E; break;
+         case Aavx_MAX32F:   pp = 0; opc = 0x5F; break;
+         case Aavx_ADD64F:   opc = 0x58; break;
+         case Aavx_MUL64F:   opc = 0x59; break;
+         case Aavx_SUB64F:   opc = 0x5C; break;
+         case Aavx_MIN64F:   opc = 0x5D; break;
+         case Aavx_DIV64F:   opc = 0x5E; break;
+         case Aavx_MAX64F:   opc = 0x5F; break;
+         default: goto bad;
+      }
+      /* op %srcR, %srcL, %dst */
+      p = emitVexRR(p, mmmmm, pp, 1, opc,
+                    dvregEnc3210(i->Ain.AvxReRg.dst),
+                    dvregEnc3210(i->Ain.AvxReRg.srcL),
+                    dvregEnc3210(i->Ain.AvxReRg.srcR));
+      goto done;
+   }
+
+   case Ain_AvxShift: {
+      opc = subopc = 0;
+      switch (i->Ain.AvxShift.op) {
+         case Aavx_SHL16: opc = 0x71; subopc = 6; break;
+         case Aavx_SHL32: opc = 0x72; subopc = 6; break;
+         case Aavx_SHL64: opc = 0x73; subopc = 6; break;
+         case Aavx_SHR16: opc = 0x71; subopc = 2; break;
+         case Aavx_SHR32: opc = 0x72; subopc = 2; break;
+         case Aavx_SHR64: opc = 0x73; subopc = 2; break;
+         case Aavx_SAR16: opc = 0x71; subopc = 4; break;
+         case Aavx_SAR32: opc = 0x72; subopc = 4; break;
+         default: goto bad;
+      }
+      /* op $amt, %src, %dst: the destination goes in VEX.vvvv */
+      p = emitVexRR(p, 1/*0F*/, 1/*66*/, 1, opc, subopc,
+                    dvregEnc3210(i->Ain.AvxShift.dst),
+                    dvregEnc3210(i->Ain.AvxShift.src));
+      *p++ = toUChar(i->Ain.AvxShift.amt);
+      goto done;
+   }
+
+   case Ain_AvxInsV128:
+      /* vinserti128 $1, %hi, %ymm(lo), %dst */
+      p = emitVexRR(p, 3/*0F3A*/, 1/*66*/, 1, 0x38,
+                    dvregEnc3210(i->Ain.AvxInsV128.dst),
+                    vregEnc3210(i->Ain.AvxInsV128.lo),
+                    vregEnc3210(i->Ain.AvxInsV128.hi));
+      *p++ = 1;
+      goto done;
+
+   case Ain_AvxExtV128:
+      /* vextracti128 $lane, %src, %dst */
+      p = emitVexRR(p, 3/*0F3A*/, 1/*66*/, 1, 0x39,
+                    dvregEnc3210(i->Ain.AvxExtV128.src), 0,
+                    vregEnc3210(i->Ain.AvxExtV128.dst));
+      *p++ = toUChar(i->Ain.AvxExtV128.lane);
+      goto done;
+
+   case Ain_AvxCMov:
+      /* jmp fwds if !condition */
+      *p++ = toUChar(0x70 + (i->Ain.AvxCMov.cond ^ 1));
+      *p++ = 0; /* # of bytes in the next bit, which we don't know yet */
+      ptmp = p;
+
+      /* vmovdqu %src, %dst */
+      p = emitVexRR(p, 1/*0F*/, 2/*F3*/, 1, 0x6F,
+                    dvregEnc3210(i->Ain.AvxCMov.dst), 0,
+                    dvregEnc3210(i->Ain.AvxCMov.src));
+
+      /* Fill in the jump offset. */
+      *(ptmp-1) = toUChar(p - ptmp);
+      goto done;
+
+   case Ain_VZeroUpper:
+      *p++ = 0xC5;
+      *p++ = 0xF8;
+      *p++ = 0x77;
+      goto done;
 
    case Ain_EvCheck: {
       /* We generate:
@@ -3910,6 +4695,10 @@ Int emit_AMD64Instr ( /*MB_MOD*/Bool* is_profInc,
       goto done;
    }
 
+   case Ain_PCMark:
+      /* Only of interest to the guest PC map; see libvex_BackEnd. */
+      goto done;
+
    default: 
       goto bad;
    }
@@ -4124,6 +4913,30 @@ VexInvalRange patchProfInc_AMD64 ( VexEndness endness_host,
 }
 
 
+/* Set the displacement of a branch between the hot code and the cold
+   code, as previously created (with a zero displacement) by the
+   Ain_Call case for emit_AMD64Instr.  This is done before the code is
+   copied to its final place, but the code is position-independent,
+   so the displacement stays valid. */
+void resolveColdBranch_AMD64 ( UChar* branch, const UChar* target )
+{
+   UChar* disp;
+   Long   delta;
+   if (branch[0] == 0x0F && (branch[1] & 0xF0) == 0x80) {
+      /* j{cond} rel32 */
+      disp = branch + 2;
+   } else {
+      /* jmp rel32 */
+      vassert(branch[0] == 0xE9);
+      disp = branch + 1;
+   }
+   vassert(disp[0] == 0 && disp[1] == 0 && disp[2] == 0 && disp[3] == 0);
+   delta = (Long)(target - (disp + 4));
+   vassert(fitsIn32Bits(delta));
+   (void)emit32(disp, (UInt)delta);
+}
+
+
 /*---------------------------------------------------------------*/
 /*--- end                                   host_amd64_defs.c ---*/
 /*---------------------------------------------------------------*/
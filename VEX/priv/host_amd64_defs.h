@@ -43,7 +43,10 @@
 /* --------- Registers. --------- */
 
 /* The usual HReg abstraction.  There are 16 real int regs, 6 real
-   float regs, and 16 real vector regs.
+   float regs, and 16 real vector regs.  Some of the vector regs are
+   given to the allocator as 128-bit (%xmm) regs, others as 256-bit
+   (%ymm) regs, since the allocator can't deal with aliased registers.
+   The %ymm ones are only used when the host has AVX2.
 */
 
 #define ST_IN static inline
@@ -69,15 +72,20 @@ ST_IN HReg hregAMD64_XMM10 ( void ) { return mkHReg(False, HRcVec128, 10, 17); }
 ST_IN HReg hregAMD64_XMM11 ( void ) { return mkHReg(False, HRcVec128, 11, 18); }
 ST_IN HReg hregAMD64_XMM12 ( void ) { return mkHReg(False, HRcVec128, 12, 19); }
 
-ST_IN HReg hregAMD64_RAX   ( void ) { return mkHReg(False, HRcInt64,   0, 20); }
-ST_IN HReg hregAMD64_RCX   ( void ) { return mkHReg(False, HRcInt64,   1, 21); }
-ST_IN HReg hregAMD64_RDX   ( void ) { return mkHReg(False, HRcInt64,   2, 22); }
-ST_IN HReg hregAMD64_RSP   ( void ) { return mkHReg(False, HRcInt64,   4, 23); }
-ST_IN HReg hregAMD64_RBP   ( void ) { return mkHReg(False, HRcInt64,   5, 24); }
-ST_IN HReg hregAMD64_R11   ( void ) { return mkHReg(False, HRcInt64,  11, 25); }
+ST_IN HReg hregAMD64_YMM13 ( void ) { return mkHReg(False, HRcVec256, 13, 20); }
+ST_IN HReg hregAMD64_YMM14 ( void ) { return mkHReg(False, HRcVec256, 14, 21); }
+ST_IN HReg hregAMD64_YMM15 ( void ) { return mkHReg(False, HRcVec256, 15, 22); }
+ST_IN HReg hregAMD64_YMM2  ( void ) { return mkHReg(False, HRcVec256,  2, 23); }
 
-ST_IN HReg hregAMD64_XMM0  ( void ) { return mkHReg(False, HRcVec128,  0, 26); }
-ST_IN HReg hregAMD64_XMM1  ( void ) { return mkHReg(False, HRcVec128,  1, 27); }
+ST_IN HReg hregAMD64_RAX   ( void ) { return mkHReg(False, HRcInt64,   0, 24); }
+ST_IN HReg hregAMD64_RCX   ( void ) { return mkHReg(False, HRcInt64,   1, 25); }
+ST_IN HReg hregAMD64_RDX   ( void ) { return mkHReg(False, HRcInt64,   2, 26); }
+ST_IN HReg hregAMD64_RSP   ( void ) { return mkHReg(False, HRcInt64,   4, 27); }
+ST_IN HReg hregAMD64_RBP   ( void ) { return mkHReg(False, HRcInt64,   5, 28); }
+ST_IN HReg hregAMD64_R11   ( void ) { return mkHReg(False, HRcInt64,  11, 29); }
+
+ST_IN HReg hregAMD64_XMM0  ( void ) { return mkHReg(False, HRcVec128,  0, 30); }
+ST_IN HReg hregAMD64_XMM1  ( void ) { return mkHReg(False, HRcVec128,  1, 31); }
 #undef ST_IN
 
 extern UInt ppHRegAMD64 ( HReg );
@@ -346,6 +354,48 @@ typedef
 extern const HChar* showAMD64SseOp ( AMD64SseOp );
 
 
+/* --------- */
+/* AVX2 operations on 256-bit (%ymm) registers.  All but Aavx_MOV
+   are non-destructive: dst = srcL `op` srcR. */
+typedef
+   enum {
+      Aavx_INVALID,
+      /* mov */
+      Aavx_MOV,
+      /* Bitwise */
+      Aavx_AND, Aavx_OR, Aavx_XOR,
+      /* Integer */
+      Aavx_ADD8, Aavx_ADD16, Aavx_ADD32, Aavx_ADD64,
+      Aavx_QADD8U, Aavx_QADD16U,
+      Aavx_QADD8S, Aavx_QADD16S,
+      Aavx_SUB8, Aavx_SUB16, Aavx_SUB32, Aavx_SUB64,
+      Aavx_QSUB8U, Aavx_QSUB16U,
+      Aavx_QSUB8S, Aavx_QSUB16S,
+      Aavx_MUL16, Aavx_MUL32,
+      Aavx_MULHI16U, Aavx_MULHI16S,
+      Aavx_AVG8U, Aavx_AVG16U,
+      Aavx_MAX8S, Aavx_MAX16S, Aavx_MAX32S,
+      Aavx_MAX8U, Aavx_MAX16U, Aavx_MAX32U,
+      Aavx_MIN8S, Aavx_MIN16S, Aavx_MIN32S,
+      Aavx_MIN8U, Aavx_MIN16U, Aavx_MIN32U,
+      Aavx_CMPEQ8, Aavx_CMPEQ16, Aavx_CMPEQ32, Aavx_CMPEQ64,
+      Aavx_CMPGT8S, Aavx_CMPGT16S, Aavx_CMPGT32S, Aavx_CMPGT64S,
+      Aavx_PSHUFB,
+      /* Floating point */
+      Aavx_ADD32F, Aavx_SUB32F, Aavx_MUL32F, Aavx_DIV32F,
+      Aavx_MAX32F, Aavx_MIN32F,
+      Aavx_ADD64F, Aavx_SUB64F, Aavx_MUL64F, Aavx_DIV64F,
+      Aavx_MAX64F, Aavx_MIN64F,
+      /* Shifts by an immediate amount (Ain_AvxShift only) */
+      Aavx_SHL16, Aavx_SHL32, Aavx_SHL64,
+      Aavx_SHR16, Aavx_SHR32, Aavx_SHR64,
+      Aavx_SAR16, Aavx_SAR32
+   }
+   AMD64AvxOp;
+
+extern const HChar* showAMD64AvxOp ( AMD64AvxOp );
+
+
 /* --------- */
 typedef
    enum {
@@ -399,11 +449,17 @@ typedef
       Ain_SseReRg,     /* SSE binary general reg-reg, Re, Rg */
       Ain_SseCMov,     /* SSE conditional move */
       Ain_SseShuf,     /* SSE2 shuffle (pshufd) */
-      //uu Ain_AvxLdSt,     /* AVX load/store 256 bits,
-      //uu                     no alignment constraints */
-      //uu Ain_AvxReRg,     /* AVX binary general reg-reg, Re, Rg */
+      Ain_AvxLdSt,     /* AVX load/store 256 bits,
+                          no alignment constraints */
+      Ain_AvxReRg,     /* AVX2 binary reg-reg-reg, or reg-reg move */
+      Ain_AvxShift,    /* AVX2 shift by immediate */
+      Ain_AvxInsV128,  /* join two 128-bit regs into a 256-bit reg */
+      Ain_AvxExtV128,  /* extract a 128-bit half of a 256-bit reg */
+      Ain_AvxCMov,     /* AVX conditional move */
+      Ain_VZeroUpper,  /* zero the upper halves of all vector regs */
       Ain_EvCheck,     /* Event check */
-      Ain_ProfInc      /* 64-bit profile counter increment */
+      Ain_ProfInc,     /* 64-bit profile counter increment */
+      Ain_PCMark       /* start of a guest insn's code (no bytes) */
    }
    AMD64InstrTag;
 
@@ -469,12 +525,14 @@ typedef
             AMD64RMI* src;
          } Push;
          /* Pseudo-insn.  Call target (an absolute address), on given
-            condition (which could be Xcc_ALWAYS). */
+            condition (which could be Xcc_ALWAYS).  If cold, the call
+            rarely happens, and may be emitted out of line. */
          struct {
             AMD64CondCode cond;
             Addr64        target;
             Int           regparms; /* 0 .. 6 */
             RetLoc        rloc;     /* where the return value will be */
+            Bool          cold;
          } Call;
          /* Update the guest RIP value, then exit requesting to chain
             to it.  May be conditional. */
@@ -694,16 +752,48 @@ typedef
             HReg   src;
             HReg   dst;
          } SseShuf;
-         //uu struct {
-         //uu    Bool        isLoad;
-         //uu    HReg        reg;
-         //uu    AMD64AMode* addr;
-         //uu } AvxLdSt;
-         //uu struct {
-         //uu    AMD64SseOp op;
-         //uu    HReg       src;
-         //uu    HReg       dst;
-         //uu } AvxReRg;
+         struct {
+            Bool        isLoad;
+            HReg        reg;
+            AMD64AMode* addr;
+         } AvxLdSt;
+         /* dst = srcL `op` srcR.  For Aavx_MOV, srcL == srcR is the
+            source. */
+         struct {
+            AMD64AvxOp op;
+            HReg       srcL;
+            HReg       srcR;
+            HReg       dst;
+         } AvxReRg;
+         struct {
+            AMD64AvxOp op;
+            UInt       amt; /* 0 .. 63 */
+            HReg       src;
+            HReg       dst;
+         } AvxShift;
+         /* dst (256) = hi (128) : lo (128) */
+         struct {
+            HReg hi;
+            HReg lo;
+            HReg dst;
+         } AvxInsV128;
+         /* dst (128) = the lower (lane 0) or upper (lane 1) half of
+            src (256) */
+         struct {
+            UInt lane;
+            HReg src;
+            HReg dst;
+         } AvxExtV128;
+         /* Mov src to dst on the given condition, which may not
+            be the bogus Xcc_ALWAYS. */
+         struct {
+            AMD64CondCode cond;
+            HReg          src;
+            HReg          dst;
+         } AvxCMov;
+         struct {
+            /* No fields.  Trashes all the 256-bit regs. */
+         } VZeroUpper;
          struct {
             AMD64AMode* amCounter;
             AMD64AMode* amFailAddr;
@@ -713,6 +803,11 @@ typedef
                installed later, post-translation, by patching it in,
                as it is not known at translation time. */
          } ProfInc;
+         /* Marks where the code for the guest insn at guest_pc starts,
+            for the guest PC map.  Emits nothing. */
+         struct {
+            Addr64 guest_pc;
+         } PCMark;
 
       } Ain;
    }
@@ -729,7 +824,8 @@ extern AMD64Instr* AMD64Instr_Test64     ( UInt imm32, HReg dst );
 extern AMD64Instr* AMD64Instr_MulL       ( Bool syned, AMD64RM* );
 extern AMD64Instr* AMD64Instr_Div        ( Bool syned, Int sz, AMD64RM* );
 extern AMD64Instr* AMD64Instr_Push       ( AMD64RMI* );
-extern AMD64Instr* AMD64Instr_Call       ( AMD64CondCode, Addr64, Int, RetLoc );
+extern AMD64Instr* AMD64Instr_Call       ( AMD64CondCode, Addr64, Int, RetLoc,
+                                           Bool cold );
 extern AMD64Instr* AMD64Instr_XDirect    ( Addr64 dstGA, AMD64AMode* amRIP,
                                            AMD64CondCode cond, Bool toFastEP );
 extern AMD64Instr* AMD64Instr_XIndir     ( HReg dstGA, AMD64AMode* amRIP,
@@ -772,11 +868,19 @@ extern AMD64Instr* AMD64Instr_Sse64FLo   ( AMD64SseOp, HReg, HReg );
 extern AMD64Instr* AMD64Instr_SseReRg    ( AMD64SseOp, HReg, HReg );
 extern AMD64Instr* AMD64Instr_SseCMov    ( AMD64CondCode, HReg src, HReg dst );
 extern AMD64Instr* AMD64Instr_SseShuf    ( Int order, HReg src, HReg dst );
-//uu extern AMD64Instr* AMD64Instr_AvxLdSt    ( Bool isLoad, HReg, AMD64AMode* );
-//uu extern AMD64Instr* AMD64Instr_AvxReRg    ( AMD64SseOp, HReg, HReg );
+extern AMD64Instr* AMD64Instr_AvxLdSt    ( Bool isLoad, HReg, AMD64AMode* );
+extern AMD64Instr* AMD64Instr_AvxReRg    ( AMD64AvxOp, HReg srcL, HReg srcR,
+                                           HReg dst );
+extern AMD64Instr* AMD64Instr_AvxShift   ( AMD64AvxOp, UInt amt, HReg src,
+                                           HReg dst );
+extern AMD64Instr* AMD64Instr_AvxInsV128 ( HReg hi, HReg lo, HReg dst );
+extern AMD64Instr* AMD64Instr_AvxExtV128 ( UInt lane, HReg src, HReg dst );
+extern AMD64Instr* AMD64Instr_AvxCMov    ( AMD64CondCode, HReg src, HReg dst );
+extern AMD64Instr* AMD64Instr_VZeroUpper ( void );
 extern AMD64Instr* AMD64Instr_EvCheck    ( AMD64AMode* amCounter,
                                            AMD64AMode* amFailAddr );
 extern AMD64Instr* AMD64Instr_ProfInc    ( void );
+extern AMD64Instr* AMD64Instr_PCMark     ( Addr64 guest_pc );
 
 
 extern void ppAMD64Instr ( const AMD64Instr*, Bool );
@@ -786,6 +890,7 @@ extern void ppAMD64Instr ( const AMD64Instr*, Bool );
 extern void getRegUsage_AMD64Instr ( HRegUsage*, const AMD64Instr*, Bool );
 extern void mapRegs_AMD64Instr     ( HRegRemap*, AMD64Instr*, Bool );
 extern Int          emit_AMD64Instr   ( /*MB_MOD*/Bool* is_profInc,
+                                        /*MB_MOD*/ColdCode* cold,
                                         UChar* buf, Int nbuf,
                                         const AMD64Instr* i, 
                                         Bool mode64,
@@ -802,6 +907,14 @@ extern void genReload_AMD64 ( /*OUT*/HInstr** i1, /*OUT*/HInstr** i2,
 extern AMD64Instr* genMove_AMD64(HReg from, HReg to, Bool);
 extern AMD64Instr* directReload_AMD64 ( AMD64Instr* i,
                                         HReg vreg, Short spill_off );
+extern Bool isRematDef_AMD64 ( const AMD64Instr* i, /*OUT*/Int* gsOff,
+                               /*OUT*/Int* gsLen );
+extern AMD64Instr* genRemat_AMD64 ( const AMD64Instr* i, HReg to );
+extern Bool writesGuestState_AMD64 ( const AMD64Instr* i, /*OUT*/Int* off,
+                                     /*OUT*/Int* len );
+extern Bool isPCMark_AMD64 ( const AMD64Instr* i, /*OUT*/Addr* guest_pc );
+extern Bool peephole_AMD64 ( AMD64Instr** tail, /*MOD*/Int* n_tail,
+                             ULong deadAfter, /*MOD*/PeepholeStats* stats );
 
 extern const RRegUniverse* getRRegUniverse_AMD64 ( void );
 
@@ -838,6 +951,16 @@ extern VexInvalRange patchProfInc_AMD64 ( VexEndness endness_host,
                                           void*  place_to_patch,
                                           const ULong* location_of_counter );
 
+/* Resolve a branch between the hot code and the out-of-line code. */
+extern void resolveColdBranch_AMD64 ( UChar* branch, const UChar* target );
+
+/* KLUDGE: the host hwcaps, exported by LibVEX_Translate in the same
+   way as s390_host_hwcaps. */
+extern UInt amd64_host_hwcaps;
+
+#define amd64_host_has_avx2 \
+                      (amd64_host_hwcaps & VEX_HWCAPS_AMD64_AVX2)
+
 
 #endif /* ndef __VEX_HOST_AMD64_DEFS_H */
 
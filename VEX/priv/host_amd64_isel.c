@@ -155,12 +155,26 @@ typedef
 
       UInt         hwcaps;
 
+      /* True if the host has AVX2.  V256 temps then live in a single
+         256-bit vreg rather than in a pair of 128-bit ones. */
+      Bool         avx2;
+
       Bool         chainingAllowed;
       Addr64       max_ga;
 
+      /* Mark the start of each guest insn's code for the guest PC
+         map?  See VexAbiInfo::host_amd64_lazy_guest_pc. */
+      Bool         lazyGuestPC;
+
       /* These are modified as we go along. */
       HInstrArray* code;
       Int          vreg_ctr;
+
+      /* Have any 256-bit vregs been created?  If so, the upper halves
+         of the %ymm registers need clearing (vzeroupper) before
+         calling out and at the end of the block, so as to avoid
+         AVX/SSE transition penalties in code that follows. */
+      Bool         ymm_used;
    }
    ISelEnv;
 
@@ -205,6 +219,15 @@ static HReg newVRegV ( ISelEnv* env )
    return reg;
 }
 
+static HReg newVRegY ( ISelEnv* env )
+{
+   vassert(env->avx2);
+   HReg reg = mkHReg(True/*virtual reg*/, HRcVec256, 0/*enc*/, env->vreg_ctr);
+   env->vreg_ctr++;
+   env->ymm_used = True;
+   return reg;
+}
+
 
 /*---------------------------------------------------------*/
 /*--- ISEL: Forward declarations                        ---*/
@@ -253,6 +276,9 @@ static void          iselDVecExpr_wrk ( /*OUT*/HReg* rHi, HReg* rLo,
 static void          iselDVecExpr     ( /*OUT*/HReg* rHi, HReg* rLo, 
                                         ISelEnv* env, const IRExpr* e );
 
+static HReg          iselV256Expr_native ( ISelEnv* env, const IRExpr* e );
+static HReg          iselV256Expr        ( ISelEnv* env, const IRExpr* e );
+
 
 /*---------------------------------------------------------*/
 /*--- ISEL: Misc helpers                                ---*/
@@ -419,16 +445,17 @@ static AMD64Instr* iselIntExpr_single_instruction ( ISelEnv* env,
 
 /* Do a complete function call.  |guard| is a Ity_Bit expression
    indicating whether or not the call happens.  If guard==NULL, the
-   call is unconditional.  |retloc| is set to indicate where the
-   return value is after the call.  The caller (of this fn) must
-   generate code to add |stackAdjustAfterCall| to the stack pointer
-   after the call is done. */
+   call is unconditional.  |cold| indicates that the call rarely
+   happens, so that it may be emitted out of line.  |retloc| is set
+   to indicate where the return value is after the call.  The caller
+   (of this fn) must generate code to add |stackAdjustAfterCall| to
+   the stack pointer after the call is done. */
 
 static
 void doHelperCall ( /*OUT*/UInt*   stackAdjustAfterCall,
                     /*OUT*/RetLoc* retloc,
                     ISelEnv* env,
-                    IRExpr* guard,
+                    IRExpr* guard, Bool cold,
                     IRCallee* cee, IRType retTy, IRExpr** args )
 {
    AMD64CondCode cc;
@@ -594,17 +621,30 @@ void doHelperCall ( /*OUT*/UInt*   stackAdjustAfterCall,
 #  endif
 
    /* If we have a vector return type, allocate a place for it on the
-      stack and record its address. */
+      stack and record its address.  With a lazy guest PC, the caller
+      finds the return address of a helper call relative to the stack
+      pointer generated code runs with, so clear the words of the area
+      where a return address would otherwise be, to avoid a stale one
+      being found there. */
    HReg r_vecRetAddr = INVALID_HREG;
    if (retTy == Ity_V128) {
       r_vecRetAddr = newVRegI(env);
       sub_from_rsp(env, 16);
       addInstr(env, mk_iMOVsd_RR( hregAMD64_RSP(), r_vecRetAddr ));
+      if (env->lazyGuestPC)
+         addInstr(env, AMD64Instr_Alu64M(Aalu_MOV, AMD64RI_Imm(0),
+                          AMD64AMode_IR(8, hregAMD64_RSP())));
    }
    else if (retTy == Ity_V256) {
       r_vecRetAddr = newVRegI(env);
       sub_from_rsp(env, 32);
       addInstr(env, mk_iMOVsd_RR( hregAMD64_RSP(), r_vecRetAddr ));
+      if (env->lazyGuestPC) {
+         addInstr(env, AMD64Instr_Alu64M(Aalu_MOV, AMD64RI_Imm(0),
+                          AMD64AMode_IR(8, hregAMD64_RSP())));
+         addInstr(env, AMD64Instr_Alu64M(Aalu_MOV, AMD64RI_Imm(0),
+                          AMD64AMode_IR(24, hregAMD64_RSP())));
+      }
    }
 
    vassert(n_args >= 0 && n_args <= 6);
@@ -687,10 +727,19 @@ void doHelperCall ( /*OUT*/UInt*   stackAdjustAfterCall,
            vassert(0);
    }
 
+   /* Clear the upper halves of the %ymm registers before calling
+      out, so the callee's SSE code doesn't pay for a state
+      transition.  Not for conditional calls, though: those are
+      mostly rarely-taken error paths, and since vzeroupper trashes
+      the 256-bit registers it would cost us spills on the fast
+      path. */
+   if (env->ymm_used && cc == Acc_ALWAYS)
+      addInstr(env, AMD64Instr_VZeroUpper());
+
    /* Finally, generate the call itself.  This needs the *retloc value
       set in the switch above, which is why it's at the end. */
    addInstr(env,
-            AMD64Instr_Call(cc, (Addr)cee->addr, n_args, *retloc));
+            AMD64Instr_Call(cc, (Addr)cee->addr, n_args, *retloc, cold));
 }
 
 
@@ -1228,7 +1277,7 @@ static HReg iselIntExpr_R_wrk ( ISelEnv* env, const IRExpr* e )
          addInstr(env, mk_iMOVsd_RR(argL, hregAMD64_RDI()) );
          addInstr(env, mk_iMOVsd_RR(argR, hregAMD64_RSI()) );
          addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn, 2,
-                                        mk_RetLoc_simple(RLPri_Int) ));
+                                        mk_RetLoc_simple(RLPri_Int), False ));
          addInstr(env, mk_iMOVsd_RR(hregAMD64_RAX(), dst));
          return dst;
       }
@@ -1698,7 +1747,8 @@ static HReg iselIntExpr_R_wrk ( ISelEnv* env, const IRExpr* e )
             fn = (HWord)h_generic_calc_GetMSBs8x8;
             addInstr(env, mk_iMOVsd_RR(arg, hregAMD64_RDI()) );
             addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn,
-                                           1, mk_RetLoc_simple(RLPri_Int) ));
+                                           1, mk_RetLoc_simple(RLPri_Int),
+                                           False ));
             /* MovxLQ is not exactly the right thing here.  We just
                need to get the bottom 8 bits of RAX into dst, and zero
                out everything else.  Assuming that the helper returns
@@ -1729,7 +1779,8 @@ static HReg iselIntExpr_R_wrk ( ISelEnv* env, const IRExpr* e )
                                              AMD64RMI_Mem(m16_rsp),
                                              hregAMD64_RSI() )); /* 2nd arg */
             addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn,
-                                           2, mk_RetLoc_simple(RLPri_Int) ));
+                                           2, mk_RetLoc_simple(RLPri_Int),
+                                           False ));
             /* MovxLQ is not exactly the right thing here.  We just
                need to get the bottom 16 bits of RAX into dst, and zero
                out everything else.  Assuming that the helper returns
@@ -1764,7 +1815,7 @@ static HReg iselIntExpr_R_wrk ( ISelEnv* env, const IRExpr* e )
          HReg arg = iselIntExpr_R(env, e->Iex.Unop.arg);
          addInstr(env, mk_iMOVsd_RR(arg, hregAMD64_RDI()) );
          addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn, 1,
-                                        mk_RetLoc_simple(RLPri_Int) ));
+                                        mk_RetLoc_simple(RLPri_Int), False ));
          addInstr(env, mk_iMOVsd_RR(hregAMD64_RAX(), dst));
          return dst;
       }
@@ -1826,7 +1877,7 @@ static HReg iselIntExpr_R_wrk ( ISelEnv* env, const IRExpr* e )
       /* Marshal args, do the call. */
       UInt   addToSp = 0;
       RetLoc rloc    = mk_RetLoc_INVALID();
-      doHelperCall( &addToSp, &rloc, env, NULL/*guard*/,
+      doHelperCall( &addToSp, &rloc, env, NULL/*guard*/, False/*cold*/,
                     e->Iex.CCall.cee, e->Iex.CCall.retty, e->Iex.CCall.args );
       vassert(is_sane_RetLoc(rloc));
       vassert(rloc.pri == RLPri_Int);
@@ -2390,7 +2441,7 @@ static AMD64CondCode iselCondCode_wrk ( ISelEnv* env, const IRExpr* e )
       /* Marshal args, do the call. */
       UInt   addToSp = 0;
       RetLoc rloc    = mk_RetLoc_INVALID();
-      doHelperCall( &addToSp, &rloc, env, NULL/*guard*/,
+      doHelperCall( &addToSp, &rloc, env, NULL/*guard*/, False/*cold*/,
                     cal->Iex.CCall.cee,
                     cal->Iex.CCall.retty, cal->Iex.CCall.args );
       vassert(is_sane_RetLoc(rloc));
@@ -2707,7 +2758,7 @@ static HReg iselFltExpr_wrk ( ISelEnv* env, const IRExpr* e )
       /* call the helper */
       addInstr(env, AMD64Instr_Call( Acc_ALWAYS,
                                      (ULong)(HWord)h_generic_calc_MAddF32,
-                                     4, mk_RetLoc_simple(RLPri_None) ));
+                                     4, mk_RetLoc_simple(RLPri_None), False ));
       /* fetch the result from memory, using %r_argp, which the
          register allocator will keep alive across the call. */
       addInstr(env, AMD64Instr_SseLdSt(True/*isLoad*/, 4, dst,
@@ -2886,7 +2937,7 @@ static HReg iselDblExpr_wrk ( ISelEnv* env, const IRExpr* e )
       /* call the helper */
       addInstr(env, AMD64Instr_Call( Acc_ALWAYS,
                                      (ULong)(HWord)h_generic_calc_MAddF64,
-                                     4, mk_RetLoc_simple(RLPri_None) ));
+                                     4, mk_RetLoc_simple(RLPri_None), False ));
       /* fetch the result from memory, using %r_argp, which the
          register allocator will keep alive across the call. */
       addInstr(env, AMD64Instr_SseLdSt(True/*isLoad*/, 8, dst,
@@ -3303,6 +3354,14 @@ static HReg iselVecExpr_wrk ( ISelEnv* env, const IRExpr* e )
 
       case Iop_V256toV128_0:
       case Iop_V256toV128_1: {
+         if (env->avx2) {
+            HReg src = iselV256Expr(env, e->Iex.Unop.arg);
+            HReg dst = newVRegV(env);
+            addInstr(env, AMD64Instr_AvxExtV128(
+                             e->Iex.Unop.op == Iop_V256toV128_1 ? 1 : 0,
+                             src, dst));
+            return dst;
+         }
          HReg vHi, vLo;
          iselDVecExpr(&vHi, &vLo, env, e->Iex.Unop.arg);
          return (e->Iex.Unop.op == Iop_V256toV128_1) ? vHi : vLo;
@@ -3604,7 +3663,8 @@ static HReg iselVecExpr_wrk ( ISelEnv* env, const IRExpr* e )
                                           AMD64AMode_IR(0, hregAMD64_RDX())));
          /* call the helper */
          addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn,
-                                        3, mk_RetLoc_simple(RLPri_None) ));
+                                        3, mk_RetLoc_simple(RLPri_None),
+                                        False ));
          /* fetch the result from memory, using %r_argp, which the
             register allocator will keep alive across the call. */
          addInstr(env, AMD64Instr_SseLdSt(True/*isLoad*/, 16, dst,
@@ -3653,7 +3713,8 @@ static HReg iselVecExpr_wrk ( ISelEnv* env, const IRExpr* e )
 
          /* call the helper */
          addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn,
-                                        3, mk_RetLoc_simple(RLPri_None) ));
+                                        3, mk_RetLoc_simple(RLPri_None),
+                                        False ));
          /* fetch the result from memory, using %r_argp, which the
             register allocator will keep alive across the call. */
          addInstr(env, AMD64Instr_SseLdSt(True/*isLoad*/, 16, dst,
@@ -3756,6 +3817,21 @@ static void iselDVecExpr_wrk ( /*OUT*/HReg* rHi, /*OUT*/HReg* rLo,
 
    AMD64SseOp op = Asse_INVALID;
 
+   /* On AVX2 hosts, do it in a 256-bit register if possible, and
+      split the result. */
+   if (env->avx2) {
+      HReg r = iselV256Expr_native(env, e);
+      if (!hregIsInvalid(r)) {
+         HReg vHi = newVRegV(env);
+         HReg vLo = newVRegV(env);
+         addInstr(env, AMD64Instr_AvxExtV128(1, r, vHi));
+         addInstr(env, AMD64Instr_AvxExtV128(0, r, vLo));
+         *rHi = vHi;
+         *rLo = vLo;
+         return;
+      }
+   }
+
    /* read 256-bit IRTemp */
    if (e->tag == Iex_RdTmp) {
       lookupIRTempPair( rHi, rLo, env, e->Iex.RdTmp.tmp);
@@ -4091,7 +4167,7 @@ static void iselDVecExpr_wrk ( /*OUT*/HReg* rHi, /*OUT*/HReg* rLo,
                                           AMD64AMode_IR(48, hregAMD64_RDX())));
          /* call the helper */
          addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn, 3,
-                                        mk_RetLoc_simple(RLPri_None) ));
+                                        mk_RetLoc_simple(RLPri_None), False ));
          /* Prepare 3 arg regs:
             leaq 48(%r_argp), %rdi
             leaq 64(%r_argp), %rsi
@@ -4105,7 +4181,7 @@ static void iselDVecExpr_wrk ( /*OUT*/HReg* rHi, /*OUT*/HReg* rLo,
                                         hregAMD64_RDX()));
          /* call the helper */
          addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn, 3,
-                                        mk_RetLoc_simple(RLPri_None) ));
+                                        mk_RetLoc_simple(RLPri_None), False ));
          /* fetch the result from memory, using %r_argp, which the
             register allocator will keep alive across the call. */
          addInstr(env, AMD64Instr_SseLdSt(True/*isLoad*/, 16, dstHi,
@@ -4167,7 +4243,7 @@ static void iselDVecExpr_wrk ( /*OUT*/HReg* rHi, /*OUT*/HReg* rLo,
                                           AMD64AMode_IR(16, hregAMD64_RDX())));
          /* call the helper */
          addInstr(env, AMD64Instr_Call( Acc_ALWAYS, (ULong)fn, 3,
-                                        mk_RetLoc_simple(RLPri_None) ));
+                                        mk_RetLoc_simple(RLPri_None), False ));
          /* fetch the result from memory, using %r_argp, which the
             register allocator will keep alive across the call. */
          addInstr(env, AMD64Instr_SseLdSt(True/*isLoad*/, 16, dstLo,
@@ -4289,6 +4365,264 @@ static void iselDVecExpr_wrk ( /*OUT*/HReg* rHi, /*OUT*/HReg* rLo,
 }
 
 
+/*---------------------------------------------------------*/
+/*--- ISEL: SIMD (V256) expressions, into 1 YMM reg.     --*/
+/*---------------------------------------------------------*/
+
+/* These are only used on AVX2 hosts.  iselV256Expr computes |e| into
+   a 256-bit vreg.  It first tries iselV256Expr_native; if that can't
+   do the top level operation of |e|, the value is computed as two
+   128-bit halves by iselDVecExpr and then joined up. */
+
+static HReg iselV256Expr ( ISelEnv* env, const IRExpr* e )
+{
+   vassert(env->avx2);
+   HReg r = iselV256Expr_native(env, e);
+   if (hregIsInvalid(r)) {
+      HReg rHi, rLo;
+      iselDVecExpr(&rHi, &rLo, env, e);
+      r = newVRegY(env);
+      addInstr(env, AMD64Instr_AvxInsV128(rHi, rLo, r));
+   }
+   vassert(hregClass(r) == HRcVec256);
+   vassert(hregIsVirtual(r));
+   return r;
+}
+
+/* Generate all-zeroes into a new 256-bit register. */
+static HReg generate_zeroes_V256 ( ISelEnv* env )
+{
+   HReg dst = newVRegY(env);
+   addInstr(env, AMD64Instr_AvxReRg(Aavx_XOR, dst, dst, dst));
+   return dst;
+}
+
+/* Generate all-ones into a new 256-bit register. */
+static HReg generate_ones_V256 ( ISelEnv* env )
+{
+   HReg dst = newVRegY(env);
+   addInstr(env, AMD64Instr_AvxReRg(Aavx_CMPEQ32, dst, dst, dst));
+   return dst;
+}
+
+/* Compute |e| using AVX2 instructions, or return INVALID_HREG, having
+   generated no code, if its top level operation isn't one we can do
+   that way.  Sub-expressions go via iselV256Expr, so they are always
+   computed one way or the other. */
+static HReg iselV256Expr_native ( ISelEnv* env, const IRExpr* e )
+{
+   AMD64AvxOp op = Aavx_INVALID;
+   vassert(e);
+   vassert(env->avx2);
+   vassert(typeOfIRExpr(env->type_env,e) == Ity_V256);
+
+   if (e->tag == Iex_RdTmp) {
+      return lookupIRTemp(env, e->Iex.RdTmp.tmp);
+   }
+
+   if (e->tag == Iex_Get) {
+      HReg        dst = newVRegY(env);
+      AMD64AMode* am  = AMD64AMode_IR(e->Iex.Get.offset, hregAMD64_RBP());
+      addInstr(env, AMD64Instr_AvxLdSt(True/*load*/, dst, am));
+      return dst;
+   }
+
+   if (e->tag == Iex_Load && e->Iex.Load.end == Iend_LE) {
+      HReg        dst = newVRegY(env);
+      AMD64AMode* am  = iselIntExpr_AMode(env, e->Iex.Load.addr);
+      addInstr(env, AMD64Instr_AvxLdSt(True/*load*/, dst, am));
+      return dst;
+   }
+
+   if (e->tag == Iex_Const) {
+      vassert(e->Iex.Const.con->tag == Ico_V256);
+      switch (e->Iex.Const.con->Ico.V256) {
+         case 0x00000000:
+            return generate_zeroes_V256(env);
+         case 0xFFFFFFFF:
+            return generate_ones_V256(env);
+         default:
+            break;
+      }
+   }
+
+   if (e->tag == Iex_Unop) {
+   switch (e->Iex.Unop.op) {
+
+      case Iop_NotV256: {
+         HReg arg  = iselV256Expr(env, e->Iex.Unop.arg);
+         HReg ones = generate_ones_V256(env);
+         HReg dst  = newVRegY(env);
+         addInstr(env, AMD64Instr_AvxReRg(Aavx_XOR, arg, ones, dst));
+         return dst;
+      }
+
+      case Iop_CmpNEZ8x32:  op = Aavx_CMPEQ8;  goto do_CmpNEZ;
+      case Iop_CmpNEZ16x16: op = Aavx_CMPEQ16; goto do_CmpNEZ;
+      case Iop_CmpNEZ32x8:  op = Aavx_CMPEQ32; goto do_CmpNEZ;
+      case Iop_CmpNEZ64x4:  op = Aavx_CMPEQ64; goto do_CmpNEZ;
+      do_CmpNEZ: {
+         HReg arg  = iselV256Expr(env, e->Iex.Unop.arg);
+         HReg zero = generate_zeroes_V256(env);
+         HReg eqz  = newVRegY(env);
+         addInstr(env, AMD64Instr_AvxReRg(op, arg, zero, eqz));
+         HReg ones = generate_ones_V256(env);
+         HReg dst  = newVRegY(env);
+         addInstr(env, AMD64Instr_AvxReRg(Aavx_XOR, eqz, ones, dst));
+         return dst;
+      }
+
+      default:
+         break;
+   } /* switch (e->Iex.Unop.op) */
+   } /* if (e->tag == Iex_Unop) */
+
+   if (e->tag == Iex_Binop) {
+   switch (e->Iex.Binop.op) {
+
+      case Iop_AndV256:     op = Aavx_AND;      goto do_AvxReRg;
+      case Iop_OrV256:      op = Aavx_OR;       goto do_AvxReRg;
+      case Iop_XorV256:     op = Aavx_XOR;      goto do_AvxReRg;
+      case Iop_Add8x32:     op = Aavx_ADD8;     goto do_AvxReRg;
+      case Iop_Add16x16:    op = Aavx_ADD16;    goto do_AvxReRg;
+      case Iop_Add32x8:     op = Aavx_ADD32;    goto do_AvxReRg;
+      case Iop_Add64x4:     op = Aavx_ADD64;    goto do_AvxReRg;
+      case Iop_QAdd8Sx32:   op = Aavx_QADD8S;   goto do_AvxReRg;
+      case Iop_QAdd16Sx16:  op = Aavx_QADD16S;  goto do_AvxReRg;
+      case Iop_QAdd8Ux32:   op = Aavx_QADD8U;   goto do_AvxReRg;
+      case Iop_QAdd16Ux16:  op = Aavx_QADD16U;  goto do_AvxReRg;
+      case Iop_Avg8Ux32:    op = Aavx_AVG8U;    goto do_AvxReRg;
+      case Iop_Avg16Ux16:   op = Aavx_AVG16U;   goto do_AvxReRg;
+      case Iop_CmpEQ8x32:   op = Aavx_CMPEQ8;   goto do_AvxReRg;
+      case Iop_CmpEQ16x16:  op = Aavx_CMPEQ16;  goto do_AvxReRg;
+      case Iop_CmpEQ32x8:   op = Aavx_CMPEQ32;  goto do_AvxReRg;
+      case Iop_CmpEQ64x4:   op = Aavx_CMPEQ64;  goto do_AvxReRg;
+      case Iop_CmpGT8Sx32:  op = Aavx_CMPGT8S;  goto do_AvxReRg;
+      case Iop_CmpGT16Sx16: op = Aavx_CMPGT16S; goto do_AvxReRg;
+      case Iop_CmpGT32Sx8:  op = Aavx_CMPGT32S; goto do_AvxReRg;
+      case Iop_CmpGT64Sx4:  op = Aavx_CMPGT64S; goto do_AvxReRg;
+      case Iop_Max8Sx32:    op = Aavx_MAX8S;    goto do_AvxReRg;
+      case Iop_Max16Sx16:   op = Aavx_MAX16S;   goto do_AvxReRg;
+      case Iop_Max32Sx8:    op = Aavx_MAX32S;   goto do_AvxReRg;
+      case Iop_Max8Ux32:    op = Aavx_MAX8U;    goto do_AvxReRg;
+      case Iop_Max16Ux16:   op = Aavx_MAX16U;   goto do_AvxReRg;
+      case Iop_Max32Ux8:    op = Aavx_MAX32U;   goto do_AvxReRg;
+      case Iop_Min8Sx32:    op = Aavx_MIN8S;    goto do_AvxReRg;
+      case Iop_Min16Sx16:   op = Aavx_MIN16S;   goto do_AvxReRg;
+      case Iop_Min32Sx8:    op = Aavx_MIN32S;   goto do_AvxReRg;
+      case Iop_Min8Ux32:    op = Aavx_MIN8U;    goto do_AvxReRg;
+      case Iop_Min16Ux16:   op = Aavx_MIN16U;   goto do_AvxReRg;
+      case Iop_Min32Ux8:    op = Aavx_MIN32U;   goto do_AvxReRg;
+      case Iop_MulHi16Ux16: op = Aavx_MULHI16U; goto do_AvxReRg;
+      case Iop_MulHi16Sx16: op = Aavx_MULHI16S; goto do_AvxReRg;
+      case Iop_Mul16x16:    op = Aavx_MUL16;    goto do_AvxReRg;
+      case Iop_Mul32x8:     op = Aavx_MUL32;    goto do_AvxReRg;
+      case Iop_Sub8x32:     op = Aavx_SUB8;     goto do_AvxReRg;
+      case Iop_Sub16x16:    op = Aavx_SUB16;    goto do_AvxReRg;
+      case Iop_Sub32x8:     op = Aavx_SUB32;    goto do_AvxReRg;
+      case Iop_Sub64x4:     op = Aavx_SUB64;    goto do_AvxReRg;
+      case Iop_QSub8Sx32:   op = Aavx_QSUB8S;   goto do_AvxReRg;
+      case Iop_QSub16Sx16:  op = Aavx_QSUB16S;  goto do_AvxReRg;
+      case Iop_QSub8Ux32:   op = Aavx_QSUB8U;   goto do_AvxReRg;
+      case Iop_QSub16Ux16:  op = Aavx_QSUB16U;  goto do_AvxReRg;
+      case Iop_Max32Fx8:    op = Aavx_MAX32F;   goto do_AvxReRg;
+      case Iop_Min32Fx8:    op = Aavx_MIN32F;   goto do_AvxReRg;
+      case Iop_Max64Fx4:    op = Aavx_MAX64F;   goto do_AvxReRg;
+      case Iop_Min64Fx4:    op = Aavx_MIN64F;   goto do_AvxReRg;
+      do_AvxReRg: {
+         HReg argL = iselV256Expr(env, e->Iex.Binop.arg1);
+         HReg argR = iselV256Expr(env, e->Iex.Binop.arg2);
+         HReg dst  = newVRegY(env);
+         addInstr(env, AMD64Instr_AvxReRg(op, argL, argR, dst));
+         return dst;
+      }
+
+      case Iop_ShlN16x16: op = Aavx_SHL16; goto do_AvxShift;
+      case Iop_ShlN32x8:  op = Aavx_SHL32; goto do_AvxShift;
+      case Iop_ShlN64x4:  op = Aavx_SHL64; goto do_AvxShift;
+      case Iop_SarN16x16: op = Aavx_SAR16; goto do_AvxShift;
+      case Iop_SarN32x8:  op = Aavx_SAR32; goto do_AvxShift;
+      case Iop_ShrN16x16: op = Aavx_SHR16; goto do_AvxShift;
+      case Iop_ShrN32x8:  op = Aavx_SHR32; goto do_AvxShift;
+      case Iop_ShrN64x4:  op = Aavx_SHR64; goto do_AvxShift;
+      do_AvxShift: {
+         /* Only immediate, in-range shift amounts; anything else is
+            left to the 128-bit code. */
+         const IRExpr* amt = e->Iex.Binop.arg2;
+         UInt laneBits;
+         switch (e->Iex.Binop.op) {
+            case Iop_ShlN16x16: case Iop_SarN16x16: case Iop_ShrN16x16:
+               laneBits = 16; break;
+            case Iop_ShlN32x8: case Iop_SarN32x8: case Iop_ShrN32x8:
+               laneBits = 32; break;
+            default:
+               laneBits = 64; break;
+         }
+         if (amt->tag != Iex_Const
+             || amt->Iex.Const.con->tag != Ico_U8
+             || amt->Iex.Const.con->Ico.U8 >= laneBits)
+            break;
+         HReg src = iselV256Expr(env, e->Iex.Binop.arg1);
+         HReg dst = newVRegY(env);
+         addInstr(env, AMD64Instr_AvxShift(op, amt->Iex.Const.con->Ico.U8,
+                                           src, dst));
+         return dst;
+      }
+
+      case Iop_V128HLtoV256: {
+         HReg hi  = iselVecExpr(env, e->Iex.Binop.arg1);
+         HReg lo  = iselVecExpr(env, e->Iex.Binop.arg2);
+         HReg dst = newVRegY(env);
+         addInstr(env, AMD64Instr_AvxInsV128(hi, lo, dst));
+         return dst;
+      }
+
+      default:
+         break;
+   } /* switch (e->Iex.Binop.op) */
+   } /* if (e->tag == Iex_Binop) */
+
+   if (e->tag == Iex_Triop) {
+   IRTriop *triop = e->Iex.Triop.details;
+   switch (triop->op) {
+
+      case Iop_Add32Fx8: op = Aavx_ADD32F; goto do_AvxFP_w_rm;
+      case Iop_Sub32Fx8: op = Aavx_SUB32F; goto do_AvxFP_w_rm;
+      case Iop_Mul32Fx8: op = Aavx_MUL32F; goto do_AvxFP_w_rm;
+      case Iop_Div32Fx8: op = Aavx_DIV32F; goto do_AvxFP_w_rm;
+      case Iop_Add64Fx4: op = Aavx_ADD64F; goto do_AvxFP_w_rm;
+      case Iop_Sub64Fx4: op = Aavx_SUB64F; goto do_AvxFP_w_rm;
+      case Iop_Mul64Fx4: op = Aavx_MUL64F; goto do_AvxFP_w_rm;
+      case Iop_Div64Fx4: op = Aavx_DIV64F; goto do_AvxFP_w_rm;
+      do_AvxFP_w_rm: {
+         HReg argL = iselV256Expr(env, triop->arg2);
+         HReg argR = iselV256Expr(env, triop->arg3);
+         HReg dst  = newVRegY(env);
+         /* XXXROUNDINGFIXME */
+         /* set roundingmode here */
+         addInstr(env, AMD64Instr_AvxReRg(op, argL, argR, dst));
+         return dst;
+      }
+
+      default:
+         break;
+   } /* switch (triop->op) */
+   } /* if (e->tag == Iex_Triop) */
+
+   if (e->tag == Iex_ITE) {
+      HReg r1  = iselV256Expr(env, e->Iex.ITE.iftrue);
+      HReg r0  = iselV256Expr(env, e->Iex.ITE.iffalse);
+      HReg dst = newVRegY(env);
+      addInstr(env, AMD64Instr_AvxReRg(Aavx_MOV, r1, r1, dst));
+      AMD64CondCode cc = iselCondCode(env, e->Iex.ITE.cond);
+      addInstr(env, AMD64Instr_AvxCMov(cc ^ 1, r0, dst));
+      return dst;
+   }
+
+   return INVALID_HREG;
+}
+
+
 /*---------------------------------------------------------*/
 /*--- ISEL: Statements                                  ---*/
 /*---------------------------------------------------------*/
@@ -4415,6 +4749,12 @@ static void iselStmt ( ISelEnv* env, IRStmt* stmt )
          addInstr(env, AMD64Instr_SseLdSt(False/*store*/, 16, r, am));
          return;
       }
+      if (tyd == Ity_V256 && env->avx2) {
+         AMD64AMode* am = iselIntExpr_AMode(env, stmt->Ist.Store.addr);
+         HReg r = iselV256Expr(env, stmt->Ist.Store.data);
+         addInstr(env, AMD64Instr_AvxLdSt(False/*store*/, r, am));
+         return;
+      }
       if (tyd == Ity_V256) {
          HReg        rA   = iselIntExpr_R(env, stmt->Ist.Store.addr);
          AMD64AMode* am0  = AMD64AMode_IR(0,  rA);
@@ -4474,6 +4814,13 @@ static void iselStmt ( ISelEnv* env, IRStmt* stmt )
          addInstr(env, AMD64Instr_SseLdSt(False/*store*/, 16, vec, am));
          return;
       }
+      if (ty == Ity_V256 && env->avx2) {
+         HReg        vec = iselV256Expr(env, stmt->Ist.Put.data);
+         AMD64AMode* am  = AMD64AMode_IR(stmt->Ist.Put.offset,
+                                         hregAMD64_RBP());
+         addInstr(env, AMD64Instr_AvxLdSt(False/*store*/, vec, am));
+         return;
+      }
       if (ty == Ity_V256) {
          HReg vHi, vLo;
          iselDVecExpr(&vHi, &vLo, env, stmt->Ist.Put.data);
@@ -4582,6 +4929,12 @@ static void iselStmt ( ISelEnv* env, IRStmt* stmt )
          addInstr(env, mk_vMOVsd_RR(src, dst));
          return;
       }
+      if (ty == Ity_V256 && env->avx2) {
+         HReg dst = lookupIRTemp(env, tmp);
+         HReg src = iselV256Expr(env, stmt->Ist.WrTmp.data);
+         addInstr(env, AMD64Instr_AvxReRg(Aavx_MOV, src, src, dst));
+         return;
+      }
       if (ty == Ity_V256) {
          HReg rHi, rLo, dstHi, dstLo;
          iselDVecExpr(&rHi,&rLo, env, stmt->Ist.WrTmp.data);
@@ -4620,7 +4973,8 @@ static void iselStmt ( ISelEnv* env, IRStmt* stmt )
          and the call is skipped. */
       UInt   addToSp = 0;
       RetLoc rloc    = mk_RetLoc_INVALID();
-      doHelperCall( &addToSp, &rloc, env, d->guard, d->cee, retty, d->args );
+      doHelperCall( &addToSp, &rloc, env, d->guard, d->cold,
+                    d->cee, retty, d->args );
       vassert(is_sane_RetLoc(rloc));
 
       /* Now figure out what to do with the returned value, if any. */
@@ -4658,6 +5012,13 @@ static void iselStmt ( ISelEnv* env, IRStmt* stmt )
             /* See comments for Ity_V128. */
             vassert(rloc.pri == RLPri_V256SpRel);
             vassert(addToSp >= 32);
+            if (env->avx2) {
+               HReg        dst = lookupIRTemp(env, d->tmp);
+               AMD64AMode* am  = AMD64AMode_IR(rloc.spOff, hregAMD64_RSP());
+               addInstr(env, AMD64Instr_AvxLdSt( True/*load*/, dst, am ));
+               add_to_rsp(env, addToSp);
+               return;
+            }
             HReg        dstLo, dstHi;
             lookupIRTempPair(&dstHi, &dstLo, env, d->tmp);
             AMD64AMode* amLo  = AMD64AMode_IR(rloc.spOff, hregAMD64_RSP());
@@ -4756,8 +5117,11 @@ static void iselStmt ( ISelEnv* env, IRStmt* stmt )
       break;
 
    /* --------- INSTR MARK --------- */
-   /* Doesn't generate any executable code ... */
+   /* Doesn't generate any executable code, but with a lazy guest PC
+      notes where the insn's code starts. */
    case Ist_IMark:
+       if (env->lazyGuestPC)
+          addInstr(env, AMD64Instr_PCMark(stmt->Ist.IMark.addr));
        return;
 
    /* --------- ABI HINT --------- */
@@ -4841,6 +5205,10 @@ static void iselStmt ( ISelEnv* env, IRStmt* stmt )
 static void iselNext ( ISelEnv* env,
                        IRExpr* next, IRJumpKind jk, Int offsIP )
 {
+   /* Leave the %ymm upper halves clean for whatever runs next. */
+   if (env->ymm_used)
+      addInstr(env, AMD64Instr_VZeroUpper());
+
    if (vex_traceflags & VEX_TRACE_VCODE) {
       vex_printf( "\n-- PUT(%d) = ", offsIP);
       ppIRExpr( next );
@@ -4936,7 +5304,7 @@ static void iselNext ( ISelEnv* env,
 HInstrArray* iselSB_AMD64 ( const IRSB* bb,
                             VexArch      arch_host,
                             const VexArchInfo* archinfo_host,
-                            const VexAbiInfo*  vbi/*UNUSED*/,
+                            const VexAbiInfo*  vbi,
                             Int offs_Host_EvC_Counter,
                             Int offs_Host_EvC_FailAddr,
                             Bool chainingAllowed,
@@ -4982,7 +5350,10 @@ HInstrArray* iselSB_AMD64 ( const IRSB* bb,
    /* and finally ... */
    env->chainingAllowed = chainingAllowed;
    env->hwcaps          = hwcaps_host;
+   env->avx2            = toBool(hwcaps_host & VEX_HWCAPS_AMD64_AVX2);
    env->max_ga          = max_ga;
+   env->lazyGuestPC     = vbi->host_amd64_lazy_guest_pc;
+   env->ymm_used        = False;
 
    /* For each IR temporary, allocate a suitably-kinded virtual
       register. */
@@ -5004,6 +5375,11 @@ HInstrArray* iselSB_AMD64 ( const IRSB* bb,
             hreg = mkHReg(True, HRcVec128, 0, j++);
             break;
          case Ity_V256:
+            if (env->avx2) {
+               hreg = mkHReg(True, HRcVec256, 0, j++);
+               env->ymm_used = True;
+               break;
+            }
             hreg   = mkHReg(True, HRcVec128, 0, j++);
             hregHI = mkHReg(True, HRcVec128, 0, j++);
             break;
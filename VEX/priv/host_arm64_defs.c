@@ -604,6 +604,10 @@ static void showARM64VecBinOp(/*OUT*/const HChar** nm,
       case ARM64vecb_CMEQ32x4:     *nm = "cmeq  ";    *ar = "4s";   return;
       case ARM64vecb_CMEQ16x8:     *nm = "cmeq  ";    *ar = "8h";   return;
       case ARM64vecb_CMEQ8x16:     *nm = "cmeq  ";    *ar = "16b";  return;
+      case ARM64vecb_CMTST64x2:    *nm = "cmtst ";    *ar = "2d";   return;
+      case ARM64vecb_CMTST32x4:    *nm = "cmtst ";    *ar = "4s";   return;
+      case ARM64vecb_CMTST16x8:    *nm = "cmtst ";    *ar = "8h";   return;
+      case ARM64vecb_CMTST8x16:    *nm = "cmtst ";    *ar = "16b";  return;
       case ARM64vecb_CMHI64x2:     *nm = "cmhi  ";    *ar = "2d";   return;
       case ARM64vecb_CMHI32x4:     *nm = "cmhi  ";    *ar = "4s";   return;
       case ARM64vecb_CMHI16x8:     *nm = "cmhi  ";    *ar = "8h";   return;
@@ -754,6 +758,12 @@ static void showARM64VecUnaryOp(/*OUT*/const HChar** nm,
       case ARM64vecu_FRSQRTE32x4: *nm = "frsqrte"; *ar = "4s";  return;
       case ARM64vecu_FSQRT64x2:   *nm = "fsqrt";   *ar = "2d";  return;
       case ARM64vecu_FSQRT32x4:   *nm = "fsqrt";   *ar = "4s";  return;
+      case ARM64vecu_SXTL8to16x8:  *nm = "sxtl ";  *ar = "8h";  return;
+      case ARM64vecu_SXTL16to32x4: *nm = "sxtl ";  *ar = "4s";  return;
+      case ARM64vecu_SXTL32to64x2: *nm = "sxtl ";  *ar = "2d";  return;
+      case ARM64vecu_UXTL8to16x8:  *nm = "uxtl ";  *ar = "8h";  return;
+      case ARM64vecu_UXTL16to32x4: *nm = "uxtl ";  *ar = "4s";  return;
+      case ARM64vecu_UXTL32to64x2: *nm = "uxtl ";  *ar = "2d";  return;
       default: vpanic("showARM64VecUnaryOp");
    }
 }
@@ -960,13 +970,15 @@ ARM64Instr* ARM64Instr_CSel ( HReg dst, HReg argL, HReg argR,
    return i;
 }
 ARM64Instr* ARM64Instr_Call ( ARM64CondCode cond, Addr64 target, Int nArgRegs,
-                              RetLoc rloc ) {
+                              RetLoc rloc, Bool cold ) {
    ARM64Instr* i = LibVEX_Alloc_inline(sizeof(ARM64Instr));
    i->tag                   = ARM64in_Call;
    i->ARM64in.Call.cond     = cond;
    i->ARM64in.Call.target   = target;
    i->ARM64in.Call.nArgRegs = nArgRegs;
    i->ARM64in.Call.rloc     = rloc;
+   i->ARM64in.Call.cold     = cold;
+   vassert(nArgRegs >= 0 && nArgRegs <= 8);
    vassert(is_sane_RetLoc(rloc));
    return i;
 }
@@ -1533,7 +1545,7 @@ void ppARM64Instr ( const ARM64Instr* i ) {
          vex_printf("0x%llx [nArgRegs=%d, ",
                     i->ARM64in.Call.target, i->ARM64in.Call.nArgRegs);
          ppRetLoc(i->ARM64in.Call.rloc);
-         vex_printf("]");
+         vex_printf("]%s", i->ARM64in.Call.cold ? " (cold)" : "");
          return;
       case ARM64in_AddToSP: {
          Int simm = i->ARM64in.AddToSP.simm;
@@ -2618,6 +2630,312 @@ ARM64Instr* genMove_ARM64(HReg from, HReg to, Bool mode64)
 }
 
 
+/* Rematerialisation support for the register allocator.  The guest
+   state is only ever accessed through x21, so an amode based on x21
+   with a constant offset is a known part of the guest state. */
+
+static Bool isGuestStateAMode ( const ARM64AMode* am, /*OUT*/Int* off )
+{
+   switch (am->tag) {
+      case ARM64am_RI9:
+         if (!sameHReg(am->ARM64am.RI9.reg, hregARM64_X21()))
+            return False;
+         *off = am->ARM64am.RI9.simm9;
+         return True;
+      case ARM64am_RI12:
+         if (!sameHReg(am->ARM64am.RI12.reg, hregARM64_X21()))
+            return False;
+         *off = am->ARM64am.RI12.uimm12 * am->ARM64am.RI12.szB;
+         return True;
+      default:
+         return False;
+   }
+}
+
+static ARM64AMode* dopyARM64AMode ( const ARM64AMode* am )
+{
+   switch (am->tag) {
+      case ARM64am_RI9:
+         return ARM64AMode_RI9(am->ARM64am.RI9.reg, am->ARM64am.RI9.simm9);
+      case ARM64am_RI12:
+         return ARM64AMode_RI12(am->ARM64am.RI12.reg, am->ARM64am.RI12.uimm12,
+                                am->ARM64am.RI12.szB);
+      case ARM64am_RR:
+         return ARM64AMode_RR(am->ARM64am.RR.base, am->ARM64am.RR.index);
+      default:
+         vpanic("dopyARM64AMode");
+   }
+}
+
+Bool isRematDef_ARM64 ( const ARM64Instr* i, /*OUT*/Int* gsOff,
+                        /*OUT*/Int* gsLen )
+{
+   switch (i->tag) {
+      case ARM64in_Imm64:
+      case ARM64in_VImmQ:
+         *gsLen = 0;
+         return True;
+      case ARM64in_LdSt64:
+         *gsLen = 8;
+         return i->ARM64in.LdSt64.isLoad
+                && isGuestStateAMode(i->ARM64in.LdSt64.amode, gsOff);
+      case ARM64in_LdSt32:
+         *gsLen = 4;
+         return i->ARM64in.LdSt32.isLoad
+                && isGuestStateAMode(i->ARM64in.LdSt32.amode, gsOff);
+      case ARM64in_LdSt16:
+         *gsLen = 2;
+         return i->ARM64in.LdSt16.isLoad
+                && isGuestStateAMode(i->ARM64in.LdSt16.amode, gsOff);
+      case ARM64in_LdSt8:
+         *gsLen = 1;
+         return i->ARM64in.LdSt8.isLoad
+                && isGuestStateAMode(i->ARM64in.LdSt8.amode, gsOff);
+      case ARM64in_VLdStS:
+         *gsOff = i->ARM64in.VLdStS.uimm12;
+         *gsLen = 4;
+         return i->ARM64in.VLdStS.isLoad
+                && sameHReg(i->ARM64in.VLdStS.rN, hregARM64_X21());
+      case ARM64in_VLdStD:
+         *gsOff = i->ARM64in.VLdStD.uimm12;
+         *gsLen = 8;
+         return i->ARM64in.VLdStD.isLoad
+                && sameHReg(i->ARM64in.VLdStD.rN, hregARM64_X21());
+      default:
+         return False;
+   }
+}
+
+ARM64Instr* genRemat_ARM64 ( const ARM64Instr* i, HReg to )
+{
+   switch (i->tag) {
+      case ARM64in_Imm64:
+         return ARM64Instr_Imm64(to, i->ARM64in.Imm64.imm64);
+      case ARM64in_VImmQ:
+         return ARM64Instr_VImmQ(to, i->ARM64in.VImmQ.imm);
+      case ARM64in_LdSt64:
+         return ARM64Instr_LdSt64(True/*load*/, to,
+                                  dopyARM64AMode(i->ARM64in.LdSt64.amode));
+      case ARM64in_LdSt32:
+         return ARM64Instr_LdSt32(True/*load*/, to,
+                                  dopyARM64AMode(i->ARM64in.LdSt32.amode));
+      case ARM64in_LdSt16:
+         return ARM64Instr_LdSt16(True/*load*/, to,
+                                  dopyARM64AMode(i->ARM64in.LdSt16.amode));
+      case ARM64in_LdSt8:
+         return ARM64Instr_LdSt8(True/*load*/, to,
+                                 dopyARM64AMode(i->ARM64in.LdSt8.amode));
+      case ARM64in_VLdStS:
+         return ARM64Instr_VLdStS(True/*load*/, to, i->ARM64in.VLdStS.rN,
+                                  i->ARM64in.VLdStS.uimm12);
+      case ARM64in_VLdStD:
+         return ARM64Instr_VLdStD(True/*load*/, to, i->ARM64in.VLdStD.rN,
+                                  i->ARM64in.VLdStD.uimm12);
+      default:
+         ppARM64Instr(i);
+         vpanic("genRemat_ARM64");
+   }
+}
+
+/* Instructions not listed here do not write the guest state: the
+   remaining stores (StrEX, CAS) only write guest memory. */
+Bool writesGuestState_ARM64 ( const ARM64Instr* i, /*OUT*/Int* off,
+                              /*OUT*/Int* len )
+{
+   const ARM64AMode* am;
+   switch (i->tag) {
+      case ARM64in_LdSt64:
+         if (i->ARM64in.LdSt64.isLoad)
+            return False;
+         am = i->ARM64in.LdSt64.amode; *len = 8; break;
+      case ARM64in_LdSt32:
+         if (i->ARM64in.LdSt32.isLoad)
+            return False;
+         am = i->ARM64in.LdSt32.amode; *len = 4; break;
+      case ARM64in_LdSt16:
+         if (i->ARM64in.LdSt16.isLoad)
+            return False;
+         am = i->ARM64in.LdSt16.amode; *len = 2; break;
+      case ARM64in_LdSt8:
+         if (i->ARM64in.LdSt8.isLoad)
+            return False;
+         am = i->ARM64in.LdSt8.amode; *len = 1; break;
+      case ARM64in_XDirect:
+         am = i->ARM64in.XDirect.amPC; *len = 8; break;
+      case ARM64in_XIndir:
+         am = i->ARM64in.XIndir.amPC; *len = 8; break;
+      case ARM64in_XAssisted:
+         am = i->ARM64in.XAssisted.amPC; *len = 8; break;
+      case ARM64in_VLdStH:
+         if (i->ARM64in.VLdStH.isLoad
+             || !sameHReg(i->ARM64in.VLdStH.rN, hregARM64_X21()))
+            return False;
+         *off = i->ARM64in.VLdStH.uimm12; *len = 2;
+         return True;
+      case ARM64in_VLdStS:
+         if (i->ARM64in.VLdStS.isLoad
+             || !sameHReg(i->ARM64in.VLdStS.rN, hregARM64_X21()))
+            return False;
+         *off = i->ARM64in.VLdStS.uimm12; *len = 4;
+         return True;
+      case ARM64in_VLdStD:
+         if (i->ARM64in.VLdStD.isLoad
+             || !sameHReg(i->ARM64in.VLdStD.rN, hregARM64_X21()))
+            return False;
+         *off = i->ARM64in.VLdStD.uimm12; *len = 8;
+         return True;
+      case ARM64in_VLdStQ:
+         /* The address is in a register, so could be anywhere in the
+            guest state. */
+         if (i->ARM64in.VLdStQ.isLoad)
+            return False;
+         *len = 0;
+         return True;
+      case ARM64in_Call:
+      case ARM64in_EvCheck:
+         /* Helpers may be passed the guest state pointer. */
+         *len = 0;
+         return True;
+      default:
+         return False;
+   }
+   if (isGuestStateAMode(am, off))
+      return True;
+   if (am->tag == ARM64am_RR
+       && sameHReg(am->ARM64am.RR.base, hregARM64_X21())) {
+      *len = 0;
+      return True;
+   }
+   return False;
+}
+
+
+/* Peephole rewrites of register allocated code. */
+
+static inline Bool isDeadAfter ( HReg r, ULong deadAfter )
+{
+   return toBool((deadAfter >> hregIndex(r)) & 1);
+}
+
+static Bool amodeMentions ( const ARM64AMode* am, HReg r )
+{
+   switch (am->tag) {
+      case ARM64am_RI9:
+         return sameHReg(am->ARM64am.RI9.reg, r);
+      case ARM64am_RI12:
+         return sameHReg(am->ARM64am.RI12.reg, r);
+      case ARM64am_RR:
+         return sameHReg(am->ARM64am.RR.base, r)
+                || sameHReg(am->ARM64am.RR.index, r);
+      default:
+         vpanic("amodeMentions(arm64)");
+   }
+}
+
+/* Is |i| an integer load or store?  If so, its size and operands. */
+static Bool isIntLdSt ( const ARM64Instr* i, /*OUT*/UInt* szB,
+                        /*OUT*/Bool* isLoad, /*OUT*/HReg* rD,
+                        /*OUT*/ARM64AMode** amode )
+{
+   switch (i->tag) {
+      case ARM64in_LdSt64:
+         *szB = 8; *isLoad = i->ARM64in.LdSt64.isLoad;
+         *rD = i->ARM64in.LdSt64.rD; *amode = i->ARM64in.LdSt64.amode;
+         return True;
+      case ARM64in_LdSt32:
+         *szB = 4; *isLoad = i->ARM64in.LdSt32.isLoad;
+         *rD = i->ARM64in.LdSt32.rD; *amode = i->ARM64in.LdSt32.amode;
+         return True;
+      case ARM64in_LdSt16:
+         *szB = 2; *isLoad = i->ARM64in.LdSt16.isLoad;
+         *rD = i->ARM64in.LdSt16.rD; *amode = i->ARM64in.LdSt16.amode;
+         return True;
+      case ARM64in_LdSt8:
+         *szB = 1; *isLoad = i->ARM64in.LdSt8.isLoad;
+         *rD = i->ARM64in.LdSt8.rD; *amode = i->ARM64in.LdSt8.amode;
+         return True;
+      default:
+         return False;
+   }
+}
+
+static ARM64Instr* mkIntLdSt ( UInt szB, Bool isLoad, HReg rD,
+                               ARM64AMode* amode )
+{
+   switch (szB) {
+      case 8: return ARM64Instr_LdSt64(isLoad, rD, amode);
+      case 4: return ARM64Instr_LdSt32(isLoad, rD, amode);
+      case 2: return ARM64Instr_LdSt16(isLoad, rD, amode);
+      case 1: return ARM64Instr_LdSt8(isLoad, rD, amode);
+      default: vpanic("mkIntLdSt(arm64)");
+   }
+}
+
+Bool peephole_ARM64 ( ARM64Instr** tail, /*MOD*/Int* n_tail,
+                      ULong deadAfter, /*MOD*/PeepholeStats* stats )
+{
+   Int         n    = *n_tail;
+   ARM64Instr* last = tail[n-1];
+   ARM64Instr* prev = n >= 2 ? tail[n-2] : NULL;
+   UInt        szB1, szB2;
+   Bool        isLoad1, isLoad2;
+   HReg        rD1, rD2;
+   ARM64AMode  *am1, *am2;
+   Int         off1, off2;
+
+   /* mov x,x  ==>  nothing */
+   if ((last->tag == ARM64in_MovI
+        && sameHReg(last->ARM64in.MovI.dst, last->ARM64in.MovI.src))
+       || (last->tag == ARM64in_VMov
+           && sameHReg(last->ARM64in.VMov.dst, last->ARM64in.VMov.src))) {
+      *n_tail = n - 1;
+      stats->n_self_moves++;
+      return True;
+   }
+
+   if (prev == NULL)
+      return False;
+
+   /* str xA,[x21,#off] ; ldr xB,[x21,#off]  ==>
+      str xA,[x21,#off] ; mov xB,xA   (or nothing, if A == B) */
+   if (isIntLdSt(prev, &szB1, &isLoad1, &rD1, &am1) && !isLoad1 && szB1 == 8
+       && isIntLdSt(last, &szB2, &isLoad2, &rD2, &am2) && isLoad2 && szB2 == 8
+       && isGuestStateAMode(am1, &off1) && isGuestStateAMode(am2, &off2)
+       && off1 == off2) {
+      if (sameHReg(rD1, rD2))
+         *n_tail = n - 1;
+      else
+         tail[n-1] = ARM64Instr_MovI(rD2, rD1);
+      stats->n_reload_fwds++;
+      return True;
+   }
+
+   /* mov xT,xS ; str xT,[..]  ==>  str xS,[..]
+      mov xT,xS ; mov xD,xT    ==>  mov xD,xS
+      (if xT is dead afterwards) */
+   if (prev->tag == ARM64in_MovI
+       && isDeadAfter(prev->ARM64in.MovI.dst, deadAfter)) {
+      HReg t = prev->ARM64in.MovI.dst;
+      HReg s = prev->ARM64in.MovI.src;
+      if (isIntLdSt(last, &szB2, &isLoad2, &rD2, &am2) && !isLoad2
+          && sameHReg(rD2, t) && !amodeMentions(am2, t)) {
+         tail[n-2] = mkIntLdSt(szB2, False, s, am2);
+         *n_tail = n - 1;
+         stats->n_copy_fwds++;
+         return True;
+      }
+      if (last->tag == ARM64in_MovI && sameHReg(last->ARM64in.MovI.src, t)) {
+         tail[n-2] = ARM64Instr_MovI(last->ARM64in.MovI.dst, s);
+         *n_tail = n - 1;
+         stats->n_copy_fwds++;
+         return True;
+      }
+   }
+
+   return False;
+}
+
+
 /* Emit an instruction into buf and return the number of bytes used.
    Note that buf is not the insn's final place, and therefore it is
    imperative to emit position-independent code. */
@@ -2692,6 +3010,7 @@ static inline UInt qregEnc ( HReg r )
 #define X000010  BITS8(0,0, 0,0,0,0,1,0)
 #define X000011  BITS8(0,0, 0,0,0,0,1,1)
 #define X000100  BITS8(0,0, 0,0,0,1,0,0)
+#define X000101  BITS8(0,0, 0,0,0,1,0,1)
 #define X000110  BITS8(0,0, 0,0,0,1,1,0)
 #define X000111  BITS8(0,0, 0,0,0,1,1,1)
 #define X001000  BITS8(0,0, 0,0,1,0,0,0)
@@ -2720,6 +3039,7 @@ static inline UInt qregEnc ( HReg r )
 #define X100101  BITS8(0,0, 1,0,0,1,0,1)
 #define X100110  BITS8(0,0, 1,0,0,1,1,0)
 #define X100111  BITS8(0,0, 1,0,0,1,1,1)
+#define X101001  BITS8(0,0, 1,0,1,0,0,1)
 #define X101101  BITS8(0,0, 1,0,1,1,0,1)
 #define X101110  BITS8(0,0, 1,0,1,1,1,0)
 #define X110000  BITS8(0,0, 1,1,0,0,0,0)
@@ -2774,6 +3094,19 @@ static inline UInt qregEnc ( HReg r )
 #define X11110111  BITS8(1,1,1,1,0,1,1,1)
 
 
+/* --- 2 fields --- */
+
+static inline UInt X_6_26 ( UInt f1, UInt f2 ) {
+   vassert(6+26 == 32);
+   vassert(f1 < (1<<6));
+   vassert(f2 < (1<<26));
+   UInt w = 0;
+   w = (w <<  6) | f1;
+   w = (w << 26) | f2;
+   return w;
+}
+
+
 /* --- 4 fields --- */
 
 static inline UInt X_8_19_1_4 ( UInt f1, UInt f2, UInt f3, UInt f4 ) {
@@ -3279,9 +3612,11 @@ static UInt* do_load_or_store64 ( UInt* p,
    Note that buf is not the insn's final place, and therefore it is
    imperative to emit position-independent code.  If the emitted
    instruction was a profiler inc, set *is_profInc to True, else
-   leave it unchanged. */
+   leave it unchanged.  Rarely executed code may be put in the cold
+   area |cold| instead, if it is not NULL. */
 
 Int emit_ARM64Instr ( /*MB_MOD*/Bool* is_profInc,
+                      /*MB_MOD*/ColdCode* cold,
                       UChar* buf, Int nbuf, const ARM64Instr* i,
                       Bool mode64, VexEndness endness_host,
                       const void* disp_cp_chain_me_to_slowEP,
@@ -3718,6 +4053,43 @@ Int emit_ARM64Instr ( /*MB_MOD*/Bool* is_profInc,
             goto bad;
          }
 
+         /* A conditional call which rarely happens is moved out of
+            line, if there is room for it.  The hot path is then just
+            a not-taken branch:
+                  b.{cond} stub
+               back:
+            and the stub, in the cold area, is
+               stub:
+                  x9 = &target            (1 to 4 insns)
+                  blr x9
+                  b back
+            Both branch offsets are fixed up later, by
+            resolveColdBranch_ARM64. */
+         if (i->ARM64in.Call.cold
+             && i->ARM64in.Call.cond != ARM64cc_AL
+             && hasRoomColdCode(cold, 6 * 4, 2)) {
+            Int   stub = cold->used;
+            UInt* c    = (UInt*)&cold->buf[stub];
+            vassert(0 == (stub & 3));
+            // b.{cond} stub
+            addColdFixup(cold, False/*atCold*/,
+                         cold->hot_base + ((UChar*)p - buf), stub);
+            *p++ = X_8_19_1_4(X01010100, 0, 0, (UInt)i->ARM64in.Call.cond);
+            // stub:
+            //    x9 = &target
+            c = imm64_to_ireg( c, /*x*/9, (ULong)i->ARM64in.Call.target );
+            //    blr x9
+            *c++ = 0xD63F0120;
+            //    b back
+            addColdFixup(cold, True/*atCold*/, (UChar*)c - cold->buf,
+                         cold->hot_base + ((UChar*)p - buf));
+            // 000101 imm26 = B (here + imm26 << 2)
+            *c++ = X_6_26(X000101, 0);
+            cold->used = (UChar*)c - cold->buf;
+            vassert(cold->used <= N_COLDCODE_BYTES);
+            goto done;
+         }
+
          UInt* ptmp = NULL;
          if (i->ARM64in.Call.cond != ARM64cc_AL) {
             /* Create a hole to put a conditional branch in.  We'll
@@ -4562,6 +4934,19 @@ Int emit_ARM64Instr ( /*MB_MOD*/Bool* is_profInc,
                *p++ = X_3_8_5_6_5_5(X011, X01110001, vM, X100011, vN, vD);
                break;
 
+            case ARM64vecb_CMTST64x2:
+               *p++ = X_3_8_5_6_5_5(X010, X01110111, vM, X100011, vN, vD);
+               break;
+            case ARM64vecb_CMTST32x4:
+               *p++ = X_3_8_5_6_5_5(X010, X01110101, vM, X100011, vN, vD);
+               break;
+            case ARM64vecb_CMTST16x8:
+               *p++ = X_3_8_5_6_5_5(X010, X01110011, vM, X100011, vN, vD);
+               break;
+            case ARM64vecb_CMTST8x16:
+               *p++ = X_3_8_5_6_5_5(X010, X01110001, vM, X100011, vN, vD);
+               break;
+
             case ARM64vecb_CMHI64x2:
                *p++ = X_3_8_5_6_5_5(X011, X01110111, vM,  X001101, vN, vD);
                break;
@@ -5058,6 +5443,26 @@ Int emit_ARM64Instr ( /*MB_MOD*/Bool* is_profInc,
             case ARM64vecu_FSQRT32x4:
                *p++ = X_3_8_5_6_5_5(X011, X01110101, X00001, X111110, vN, vD);
                break;
+            /* SXTL/UXTL are SSHLL/USHLL with a zero shift:
+               0q u 011110 immh:immb 101001 n d, immh:immb = esize */
+            case ARM64vecu_SXTL8to16x8:
+               *p++ = X_3_6_7_6_5_5(X000, X011110, X0001000, X101001, vN, vD);
+               break;
+            case ARM64vecu_SXTL16to32x4:
+               *p++ = X_3_6_7_6_5_5(X000, X011110, X0010000, X101001, vN, vD);
+               break;
+            case ARM64vecu_SXTL32to64x2:
+               *p++ = X_3_6_7_6_5_5(X000, X011110, X0100000, X101001, vN, vD);
+               break;
+            case ARM64vecu_UXTL8to16x8:
+               *p++ = X_3_6_7_6_5_5(X001, X011110, X0001000, X101001, vN, vD);
+               break;
+            case ARM64vecu_UXTL16to32x4:
+               *p++ = X_3_6_7_6_5_5(X001, X011110, X0010000, X101001, vN, vD);
+               break;
+            case ARM64vecu_UXTL32to64x2:
+               *p++ = X_3_6_7_6_5_5(X001, X011110, X0100000, X101001, vN, vD);
+               break;
             default:
                goto bad;
          }
@@ -5602,6 +6007,37 @@ VexInvalRange patchProfInc_ARM64 ( VexEndness endness_host,
    return vir;
 }
 
+
+/* Set the offset of a branch between the hot code and the cold code,
+   as previously created (with a zero offset) by the ARM64in_Call case
+   for emit_ARM64Instr.  This is done before the code is copied to its
+   final place, which need not be 4-aligned yet, hence the bytewise
+   accesses.  The code is position-independent, so the offset stays
+   valid. */
+void resolveColdBranch_ARM64 ( UChar* branch, const UChar* target )
+{
+   Long delta = (Long)(target - branch);
+   UInt w     = (UInt)branch[0]         | ((UInt)branch[1] << 8)
+                | ((UInt)branch[2] << 16) | ((UInt)branch[3] << 24);
+   vassert(0 == (delta & 3));
+   delta >>= 2;
+   if ((w & 0xFF000010) == 0x54000000) {
+      /* b.cond: 01010100 simm19 0 cond, with simm19 still zero */
+      vassert((w & 0x00FFFFE0) == 0);
+      vassert(delta >= -(1LL << 18) && delta < (1LL << 18));
+      w |= ((UInt)delta & 0x7FFFF) << 5;
+   } else {
+      /* b: 000101 simm26, with simm26 still zero */
+      vassert(w == 0x14000000);
+      vassert(delta >= -(1LL << 25) && delta < (1LL << 25));
+      w |= (UInt)delta & 0x3FFFFFF;
+   }
+   branch[0] = toUChar(w);
+   branch[1] = toUChar(w >> 8);
+   branch[2] = toUChar(w >> 16);
+   branch[3] = toUChar(w >> 24);
+}
+
 /*---------------------------------------------------------------*/
 /*--- end                                   host_arm64_defs.c ---*/
 /*---------------------------------------------------------------*/
@@ -329,6 +329,8 @@ typedef
       ARM64vecb_XOR,
       ARM64vecb_CMEQ64x2,    ARM64vecb_CMEQ32x4,
       ARM64vecb_CMEQ16x8,    ARM64vecb_CMEQ8x16,
+      ARM64vecb_CMTST64x2,   ARM64vecb_CMTST32x4,
+      ARM64vecb_CMTST16x8,   ARM64vecb_CMTST8x16,
       ARM64vecb_CMHI64x2,    ARM64vecb_CMHI32x4, /* >u */
       ARM64vecb_CMHI16x8,    ARM64vecb_CMHI8x16,
       ARM64vecb_CMGT64x2,    ARM64vecb_CMGT32x4, /* >s */
@@ -415,6 +417,9 @@ typedef
       ARM64vecu_FRECPE64x2,   ARM64vecu_FRECPE32x4,
       ARM64vecu_FRSQRTE64x2,  ARM64vecu_FRSQRTE32x4,
       ARM64vecu_FSQRT64x2,    ARM64vecu_FSQRT32x4,
+      /* These widen the lower 64 bits of the source. */
+      ARM64vecu_SXTL8to16x8,  ARM64vecu_SXTL16to32x4, ARM64vecu_SXTL32to64x2,
+      ARM64vecu_UXTL8to16x8,  ARM64vecu_UXTL16to32x4, ARM64vecu_UXTL32to64x2,
       ARM64vecu_INVALID
    }
    ARM64VecUnaryOp;
@@ -634,12 +639,14 @@ typedef
             ARM64CondCode cond;
          } CSel;
          /* Pseudo-insn.  Call target (an absolute address), on given
-            condition (which could be ARM64cc_AL). */
+            condition (which could be ARM64cc_AL).  If cold, the call
+            rarely happens, and may be emitted out of line. */
          struct {
             RetLoc        rloc;     /* where the return value will be */
             Addr64        target;
             ARM64CondCode cond;
             Int           nArgRegs; /* # regs carrying args: 0 .. 8 */
+            Bool          cold;
          } Call;
          /* move SP by small, signed constant */
          struct {
@@ -932,7 +939,7 @@ extern ARM64Instr* ARM64Instr_XAssisted ( HReg dstGA, ARM64AMode* amPC,
 extern ARM64Instr* ARM64Instr_CSel    ( HReg dst, HReg argL, HReg argR,
                                         ARM64CondCode cond );
 extern ARM64Instr* ARM64Instr_Call    ( ARM64CondCode, Addr64, Int nArgRegs,
-                                        RetLoc rloc );
+                                        RetLoc rloc, Bool cold );
 extern ARM64Instr* ARM64Instr_AddToSP ( Int simm );
 extern ARM64Instr* ARM64Instr_FromSP  ( HReg dst );
 extern ARM64Instr* ARM64Instr_Mul     ( HReg dst, HReg argL, HReg argR,
@@ -994,6 +1001,7 @@ extern void ppARM64Instr ( const ARM64Instr* );
 extern void getRegUsage_ARM64Instr ( HRegUsage*, const ARM64Instr*, Bool );
 extern void mapRegs_ARM64Instr     ( HRegRemap*, ARM64Instr*, Bool );
 extern Int  emit_ARM64Instr        ( /*MB_MOD*/Bool* is_profInc,
+                                     /*MB_MOD*/ColdCode* cold,
                                      UChar* buf, Int nbuf, const ARM64Instr* i,
                                      Bool mode64,
                                      VexEndness endness_host,
@@ -1007,6 +1015,13 @@ extern void genSpill_ARM64  ( /*OUT*/HInstr** i1, /*OUT*/HInstr** i2,
 extern void genReload_ARM64 ( /*OUT*/HInstr** i1, /*OUT*/HInstr** i2,
                               HReg rreg, Int offset, Bool );
 extern ARM64Instr* genMove_ARM64(HReg from, HReg to, Bool);
+extern Bool isRematDef_ARM64 ( const ARM64Instr* i, /*OUT*/Int* gsOff,
+                               /*OUT*/Int* gsLen );
+extern ARM64Instr* genRemat_ARM64 ( const ARM64Instr* i, HReg to );
+extern Bool writesGuestState_ARM64 ( const ARM64Instr* i, /*OUT*/Int* off,
+                                     /*OUT*/Int* len );
+extern Bool peephole_ARM64 ( ARM64Instr** tail, /*MOD*/Int* n_tail,
+                             ULong deadAfter, /*MOD*/PeepholeStats* stats );
 
 extern const RRegUniverse* getRRegUniverse_ARM64 ( void );
 
@@ -1041,6 +1056,9 @@ extern VexInvalRange patchProfInc_ARM64 ( VexEndness endness_host,
                                           void*  place_to_patch,
                                           const ULong* location_of_counter );
 
+/* Resolve a branch between the hot code and the out-of-line code. */
+extern void resolveColdBranch_ARM64 ( UChar* branch, const UChar* target );
+
 
 #endif /* ndef __VEX_HOST_ARM64_DEFS_H */
 
@@ -464,17 +464,19 @@ Bool mightRequireFixedRegs ( IRExpr* e )
 
 /* Do a complete function call.  |guard| is a Ity_Bit expression
    indicating whether or not the call happens.  If guard==NULL, the
-   call is unconditional.  |retloc| is set to indicate where the
-   return value is after the call.  The caller (of this fn) must
-   generate code to add |stackAdjustAfterCall| to the stack pointer
-   after the call is done.  Returns True iff it managed to handle this
-   combination of arg/return types, else returns False. */
+   call is unconditional.  |cold| indicates that the call rarely
+   happens, so that it may be emitted out of line.  |retloc| is set
+   to indicate where the return value is after the call.  The caller
+   (of this fn) must generate code to add |stackAdjustAfterCall| to
+   the stack pointer after the call is done.  Returns True iff
+   it managed to handle this combination of arg/return types, else
+   returns False. */
 
 static
 Bool doHelperCall ( /*OUT*/UInt*   stackAdjustAfterCall,
                     /*OUT*/RetLoc* retloc,
                     ISelEnv* env,
-                    IRExpr* guard,
+                    IRExpr* guard, Bool cold,
                     IRCallee* cee, IRType retTy, IRExpr** args )
 {
    ARM64CondCode cc;
@@ -769,7 +771,7 @@ Bool doHelperCall ( /*OUT*/UInt*   stackAdjustAfterCall,
       allocation, to know what regs the call reads.) */
 
    target = (Addr)cee->addr;
-   addInstr(env, ARM64Instr_Call( cc, target, nextArgReg, *retloc ));
+   addInstr(env, ARM64Instr_Call( cc, target, nextArgReg, *retloc, cold ));
 
    return True; /* success */
 }
@@ -1733,7 +1735,8 @@ static HReg iselIntExpr_R_wrk ( ISelEnv* env, IRExpr* e )
          addInstr(env, ARM64Instr_MovI(hregARM64_X0(), regL));
          addInstr(env, ARM64Instr_MovI(hregARM64_X1(), regR));
          addInstr(env, ARM64Instr_Call( ARM64cc_AL, (Addr)fn,
-                                        2, mk_RetLoc_simple(RLPri_Int) ));
+                                        2, mk_RetLoc_simple(RLPri_Int),
+                                        False ));
          addInstr(env, ARM64Instr_MovI(res, hregARM64_X0()));
          return res;
       }
@@ -2029,7 +2032,8 @@ static HReg iselIntExpr_R_wrk ( ISelEnv* env, IRExpr* e )
       /* Marshal args, do the call, clear stack. */
       UInt   addToSp = 0;
       RetLoc rloc    = mk_RetLoc_INVALID();
-      Bool   ok      = doHelperCall( &addToSp, &rloc, env, NULL/*guard*/,
+      Bool   ok      = doHelperCall( &addToSp, &rloc, env,
+                                     NULL/*guard*/, False/*cold*/,
                                      e->Iex.CCall.cee, e->Iex.CCall.retty,
                                      e->Iex.CCall.args );
       /* */
@@ -2326,22 +2330,26 @@ static HReg iselV128Expr_wrk ( ISelEnv* env, IRExpr* e )
          case Iop_CmpNEZ16x8:
          case Iop_CmpNEZ32x4:
          case Iop_CmpNEZ64x2: {
-            HReg arg  = iselV128Expr(env, e->Iex.Unop.arg);
-            HReg zero = newVRegV(env);
-            HReg res  = newVRegV(env);
             ARM64VecBinOp cmp = ARM64vecb_INVALID;
             switch (e->Iex.Unop.op) {
-               case Iop_CmpNEZ64x2: cmp = ARM64vecb_CMEQ64x2; break;
-               case Iop_CmpNEZ32x4: cmp = ARM64vecb_CMEQ32x4; break;
-               case Iop_CmpNEZ16x8: cmp = ARM64vecb_CMEQ16x8; break;
-               case Iop_CmpNEZ8x16: cmp = ARM64vecb_CMEQ8x16; break;
+               case Iop_CmpNEZ64x2: cmp = ARM64vecb_CMTST64x2; break;
+               case Iop_CmpNEZ32x4: cmp = ARM64vecb_CMTST32x4; break;
+               case Iop_CmpNEZ16x8: cmp = ARM64vecb_CMTST16x8; break;
+               case Iop_CmpNEZ8x16: cmp = ARM64vecb_CMTST8x16; break;
                default: vassert(0);
             }
-            // This is pretty feeble.  Better: use CMP against zero
-            // and avoid the extra instruction and extra register.
-            addInstr(env, ARM64Instr_VImmQ(zero, 0x0000));
-            addInstr(env, ARM64Instr_VBinV(cmp, res, arg, zero));
-            addInstr(env, ARM64Instr_VUnaryV(ARM64vecu_NOT, res, res));
+            /* CmpNEZ(And(x,y)) is CMTST x,y; plain CmpNEZ(x) is
+               CMTST x,x. */
+            HReg res = newVRegV(env);
+            IRExpr* arg = e->Iex.Unop.arg;
+            if (arg->tag == Iex_Binop && arg->Iex.Binop.op == Iop_AndV128) {
+               HReg argL = iselV128Expr(env, arg->Iex.Binop.arg1);
+               HReg argR = iselV128Expr(env, arg->Iex.Binop.arg2);
+               addInstr(env, ARM64Instr_VBinV(cmp, res, argL, argR));
+            } else {
+               HReg argX = iselV128Expr(env, arg);
+               addInstr(env, ARM64Instr_VBinV(cmp, res, argX, argX));
+            }
             return res;
          }
          case Iop_V256toV128_0:
@@ -2356,31 +2364,33 @@ static HReg iselV128Expr_wrk ( ISelEnv* env, IRExpr* e )
             addInstr(env, ARM64Instr_VQfromX(res, arg));
             return res;
          }
-         case Iop_Widen8Sto16x8: {
-            HReg res = newVRegV(env);
-            HReg arg = iselIntExpr_R(env, e->Iex.Unop.arg);
-            addInstr(env, ARM64Instr_VQfromX(res, arg));
-            addInstr(env, ARM64Instr_VBinV(ARM64vecb_ZIP18x16, res, res, res));
-            addInstr(env, ARM64Instr_VShiftImmV(ARM64vecshi_SSHR16x8,
-                                                res, res, 8));
-            return res;
-         }
-         case Iop_Widen16Sto32x4: {
-            HReg res = newVRegV(env);
-            HReg arg = iselIntExpr_R(env, e->Iex.Unop.arg);
-            addInstr(env, ARM64Instr_VQfromX(res, arg));
-            addInstr(env, ARM64Instr_VBinV(ARM64vecb_ZIP116x8, res, res, res));
-            addInstr(env, ARM64Instr_VShiftImmV(ARM64vecshi_SSHR32x4,
-                                                res, res, 16));
-            return res;
-         }
-         case Iop_Widen32Sto64x2: {
-            HReg res = newVRegV(env);
-            HReg arg = iselIntExpr_R(env, e->Iex.Unop.arg);
-            addInstr(env, ARM64Instr_VQfromX(res, arg));
-            addInstr(env, ARM64Instr_VBinV(ARM64vecb_ZIP132x4, res, res, res));
-            addInstr(env, ARM64Instr_VShiftImmV(ARM64vecshi_SSHR64x2,
-                                                res, res, 32));
+         case Iop_Widen8Sto16x8:  case Iop_Widen8Uto16x8:
+         case Iop_Widen16Sto32x4: case Iop_Widen16Uto32x4:
+         case Iop_Widen32Sto64x2: case Iop_Widen32Uto64x2: {
+            ARM64VecUnaryOp op = ARM64vecu_INVALID;
+            switch (e->Iex.Unop.op) {
+               case Iop_Widen8Sto16x8:  op = ARM64vecu_SXTL8to16x8;  break;
+               case Iop_Widen16Sto32x4: op = ARM64vecu_SXTL16to32x4; break;
+               case Iop_Widen32Sto64x2: op = ARM64vecu_SXTL32to64x2; break;
+               case Iop_Widen8Uto16x8:  op = ARM64vecu_UXTL8to16x8;  break;
+               case Iop_Widen16Uto32x4: op = ARM64vecu_UXTL16to32x4; break;
+               case Iop_Widen32Uto64x2: op = ARM64vecu_UXTL32to64x2; break;
+               default: vassert(0);
+            }
+            /* SXTL/UXTL only look at the lower half of the source, so
+               if the arg is the lower half of a vector, use it as-is
+               and avoid the round trip through an integer register. */
+            HReg    res = newVRegV(env);
+            HReg    src;
+            IRExpr* arg = e->Iex.Unop.arg;
+            if (arg->tag == Iex_Unop && arg->Iex.Unop.op == Iop_V128to64) {
+               src = iselV128Expr(env, arg->Iex.Unop.arg);
+            } else {
+               src = newVRegV(env);
+               addInstr(env, ARM64Instr_VQfromX(src,
+                                                iselIntExpr_R(env, arg)));
+            }
+            addInstr(env, ARM64Instr_VUnaryV(op, res, src));
             return res;
          }
          /* ... */
@@ -3750,7 +3760,8 @@ static void iselStmt ( ISelEnv* env, IRStmt* stmt )
          call is skipped. */
       UInt   addToSp = 0;
       RetLoc rloc    = mk_RetLoc_INVALID();
-      doHelperCall( &addToSp, &rloc, env, d->guard, d->cee, retty, d->args );
+      doHelperCall( &addToSp, &rloc, env, d->guard, d->cold,
+                    d->cee, retty, d->args );
       vassert(is_sane_RetLoc(rloc));
 
       /* Now figure out what to do with the returned value, if any. */
@@ -4123,8 +4134,9 @@ HInstrArray* iselSB_ARM64 ( const IRSB* bb,
    /* Check that the host's endianness is as expected. */
    vassert(archinfo_host->endness == VexEndnessLE);
 
-   /* guard against unexpected space regressions */
-   vassert(sizeof(ARM64Instr) <= 32);
+   /* guard against unexpected space regressions.  ARM64in.Call is
+      the largest member, with its cold flag. */
+   vassert(sizeof(ARM64Instr) <= 40);
 
    /* Make up an initial environment to use. */
    env = LibVEX_Alloc_inline(sizeof(ISelEnv));
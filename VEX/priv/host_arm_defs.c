@@ -3070,6 +3070,7 @@ static UInt* do_load_or_store32 ( UInt* p,
    leave it unchanged. */
 
 Int emit_ARMInstr ( /*MB_MOD*/Bool* is_profInc,
+                    /*MB_MOD*/ColdCode* cold,
                     UChar* buf, Int nbuf, const ARMInstr* i, 
                     Bool mode64, VexEndness endness_host,
                     const void* disp_cp_chain_me_to_slowEP,
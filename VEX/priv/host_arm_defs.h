@@ -1057,6 +1057,7 @@ extern void ppARMInstr ( const ARMInstr* );
 extern void getRegUsage_ARMInstr ( HRegUsage*, const ARMInstr*, Bool );
 extern void mapRegs_ARMInstr     ( HRegRemap*, ARMInstr*, Bool );
 extern Int  emit_ARMInstr        ( /*MB_MOD*/Bool* is_profInc,
+                                   /*MB_MOD*/ColdCode* cold,
                                    UChar* buf, Int nbuf, const ARMInstr* i, 
                                    Bool mode64,
                                    VexEndness endness_host,
@@ -195,7 +195,7 @@ inline
 static void sanity_check_spill_offset ( VRegLR* vreg )
 {
    switch (vreg->reg_class) {
-      case HRcVec128: case HRcFlt64:
+      case HRcVec256: case HRcVec128: case HRcFlt64:
          vassert(0 == ((UShort)vreg->spill_offset % 16)); break;
       default:
          vassert(0 == ((UShort)vreg->spill_offset % 8)); break;
@@ -850,6 +850,25 @@ HInstrArray* doRegisterAllocation_v2 (
             ss_busy_until_before[ss_no+1] = vreg_lrs[j].dead_before;
             break;
 
+         case HRcVec256:
+            /* Similarly, find four adjacent free slots, moving along
+               in steps of 4. */
+            for (ss_no = 0; ss_no < N_SPILL64S-3; ss_no += 4)
+               if (ss_busy_until_before[ss_no+0] <= vreg_lrs[j].live_after
+                   && ss_busy_until_before[ss_no+1] <= vreg_lrs[j].live_after
+                   && ss_busy_until_before[ss_no+2] <= vreg_lrs[j].live_after
+                   && ss_busy_until_before[ss_no+3] <= vreg_lrs[j].live_after)
+                  break;
+            if (ss_no >= N_SPILL64S-3) {
+               vpanic("LibVEX_N_SPILL_BYTES is too low.  " 
+                      "Increase and recompile.");
+            }
+            ss_busy_until_before[ss_no+0] = vreg_lrs[j].dead_before;
+            ss_busy_until_before[ss_no+1] = vreg_lrs[j].dead_before;
+            ss_busy_until_before[ss_no+2] = vreg_lrs[j].dead_before;
+            ss_busy_until_before[ss_no+3] = vreg_lrs[j].dead_before;
+            break;
+
          default:
             /* The ordinary case -- just find a single spill slot. */
             /* Find the lowest-numbered spill slot which is available
@@ -1158,6 +1177,7 @@ HInstrArray* doRegisterAllocation_v2 (
                      EMIT_INSTR(spill1);
                   if (spill2)
                      EMIT_INSTR(spill2);
+                  con->stats->n_spills++;
                }
                rreg_state[k].eq_spill_slot = True;
             }
@@ -1334,6 +1354,7 @@ HInstrArray* doRegisterAllocation_v2 (
                   EMIT_INSTR(reload1);
                if (reload2)
                   EMIT_INSTR(reload2);
+               con->stats->n_reloads++;
                /* This rreg is read or modified by the instruction.
                   If it's merely read we can claim it now equals the
                   spill slot, but not so if it is modified. */
@@ -1419,6 +1440,7 @@ HInstrArray* doRegisterAllocation_v2 (
                EMIT_INSTR(spill1);
             if (spill2)
                EMIT_INSTR(spill2);
+            con->stats->n_spills++;
          }
 
          /* Update the rreg_state to reflect the new assignment for this
@@ -1445,6 +1467,7 @@ HInstrArray* doRegisterAllocation_v2 (
                EMIT_INSTR(reload1);
             if (reload2)
                EMIT_INSTR(reload2);
+            con->stats->n_reloads++;
             /* This rreg is read or modified by the instruction.
                If it's merely read we can claim it now equals the
                spill slot, but not so if it is modified. */
@@ -26,6 +26,32 @@
    The GNU General Public License is contained in the file COPYING.
 */
 
+/* This file holds the v3 register allocator and the v4 one
+   (--vex-regalloc-version=4). v4 is v3 with the spilling made cheaper,
+   which matters for heavily instrumented code such as Memcheck's:
+
+   - Exact next-use information is computed for every vreg. When a
+     register has to be freed, the vreg evicted is the one whose next use
+     is furthest away, with a preference for vregs which can be evicted
+     without a spill store.
+
+   - Live range splitting. When a real register becomes unavailable (for
+     example the caller-saved registers around a helper call), a vreg
+     bound to it is moved to a free register if there is one, rather than
+     spilled and reloaded. A spilled vreg is reloaded into whatever
+     register is free at its next use.
+
+   - Rematerialisation. A vreg whose only definition loads a constant, or
+     loads a value from the guest state which is not overwritten during
+     the vreg's live range, is never spilled: its defining instruction is
+     re-executed instead of a reload. This needs the optional isRematDef,
+     genRemat and writesGuestState callbacks.
+
+   - Spill slots are handed out lazily, only to vregs which actually get
+     spilled, and are reused as soon as their vreg is dead. v3 gives a
+     slot to every vreg before the instructions are processed. In both,
+     vregs coalesced by MOV coalescing share a slot. */
+
 #include "libvex_basictypes.h"
 #include "libvex.h"
 
@@ -43,14 +69,21 @@
 #define INVALID_INSTRNO (-2)
 #define INVALID_INDEX (-2)
 
+/* Returned by next_use() for a vreg without further uses. */
+#define NO_NEXT_USE 0x7FFF
+
+/* Number of 64-bit spill slots. */
+#define N_SPILL64S (LibVEX_N_SPILL_BYTES / 8)
+
 /* Register allocator state is kept in an array of VRegState's.
    There is an element for every virtual register (vreg).
    Elements are indexed [0 .. n_vregs-1].
    Records information about vreg live range and its state. */
 typedef
    struct {
-      /* Live range, register class and spill offset are computed during the
-         first register allocator pass and remain unchanged after that. */
+      /* Live range, register class, uses and rematerialisation info are
+         computed before the instructions are processed and remain
+         unchanged after that. */
 
       /* This vreg becomes live with this instruction (inclusive). Contains
          either an instruction number or INVALID_INSTRNO. */
@@ -64,14 +97,16 @@ typedef
       /* What is its current disposition? */
       enum { Unallocated, /* Neither spilled nor assigned to a real reg. */
              Assigned,    /* Assigned to a real register, viz rreg. */
-             Spilled      /* Spilled to the spill slot. */
+             Spilled      /* Spilled, or evicted if rematerialisable. */
            } disp;
 
       /* If .disp == Assigned, what rreg is it bound to? */
       HReg rreg;
 
-      /* The "home" spill slot. The offset is relative to the beginning of
+      /* The spill slot, given out up front by v3 and the first time the
+         vreg is spilled by v4. The offset is relative to the beginning of
          the guest state. */
+      Bool   has_spill_slot;
       UShort spill_offset;
 
       /* This vreg (vregS) is coalesced to another vreg
@@ -85,6 +120,24 @@ typedef
       /* If this vregS is coalesced to another vregD, what is the combined
          dead_before for vregS+vregD. Used to effectively allocate registers. */
       Short effective_dead_before;
+
+      /* If the vreg can be rematerialised, the instruction which computes
+         its value, else INVALID_INSTRNO. For a value loaded from the guest
+         state, |gs_off| and |gs_len| give the bytes loaded; |gs_len| is
+         zero for a constant. */
+      Short remat_def;
+      Short gs_off;
+      Short gs_len;
+
+      /* How many instructions write or modify this vreg. */
+      UShort n_writes;
+
+      /* The instructions mentioning this vreg, in order, are
+         uses[uses_first .. uses_first + n_uses - 1], and uses[uses_first +
+         next_use] is the first of them not yet processed. */
+      UInt   uses_first;
+      UShort n_uses;
+      UShort next_use;
    }
    VRegState;
 
@@ -110,10 +163,9 @@ typedef
       /* If .disp == Bound, what vreg is it bound to? */
       HReg vreg;
 
-      /* If .disp == Bound, has the associated vreg been reloaded from its spill
-         slot recently and is this rreg still equal to that spill slot?
-         Avoids unnecessary spilling that vreg later, when this rreg needs
-         to be reserved. */
+      /* If .disp == Bound, can the associated vreg be evicted without
+         a spill store? That is the case when it has been reloaded from its
+         spill slot and not modified since, or when it is rematerialisable. */
       Bool eq_spill_slot;
    }
    RRegState;
@@ -190,6 +242,16 @@ static inline void enlarge_rreg_lrs(RRegLRState* rreg_lrs)
    rreg_lrs->lrs_size = 2 * rreg_lrs->lrs_used;
 }
 
+/* The next instruction which uses the vreg, among those not yet
+   processed. */
+static inline Short next_use(const VRegState* vreg, const Short* uses)
+{
+   if (vreg->next_use < vreg->n_uses) {
+      return uses[vreg->uses_first + vreg->next_use];
+   }
+   return NO_NEXT_USE;
+}
+
 #define PRINT_STATE                                              \
    do {                                                          \
       print_state(con, vreg_state, n_vregs, rreg_state, n_rregs, \
@@ -228,7 +290,11 @@ static inline void print_state(
          written += con->ppReg(vreg->rreg);
          break;
       case Spilled:
-         written = vex_printf("spilled at offset %u", vreg->spill_offset);
+         if (vreg->remat_def != INVALID_INSTRNO) {
+            written = vex_printf("evicted, remat at %d", vreg->remat_def);
+         } else {
+            written = vex_printf("spilled at offset %u", vreg->spill_offset);
+         }
          break;
       default:
          vassert(0);
@@ -273,7 +339,7 @@ static inline void print_state(
          vex_printf("bound for ");
          con->ppReg(rreg->vreg);
          if (rreg->eq_spill_slot) {
-            vex_printf("    (equals to its spill slot)");
+            vex_printf("    (evictable without a spill)");
          }
          vex_printf("\n");
          break;
@@ -303,6 +369,89 @@ static inline void emit_instr(HInstr* instr, HInstrArray* instrs_out,
    addHInstr(instrs_out, instr);
 }
 
+/* Gives a spill slot to a vreg. Any slot whose previous occupant is dead
+   before instruction |from| can be reused: v3 passes the vreg's live_after,
+   v4 the instruction before which the vreg is first spilled. The slot stays
+   busy until the vreg and all the vregs coalesced with it are dead.
+
+   Each spill slot is 8 bytes long. For vregs which take more than 64 bits
+   to spill (for example classes Flt64 and Vec128), we have to allocate two
+   consecutive spill slots. For 256 bit registers (class Vec256), we have to
+   allocate four consecutive spill slots.
+
+   For Vec128-class on PowerPC, the spill slot's actual address must be
+   16-byte aligned. Since the spill slot's address is computed as an offset
+   from the guest state pointer, and since the user of the generated code
+   must set that pointer to a 32-byte aligned value, we have the residual
+   obligation here of choosing a 16-byte aligned spill slot offset for
+   Vec128-class values. Since each spill slot is 8 bytes long, that means for
+   Vec128-class values we must allocate a spill slot number which is
+   zero mod 2. Similarly, for Vec256 class on amd64, find a spill slot number
+   which is zero mod 4. */
+static void alloc_spill_slot(VRegState* vreg, Short from,
+                             Short* ss_busy_until_before,
+                             const RegAllocControl* con)
+{
+   STATIC_ASSERT((N_SPILL64S % 2) == 0);
+   STATIC_ASSERT((LibVEX_N_SPILL_BYTES % LibVEX_GUEST_STATE_ALIGN) == 0);
+
+   UInt ss_no;
+   switch (vreg->reg_class) {
+      case HRcFlt64:
+      case HRcVec128:
+         for (ss_no = 0; ss_no < N_SPILL64S - 1; ss_no += 2)
+            if (ss_busy_until_before[ss_no + 0] <= from
+                && ss_busy_until_before[ss_no + 1] <= from)
+               break;
+         if (ss_no >= N_SPILL64S - 1) {
+            vpanic("N_SPILL64S is too low in VEX. Increase and recompile.");
+         }
+         ss_busy_until_before[ss_no + 0] = vreg->effective_dead_before;
+         ss_busy_until_before[ss_no + 1] = vreg->effective_dead_before;
+         break;
+      case HRcVec256:
+         for (ss_no = 0; ss_no < N_SPILL64S - 3; ss_no += 4)
+            if (ss_busy_until_before[ss_no + 0] <= from
+                && ss_busy_until_before[ss_no + 1] <= from
+                && ss_busy_until_before[ss_no + 2] <= from
+                && ss_busy_until_before[ss_no + 3] <= from)
+               break;
+         if (ss_no >= N_SPILL64S - 3) {
+            vpanic("N_SPILL64S is too low in VEX. Increase and recompile.");
+         }
+         for (UInt k = 0; k < 4; k++) {
+            ss_busy_until_before[ss_no + k] = vreg->effective_dead_before;
+         }
+         break;
+      default:
+         for (ss_no = 0; ss_no < N_SPILL64S; ss_no++) {
+            if (ss_busy_until_before[ss_no] <= from)
+               break;
+         }
+         if (ss_no == N_SPILL64S) {
+            vpanic("N_SPILL64S is too low in VEX. Increase and recompile.");
+         }
+         ss_busy_until_before[ss_no] = vreg->effective_dead_before;
+         break;
+   }
+
+   /* This reflects VEX's hard-wired knowledge of the guest state layout:
+      the guest state itself, then two equal sized areas following it for two
+      sets of shadow state, and then the spill area. */
+   vreg->spill_offset   = toUShort(con->guest_sizeB * 3 + ss_no * 8);
+   vreg->has_spill_slot = True;
+
+   /* Independent check that we've made a sane choice of the slot. */
+   switch (vreg->reg_class) {
+   case HRcVec256: case HRcVec128: case HRcFlt64:
+      vassert((vreg->spill_offset % 16) == 0);
+      break;
+   default:
+      vassert((vreg->spill_offset % 8) == 0);
+      break;
+   }
+}
+
 /* Updates register allocator state after vreg has been spilled. */
 static inline void mark_vreg_spilled(
    UInt v_idx, VRegState* vreg_state, UInt n_vregs,
@@ -316,13 +465,14 @@ static inline void mark_vreg_spilled(
    FREE_RREG(&rreg_state[r_idx]);
 }
 
-/* Spills a vreg assigned to some rreg.
-   The vreg is spilled and the rreg is freed.
+/* Evicts a vreg assigned to some rreg. If |reuse_spill_slot|, a spill store
+   is generated only if the vreg cannot be recreated otherwise; if not, it is
+   always generated. The rreg is freed.
    Returns rreg's index. */
-static inline UInt spill_vreg(
+static inline UInt evict_vreg(
    HReg vreg, UInt v_idx, UInt current_ii, VRegState* vreg_state, UInt n_vregs,
-   RRegState* rreg_state, UInt n_rregs, HInstrArray* instrs_out,
-   const RegAllocControl* con)
+   RRegState* rreg_state, UInt n_rregs, Short* ss_busy_until_before,
+   Bool reuse_spill_slot, HInstrArray* instrs_out, const RegAllocControl* con)
 {
    /* Check some invariants first. */
    vassert(IS_VALID_VREGNO((v_idx)));
@@ -334,24 +484,33 @@ static inline UInt spill_vreg(
    vassert(vreg_state[v_idx].dead_before > (Short) current_ii);
    vassert(vreg_state[v_idx].reg_class != HRcINVALID);
 
-   /* Generate spill. */
-   HInstr* spill1 = NULL;
-   HInstr* spill2 = NULL;
-   con->genSpill(&spill1, &spill2, rreg, vreg_state[v_idx].spill_offset,
-                 con->mode64);
-   vassert(spill1 != NULL || spill2 != NULL); /* cannot be both NULL */
-   if (spill1 != NULL) {
-      emit_instr(spill1, instrs_out, con, "spill1");
-   }
-   if (spill2 != NULL) {
-      emit_instr(spill2, instrs_out, con, "spill2");
+   if (! reuse_spill_slot || ! rreg_state[r_idx].eq_spill_slot) {
+      vassert(vreg_state[v_idx].remat_def == INVALID_INSTRNO);
+      if (! vreg_state[v_idx].has_spill_slot) {
+         alloc_spill_slot(&vreg_state[v_idx], (Short) current_ii,
+                          ss_busy_until_before, con);
+      }
+
+      /* Generate spill. */
+      HInstr* spill1 = NULL;
+      HInstr* spill2 = NULL;
+      con->genSpill(&spill1, &spill2, rreg, vreg_state[v_idx].spill_offset,
+                    con->mode64);
+      vassert(spill1 != NULL || spill2 != NULL); /* cannot be both NULL */
+      if (spill1 != NULL) {
+         emit_instr(spill1, instrs_out, con, "spill1");
+      }
+      if (spill2 != NULL) {
+         emit_instr(spill2, instrs_out, con, "spill2");
+      }
+      con->stats->n_spills++;
    }
 
    mark_vreg_spilled(v_idx, vreg_state, n_vregs, rreg_state, n_rregs);
    return r_idx;
 }
 
-/* Chooses a vreg to be spilled based on various criteria.
+/* Chooses a vreg to be spilled based on various criteria (v3).
    The vreg must not be from the instruction being processed, that is, it must
    not be listed in reg_usage->vRegs. */
 static inline HReg find_vreg_to_spill(
@@ -408,6 +567,51 @@ static inline HReg find_vreg_to_spill(
    return vreg_found;
 }
 
+/* Chooses a vreg to be evicted (v4), among those of the given class bound to
+   rregs. The vreg must not be from the instruction being processed, that is,
+   it must not be listed in reg_usage->vRegs.
+   The ideal candidate is the one used again furthest away. Vregs which can be
+   evicted without a spill store cost only one instruction when they are
+   used again, instead of two, so they count as twice as far away. */
+static inline HReg find_vreg_to_evict(
+   const VRegState* vreg_state, UInt n_vregs,
+   const RRegState* rreg_state, UInt n_rregs,
+   const HRegUsage* instr_regusage, HRegClass target_hregclass,
+   const Short* uses, UInt current_ii, const RegAllocControl* con)
+{
+   HReg vreg_found = INVALID_HREG;
+   UInt score_so_far = 0;
+
+   for (UInt r_idx = con->univ->allocable_start[target_hregclass];
+        r_idx <= con->univ->allocable_end[target_hregclass]; r_idx++) {
+      if (rreg_state[r_idx].disp == Bound) {
+         HReg vreg = rreg_state[r_idx].vreg;
+         if (! HRegUsage__contains(instr_regusage, vreg)) {
+            Short nu = next_use(&vreg_state[hregIndex(vreg)], uses);
+            vassert(nu > (Short) current_ii);
+            UInt score = nu - current_ii;
+            if (rreg_state[r_idx].eq_spill_slot) {
+               score *= 2;
+            }
+
+            if (score > score_so_far) {
+               score_so_far = score;
+               vreg_found = vreg;
+            }
+         }
+      }
+   }
+
+   if (hregIsInvalid(vreg_found)) {
+      vex_printf("doRegisterAllocation_v3: cannot find a register in class: ");
+      ppHRegClass(target_hregclass);
+      vex_printf("\n");
+      vpanic("doRegisterAllocation_v3: cannot find a register.");
+   }
+
+   return vreg_found;
+}
+
 /* Find a free rreg of the correct class.
    Tries to find an rreg whose hard live range (if any) starts after the vreg's
    live range ends. If that is not possible, then at least whose live range
@@ -465,9 +669,21 @@ static Int find_free_rreg(
    return r_idx_found;
 }
 
-/* A target-independent register allocator (v3). Requires various functions
-   which it uses to deal abstractly with instructions and registers, since it
-   cannot have any target-specific knowledge.
+/* Is the free rreg going to stay free up to (but excluding) instruction
+   |until|, as far as its hard live ranges are concerned? */
+static inline Bool rreg_free_until(const RRegLRState* rreg_lrs,
+                                   UInt current_ii, Short until)
+{
+   if (rreg_lrs->lrs_used == 0) {
+      return True;
+   }
+   const RRegLR* lr = rreg_lrs->lr_current;
+   return (Short) current_ii >= lr->dead_before || lr->live_after >= until;
+}
+
+/* A target-independent register allocator (v3 or v4). Requires various
+   functions which it uses to deal abstractly with instructions and registers,
+   since it cannot have any target-specific knowledge.
 
    Returns a new list of instructions, which, as a result of the behaviour of
    mapRegs, will be in-place modifications of the original instructions.
@@ -478,12 +694,15 @@ static Int find_free_rreg(
 
    Takes unallocated instructions and returns allocated instructions.
 */
-HInstrArray* doRegisterAllocation_v3(
+static HInstrArray* do_register_allocation(
    /* Incoming virtual-registerised code. */
    HInstrArray* instrs_in,
 
    /* Register allocator controls to use. */
-   const RegAllocControl* con
+   const RegAllocControl* con,
+
+   /* Use the v4 spilling strategy? */
+   Bool v4
 )
 {
    vassert((con->guest_sizeB % LibVEX_GUEST_STATE_ALIGN) == 0);
@@ -517,6 +736,21 @@ HInstrArray* doRegisterAllocation_v3(
    UInt* coalesce_heads = LibVEX_Alloc_inline(n_vregs * sizeof(UInt));
    UInt nr_coalesce_heads = 0;
 
+   /* Vregs which might be rematerialised from the guest state, in the order
+      of their definitions. v4 only. */
+   UInt* gs_remats = NULL;
+   if (v4) {
+      gs_remats = LibVEX_Alloc_inline(n_vregs * sizeof(UInt));
+   }
+   UInt nr_gs_remats = 0;
+
+   /* The instructions using each vreg; see VRegState.uses_first. v4 only. */
+   Short* uses = NULL;
+
+   /* For each spill slot, the instruction before which it is in use. */
+   Short ss_busy_until_before[N_SPILL64S];
+   vex_bzero(&ss_busy_until_before, sizeof(ss_busy_until_before));
+
    /* The live range numbers are signed shorts, and so limiting the
       number of instructions to 15000 comfortably guards against them
       overflowing 32k. */
@@ -549,7 +783,7 @@ HInstrArray* doRegisterAllocation_v3(
 
 
 /* Finds an rreg of the correct class.
-   If a free rreg is not found, then spills a vreg not used by the current
+   If a free rreg is not found, then evicts a vreg not used by the current
    instruction and makes free the corresponding rreg. */
 #  define FIND_OR_MAKE_FREE_RREG(_ii, _v_idx, _reg_class, _reserve_phase)      \
    ({                                                                          \
@@ -557,15 +791,20 @@ HInstrArray* doRegisterAllocation_v3(
                       vreg_state, n_vregs, rreg_state, n_rregs, rreg_lr_state, \
                       (_v_idx), (_ii), (_reg_class), (_reserve_phase), con);   \
       if (_r_free_idx == INVALID_INDEX) {                                      \
-         HReg vreg_to_spill = find_vreg_to_spill(                              \
-                                     vreg_state, n_vregs, rreg_state, n_rregs, \
-                                     &reg_usage[(_ii)], (_reg_class),          \
-                                     reg_usage, (_ii) + 1,                     \
-                                     instrs_in->arr_used - 1, con);            \
-         _r_free_idx = spill_vreg(vreg_to_spill, hregIndex(vreg_to_spill),     \
+         HReg vreg_to_evict                                                    \
+            = v4 ? find_vreg_to_evict(vreg_state, n_vregs,                     \
+                                      rreg_state, n_rregs,                     \
+                                      &reg_usage[(_ii)], (_reg_class),         \
+                                      uses, (_ii), con)                        \
+                 : find_vreg_to_spill(vreg_state, n_vregs,                     \
+                                      rreg_state, n_rregs,                     \
+                                      &reg_usage[(_ii)], (_reg_class),         \
+                                      reg_usage, (_ii) + 1,                    \
+                                      instrs_in->arr_used - 1, con);           \
+         _r_free_idx = evict_vreg(vreg_to_evict, hregIndex(vreg_to_evict),     \
                                   (_ii), vreg_state, n_vregs,                  \
-                                  rreg_state, n_rregs,                         \
-                                  instrs_out, con);                            \
+                                  rreg_state, n_rregs, ss_busy_until_before,   \
+                                  v4, instrs_out, con);                        \
       }                                                                        \
                                                                                \
       vassert(IS_VALID_RREGNO(_r_free_idx));                                   \
@@ -581,10 +820,18 @@ HInstrArray* doRegisterAllocation_v3(
       vreg_state[v_idx].reg_class             = HRcINVALID;
       vreg_state[v_idx].disp                  = Unallocated;
       vreg_state[v_idx].rreg                  = INVALID_HREG;
+      vreg_state[v_idx].has_spill_slot        = False;
       vreg_state[v_idx].spill_offset          = 0;
       vreg_state[v_idx].coalescedTo           = INVALID_HREG;
       vreg_state[v_idx].coalescedFirst        = INVALID_HREG;
       vreg_state[v_idx].effective_dead_before = INVALID_INSTRNO;
+      vreg_state[v_idx].remat_def             = INVALID_INSTRNO;
+      vreg_state[v_idx].gs_off                = 0;
+      vreg_state[v_idx].gs_len                = 0;
+      vreg_state[v_idx].n_writes              = 0;
+      vreg_state[v_idx].uses_first            = 0;
+      vreg_state[v_idx].n_uses                = 0;
+      vreg_state[v_idx].next_use              = 0;
    }
 
    for (UInt r_idx = 0; r_idx < n_rregs; r_idx++) {
@@ -604,6 +851,7 @@ HInstrArray* doRegisterAllocation_v3(
    }
 
    /* --- Stage 1. Scan the incoming instructions. --- */
+   UInt n_mentions = 0;
    for (UShort ii = 0; ii < instrs_in->arr_used; ii++) {
       const HInstr* instr = instrs_in->arr[ii];
 
@@ -653,12 +901,28 @@ HInstrArray* doRegisterAllocation_v3(
          case HRmWrite:
             if (vreg_state[v_idx].live_after == INVALID_INSTRNO) {
                vreg_state[v_idx].live_after = toShort(ii);
+
+               /* Can the vreg be recomputed from its definition? Only if
+                  the definition writes nothing else and reads no vregs. */
+               Int gs_off, gs_len;
+               if (v4 && con->isRematDef != NULL && reg_usage[ii].n_vRegs == 1
+                   && con->isRematDef(instr, &gs_off, &gs_len)) {
+                  vreg_state[v_idx].remat_def = toShort(ii);
+                  vreg_state[v_idx].gs_off    = toShort(gs_off);
+                  vreg_state[v_idx].gs_len    = toShort(gs_len);
+                  if (gs_len > 0) {
+                     gs_remats[nr_gs_remats] = v_idx;
+                     nr_gs_remats += 1;
+                  }
+               }
             }
+            vreg_state[v_idx].n_writes += 1;
             break;
          case HRmModify:
             if (vreg_state[v_idx].live_after == INVALID_INSTRNO) {
                OFFENDING_VREG(v_idx, instr, "Modify");
             }
+            vreg_state[v_idx].n_writes += 1;
             break;
          default:
             vassert(0);
@@ -667,6 +931,8 @@ HInstrArray* doRegisterAllocation_v3(
          vreg_state[v_idx].dead_before = toShort(ii + 1);
          vreg_state[v_idx].effective_dead_before
             = vreg_state[v_idx].dead_before;
+         vreg_state[v_idx].n_uses += 1;
+         n_mentions += 1;
       }
 
       /* Process real registers mentioned in the instruction. */
@@ -727,11 +993,40 @@ HInstrArray* doRegisterAllocation_v3(
       }
    }
 
+   /* v4: lay out the lists of uses, then fill them in. A vreg written more
+      than once cannot be recomputed from a single definition. */
+   if (v4) {
+      if (n_mentions > 0) {
+         uses = LibVEX_Alloc_inline(n_mentions * sizeof(Short));
+      }
+      UInt uses_next = 0;
+      for (UInt v_idx = 0; v_idx < n_vregs; v_idx++) {
+         vreg_state[v_idx].uses_first = uses_next;
+         uses_next += vreg_state[v_idx].n_uses;
+         vreg_state[v_idx].n_uses = 0;
+         if (vreg_state[v_idx].n_writes != 1) {
+            vreg_state[v_idx].remat_def = INVALID_INSTRNO;
+         }
+      }
+      vassert(uses_next == n_mentions);
+      for (UShort ii = 0; ii < instrs_in->arr_used; ii++) {
+         for (UInt j = 0; j < reg_usage[ii].n_vRegs; j++) {
+            VRegState* vreg = &vreg_state[hregIndex(reg_usage[ii].vRegs[j])];
+            uses[vreg->uses_first + vreg->n_uses] = toShort(ii);
+            vreg->n_uses += 1;
+         }
+      }
+   }
+
    if (DEBUG_REGALLOC) {
       for (UInt v_idx = 0; v_idx < n_vregs; v_idx++) {
-         vex_printf("vreg %3u:  [%3d, %3d)\n",
+         vex_printf("vreg %3u:  [%3d, %3d)",
                     v_idx, vreg_state[v_idx].live_after,
                     vreg_state[v_idx].dead_before);
+         if (vreg_state[v_idx].remat_def != INVALID_INSTRNO) {
+            vex_printf("  remat at %d", vreg_state[v_idx].remat_def);
+         }
+         vex_printf("\n");
       }
 
       for (UInt r_idx = 0; r_idx < n_rregs; r_idx++) {
@@ -803,118 +1098,42 @@ HInstrArray* doRegisterAllocation_v3(
       }
    }
 
-   /* --- Stage 3. Allocate spill slots. --- */
-
-   /* Each spill slot is 8 bytes long. For vregs which take more than 64 bits
-      to spill (for example classes Flt64 and Vec128), we have to allocate two
-      consecutive spill slots. For 256 bit registers (class Vec256), we have to
-      allocate four consecutive spill slots.
-
-      For Vec128-class on PowerPC, the spill slot's actual address must be
-      16-byte aligned. Since the spill slot's address is computed as an offset
-      from the guest state pointer, and since the user of the generated code
-      must set that pointer to a 32-byte aligned value, we have the residual
-      obligation here of choosing a 16-byte aligned spill slot offset for
-      Vec128-class values. Since each spill slot is 8 bytes long, that means for
-      Vec128-class values we must allocate a spill slot number which is
-      zero mod 2.
-
-      Similarly, for Vec256 class on amd64, find a spill slot number which is
-      zero mod 4. This guarantees it will be 32-byte aligned, which isn't
-      actually necessary on amd64 (we use movUpd etc to spill), but seems like
-      a good practice.
-
-      Do a rank-based allocation of vregs to spill slot numbers. We put as few
-      values as possible in spill slots, but nevertheless need to have a spill
-      slot available for all vregs, just in case. */
-
-#  define N_SPILL64S (LibVEX_N_SPILL_BYTES / 8)
-   STATIC_ASSERT((N_SPILL64S % 2) == 0);
-   STATIC_ASSERT((LibVEX_N_SPILL_BYTES % LibVEX_GUEST_STATE_ALIGN) == 0);
-
-   Short ss_busy_until_before[N_SPILL64S];
-   vex_bzero(&ss_busy_until_before, sizeof(ss_busy_until_before));
-
-   for (UInt v_idx = 0; v_idx < n_vregs; v_idx++) {
-      /* True iff this vreg is unused. In which case we also expect that the
-         reg_class field for it has not been set.  */
-      if (vreg_state[v_idx].live_after == INVALID_INSTRNO) {
-         vassert(vreg_state[v_idx].reg_class == HRcINVALID);
-         continue;
-      }
-      if (! hregIsInvalid(vreg_state[v_idx].coalescedFirst)) {
-         /* Coalesced vregs should share the same spill slot with the first vreg
-            in the coalescing chain. But we don't have that information, yet. */
-         continue;
-      }
-
-      /* The spill slots are 64 bits in size.  As per the comment on definition
-         of HRegClass in host_generic_regs.h, that means, to spill a vreg of
-         class Flt64 or Vec128, we'll need to find two adjacent spill slots to
-         use. For Vec256, we'll need to find four adjacent slots to use. Note,
-         this logic needs to be kept in sync with the size info on the
-         definition of HRegClass. */
-      UInt ss_no;
-      switch (vreg_state[v_idx].reg_class) {
-         case HRcFlt64:
-         case HRcVec128:
-            /* Find two adjacent free slots which provide up to 128 bits to
-               spill the vreg. Since we are trying to find an even:odd pair,
-               move along in steps of 2 (slots). */
-            for (ss_no = 0; ss_no < N_SPILL64S - 1; ss_no += 2)
-               if (ss_busy_until_before[ss_no + 0] <= vreg_state[v_idx].live_after
-                 && ss_busy_until_before[ss_no + 1] <= vreg_state[v_idx].live_after)
-                  break;
-            if (ss_no >= N_SPILL64S - 1) {
-               vpanic("N_SPILL64S is too low in VEX. Increase and recompile.");
-            }
-            ss_busy_until_before[ss_no + 0]
-               = vreg_state[v_idx].effective_dead_before;
-            ss_busy_until_before[ss_no + 1]
-               = vreg_state[v_idx].effective_dead_before;
-            break;
-         default:
-            /* The ordinary case -- just find a single lowest-numbered spill
-               slot which is available at the start point of this interval,
-               and assign the interval to it. */
-            for (ss_no = 0; ss_no < N_SPILL64S; ss_no++) {
-               if (ss_busy_until_before[ss_no] <= vreg_state[v_idx].live_after)
-                  break;
-            }
-            if (ss_no == N_SPILL64S) {
-               vpanic("N_SPILL64S is too low in VEX. Increase and recompile.");
-            }
-            ss_busy_until_before[ss_no]
-               = vreg_state[v_idx].effective_dead_before;
-            break;
-      }
-
-      /* This reflects VEX's hard-wired knowledge of the guest state layout:
-         the guest state itself, then two equal sized areas following it for two
-         sets of shadow state, and then the spill area. */
-      vreg_state[v_idx].spill_offset
-         = toShort(con->guest_sizeB * 3 + ss_no * 8);
+   /* --- Stage 3. Allocate spill slots (v3). --- */
+   /* v3 does a rank-based allocation of vregs to spill slot numbers. We put
+      as few values as possible in spill slots, but nevertheless need to have
+      a spill slot available for all vregs, just in case. v4 hands the spill
+      slots out lazily instead. */
+   if (! v4) {
+      for (UInt v_idx = 0; v_idx < n_vregs; v_idx++) {
+         /* True iff this vreg is unused. In which case we also expect that
+            the reg_class field for it has not been set.  */
+         if (vreg_state[v_idx].live_after == INVALID_INSTRNO) {
+            vassert(vreg_state[v_idx].reg_class == HRcINVALID);
+            continue;
+         }
+         if (! hregIsInvalid(vreg_state[v_idx].coalescedFirst)) {
+            /* Coalesced vregs should share the same spill slot with the first
+               vreg in the coalescing chain. But we don't have that
+               information, yet. */
+            continue;
+         }
 
-      /* Independent check that we've made a sane choice of the slot. */
-      switch (vreg_state[v_idx].reg_class) {
-      case HRcVec128: case HRcFlt64:
-         vassert((vreg_state[v_idx].spill_offset % 16) == 0);
-         break;
-      default:
-         vassert((vreg_state[v_idx].spill_offset % 8) == 0);
-         break;
+         alloc_spill_slot(&vreg_state[v_idx], vreg_state[v_idx].live_after,
+                          ss_busy_until_before, con);
       }
    }
 
-   /* Fill in the spill offsets and effective_dead_before for coalesced vregs.*/
+   /* Fill in the spill slots and effective_dead_before for coalesced vregs. */
    for (UInt i = 0; i < nr_coalesce_heads; i++) {
       UInt vs_idx = coalesce_heads[i];
       Short effective_dead_before = vreg_state[vs_idx].effective_dead_before;
+      Bool   has_spill_slot       = vreg_state[vs_idx].has_spill_slot;
       UShort spill_offset         = vreg_state[vs_idx].spill_offset;
       HReg vregD = vreg_state[vs_idx].coalescedTo;
       while (! hregIsInvalid(vregD)) {
          UInt vd_idx = hregIndex(vregD);
          vreg_state[vd_idx].effective_dead_before = effective_dead_before;
+         vreg_state[vd_idx].has_spill_slot        = has_spill_slot;
          vreg_state[vd_idx].spill_offset          = spill_offset;
          vregD = vreg_state[vd_idx].coalescedTo;
       }
@@ -926,12 +1145,87 @@ HInstrArray* doRegisterAllocation_v3(
       PRINT_STATE;
    }
 
-   if (0) {
-      vex_printf("\n\n");
-      for (UInt v_idx = 0; v_idx < n_vregs; v_idx++) {
-         if (vreg_state[v_idx].live_after != INVALID_INSTRNO) {
-            vex_printf("vreg %3u    --> spill offset %u\n",
-                       v_idx, vreg_state[v_idx].spill_offset);
+
+   /* --- Stage 3a. Rematerialisation (preparation, v4). --- */
+   if (v4) {
+      /* A value loaded from the guest state can only be loaded again if the
+         guest state it came from is not written to while the vreg, or any
+         vreg coalesced to it, is live. Walk the instructions keeping a list of such
+         vregs which are live, and cross off those whose guest state gets
+         written. */
+      if (nr_gs_remats > 0 && con->writesGuestState == NULL) {
+         for (UInt i = 0; i < nr_gs_remats; i++) {
+            vreg_state[gs_remats[i]].remat_def = INVALID_INSTRNO;
+         }
+      } else if (nr_gs_remats > 0) {
+         UInt* live_gs_remats
+            = LibVEX_Alloc_inline(nr_gs_remats * sizeof(UInt));
+         UInt nr_live = 0;
+         UInt next    = 0;
+         for (UShort ii = 0; ii < instrs_in->arr_used; ii++) {
+            while (next < nr_gs_remats
+                   && vreg_state[gs_remats[next]].live_after < (Short) ii) {
+               live_gs_remats[nr_live] = gs_remats[next];
+               nr_live += 1;
+               next += 1;
+            }
+            if (nr_live == 0) {
+               if (next == nr_gs_remats) {
+                  break;
+               }
+               continue;
+            }
+
+            Int  off = 0, len = 0;
+            Bool writes = con->writesGuestState(instrs_in->arr[ii], &off, &len);
+            UInt k = 0;
+            for (UInt i = 0; i < nr_live; i++) {
+               VRegState* vreg = &vreg_state[live_gs_remats[i]];
+               if (vreg->remat_def == INVALID_INSTRNO
+                   || vreg->effective_dead_before <= (Short) ii) {
+                  continue; /* Done with it. */
+               }
+               if (writes && (len == 0 || (off < vreg->gs_off + vreg->gs_len
+                                           && vreg->gs_off < off + len))) {
+                  vreg->remat_def = INVALID_INSTRNO;
+                  continue;
+               }
+               live_gs_remats[k] = live_gs_remats[i];
+               k += 1;
+            }
+            nr_live = k;
+         }
+      }
+
+      /* A vreg evicted without a spill store has no spill slot to pass on to
+         the vregs it is coalesced to. So a coalescing chain is
+         rematerialisable only if all of it is: its head is, and the MOVs are
+         the only writes to the rest of it. */
+      for (UInt i = 0; i < nr_coalesce_heads; i++) {
+         VRegState* head = &vreg_state[coalesce_heads[i]];
+         if (head->remat_def == INVALID_INSTRNO) {
+            continue;
+         }
+
+         Bool all_remat = True;
+         for (HReg vregD = head->coalescedTo; ! hregIsInvalid(vregD);
+              vregD = vreg_state[hregIndex(vregD)].coalescedTo) {
+            if (vreg_state[hregIndex(vregD)].n_writes != 1) {
+               all_remat = False;
+               break;
+            }
+         }
+
+         if (! all_remat) {
+            head->remat_def = INVALID_INSTRNO;
+            continue;
+         }
+         for (HReg vregD = head->coalescedTo; ! hregIsInvalid(vregD);
+              vregD = vreg_state[hregIndex(vregD)].coalescedTo) {
+            VRegState* vd_st = &vreg_state[hregIndex(vregD)];
+            vd_st->remat_def = head->remat_def;
+            vd_st->gs_off    = head->gs_off;
+            vd_st->gs_len    = head->gs_len;
          }
       }
    }
@@ -950,6 +1244,17 @@ HInstrArray* doRegisterAllocation_v3(
          vex_printf("\n");
       }
 
+      /* v4: step past this instruction in the lists of uses, so that
+         next_use() of the vregs used here gives their use after this
+         instruction. */
+      if (v4) {
+         for (UInt j = 0; j < reg_usage[ii].n_vRegs; j++) {
+            VRegState* vreg = &vreg_state[hregIndex(reg_usage[ii].vRegs[j])];
+            vassert(uses[vreg->uses_first + vreg->next_use] == (Short) ii);
+            vreg->next_use += 1;
+         }
+      }
+
       /* ------------ Sanity checks ------------ */
 
       /* Sanity checks are relatively expensive. So they are done only once
@@ -978,6 +1283,12 @@ HInstrArray* doRegisterAllocation_v3(
                vassert(hregClass(vreg_state[v_idx].rreg)
                        == hregClass(con->univ->regs[r_idx]));
             }
+
+            /* A spilled vreg can always be brought back. */
+            if (vreg_state[v_idx].disp == Spilled) {
+               vassert(vreg_state[v_idx].has_spill_slot
+                       || vreg_state[v_idx].remat_def != INVALID_INSTRNO);
+            }
          }
 
          for (UInt r_idx = 0; r_idx < n_rregs; r_idx++) {
@@ -1054,6 +1365,9 @@ HInstrArray* doRegisterAllocation_v3(
             }
 
             vreg_state[vd_idx].disp = vreg_state[vs_idx].disp;
+            vreg_state[vd_idx].has_spill_slot
+               = vreg_state[vs_idx].has_spill_slot;
+            vreg_state[vd_idx].spill_offset = vreg_state[vs_idx].spill_offset;
             FREE_VREG(&vreg_state[vs_idx]);
 
             if (DEBUG_REGALLOC) {
@@ -1086,9 +1400,11 @@ HInstrArray* doRegisterAllocation_v3(
 
       /* --- Reserve and free rregs if needed. --- */
       /* If the rreg enters its hard live range and is not free:
-         1. If the corresponding vreg is not used by the instruction, spill it.
+         1. If the corresponding vreg is not used by the instruction, split
+            its live range: move it to a free rreg which stays free until
+            the vreg's next use, if there is one. Otherwise evict it.
          2. If the corresponding vreg is used by the instruction, then:
-         2a. If there are no free rregs, spill a vreg not used by this
+         2a. If there are no free rregs, evict a vreg not used by this
              instruction.
          2b. Move the corresponding vreg to a free rreg. This is better than
              spilling it and immediatelly reloading it.
@@ -1129,35 +1445,51 @@ HInstrArray* doRegisterAllocation_v3(
                      it now somehow. */
                   HReg vreg = rreg->vreg;
                   UInt v_idx = hregIndex(vreg);
+                  Int  r_free_idx;
 
                   if (! HRegUsage__contains(&reg_usage[ii], vreg)) {
-                     if (rreg->eq_spill_slot) {
-                        mark_vreg_spilled(v_idx, vreg_state, n_vregs,
-                                          rreg_state, n_rregs);
-                     } else {
-                        /* Spill the vreg. It is not used by this instruction.*/
-                        spill_vreg(vreg, v_idx, ii, vreg_state, n_vregs,
-                                   rreg_state, n_rregs, instrs_out, con);
+                     /* v4 moves the vreg to a free rreg, if there is one
+                        which stays free up to the vreg's next use. Otherwise
+                        the vreg is evicted. It is not used by this
+                        instruction. */
+                     r_free_idx = INVALID_INDEX;
+                     if (v4) {
+                        r_free_idx = find_free_rreg(
+                                     vreg_state, n_vregs, rreg_state, n_rregs,
+                                     rreg_lr_state, v_idx, ii,
+                                     vreg_state[v_idx].reg_class, True, con);
+                     }
+                     if (r_free_idx != INVALID_INDEX
+                         && !rreg_free_until(&rreg_lr_state[r_free_idx], ii,
+                                   next_use(&vreg_state[v_idx], uses) + 1)) {
+                        r_free_idx = INVALID_INDEX;
+                     }
+                     if (r_free_idx == INVALID_INDEX) {
+                        evict_vreg(vreg, v_idx, ii, vreg_state, n_vregs,
+                                   rreg_state, n_rregs, ss_busy_until_before,
+                                   True, instrs_out, con);
+                        break;
                      }
                   } else {
                      /* Find or make a free rreg where to move this vreg to. */
-                     UInt r_free_idx = FIND_OR_MAKE_FREE_RREG(
+                     r_free_idx = FIND_OR_MAKE_FREE_RREG(
                                   ii, v_idx, vreg_state[v_idx].reg_class, True);
-
-                     /* Generate "move" between real registers. */
-                     HInstr* move = con->genMove(con->univ->regs[r_idx],
-                                      con->univ->regs[r_free_idx], con->mode64);
-                     vassert(move != NULL);
-                     emit_instr(move, instrs_out, con, "move");
-
-                     /* Update the register allocator state. */
-                     vassert(vreg_state[v_idx].disp == Assigned);
-                     vreg_state[v_idx].rreg = con->univ->regs[r_free_idx];
-                     rreg_state[r_free_idx].disp          = Bound;
-                     rreg_state[r_free_idx].vreg          = vreg;
-                     rreg_state[r_free_idx].eq_spill_slot = rreg->eq_spill_slot;
-                     FREE_RREG(rreg);
                   }
+
+                  /* Generate "move" between real registers. */
+                  HInstr* move = con->genMove(con->univ->regs[r_idx],
+                                   con->univ->regs[r_free_idx], con->mode64);
+                  vassert(move != NULL);
+                  emit_instr(move, instrs_out, con, "move");
+                  con->stats->n_moves++;
+
+                  /* Update the register allocator state. */
+                  vassert(vreg_state[v_idx].disp == Assigned);
+                  vreg_state[v_idx].rreg = con->univ->regs[r_free_idx];
+                  rreg_state[r_free_idx].disp          = Bound;
+                  rreg_state[r_free_idx].vreg          = vreg;
+                  rreg_state[r_free_idx].eq_spill_slot = rreg->eq_spill_slot;
+                  FREE_RREG(rreg);
                   break;
                }
                case Free:
@@ -1183,9 +1515,10 @@ HInstrArray* doRegisterAllocation_v3(
       /* If the instruction reads exactly one vreg which is currently spilled,
          and this is the last use of that vreg, see if we can convert
          the instruction into one that reads directly from the spill slot.
-         This is clearly only possible for x86 and amd64 targets, since ppc and
-         arm are load-store architectures. If successful, replace
-         instrs_in->arr[ii] with this new instruction, and recompute
+         A word-sized value from the guest state can also be read directly
+         from there. This is clearly only possible for x86 and amd64 targets,
+         since ppc and arm are load-store architectures. If successful,
+         replace instrs_in->arr[ii] with this new instruction, and recompute
          its reg_usage, so that the change is invisible to the standard-case
          handling that follows. */
       if ((con->directReload != NULL) && (reg_usage[ii].n_vRegs <= 2)) {
@@ -1202,13 +1535,21 @@ HInstrArray* doRegisterAllocation_v3(
                nreads++;
                UInt v_idx = hregIndex(vreg);
                vassert(IS_VALID_VREGNO(v_idx));
-               if (vreg_state[v_idx].disp == Spilled) {
+               const VRegState* vreg_st = &vreg_state[v_idx];
+               if (vreg_st->disp == Spilled) {
                   /* Is this its last use? */
-                  vassert(vreg_state[v_idx].dead_before >= (Short) (ii + 1));
-                  if ((vreg_state[v_idx].dead_before == (Short) (ii + 1))
+                  vassert(vreg_st->dead_before >= (Short) (ii + 1));
+                  if ((vreg_st->dead_before == (Short) (ii + 1))
                       && hregIsInvalid(vreg_found)) {
-                     vreg_found = vreg;
-                     spill_offset = vreg_state[v_idx].spill_offset;
+                     if (vreg_st->remat_def == INVALID_INSTRNO) {
+                        vreg_found = vreg;
+                        spill_offset = vreg_st->spill_offset;
+                     } else if (vreg_st->gs_len == (con->mode64 ? 8 : 4)
+                                && (vreg_st->reg_class == HRcInt64
+                                    || vreg_st->reg_class == HRcInt32)) {
+                        vreg_found = vreg;
+                        spill_offset = vreg_st->gs_off;
+                     }
                   }
                }
             }
@@ -1249,15 +1590,15 @@ HInstrArray* doRegisterAllocation_v3(
 
       /* The vreg -> rreg map constructed and then applied to each
          instruction. */
-         HRegRemap remap;
-         initHRegRemap(&remap);
+      HRegRemap remap;
+      initHRegRemap(&remap);
 
       /* --- Allocate vregs used by the instruction. --- */
       /* Vregs used by the instruction can be in the following states:
          - Unallocated: vreg is entering its live range. Find a free rreg.
          - Assigned: we do nothing; rreg has been allocated previously.
-         - Spilled: Find a free rreg and reload vreg into it.
-         Naturally, finding a free rreg may involve spilling a vreg not used by
+         - Spilled: Find a free rreg and reload or rematerialise vreg into it.
+         Naturally, finding a free rreg may involve evicting a vreg not used by
          the instruction. */
       for (UInt j = 0; j < reg_usage[ii].n_vRegs; j++) {
          HReg vreg = reg_usage[ii].vRegs[j];
@@ -1289,19 +1630,27 @@ HInstrArray* doRegisterAllocation_v3(
             if ((vreg_state[v_idx].disp == Spilled)
                 && (reg_usage[ii].vMode[j] != HRmWrite)) {
 
-               HInstr* reload1 = NULL;
-               HInstr* reload2 = NULL;
-               con->genReload(&reload1, &reload2, rreg,
-                         vreg_state[v_idx].spill_offset, con->mode64);
-               vassert(reload1 != NULL || reload2 != NULL);
-               if (reload1 != NULL) {
-                  emit_instr(reload1, instrs_out, con, "reload1");
-               }
-               if (reload2 != NULL) {
-                  emit_instr(reload2, instrs_out, con, "reload2");
+               if (vreg_state[v_idx].remat_def != INVALID_INSTRNO) {
+                  HInstr* remat = con->genRemat(
+                                     instrs_in->arr[vreg_state[v_idx].remat_def],
+                                     rreg);
+                  emit_instr(remat, instrs_out, con, "remat");
+                  con->stats->n_remats++;
+               } else {
+                  vassert(vreg_state[v_idx].has_spill_slot);
+                  HInstr* reload1 = NULL;
+                  HInstr* reload2 = NULL;
+                  con->genReload(&reload1, &reload2, rreg,
+                                 vreg_state[v_idx].spill_offset, con->mode64);
+                  vassert(reload1 != NULL || reload2 != NULL);
+                  if (reload1 != NULL) {
+                     emit_instr(reload1, instrs_out, con, "reload1");
+                  }
+                  if (reload2 != NULL) {
+                     emit_instr(reload2, instrs_out, con, "reload2");
+                  }
+                  con->stats->n_reloads++;
                }
-
-
             }
 
             rreg_state[r_idx].disp          = Bound;
@@ -1312,9 +1661,11 @@ HInstrArray* doRegisterAllocation_v3(
             addToHRegRemap(&remap, vreg, rreg);
          }
 
-         /* If this vreg is written or modified, mark it so. */
+         /* If this vreg is written or modified, mark it so. The only write
+            to a rematerialisable vreg is its definition. */
          if (reg_usage[ii].vMode[j] != HRmRead) {
-            rreg_state[r_idx].eq_spill_slot = False;
+            rreg_state[r_idx].eq_spill_slot
+               = vreg_state[v_idx].remat_def != INVALID_INSTRNO;
          }
       }
 
@@ -1368,6 +1719,28 @@ HInstrArray* doRegisterAllocation_v3(
    return instrs_out;
 }
 
+HInstrArray* doRegisterAllocation_v3(
+   /* Incoming virtual-registerised code. */
+   HInstrArray* instrs_in,
+
+   /* Register allocator controls to use. */
+   const RegAllocControl* con
+)
+{
+   return do_register_allocation(instrs_in, con, False);
+}
+
+HInstrArray* doRegisterAllocation_v4(
+   /* Incoming virtual-registerised code. */
+   HInstrArray* instrs_in,
+
+   /* Register allocator controls to use. */
+   const RegAllocControl* con
+)
+{
+   return do_register_allocation(instrs_in, con, True);
+}
+
 /*----------------------------------------------------------------------------*/
 /*---                                            host_generic_reg_alloc3.c ---*/
 /*----------------------------------------------------------------------------*/
@@ -53,6 +53,7 @@ void ppHRegClass ( HRegClass hrc )
       case HRcFlt64:   vex_printf("HRcFlt64"); break;
       case HRcVec64:   vex_printf("HRcVec64"); break;
       case HRcVec128:  vex_printf("HRcVec128"); break;
+      case HRcVec256:  vex_printf("HRcVec256"); break;
       default: vpanic("ppHRegClass");
    }
 }
@@ -76,6 +77,7 @@ UInt ppHReg ( HReg r )
       case HRcFlt64:   return vex_printf("%%%sD%u", maybe_v, regNN);
       case HRcVec64:   return vex_printf("%%%sv%u", maybe_v, regNN);
       case HRcVec128:  return vex_printf("%%%sV%u", maybe_v, regNN);
+      case HRcVec256:  return vex_printf("%%%sY%u", maybe_v, regNN);
       default: vpanic("ppHReg");
    }
 }
@@ -366,6 +368,86 @@ void ppRetLoc ( RetLoc ska )
 }
 
 
+/*---------------------------------------------------------*/
+/*--- Out-of-line (cold) code                           ---*/
+/*---------------------------------------------------------*/
+
+void initColdCode ( /*OUT*/ColdCode* cold )
+{
+   cold->used     = 0;
+   cold->hot_base = 0;
+   cold->n_fixups = 0;
+}
+
+void addColdFixup ( /*MOD*/ColdCode* cold, Bool atCold, Int at, Int to )
+{
+   vassert(cold->n_fixups < N_COLDCODE_FIXUPS);
+   vassert(at >= 0 && to >= 0);
+   cold->fixups[cold->n_fixups].at     = at;
+   cold->fixups[cold->n_fixups].to     = to;
+   cold->fixups[cold->n_fixups].atCold = atCold;
+   cold->n_fixups++;
+}
+
+
+/*---------------------------------------------------------*/
+/*--- Peephole optimisation after reg-alloc             ---*/
+/*---------------------------------------------------------*/
+
+/* The longest instruction sequence a back end's peephole function gets
+   to look at. */
+#define PEEPHOLE_WINDOW 3
+
+HInstrArray* doPeephole ( HInstrArray* instrs_in,
+                          const PeepholeControl* con )
+{
+   Int          i, n_tail;
+   ULong        live, allocable;
+   HRegUsage    usage;
+   HInstrArray* instrs_out = newHInstrArray();
+   ULong*       dead_after;
+
+   if (instrs_in->arr_used == 0)
+      return instrs_out;
+
+   vassert(con->univ->allocable <= 64);
+   allocable = con->univ->allocable == 64
+                  ? ~0ULL : (1ULL << con->univ->allocable) - 1;
+
+   /* Find which allocatable real registers are dead after each
+      instruction.  Nothing is live at the end of the block, since the
+      guest state is in memory by then. */
+   dead_after = LibVEX_Alloc_inline(instrs_in->arr_used * sizeof(ULong));
+   live = 0;
+   for (i = instrs_in->arr_used - 1; i >= 0; i--) {
+      dead_after[i] = allocable & ~live;
+      con->getRegUsage(&usage, instrs_in->arr[i], con->mode64);
+      live = (live & ~usage.rWritten) | usage.rRead;
+   }
+
+   /* Append the instructions one at a time, each time letting the back
+      end rewrite the last few of them.  A rewrite must leave the same
+      values in the registers live after the current instruction, so
+      |dead_after| stays valid for the end of the window. */
+   for (i = 0; i < instrs_in->arr_used; i++) {
+      addHInstr(instrs_out, instrs_in->arr[i]);
+      while (True) {
+         n_tail = instrs_out->arr_used < PEEPHOLE_WINDOW
+                     ? instrs_out->arr_used : PEEPHOLE_WINDOW;
+         HInstr** tail = &instrs_out->arr[instrs_out->arr_used - n_tail];
+         Int n_tail_after = n_tail;
+         if (!con->peephole(tail, &n_tail_after, dead_after[i], con->stats))
+            break;
+         vassert(n_tail_after >= 0 && n_tail_after <= n_tail);
+         instrs_out->arr_used -= n_tail - n_tail_after;
+         if (instrs_out->arr_used == 0)
+            break;
+      }
+   }
+
+   return instrs_out;
+}
+
 /*---------------------------------------------------------------*/
 /*--- end                                 host_generic_regs.c ---*/
 /*---------------------------------------------------------------*/
@@ -104,6 +104,7 @@ typedef  struct { UInt u32; }  HReg;
                              so won't fit in a 64-bit slot)
       HRcVec64     64 bits
       HRcVec128    128 bits
+      HRcVec256    256 bits
 
    If you add another regclass, you must remember to update
    host_generic_reg_alloc*.c and RRegUniverse accordingly.
@@ -119,7 +120,8 @@ typedef
       HRcFlt64=6,     /* 64-bit float */
       HRcVec64=7,     /* 64-bit SIMD */
       HRcVec128=8,    /* 128-bit SIMD */
-      HrcLAST=HRcVec128
+      HRcVec256=9,    /* 256-bit SIMD */
+      HrcLAST=HRcVec256
    }
    HRegClass;
 
@@ -470,10 +472,82 @@ static inline Bool is_RetLoc_INVALID ( RetLoc rl ) {
 }
 
 
+/*---------------------------------------------------------*/
+/*--- Out-of-line (cold) code                           ---*/
+/*---------------------------------------------------------*/
+
+/* This is common to all back ends.  While a superblock is being
+   assembled, an emitter may put rarely executed code (eg, conditional
+   calls marked as cold in the IR) into a cold area rather than
+   inline, so that the hot path is straight-line code.  The cold area
+   is appended to the hot code once the whole superblock has been
+   assembled.  Since the final distance between the two is not known
+   until then, the branches from the hot code to the cold code and
+   back are emitted with a zero displacement, and recorded as fixups,
+   which are then resolved by the back end's resolveColdBranch
+   function.
+
+   An emitter which finds that the cold area is NULL or full simply
+   generates the code inline, so using it is never required. */
+
+#define N_COLDCODE_BYTES  4096
+#define N_COLDCODE_FIXUPS 256
+
+typedef
+   struct {
+      /* Where the branch is: an offset in the hot code if .atCold is
+         False, else in the cold code. */
+      Int  at;
+      /* Where it goes to: an offset in the other area. */
+      Int  to;
+      Bool atCold;
+   }
+   ColdFixup;
+
+typedef
+   struct {
+      /* The cold code.  Keep this first, so that it is suitably
+         aligned for back ends which emit 32-bit words. */
+      UChar     buf[N_COLDCODE_BYTES];
+      Int       used;
+      /* The offset in the hot code of the instruction being emitted.
+         Set by the caller of the emitter. */
+      Int       hot_base;
+      ColdFixup fixups[N_COLDCODE_FIXUPS];
+      Int       n_fixups;
+   }
+   ColdCode;
+
+extern void initColdCode ( /*OUT*/ColdCode* cold );
+
+/* Is there room in the cold area for |nbytes| of code and |nfixups|
+   fixups? */
+static inline Bool hasRoomColdCode ( const ColdCode* cold,
+                                     Int nbytes, Int nfixups ) {
+   return cold != NULL
+          && cold->used + nbytes <= N_COLDCODE_BYTES
+          && cold->n_fixups + nfixups <= N_COLDCODE_FIXUPS;
+}
+
+extern void addColdFixup ( /*MOD*/ColdCode* cold,
+                           Bool atCold, Int at, Int to );
+
+
 /*---------------------------------------------------------*/
 /*--- Reg alloc: TODO: move somewhere else              ---*/
 /*---------------------------------------------------------*/
 
+/* Counts of the spill code generated by the register allocator, for
+   statistics only. */
+typedef
+   struct {
+      UInt n_spills;  /* stores of registers to spill slots */
+      UInt n_reloads; /* loads of registers from spill slots */
+      UInt n_remats;  /* values recomputed instead of being reloaded */
+      UInt n_moves;   /* reg-reg moves added to free up registers */
+   }
+   RegAllocStats;
+
 /* Control of the VEX register allocator. */
 typedef
    struct {
@@ -497,12 +571,30 @@ typedef
       HInstr* (*directReload)(HInstr*, HReg, Short);
       UInt    guest_sizeB;
 
+      /* Optional rematerialisation support, used by v4 only.
+         isRematDef: does the insn write a single register from a
+         constant or from the guest state, reading no other registers,
+         so that it can be re-executed instead of spilling and reloading
+         the value?  If so, also sets *gsOff and *gsLen to the guest
+         state bytes read (*gsLen is 0 for constants).
+         genRemat: returns a copy of such an insn, writing the given
+         real register instead.
+         writesGuestState: might the insn write the guest state?  If so,
+         sets *off and *len to the bytes written, or *len to 0 if they
+         are not known. */
+      Bool    (*isRematDef)(const HInstr*, Int* gsOff, Int* gsLen);
+      HInstr* (*genRemat)(const HInstr*, HReg);
+      Bool    (*writesGuestState)(const HInstr*, Int* off, Int* len);
+
       /* For debug printing only. */
       void (*ppInstr)(const HInstr*, Bool);
       UInt (*ppReg)(HReg);
 
       /* 32/64bit mode */
       Bool mode64;
+
+      /* Where to count the spill code generated. */
+      RegAllocStats* stats;
    }
    RegAllocControl;
 
@@ -514,6 +606,57 @@ extern HInstrArray* doRegisterAllocation_v3(
    HInstrArray* instrs_in,
    const RegAllocControl* con
 );
+extern HInstrArray* doRegisterAllocation_v4(
+   HInstrArray* instrs_in,
+   const RegAllocControl* con
+);
+
+
+/*---------------------------------------------------------*/
+/*--- Peephole optimisation after reg-alloc             ---*/
+/*---------------------------------------------------------*/
+
+/* How often each kind of peephole rewrite was done, for statistics
+   only. */
+typedef
+   struct {
+      UInt n_self_moves;  /* reg-reg moves to the same reg, removed */
+      UInt n_reload_fwds; /* reloads just after a spill, made moves */
+      UInt n_copy_fwds;   /* reg-reg moves merged into the next insn */
+      UInt n_imm_fwds;    /* constants merged into the next insn */
+      UInt n_zext_folds;  /* zero-extensions merged into their source */
+   }
+   PeepholeStats;
+
+typedef
+   struct {
+      /* The real-register universe of the host. */
+      const RRegUniverse* univ;
+
+      void (*getRegUsage)(HRegUsage*, const HInstr*, Bool);
+
+      /* Rewrites the last |*n_tail| instructions at |tail|, which are
+         at most 3.  May replace instructions in place and remove some
+         of them, setting |*n_tail| to the number left.  Returns True
+         if anything was changed.  |deadAfter| is the set of
+         allocatable real registers (as a bit mask of their indices in
+         |univ|) whose values are not used after the last
+         instruction. */
+      Bool (*peephole)(HInstr** tail, Int* n_tail, ULong deadAfter,
+                       PeepholeStats* stats);
+
+      /* 32/64bit mode */
+      Bool mode64;
+
+      /* Where to count the rewrites. */
+      PeepholeStats* stats;
+   }
+   PeepholeControl;
+
+/* Applies the back end's peephole rewrites to register allocated
+   code. */
+extern HInstrArray* doPeephole ( HInstrArray* instrs_in,
+                                 const PeepholeControl* con );
 
 
 #endif /* ndef __VEX_HOST_GENERIC_REGS_H */
@@ -3769,6 +3769,7 @@ static UChar *mkMoveReg(UChar * p, UInt r_dst, UInt r_src)
    instruction was a profiler inc, set *is_profInc to True, else
    leave it unchanged. */
 Int emit_MIPSInstr ( /*MB_MOD*/Bool* is_profInc,
+                     /*MB_MOD*/ColdCode* cold,
                      UChar* buf, Int nbuf, const MIPSInstr* i,
                      Bool mode64,
                      VexEndness endness_host,
@@ -1007,6 +1007,7 @@ extern void ppMIPSInstr(const MIPSInstr *, Bool mode64);
 extern void getRegUsage_MIPSInstr (HRegUsage *, const MIPSInstr *, Bool);
 extern void mapRegs_MIPSInstr     (HRegRemap *, MIPSInstr *, Bool mode64);
 extern Int        emit_MIPSInstr (/*MB_MOD*/Bool* is_profInc,
+                                  /*MB_MOD*/ColdCode* cold,
                                   UChar* buf, Int nbuf, const MIPSInstr* i,
                                   Bool mode64,
                                   VexEndness endness_host,
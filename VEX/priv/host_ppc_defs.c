@@ -3980,6 +3980,7 @@ static UChar* mkFormVA ( UChar* p, UInt opc1, UInt r1, UInt r2,
    it unchanged.
 */
 Int emit_PPCInstr ( /*MB_MOD*/Bool* is_profInc,
+                    /*MB_MOD*/ColdCode* cold,
                     UChar* buf, Int nbuf, const PPCInstr* i, 
                     Bool mode64, VexEndness endness_host,
                     const void* disp_cp_chain_me_to_slowEP,
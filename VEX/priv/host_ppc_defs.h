@@ -1202,6 +1202,7 @@ extern void ppPPCInstr(const PPCInstr*, Bool mode64);
 extern void getRegUsage_PPCInstr ( HRegUsage*, const PPCInstr*, Bool mode64 );
 extern void mapRegs_PPCInstr     ( HRegRemap*, PPCInstr* , Bool mode64);
 extern Int          emit_PPCInstr   ( /*MB_MOD*/Bool* is_profInc,
+                                      /*MB_MOD*/ColdCode* cold,
                                       UChar* buf, Int nbuf, const PPCInstr* i, 
                                       Bool mode64,
                                       VexEndness endness_host,
@@ -11319,7 +11319,8 @@ s390_insn_vec_triop_emit(UChar *buf, const s390_insn *insn)
 
 
 Int
-emit_S390Instr(Bool *is_profinc, UChar *buf, Int nbuf, const s390_insn *insn,
+emit_S390Instr(Bool *is_profinc, ColdCode *cold, UChar *buf, Int nbuf,
+               const s390_insn *insn,
                Bool mode64, VexEndness endness_host,
                const void *disp_cp_chain_me_to_slowEP,
                const void *disp_cp_chain_me_to_fastEP,
@@ -2123,6 +2123,7 @@ static UChar* push_word_from_tags ( UChar* p, UShort tags )
    leave it unchanged. */
 
 Int emit_X86Instr ( /*MB_MOD*/Bool* is_profInc,
+                    /*MB_MOD*/ColdCode* cold,
                     UChar* buf, Int nbuf, const X86Instr* i, 
                     Bool mode64, VexEndness endness_host,
                     const void* disp_cp_chain_me_to_slowEP,
@@ -717,6 +717,7 @@ extern void ppX86Instr ( const X86Instr*, Bool );
 extern void         getRegUsage_X86Instr ( HRegUsage*, const X86Instr*, Bool );
 extern void         mapRegs_X86Instr     ( HRegRemap*, X86Instr*, Bool );
 extern Int          emit_X86Instr   ( /*MB_MOD*/Bool* is_profInc,
+                                      /*MB_MOD*/ColdCode* cold,
                                       UChar* buf, Int nbuf, const X86Instr* i, 
                                       Bool mode64,
                                       VexEndness endness_host,
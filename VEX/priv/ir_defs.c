@@ -1459,6 +1459,8 @@ void ppIRDirty ( const IRDirty* d )
    }
    vex_printf("DIRTY ");
    ppIRExpr(d->guard);
+   if (d->cold)
+      vex_printf(" COLD");
    if (d->mFx != Ifx_None) {
       vex_printf(" ");
       ppIREffect(d->mFx);
@@ -2106,6 +2108,7 @@ IRDirty* emptyIRDirty ( void ) {
    d->guard    = NULL;
    d->args     = NULL;
    d->tmp      = IRTemp_INVALID;
+   d->cold     = False;
    d->mFx      = Ifx_None;
    d->mAddr    = NULL;
    d->mSize    = 0;
@@ -2455,6 +2458,7 @@ IRDirty* deepCopyIRDirty ( const IRDirty* d )
    d2->guard = deepCopyIRExpr(d->guard);
    d2->args  = deepCopyIRExprVec(d->args);
    d2->tmp   = d->tmp;
+   d2->cold  = d->cold;
    d2->mFx   = d->mFx;
    d2->mAddr = d->mAddr==NULL ? NULL : deepCopyIRExpr(d->mAddr);
    d2->mSize = d->mSize;
@@ -5774,7 +5774,8 @@ static Interval stmt_modifies_guest_state (
 /* notstatic */ Addr ado_treebuild_BB (
                         IRSB* bb,
                         Bool (*preciseMemExnsFn)(Int,Int,VexRegisterUpdates),
-                        VexRegisterUpdates pxControl
+                        VexRegisterUpdates pxControl,
+                        Bool loadsStayInInsn
                      )
 {
    Int      i, j, k, m;
@@ -5953,6 +5954,12 @@ static Interval stmt_modifies_guest_state (
                  reported. */
               || (env[k].doesLoad && putInterval.present &&
                   putRequiresPreciseMemExns)
+              /* when the guest PC is not kept up to date, it is
+                 recovered from the position of the faulting host insn
+                 relative to the IMarks, so a load must not be moved
+                 into the code of a later guest insn either. */
+              || (env[k].doesLoad && loadsStayInInsn
+                  && st->tag == Ist_IMark)
               /* probably overly conservative: a memory bus event
                  invalidates absolutely everything, so that all
                  computation prior to it is forced to complete before
@@ -64,12 +64,15 @@ void do_deadcode_BB ( IRSB* bb );
 /* The tree-builder.  Make (approximately) maximal safe trees.  bb is
    destructively modified.  Returns (unrelatedly, but useful later on)
    the guest address of the highest addressed byte from any insn in
-   this block, or Addr_MAX if unknown (can that ever happen?) */
+   this block, or Addr_MAX if unknown (can that ever happen?)
+   If loadsStayInInsn is True, no load is moved past an IMark, so that
+   a faulting load stays within the code of its own guest insn. */
 extern
 Addr ado_treebuild_BB (
         IRSB* bb,
         Bool (*preciseMemExnsFn)(Int,Int,VexRegisterUpdates),
-        VexRegisterUpdates pxControl
+        VexRegisterUpdates pxControl,
+        Bool loadsStayInInsn
      );
 
 #endif /* ndef __VEX_IR_OPT_H */
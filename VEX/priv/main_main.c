@@ -187,6 +187,7 @@ void LibVEX_default_VexControl ( /*OUT*/ VexControl* vcon )
    vcon->guest_chase_thresh             = 10;
    vcon->guest_chase_cond               = False;
    vcon->regalloc_version               = 3;
+   vcon->peephole                       = True;
 }
 
 
@@ -226,7 +227,9 @@ void LibVEX_Init (
    vassert(vcon->guest_chase_thresh < vcon->guest_max_insns);
    vassert(vcon->guest_chase_cond == True 
            || vcon->guest_chase_cond == False);
-   vassert(vcon->regalloc_version == 2 || vcon->regalloc_version == 3);
+   vassert(vcon->regalloc_version == 2 || vcon->regalloc_version == 3
+           || vcon->regalloc_version == 4);
+   vassert(vcon->peephole == True || vcon->peephole == False);
 
    /* Check that Vex has been built with sizes of basic types as
       stated in priv/libvex_basictypes.h.  Failure of any of these is
@@ -307,6 +310,95 @@ void LibVEX_Init (
    object files in non VEXMULTIARCH. */
 UInt s390_host_hwcaps;
 
+/* Likewise for amd64, whose emitter picks VEX encodings for the SSE
+   instructions when the host has AVX2. */
+UInt amd64_host_hwcaps;
+
+
+/* Is NAME one of the guest helpers that compute conditions or flags
+   from the flags thunk?  These are what the guest spechelpers try to
+   replace with inline IR. */
+static Bool is_cc_helper ( const HChar* name )
+{
+   static const HChar* const cc_helpers[] = {
+      "x86g_calculate_condition",   "x86g_calculate_eflags_c",
+      "x86g_calculate_eflags_all",
+      "amd64g_calculate_condition", "amd64g_calculate_rflags_c",
+      "amd64g_calculate_rflags_all",
+      "armg_calculate_condition",   "armg_calculate_flag_c",
+      "armg_calculate_flag_v",      "armg_calculate_flags_nzcv",
+      "arm64g_calculate_condition", "arm64g_calculate_flag_c",
+      "arm64g_calculate_flags_nzcv"
+   };
+   UInt i;
+   for (i = 0; i < sizeof(cc_helpers) / sizeof(cc_helpers[0]); i++) {
+      if (vex_streq(name, cc_helpers[i]))
+         return True;
+   }
+   return False;
+}
+
+
+/* With VexAbiInfo::host_amd64_lazy_guest_pc, the guest's
+   precise-exceptions function is wrapped so that the guest PC on its
+   own never has to be up to date at a memory access; the caller
+   recovers it from the PC map instead.  Set up by LibVEX_FrontEnd and
+   reused by libvex_BackEnd for the same translation. */
+static Bool (*lazy_pc_inner) ( Int, Int, VexRegisterUpdates ) = NULL;
+static Int lazy_pc_minoff = 0;
+static Int lazy_pc_maxoff = -1;
+
+static Bool lazy_pc_precise_mem_exns ( Int minoff, Int maxoff,
+                                       VexRegisterUpdates pxControl )
+{
+   if (minoff >= lazy_pc_minoff && maxoff <= lazy_pc_maxoff)
+      return False;
+   return lazy_pc_inner( minoff, maxoff, pxControl );
+}
+
+/* Note that host code from OFFS onwards belongs to the guest insn at
+   PC, merging with the previous entry where possible.  Returns False
+   if MAP is full. */
+static Bool add_pc_map_entry ( VexGuestPCMapEntry* map, Int size,
+                               /*MOD*/Int* used, UInt offs, Addr pc )
+{
+   if (*used > 0 && map[*used - 1].host_offs == offs) {
+      map[*used - 1].guest_pc = pc;
+      return True;
+   }
+   if (*used > 0 && map[*used - 1].guest_pc == pc)
+      return True;
+   if (*used >= size)
+      return False;
+   map[*used].host_offs = offs;
+   map[*used].guest_pc  = pc;
+   (*used)++;
+   return True;
+}
+
+/* For when the guest PC map overflows: the translation is redone with
+   the guest PC written at the start of each guest insn, so that it is
+   always up to date, as if by VexRegUpdAllregsAtEachInsn.  This is
+   done on the tree-built IR, which is fine as the guest PC is never
+   read other than through the constant in the IMark. */
+static IRSB* put_guest_pc_at_imarks ( const IRSB* bb )
+{
+   IRSB* out = deepCopyIRSBExceptStmts(bb);
+   Int   i;
+   for (i = 0; i < bb->stmts_used; i++) {
+      IRStmt* st = bb->stmts[i];
+      addStmtToIRSB(out, st);
+      if (st->tag != Ist_IMark)
+         continue;
+      Addr pc = st->Ist.IMark.addr;
+      addStmtToIRSB(out, IRStmt_Put(lazy_pc_minoff,
+                           lazy_pc_maxoff - lazy_pc_minoff == 7
+                              ? IRExpr_Const(IRConst_U64(pc))
+                              : IRExpr_Const(IRConst_U32((UInt)pc))));
+   }
+   return out;
+}
+
 
 /* Exported to library client. */
 
@@ -357,6 +449,9 @@ IRSB* LibVEX_FrontEnd ( /*MOD*/ VexTranslateArgs* vta,
    if (vta->arch_host == VexArchS390X) {
       s390_host_hwcaps = vta->archinfo_host.hwcaps;
    }
+   if (vta->arch_host == VexArchAMD64) {
+      amd64_host_hwcaps = vta->archinfo_host.hwcaps;
+   }
 
    /* First off, check that the guest and host insn sets
       are supported. */
@@ -533,6 +628,16 @@ IRSB* LibVEX_FrontEnd ( /*MOD*/ VexTranslateArgs* vta,
    res->n_sc_extents   = 0;
    res->offs_profInc   = -1;
    res->n_guest_instrs = 0;
+   res->n_spills       = 0;
+   res->n_reloads      = 0;
+   res->n_remats       = 0;
+   res->n_moves        = 0;
+   res->n_pp_self_moves  = 0;
+   res->n_pp_reload_fwds = 0;
+   res->n_pp_copy_fwds   = 0;
+   res->n_pp_imm_fwds    = 0;
+   res->n_pp_zext_folds  = 0;
+   res->n_unspec_cc_calls = 0;
 
 #ifndef VEXMULTIARCH
    /* yet more sanity checks ... */
@@ -553,6 +658,16 @@ IRSB* LibVEX_FrontEnd ( /*MOD*/ VexTranslateArgs* vta,
                    " Front end "
                    "------------------------\n\n");
 
+   if (vta->abiinfo_both.host_amd64_lazy_guest_pc) {
+      vassert(vta->arch_host == VexArchAMD64);
+      vassert(vta->pc_map != NULL && vta->pc_map_size > 0);
+      vassert(vta->pc_map_used != NULL);
+      lazy_pc_inner    = preciseMemExnsFn;
+      lazy_pc_minoff   = offB_GUEST_IP;
+      lazy_pc_maxoff   = offB_GUEST_IP + szB_GUEST_IP - 1;
+      preciseMemExnsFn = lazy_pc_precise_mem_exns;
+   }
+
    *pxControl = vex_control.iropt_register_updates_default;
    vassert(*pxControl >= VexRegUpdSpAtMemAccess
            && *pxControl <= VexRegUpdAllregsAtEachInsn);
@@ -628,6 +743,16 @@ IRSB* LibVEX_FrontEnd ( /*MOD*/ VexTranslateArgs* vta,
                               vta->guest_bytes_addr,
                               vta->arch_guest );
 
+   /* The IR is flat now, so any condition code helper calls that
+      survived specialisation are on the rhs of a WrTmp. */
+   for (i = 0; i < irsb->stmts_used; i++) {
+      const IRStmt* st = irsb->stmts[i];
+      if (st->tag == Ist_WrTmp
+          && st->Ist.WrTmp.data->tag == Iex_CCall
+          && is_cc_helper(st->Ist.WrTmp.data->Iex.CCall.cee->name))
+         res->n_unspec_cc_calls++;
+   }
+
    // JRS 2016 Aug 03: Sanity checking is expensive, we already checked
    // the output of the front end, and iropt never screws up the IR by
    // itself, unless it is being hacked on.  So remove this post-iropt
@@ -715,20 +840,26 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
    void         (*genReload)    ( HInstr**, HInstr**, HReg, Int, Bool );
    HInstr*      (*genMove)      ( HReg, HReg, Bool );
    HInstr*      (*directReload) ( HInstr*, HReg, Short );
+   Bool         (*isRematDef)   ( const HInstr*, Int*, Int* );
+   HInstr*      (*genRemat)     ( const HInstr*, HReg );
+   Bool         (*writesGuestState) ( const HInstr*, Int*, Int* );
+   Bool         (*peephole)     ( HInstr**, Int*, ULong, PeepholeStats* );
    void         (*ppInstr)      ( const HInstr*, Bool );
    UInt         (*ppReg)        ( HReg );
    HInstrArray* (*iselSB)       ( const IRSB*, VexArch, const VexArchInfo*,
                                   const VexAbiInfo*, Int, Int, Bool, Bool,
                                   Addr );
-   Int          (*emit)         ( /*MB_MOD*/Bool*,
+   Int          (*emit)         ( /*MB_MOD*/Bool*, /*MB_MOD*/ColdCode*,
                                   UChar*, Int, const HInstr*, Bool, VexEndness,
                                   const void*, const void*, const void*,
                                   const void* );
+   void         (*resolveColdBranch) ( UChar*, const UChar* );
+   Bool         (*isPCMark)     ( const HInstr*, Addr* );
    Bool (*preciseMemExnsFn) ( Int, Int, VexRegisterUpdates );
 
    const RRegUniverse* rRegUniv = NULL;
 
-   Bool            mode64, chainingAllowed;
+   Bool            mode64, chainingAllowed, lazyPC;
    Int             i, j, k, out_used;
    Int guest_sizeB;
    Int offB_HOST_EvC_COUNTER;
@@ -737,6 +868,8 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
    UChar           insn_bytes[128];
    HInstrArray*    vcode;
    HInstrArray*    rcode;
+   ColdCode*       cold;
+   VexAbiInfo      abiinfo;
 
    getRegUsage             = NULL;
    mapRegs                 = NULL;
@@ -744,10 +877,16 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
    genReload               = NULL;
    genMove                 = NULL;
    directReload            = NULL;
+   isRematDef              = NULL;
+   genRemat                = NULL;
+   writesGuestState        = NULL;
+   peephole                = NULL;
    ppInstr                 = NULL;
    ppReg                   = NULL;
    iselSB                  = NULL;
    emit                    = NULL;
+   resolveColdBranch       = NULL;
+   isPCMark                = NULL;
 
    mode64                 = False;
    chainingAllowed        = False;
@@ -879,10 +1018,17 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
          genReload    = CAST_TO_TYPEOF(genReload) AMD64FN(genReload_AMD64);
          genMove      = CAST_TO_TYPEOF(genMove) AMD64FN(genMove_AMD64);
          directReload = CAST_TO_TYPEOF(directReload) AMD64FN(directReload_AMD64);
+         isRematDef   = CAST_TO_TYPEOF(isRematDef) AMD64FN(isRematDef_AMD64);
+         genRemat     = CAST_TO_TYPEOF(genRemat) AMD64FN(genRemat_AMD64);
+         writesGuestState
+            = CAST_TO_TYPEOF(writesGuestState) AMD64FN(writesGuestState_AMD64);
+         peephole     = CAST_TO_TYPEOF(peephole) AMD64FN(peephole_AMD64);
          ppInstr      = CAST_TO_TYPEOF(ppInstr) AMD64FN(ppAMD64Instr);
          ppReg        = CAST_TO_TYPEOF(ppReg) AMD64FN(ppHRegAMD64);
          iselSB       = AMD64FN(iselSB_AMD64);
          emit         = CAST_TO_TYPEOF(emit) AMD64FN(emit_AMD64Instr);
+         resolveColdBranch = AMD64FN(resolveColdBranch_AMD64);
+         isPCMark     = CAST_TO_TYPEOF(isPCMark) AMD64FN(isPCMark_AMD64);
          vassert(vta->archinfo_host.endness == VexEndnessLE);
          break;
 
@@ -961,10 +1107,16 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
          genSpill     = CAST_TO_TYPEOF(genSpill) ARM64FN(genSpill_ARM64);
          genReload    = CAST_TO_TYPEOF(genReload) ARM64FN(genReload_ARM64);
          genMove      = CAST_TO_TYPEOF(genMove) ARM64FN(genMove_ARM64);
+         isRematDef   = CAST_TO_TYPEOF(isRematDef) ARM64FN(isRematDef_ARM64);
+         genRemat     = CAST_TO_TYPEOF(genRemat) ARM64FN(genRemat_ARM64);
+         writesGuestState
+            = CAST_TO_TYPEOF(writesGuestState) ARM64FN(writesGuestState_ARM64);
+         peephole     = CAST_TO_TYPEOF(peephole) ARM64FN(peephole_ARM64);
          ppInstr      = CAST_TO_TYPEOF(ppInstr) ARM64FN(ppARM64Instr);
          ppReg        = CAST_TO_TYPEOF(ppReg) ARM64FN(ppHRegARM64);
          iselSB       = ARM64FN(iselSB_ARM64);
          emit         = CAST_TO_TYPEOF(emit) ARM64FN(emit_ARM64Instr);
+         resolveColdBranch = ARM64FN(resolveColdBranch_ARM64);
          vassert(vta->archinfo_host.endness == VexEndnessLE);
          break;
 
@@ -1013,7 +1165,14 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
 
    /* Turn it into virtual-registerised code.  Build trees -- this
       also throws away any dead bindings. */
-   max_ga = ado_treebuild_BB( irsb, preciseMemExnsFn, pxControl );
+   abiinfo = vta->abiinfo_both;
+   lazyPC  = abiinfo.host_amd64_lazy_guest_pc;
+   if (lazyPC) {
+      vassert(isPCMark != NULL);
+      vassert(lazy_pc_inner == preciseMemExnsFn);
+      preciseMemExnsFn = lazy_pc_precise_mem_exns;
+   }
+   max_ga = ado_treebuild_BB( irsb, preciseMemExnsFn, pxControl, lazyPC );
 
    if (vta->finaltidy) {
       irsb = vta->finaltidy(irsb);
@@ -1046,9 +1205,10 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
       irsb->offsIP properly. */
    vassert(irsb->offsIP >= 16);
 
+  select_insns:
    vcode = iselSB ( irsb, vta->arch_host,
                     &vta->archinfo_host, 
-                    &vta->abiinfo_both,
+                    &abiinfo,
                     offB_HOST_EvC_COUNTER,
                     offB_HOST_EvC_FAILADDR,
                     chainingAllowed,
@@ -1070,11 +1230,16 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
    }
 
    /* Register allocate. */
+   RegAllocStats ra_stats;
+   vex_bzero(&ra_stats, sizeof(ra_stats));
    RegAllocControl con = {
       .univ = rRegUniv, .getRegUsage = getRegUsage, .mapRegs = mapRegs,
       .genSpill = genSpill, .genReload = genReload, .genMove = genMove,
       .directReload = directReload, .guest_sizeB = guest_sizeB,
-      .ppInstr = ppInstr, .ppReg = ppReg, .mode64 = mode64};
+      .isRematDef = isRematDef, .genRemat = genRemat,
+      .writesGuestState = writesGuestState,
+      .ppInstr = ppInstr, .ppReg = ppReg, .mode64 = mode64,
+      .stats = &ra_stats};
    switch (vex_control.regalloc_version) {
    case 2:
       rcode = doRegisterAllocation_v2(vcode, &con);
@@ -1082,12 +1247,37 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
    case 3:
       rcode = doRegisterAllocation_v3(vcode, &con);
       break;
+   case 4:
+      rcode = doRegisterAllocation_v4(vcode, &con);
+      break;
    default:
       vassert(0);
    }
 
    vexAllocSanityCheck();
 
+   res->n_spills  = ra_stats.n_spills;
+   res->n_reloads = ra_stats.n_reloads;
+   res->n_remats  = ra_stats.n_remats;
+   res->n_moves   = ra_stats.n_moves;
+
+   /* Peephole-optimise the register allocated code. */
+   PeepholeStats pp_stats;
+   vex_bzero(&pp_stats, sizeof(pp_stats));
+   if (vex_control.peephole && peephole != NULL) {
+      PeepholeControl pcon = {
+         .univ = rRegUniv, .getRegUsage = getRegUsage,
+         .peephole = peephole, .mode64 = mode64, .stats = &pp_stats};
+      rcode = doPeephole(rcode, &pcon);
+      vexAllocSanityCheck();
+   }
+
+   res->n_pp_self_moves  = pp_stats.n_self_moves;
+   res->n_pp_reload_fwds = pp_stats.n_reload_fwds;
+   res->n_pp_copy_fwds   = pp_stats.n_copy_fwds;
+   res->n_pp_imm_fwds    = pp_stats.n_imm_fwds;
+   res->n_pp_zext_folds  = pp_stats.n_zext_folds;
+
    if (vex_traceflags & VEX_TRACE_RCODE) {
       vex_printf("\n------------------------" 
                    " Register-allocated code "
@@ -1097,7 +1287,15 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
          ppInstr(rcode->arr[i], mode64);
          vex_printf("\n");
       }
-      vex_printf("\n");
+      vex_printf("\nregalloc v%u: %u spills, %u reloads, %u remats, "
+                 "%u moves\n\n", vex_control.regalloc_version,
+                 ra_stats.n_spills, ra_stats.n_reloads, ra_stats.n_remats,
+                 ra_stats.n_moves);
+      vex_printf("peephole: %u self-moves, %u reload forwards, "
+                 "%u copy forwards, %u imm forwards, %u zext folds\n\n",
+                 pp_stats.n_self_moves, pp_stats.n_reload_fwds,
+                 pp_stats.n_copy_fwds, pp_stats.n_imm_fwds,
+                 pp_stats.n_zext_folds);
    }
 
    /* HACK */
@@ -1114,15 +1312,42 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
                    "------------------------\n\n");
    }
 
+   /* Back ends which can move cold code out of line get an area to
+      put it in.  It is appended to the hot code below. */
+   cold = NULL;
+   if (resolveColdBranch != NULL) {
+      cold = LibVEX_Alloc_inline(sizeof(ColdCode));
+      initColdCode(cold);
+   }
+
+   /* With a lazy guest PC, note where each guest insn's code starts,
+      both in the hot code and, separately, in the cold code. */
+   Int                 n_pc_map      = 0;
+   Int                 n_cold_pc_map = 0;
+   VexGuestPCMapEntry* cold_pc_map   = NULL;
+   Addr                curr_pc       = 0;
+   if (lazyPC) {
+      cold_pc_map = LibVEX_Alloc_inline(vta->pc_map_size
+                                        * sizeof(VexGuestPCMapEntry));
+   }
+
    out_used = 0; /* tracks along the host_bytes array */
    for (i = 0; i < rcode->arr_used; i++) {
       HInstr* hi           = rcode->arr[i];
       Bool    hi_isProfInc = False;
+      Int     cold_used    = cold != NULL ? cold->used : 0;
       if (UNLIKELY(vex_traceflags & VEX_TRACE_ASM)) {
          ppInstr(hi, mode64);
          vex_printf("\n");
       }
-      j = emit( &hi_isProfInc,
+      if (lazyPC && isPCMark(hi, &curr_pc)) {
+         if (UNLIKELY(!add_pc_map_entry(vta->pc_map, vta->pc_map_size,
+                                        &n_pc_map, out_used, curr_pc)))
+            goto pc_map_full;
+      }
+      if (cold != NULL)
+         cold->hot_base = out_used;
+      j = emit( &hi_isProfInc, cold,
                 insn_bytes, sizeof insn_bytes, hi,
                 mode64, vta->archinfo_host.endness,
                 vta->disp_cp_chain_me_to_slowEP,
@@ -1140,6 +1365,11 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
          res->status = VexTransOutputFull;
          return;
       }
+      if (lazyPC && cold != NULL && cold->used > cold_used) {
+         if (UNLIKELY(!add_pc_map_entry(cold_pc_map, vta->pc_map_size,
+                                        &n_cold_pc_map, cold_used, curr_pc)))
+            goto pc_map_full;
+      }
       if (UNLIKELY(hi_isProfInc)) {
          vassert(vta->addProfInc); /* else where did it come from? */
          vassert(res->offs_profInc == -1); /* there can be only one (tm) */
@@ -1153,7 +1383,59 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
         out_used += j;
       }
    }
+
+   /* Append the cold code, and resolve the branches between it and
+      the hot code. */
+   if (cold != NULL && cold->used > 0) {
+      Int hot_used = out_used;
+      if (UNLIKELY(vex_traceflags & VEX_TRACE_ASM)) {
+         vex_printf("cold code:\n");
+         for (k = 0; k < cold->used; k++)
+            vex_printf("%02x ", (UInt)cold->buf[k]);
+         vex_printf("\n\n");
+      }
+      if (UNLIKELY(out_used + cold->used > vta->host_bytes_size)) {
+         vexSetAllocModeTEMP_and_clear();
+         vex_traceflags = 0;
+         res->status = VexTransOutputFull;
+         return;
+      }
+      for (k = 0; k < cold->used; k++)
+         vta->host_bytes[out_used + k] = cold->buf[k];
+      out_used += cold->used;
+      for (k = 0; k < cold->n_fixups; k++) {
+         const ColdFixup* fx = &cold->fixups[k];
+         if (fx->atCold) {
+            vassert(fx->at < cold->used && fx->to < hot_used);
+            resolveColdBranch( &vta->host_bytes[hot_used + fx->at],
+                               &vta->host_bytes[fx->to] );
+         } else {
+            vassert(fx->at < hot_used && fx->to < cold->used);
+            resolveColdBranch( &vta->host_bytes[fx->at],
+                               &vta->host_bytes[hot_used + fx->to] );
+         }
+      }
+      /* The cold code must not be taken to belong to the last guest
+         insn in the hot code, so make sure it starts with an entry of
+         its own. */
+      if (lazyPC) {
+         if (n_cold_pc_map == 0 || cold_pc_map[0].host_offs != 0) {
+            if (UNLIKELY(!add_pc_map_entry(vta->pc_map, vta->pc_map_size,
+                                           &n_pc_map, hot_used, 0)))
+               goto pc_map_full;
+         }
+         for (k = 0; k < n_cold_pc_map; k++) {
+            if (UNLIKELY(!add_pc_map_entry(
+                             vta->pc_map, vta->pc_map_size, &n_pc_map,
+                             hot_used + cold_pc_map[k].host_offs,
+                             cold_pc_map[k].guest_pc)))
+               goto pc_map_full;
+         }
+      }
+   }
    *(vta->host_bytes_used) = out_used;
+   if (lazyPC)
+      *(vta->pc_map_used) = n_pc_map;
 
    vexAllocSanityCheck();
 
@@ -1172,6 +1454,21 @@ static void libvex_BackEnd ( const VexTranslateArgs *vta,
    vex_traceflags = 0;
    res->status = VexTransOK;
    return;
+
+  pc_map_full:
+   /* More guest insns and out-of-line stretches than the PC map has
+      room for.  Rather than fail, redo the back end from instruction
+      selection onwards with the guest PC kept up to date; the caller
+      then finds no map entries for this translation. */
+   vassert(lazyPC);
+   if (vex_traceflags & VEX_TRACE_ASM)
+      vex_printf("guest PC map full, redoing with eager PC updates\n\n");
+   irsb    = put_guest_pc_at_imarks(irsb);
+   lazyPC  = False;
+   abiinfo.host_amd64_lazy_guest_pc = False;
+   res->offs_profInc = -1;
+   *(vta->pc_map_used) = 0;
+   goto select_insns;
 }
 
 
@@ -1501,6 +1798,7 @@ void LibVEX_default_VexAbiInfo ( /*OUT*/VexAbiInfo* vbi )
    vbi->guest_ppc_zap_RZ_at_bl         = NULL;
    vbi->guest__use_fallback_LLSC       = False;
    vbi->host_ppc_calls_use_fndescrs    = False;
+   vbi->host_amd64_lazy_guest_pc       = False;
 }
 
 
@@ -395,6 +395,10 @@ void LibVEX_default_VexArchInfo ( /*OUT*/VexArchInfo* vai );
       host is ppc32-linux                 ==> False
       host is ppc64-linux                 ==> True
       host is other                       ==> inapplicable
+
+   host_amd64_lazy_guest_pc
+      host is amd64                       ==> applicable, default False
+      host is other                       ==> inapplicable
 */
 
 typedef
@@ -433,6 +437,15 @@ typedef
          itself?  True => descriptor, False => code. */
       Bool host_ppc_calls_use_fndescrs;
 
+      /* AMD64 HOSTS only: leave the guest program counter out of the
+         registers that must be up to date at memory accesses, even if
+         the register-update policy asks for it.  Instead, the back end
+         marks where each guest instruction's code starts and hands
+         back a table (VexTranslateArgs::pc_map) from which the caller
+         must reconstruct the guest PC after a fault or inside a
+         helper call. */
+      Bool host_amd64_lazy_guest_pc;
+
       /* MIPS32/MIPS64 GUESTS only: emulated FPU mode. */
       UInt guest_mips_fp_mode;
    }
@@ -518,8 +531,13 @@ typedef
       /* Register allocator version. Allowed values are:
          - '2': previous, good and slow implementation.
          - '3': current, faster implementation; perhaps producing slightly worse
-                spilling decisions. */
+                spilling decisions.
+         - '4': the '3' one with live range splitting, rematerialisation
+                and spill slot reuse. */
       UInt regalloc_version;
+      /* Rewrite register allocated code with the back end's peephole
+         optimisations, where it has any?  Default: YES. */
+      Bool peephole;
    }
    VexControl;
 
@@ -648,6 +666,21 @@ typedef
       /* Stats only: the number of guest insns included in the
          translation.  It may be zero (!). */
       UInt n_guest_instrs;
+      /* Stats only: the spill code generated by the register
+         allocator. */
+      UInt n_spills;
+      UInt n_reloads;
+      UInt n_remats;
+      UInt n_moves;
+      /* Stats only: the rewrites done by the peephole optimiser. */
+      UInt n_pp_self_moves;
+      UInt n_pp_reload_fwds;
+      UInt n_pp_copy_fwds;
+      UInt n_pp_imm_fwds;
+      UInt n_pp_zext_folds;
+      /* Stats only: the number of calls to the guest's condition code
+         helpers that iropt could not specialise away. */
+      UInt n_unspec_cc_calls;
    }
    VexTranslateResult;
 
@@ -670,6 +703,19 @@ typedef
    VexGuestExtents;
 
 
+/* One entry of the guest PC map produced for a translation made with
+   VexAbiInfo::host_amd64_lazy_guest_pc.  Host code from |host_offs|
+   up to the next entry's |host_offs| belongs to the guest instruction
+   at |guest_pc|.  Entries are in increasing |host_offs| order; code
+   before the first entry belongs to no guest instruction. */
+typedef
+   struct {
+      UInt host_offs;
+      Addr guest_pc;
+   }
+   VexGuestPCMapEntry;
+
+
 /* A structure to carry arguments for LibVEX_Translate.  There are so
    many of them, it seems better to have a structure. */
 typedef
@@ -709,6 +755,15 @@ typedef
       /* OUT: how much of the output area is used. */
       Int*    host_bytes_used;
 
+      /* IN: if abiinfo_both.host_amd64_lazy_guest_pc is set, a place
+         to put the guest PC map, and its size in entries.  Otherwise
+         ignored.  OUT: how many entries are used.  If the map would
+         not fit, the translation keeps the guest PC up to date
+         instead and no entries are used. */
+      VexGuestPCMapEntry* pc_map;
+      Int                 pc_map_size;
+      Int*                pc_map_used;
+
       /* IN: optionally, two instrumentation functions.  May be
 	 NULL. */
       IRSB*   (*instrument1) ( /*callback_opaque*/void*, 
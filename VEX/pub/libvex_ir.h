@@ -2488,6 +2488,12 @@ typedef
       IRExpr**  args;   /* arg vector, ends in NULL. */
       IRTemp    tmp;    /* to assign result to, or IRTemp_INVALID if none */
 
+      /* A hint that the call is rarely made, that is, that .guard is
+         nearly always false.  Back ends may then move the code doing
+         the call out of line, away from the code executed when the
+         guard is false. */
+      Bool      cold;
+
       /* Mem effects; we allow only one R/W/M region to be stated */
       IREffect  mFx;    /* indicates memory effects, if any */
       IRExpr*   mAddr;  /* of access, or NULL if mFx==Ifx_None */
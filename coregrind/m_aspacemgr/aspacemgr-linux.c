@@ -2649,12 +2649,198 @@ SysRes VG_(am_mmap_anon_float_valgrind)( SizeT length )
    return sres;
 }
 
-/* Really just a wrapper around VG_(am_mmap_anon_float_valgrind). */
+/* Find the size of the transparent huge pages from the kernel.  Old
+   kernels don't tell it, in which case it is assumed to be the size
+   mapped by a page middle directory entry, with 8 byte page table
+   entries: 2MB with 4KB pages. */
+
+SizeT VG_(am_hugepage_szB) ( void )
+{
+#if defined(VGO_linux)
+   static SizeT hugepage_szB = 0;
+   HChar  buf[32];
+   SysRes fd;
+   Int    n;
+
+   if (hugepage_szB != 0)
+      return hugepage_szB;
+
+   fd = ML_(am_open)( "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size",
+                      VKI_O_RDONLY, 0 );
+   if (!sr_isError(fd)) {
+      n = ML_(am_read)( sr_Res(fd), buf, sizeof(buf) - 1 );
+      ML_(am_close)( sr_Res(fd) );
+      if (n > 0) {
+         buf[n] = 0;
+         hugepage_szB = (SizeT)VG_(strtoull10)( buf, NULL );
+      }
+   }
+   if (hugepage_szB < VKI_PAGE_SIZE
+       || (hugepage_szB & (hugepage_szB - 1)) != 0
+       || !VG_IS_PAGE_ALIGNED(hugepage_szB))
+      hugepage_szB = VKI_PAGE_SIZE * (VKI_PAGE_SIZE / sizeof(ULong));
+   return hugepage_szB;
+#else
+   return 0;
+#endif
+}
+
+/* Map anonymously at an unconstrained address for V, trying to get
+   huge pages for the mapping.  With --huge-pages=hugetlb, the mapping
+   is first made with MAP_HUGETLB.  That needs huge pages reserved by
+   the administrator (/proc/sys/vm/nr_hugepages), of the size we use,
+   so it often fails, in which case, and with --huge-pages=madvise, a
+   normal mapping is made, aligned on the huge page size so that the
+   kernel can back it with transparent huge pages, and MADV_HUGEPAGE tells the
+   kernel that it is worth it.  If the kernel does not know about
+   transparent huge pages, the madvise fails, and we just have a normal
+   mapping. */
+
+#if defined(VGO_linux) && !defined(ENABLE_INNER)
+/* Once a MAP_HUGETLB mapping failed, don't try again: the reserved
+   huge pages are not coming back. */
+static Bool hugetlb_failed = False;
+static Bool madvise_failed = False;
+#endif
+
+SysRes VG_(am_mmap_anon_float_valgrind_huge)( SizeT length )
+{
+#if defined(VGO_linux) && !defined(ENABLE_INNER)
+   SysRes     sres;
+   NSegment   seg;
+   Addr       advised, start;
+   Bool       ok;
+   MapRequest req;
+   UInt       prot  = VKI_PROT_READ|VKI_PROT_WRITE|VKI_PROT_EXEC;
+   UInt       flags = VKI_MAP_FIXED|VKI_MAP_PRIVATE|VKI_MAP_ANONYMOUS;
+   SizeT      hp_szB = VG_(am_hugepage_szB)();
+
+   if (VG_(clo_huge_pages) == Vg_HugePagesNo || length == 0)
+      return VG_(am_mmap_anon_float_valgrind)( length );
+
+   length = VG_ROUNDUP(length, hp_szB);
+
+   /* Ask for an advisory one huge page bigger than needed, so as to be
+      able to align the mapping inside the advised range.  If this is
+      refused, try a normal mapping. */
+   req.rkind = MAny;
+   req.start = 0;
+   req.len   = length + hp_szB;
+   advised = VG_(am_get_advisory)( &req, False/*forClient*/, &ok );
+   if (!ok)
+      return VG_(am_mmap_anon_float_valgrind)( length );
+   start = VG_ROUNDUP(advised, hp_szB);
+
+   sres = VG_(mk_SysRes_Error)( VKI_ENOMEM );
+   if (VG_(clo_huge_pages) == Vg_HugePagesHugetlb && !hugetlb_failed) {
+      sres = VG_(am_do_mmap_NO_NOTIFY)( start, length, prot,
+                                        flags | VKI_MAP_HUGETLB,
+                                        VM_TAG_VALGRIND, 0 );
+      if (sr_isError(sres)) {
+         hugetlb_failed = True;
+         VG_(debugLog)(1, "aspacem",
+                       "MAP_HUGETLB mapping failed (error %lu), "
+                       "using MADV_HUGEPAGE instead\n", sr_Err(sres));
+      }
+   }
+   if (sr_isError(sres)) {
+      sres = VG_(am_do_mmap_NO_NOTIFY)( start, length, prot, flags,
+                                        VM_TAG_VALGRIND, 0 );
+      if (sr_isError(sres))
+         return sres;
+      if (!madvise_failed) {
+         SysRes mres = VG_(do_syscall3)( __NR_madvise, start, length,
+                                         VKI_MADV_HUGEPAGE );
+         if (sr_isError(mres)) {
+            madvise_failed = True;
+            VG_(debugLog)(1, "aspacem",
+                          "MADV_HUGEPAGE failed (error %lu), "
+                          "using normal pages\n", sr_Err(mres));
+         }
+      }
+   }
+
+   if (sr_Res(sres) != start) {
+      /* See VG_(am_mmap_anon_float_valgrind). */
+      (void)ML_(am_do_munmap_NO_NOTIFY)( sr_Res(sres), length );
+      return VG_(mk_SysRes_Error)( VKI_EINVAL );
+   }
+
+   /* Ok, the mapping succeeded.  Now notify the interval map. */
+   init_nsegment( &seg );
+   seg.kind  = SkAnonV;
+   seg.start = start;
+   seg.end   = start + length - 1;
+   seg.hasR  = True;
+   seg.hasW  = True;
+   seg.hasX  = True;
+   add_segment( &seg );
+
+   AM_SANITY_CHECK;
+   return sres;
+#else
+   return VG_(am_mmap_anon_float_valgrind)( length );
+#endif
+}
+
+/* Is VG_(am_mmap_anon_float_valgrind_huge) still getting huge pages,
+   as far as we can tell? */
+
+static Bool huge_pages_in_use ( void )
+{
+#if defined(VGO_linux) && !defined(ENABLE_INNER)
+   if (VG_(clo_huge_pages) == Vg_HugePagesHugetlb && !hugetlb_failed)
+      return True;
+   return VG_(clo_huge_pages) != Vg_HugePagesNo && !madvise_failed;
+#else
+   return False;
+#endif
+}
+
+/* Really just a wrapper around VG_(am_mmap_anon_float_valgrind).  With
+   --huge-pages, small requests are carved out of huge page mappings,
+   which is possible as shadow memory is never given back.  Once huge
+   pages turn out not to be available, small requests get mappings of
+   their own again, after using up what is left of the last huge page
+   mapping. */
 
 void* VG_(am_shadow_alloc)(SizeT size)
 {
-   SysRes sres = VG_(am_mmap_anon_float_valgrind)( size );
-   return sr_isError(sres) ? NULL : (void*)(Addr)sr_Res(sres);
+   static Addr  huge_next = 0;
+   static SizeT huge_left = 0;
+   SysRes sres;
+   SizeT  hp_szB = VG_(am_hugepage_szB)();
+
+   if (VG_(clo_huge_pages) == Vg_HugePagesNo || size == 0
+       || VG_PGROUNDUP(size) >= hp_szB) {
+      sres = VG_(clo_huge_pages) == Vg_HugePagesNo
+                ? VG_(am_mmap_anon_float_valgrind)( size )
+                : VG_(am_mmap_anon_float_valgrind_huge)( size );
+      return sr_isError(sres) ? NULL : (void*)(Addr)sr_Res(sres);
+   }
+
+   size = VG_PGROUNDUP(size);
+   if (size <= huge_left) {
+      huge_next += size;
+      huge_left -= size;
+      return (void*)(huge_next - size);
+   }
+
+   if (!huge_pages_in_use()) {
+      sres = VG_(am_mmap_anon_float_valgrind)( size );
+      return sr_isError(sres) ? NULL : (void*)(Addr)sr_Res(sres);
+   }
+
+   /* Start a new huge page mapping, and carve the following requests out
+      of whichever of it and the current one has more left. */
+   sres = VG_(am_mmap_anon_float_valgrind_huge)( hp_szB );
+   if (sr_isError(sres))
+      return NULL;
+   if (hp_szB - size > huge_left) {
+      huge_next = sr_Res(sres) + size;
+      huge_left = hp_szB - size;
+   }
+   return (void*)(Addr)sr_Res(sres);
 }
 
 /* Map a file at an unconstrained address for V, and update the
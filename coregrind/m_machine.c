@@ -40,6 +40,7 @@
 #include "pub_core_cpuid.h"
 #include "pub_core_libcsignal.h"   // for ppc32 messing with SIGILL and SIGFPE
 #include "pub_core_debuglog.h"
+#include "pub_core_scheduler.h"    // VG_(sync_lazy_guest_pc)
 
 
 #define INSTR_PTR(regs)    ((regs).vex.VG_INSTR_PTR)
@@ -49,6 +50,7 @@
 #define STACK_PTR_S1(regs)    ((regs).vex_shadow1.VG_STACK_PTR)
 
 Addr VG_(get_IP) ( ThreadId tid ) {
+   VG_(sync_lazy_guest_pc)( tid, 0 );
    return INSTR_PTR( VG_(threads)[tid].arch );
 }
 Addr VG_(get_SP) ( ThreadId tid ) {
@@ -81,6 +83,7 @@ void VG_(get_UnwindStartRegs) ( /*OUT*/UnwindStartRegs* regs,
    regs->misc.X86.r_ebp
       = VG_(threads)[tid].arch.vex.guest_EBP;
 #  elif defined(VGA_amd64)
+   VG_(sync_lazy_guest_pc)( tid, 0 );
    regs->r_pc = VG_(threads)[tid].arch.vex.guest_RIP;
    regs->r_sp = VG_(threads)[tid].arch.vex.guest_RSP;
    regs->misc.AMD64.r_rbp
@@ -206,6 +206,12 @@ static void usage_NORETURN ( Bool debug_help )
 "           more sectors may increase performance, but use more memory.\n"
 "    --avg-transtab-entry-size=<number> avg size in bytes of a translated\n"
 "           basic block [0, meaning use tool provided default]\n"
+"    --transtab-keep-hot=<number> percentage of a recycled sector of the\n"
+"           translated code cache kept for its hottest translations [20]\n"
+"    --transtab-max-mb=<number> adjust the number of sectors of the translated\n"
+"           code cache at run time, within <number> MB [0, meaning fixed]\n"
+"    --huge-pages=no|madvise|hugetlb  back the translated code cache and\n"
+"           the tool's shadow memory with huge pages? [no]\n"
 "    --aspace-minaddr=0xPP     avoid mapping memory below 0xPP [guessed]\n"
 "    --valgrind-stacksize=<number> size of valgrind (host) thread's stack\n"
 "                               (in bytes) ["
@@ -281,6 +287,8 @@ static void usage_NORETURN ( Bool debug_help )
 "      --vex-iropt-register-updates=mode   setting to use by default\n"
 "      --px-default=mode      synonym for --vex-iropt-register-updates\n"
 "      --px-file-backed=mode  optional setting for file-backed (non-JIT) code\n"
+"      --px-lazy-pc=no|yes    recover the program counter at faults instead\n"
+"                             of keeping it up to date (amd64 only) [yes]\n"
 "    Tracing and profile control:\n"
 "      --trace-flags and --profile-flags values (omit the middle space):\n"
 "         1000 0000   show conversion into IR\n"
@@ -294,7 +302,8 @@ static void usage_NORETURN ( Bool debug_help )
 "         0000 0000   show summary profile only\n"
 "        (Nb: you need --trace-notbelow and/or --trace-notabove\n"
 "             with --trace-flags for full details)\n"
-"    --vex-regalloc-version=2|3             [3]\n"
+"    --vex-regalloc-version=2|3|4           [3]\n"
+"    --vex-peephole=no|yes                  [yes]\n"
 "\n"
 "  debugging options for Valgrind tools that report errors\n"
 "    --dump-error=<number>     show translation for basic block associated\n"
@@ -690,6 +699,12 @@ void main_process_cmd_line_options( void )
       else if VG_BINT_CLO(arg, "--avg-transtab-entry-size",
                                VG_(clo_avg_transtab_entry_size),
                                50, 5000) {}
+      else if VG_BINT_CLO(arg, "--transtab-keep-hot",
+                               VG_(clo_transtab_keep_hot),
+                               0, 50) {}
+      else if VG_BINT_CLO(arg, "--transtab-max-mb",
+                               VG_(clo_transtab_max_mb),
+                               0, 1024*1024) {}
       else if VG_BINT_CLO(arg, "--merge-recursive-frames",
                                VG_(clo_merge_recursive_frames), 0,
                                VG_DEEPEST_BACKTRACE) {}
@@ -703,6 +718,13 @@ void main_process_cmd_line_options( void )
       else if VG_XACT_CLO(arg, "--smc-check=all-non-file",
                           VG_(clo_smc_check), Vg_SmcAllNonFile) {}
 
+      else if VG_XACT_CLO(arg, "--huge-pages=no",
+                          VG_(clo_huge_pages), Vg_HugePagesNo) {}
+      else if VG_XACT_CLO(arg, "--huge-pages=madvise",
+                          VG_(clo_huge_pages), Vg_HugePagesMadvise) {}
+      else if VG_XACT_CLO(arg, "--huge-pages=hugetlb",
+                          VG_(clo_huge_pages), Vg_HugePagesHugetlb) {}
+
       else if VG_USETX_CLO (arg, "--kernel-variant",
                             "bproc,"
                             "android-no-hw-tls,"
@@ -722,7 +744,7 @@ void main_process_cmd_line_options( void )
       else if VG_BINT_CLO(arg, "--vex-iropt-level",
                        VG_(clo_vex_control).iropt_level, 0, 2) {}
       else if VG_BINT_CLO(arg, "--vex-regalloc-version",
-                       VG_(clo_vex_control).regalloc_version, 2, 3) {}
+                       VG_(clo_vex_control).regalloc_version, 2, 4) {}
 
       else if VG_STRINDEX_CLO(arg, "--vex-iropt-register-updates",
                                    pxStrings, ix) {
@@ -747,6 +769,12 @@ void main_process_cmd_line_options( void )
          vg_assert(pxVals[ix] <= VexRegUpdAllregsAtEachInsn);
          VG_(clo_px_file_backed) = pxVals[ix];
       }
+      else if VG_BOOL_CLO(arg, "--px-lazy-pc", VG_(clo_px_lazy_pc)) {
+#        if !defined(VGA_amd64)
+         /* Needs back end support, which only amd64 has. */
+         VG_(clo_px_lazy_pc) = False;
+#        endif
+      }
 
       else if VG_BINT_CLO(arg, "--vex-iropt-unroll-thresh",
                        VG_(clo_vex_control).iropt_unroll_thresh, 0, 400) {}
@@ -756,6 +784,8 @@ void main_process_cmd_line_options( void )
                        VG_(clo_vex_control).guest_chase_thresh, 0, 99) {}
       else if VG_BOOL_CLO(arg, "--vex-guest-chase-cond",
                        VG_(clo_vex_control).guest_chase_cond) {}
+      else if VG_BOOL_CLO(arg, "--vex-peephole",
+                       VG_(clo_vex_control).peephole) {}
 
       else if VG_INT_CLO(arg, "--log-fd", tmp_log_fd) {
          log_to = VgLogTo_Fd;
@@ -952,6 +982,14 @@ void main_process_cmd_line_options( void )
          "You must define a non nul exit error code, with --error-exitcode=...\n");
    }
 
+#  if !defined(VGO_linux)
+   if (VG_(clo_huge_pages) != Vg_HugePagesNo) {
+      VG_(fmsg_bad_option)("--huge-pages=madvise or =hugetlb",
+                           "--huge-pages= is only available on Linux.\n");
+      /*NOTREACHED*/
+   }
+#  endif
+
 #  if !defined(VGO_darwin)
    if (VG_(clo_resync_filter) != 0) {
       VG_(fmsg_bad_option)("--resync-filter=yes or =verbose", 
@@ -1023,6 +1061,14 @@ void main_process_cmd_line_options( void )
       children, if requested via --log|xml-file= options. */
    VG_(atfork)(NULL, NULL, VG_(logging_atfork_child));
 
+   if (VG_(clo_huge_pages) != Vg_HugePagesNo
+       && VG_(am_hugepage_szB)() > VG_MAX_HUGEPAGE_SZB) {
+      VG_(umsg)("Warning: huge pages of %lu MB are too big to be worth "
+                "using, ignoring --huge-pages\n",
+                VG_(am_hugepage_szB)() / (1024 * 1024));
+      VG_(clo_huge_pages) = Vg_HugePagesNo;
+   }
+
    // Suppressions related stuff
 
    if (VG_(clo_default_supp) &&
@@ -134,6 +134,11 @@ Bool   VG_(clo_track_fds)      = False;
 Bool   VG_(clo_show_below_main)= False;
 Bool   VG_(clo_keep_debuginfo) = False;
 Bool   VG_(clo_show_emwarns)   = False;
+#if defined(VGA_amd64)
+Bool   VG_(clo_px_lazy_pc)     = True;
+#else
+Bool   VG_(clo_px_lazy_pc)     = False;
+#endif
 Word   VG_(clo_max_stackframe) = 2000000;
 UInt   VG_(clo_max_threads)    = MAX_THREADS_DEFAULT;
 Word   VG_(clo_main_stacksize) = 0; /* use client's rlimit.stack */
@@ -158,6 +163,8 @@ VgSmc VG_(clo_smc_check) = Vg_SmcStack;
 #  error "Unknown arch"
 #endif
 
+VgHugePages VG_(clo_huge_pages) = Vg_HugePagesNo;
+
 #if defined(VGO_darwin)
 UInt VG_(clo_resync_filter) = 1; /* enabled, but quiet */
 #else
@@ -111,6 +111,10 @@
 /* If False, a fault is Valgrind-internal (ie, a bug) */
 Bool VG_(in_generated_code) = False;
 
+/* The host stack pointer generated code runs with, as set by
+   VG_(disp_run_translations).  Only maintained on amd64. */
+Addr VG_(generated_code_sp) = 0;
+
 /* 64-bit counter for the number of basic blocks done. */
 static ULong bbs_done = 0;
 
@@ -123,6 +127,48 @@ static ULong vgdb_next_poll;
 
 /* Forwards */
 static void do_client_request ( ThreadId tid );
+
+
+/* ---------------------------------------------------------------------
+   Recovering the guest PC with --px-lazy-pc=yes.
+   ------------------------------------------------------------------ */
+
+void VG_(sync_lazy_guest_pc) ( ThreadId tid, Addr host_pc )
+{
+#  if defined(VGA_amd64)
+   Addr guest_pc;
+
+   if (!VG_(clo_px_lazy_pc) || !VG_(in_generated_code)
+       || tid != VG_(running_tid))
+      return;
+
+   /* A fault in generated code itself. */
+   if (host_pc != 0 && VG_(search_transtab_guest_pc)(&guest_pc, host_pc)) {
+      if (guest_pc != 0)
+         VG_(threads)[tid].arch.vex.guest_RIP = guest_pc;
+      return;
+   }
+
+   /* Otherwise we are inside a helper called from generated code.
+      Generated code calls helpers with the stack pointer it runs
+      with, except that it first makes room for a 16 or 32 byte vector
+      result, if any.  In that case the words of the result area in
+      which a return address could be are zeroed before the call.  So
+      the return address is the first word in the translation cache
+      at 8, 24 or 40 bytes below that stack pointer. */
+   const Addr* sp = (const Addr*)VG_(generated_code_sp);
+   Int i;
+   vg_assert(sp != NULL);
+   for (i = 1; i <= 5; i += 2) {
+      if (sp[-i] != 0 && VG_(search_transtab_guest_pc)(&guest_pc, sp[-i])) {
+         if (guest_pc != 0)
+            VG_(threads)[tid].arch.vex.guest_RIP = guest_pc;
+         return;
+      }
+   }
+#  endif
+}
+
 static void scheduler_sanity ( ThreadId tid );
 static void mostly_clear_thread_record ( ThreadId tid );
 
@@ -1131,11 +1177,18 @@ void handle_chain_me ( ThreadId tid, void* place_to_chain, Bool toFastEP )
                                  ip, False/*dont_upd_fast_cache*/ );
    if (!found) {
       /* Not found; we need to request a translation. */
+      ULong n_recycled = VG_(get_n_sectors_recycled)();
       if (VG_(translate)( tid, ip, /*debug*/False, 0/*not verbose*/, 
                           bbs_done, True/*allow redirection*/ )) {
          found = VG_(search_transtab)( NULL, &to_sNo, &to_tteNo,
                                        ip, False ); 
          vg_assert2(found, "handle_chain_me: missing tt_fast entry");
+         /* If making the translation recycled a sector, the block
+            containing place_to_chain might have been dumped, or
+            moved elsewhere in the code cache.  Then place_to_chain
+            can't be trusted anymore, so don't do the chaining. */
+         if (VG_(get_n_sectors_recycled)() != n_recycled)
+            return;
       } else {
 	 // If VG_(translate)() fails, it's because it had to throw a
 	 // signal because the client jumped to a bad address.  That
@@ -1822,6 +1875,79 @@ static Bool os_client_request(ThreadId tid, UWord *args)
 }
 
 
+/* Bulk memory operations for the string function replacements.  Each
+   returns zero, doing nothing, unless the memory involved is all
+   accessible to the client and the tool has updated its shadow state
+   for the operation, in which case the operation is done here and now.
+   The replacement then does it itself if need be, which takes care of
+   reporting errors and delivering signals properly. */
+
+/* Can the core safely access [a, a+len) with protection prot on behalf
+   of the client?  Besides the client having the access, none of it
+   may be a file mapping: those can extend past the end of the file,
+   and touching that part would raise SIGBUS in the core itself. */
+static Bool bulk_range_ok ( Addr a, SizeT len, UInt prot )
+{
+   const NSegment* seg;
+
+   if (len == 0 || !VG_(am_is_valid_for_client)(a, len, prot))
+      return False;
+   while (True) {
+      seg = VG_(am_find_nsegment)(a);
+      if (seg == NULL || seg->kind == SkFileC)
+         return False;
+      if (seg->end - a >= len - 1)
+         return True;
+      len -= seg->end + 1 - a;
+      a = seg->end + 1;
+   }
+}
+
+static UWord bulk_copy ( ThreadId tid, Addr dst, Addr src, SizeT len )
+{
+   if (VG_(tdict).track_bulk_copy == NULL
+       || !bulk_range_ok(src, len, VKI_PROT_READ)
+       || !bulk_range_ok(dst, len, VKI_PROT_WRITE)
+       || !VG_(tdict).track_bulk_copy(tid, dst, src, len))
+      return 0;
+   VG_(memmove)((void*)dst, (void*)src, len);
+   return 1;
+}
+
+static UWord bulk_fill ( ThreadId tid, Addr dst, Addr val, SizeT len )
+{
+   if (VG_(tdict).track_bulk_fill == NULL
+       || !bulk_range_ok(val, 1, VKI_PROT_READ)
+       || !bulk_range_ok(dst, len, VKI_PROT_WRITE)
+       || !VG_(tdict).track_bulk_fill(tid, dst, val, len))
+      return 0;
+   VG_(memset)((void*)dst, *(UChar*)val, len);
+   return 1;
+}
+
+/* Returns the length of the string including its terminating zero. */
+static UWord bulk_strlen ( ThreadId tid, Addr str )
+{
+   Addr a = str;
+
+   if (VG_(tdict).track_bulk_strlen == NULL)
+      return 0;
+   /* Look for the end of the string a page at a time, making sure
+      that each page is readable before looking at it. */
+   while (True) {
+      Addr limit = VG_PGROUNDDN(a) + VKI_PAGE_SIZE;
+      if (!bulk_range_ok(a, limit - a, VKI_PROT_READ))
+         return 0;
+      for (; a < limit; a++) {
+         if (*(UChar*)a == 0) {
+            SizeT len = a - str + 1;
+            return VG_(tdict).track_bulk_strlen(tid, str, len) ? len : 0;
+         }
+      }
+   }
+}
+
+
 /* Write out a client message, possibly including a back trace. Return
    the number of characters written. In case of XML output, the format
    string as well as any arguments it requires will be XML'ified. 
@@ -2034,6 +2160,18 @@ void do_client_request ( ThreadId tid )
          SET_CLREQ_RETVAL( tid, 0 );     /* return value is meaningless */
          break; }
 
+      case VG_USERREQ__BULK_COPY:
+         SET_CLREQ_RETVAL( tid, bulk_copy(tid, arg[1], arg[2], arg[3]) );
+         break;
+
+      case VG_USERREQ__BULK_FILL:
+         SET_CLREQ_RETVAL( tid, bulk_fill(tid, arg[1], arg[2], arg[3]) );
+         break;
+
+      case VG_USERREQ__BULK_STRLEN:
+         SET_CLREQ_RETVAL( tid, bulk_strlen(tid, arg[1]) );
+         break;
+
       case VG_USERREQ__GET_MALLOCFUNCS: {
 	 struct vg_mallocfunc_info *info = (struct vg_mallocfunc_info *)arg[1];
 
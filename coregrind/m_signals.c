@@ -2756,6 +2756,8 @@ void sync_signalhandler_from_kernel ( ThreadId tid,
       }
 
       if (VG_(in_generated_code)) {
+         /* Bring the guest PC up to date before anyone looks at it. */
+         VG_(sync_lazy_guest_pc)(tid, (Addr)VG_UCONTEXT_INSTR_PTR(uc));
          if (VG_(gdbserver_report_signal) (info, tid)
              || VG_(sigismember)(&tst->sig_mask, sigNo)) {
             /* Can't continue; must longjmp back to the scheduler and thus
@@ -394,6 +394,12 @@ void VG_(fn)(VG_REGPARM(2) void(*f)(args)) { \
    VG_(tdict).fn = f; \
 }
 
+/* As DEF0, but for events whose handlers return a Bool. */
+#define DEF0B(fn, args...) \
+void VG_(fn)(Bool(*f)(args)) { \
+   VG_(tdict).fn = f; \
+}
+
 DEF0(track_new_mem_startup,       Addr, SizeT, Bool, Bool, Bool, ULong)
 DEF0(track_new_mem_stack_signal,  Addr, SizeT, UInt)
 DEF0(track_new_mem_brk,           Addr, SizeT, UInt)
@@ -445,6 +451,10 @@ DEF0(track_pre_mem_read_asciiz,   CorePart, ThreadId, const HChar*, Addr)
 DEF0(track_pre_mem_write,         CorePart, ThreadId, const HChar*, Addr, SizeT)
 DEF0(track_post_mem_write,        CorePart, ThreadId, Addr, SizeT)
 
+DEF0B(track_bulk_copy,            ThreadId, Addr, Addr, SizeT)
+DEF0B(track_bulk_fill,            ThreadId, Addr, Addr, SizeT)
+DEF0B(track_bulk_strlen,          ThreadId, Addr, SizeT)
+
 DEF0(track_pre_reg_read,          CorePart, ThreadId, const HChar*, PtrdiffT, SizeT)
 DEF0(track_post_reg_write,        CorePart, ThreadId,               PtrdiffT, SizeT)
 
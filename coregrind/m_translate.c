@@ -77,6 +77,19 @@ static ULong n_PX_VexRegUpdUnwindregsAtMemAccess = 0;
 static ULong n_PX_VexRegUpdAllregsAtMemAccess    = 0;
 static ULong n_PX_VexRegUpdAllregsAtEachInsn     = 0;
 
+static ULong n_RA_spills  = 0;
+static ULong n_RA_reloads = 0;
+static ULong n_RA_remats  = 0;
+static ULong n_RA_moves   = 0;
+
+static ULong n_PP_self_moves  = 0;
+static ULong n_PP_reload_fwds = 0;
+static ULong n_PP_copy_fwds   = 0;
+static ULong n_PP_imm_fwds    = 0;
+static ULong n_PP_zext_folds  = 0;
+
+static ULong n_unspec_cc_calls = 0;
+
 void VG_(print_translation_stats) ( void )
 {
    UInt n_SP_updates = n_SP_updates_new_fast + n_SP_updates_new_generic_known
@@ -111,6 +124,24 @@ void VG_(print_translation_stats) ( void )
        "  AllRegs %'llu,  AllRegsAllInsns %'llu\n",
        n_PX_VexRegUpdSpAtMemAccess, n_PX_VexRegUpdUnwindregsAtMemAccess,
        n_PX_VexRegUpdAllregsAtMemAccess, n_PX_VexRegUpdAllregsAtEachInsn);
+
+   VG_(message)
+      (Vg_DebugMsg,
+       "translate: regalloc: spills %'llu, reloads %'llu,"
+       " remats %'llu, moves %'llu\n",
+       n_RA_spills, n_RA_reloads, n_RA_remats, n_RA_moves);
+
+   VG_(message)
+      (Vg_DebugMsg,
+       "translate: peephole: self-moves %'llu, reload fwds %'llu,"
+       " copy fwds %'llu, imm fwds %'llu, zext folds %'llu\n",
+       n_PP_self_moves, n_PP_reload_fwds, n_PP_copy_fwds,
+       n_PP_imm_fwds, n_PP_zext_folds);
+
+   VG_(message)
+      (Vg_DebugMsg,
+       "translate: condition code helper calls left unspecialised: %'llu\n",
+       n_unspec_cc_calls);
 }
 
 /*------------------------------------------------------------*/
@@ -740,6 +771,13 @@ IRSB* vg_SP_update_pass ( void*             closureV,
 #define N_TMPBUF 60000
 static UChar tmpbuf[N_TMPBUF];
 
+/* And the guest PC map, with --px-lazy-pc=yes.  There is at most one
+   entry for each guest insn (even after loop unrolling) and one for
+   each stretch of out-of-line code.  A translation which needs more
+   keeps the guest PC up to date instead, and has an empty map. */
+#define N_PC_MAP 2048
+static VexGuestPCMapEntry pc_map[N_PC_MAP];
+
 
 /* Function pointers we must supply to LibVEX in order that it
    can bomb out and emit messages under Valgrind's control. */
@@ -1491,7 +1529,7 @@ Bool VG_(translate) ( ThreadId tid,
 {
    Addr               addr;
    T_Kind             kind;
-   Int                tmpbuf_used, verbosity, i;
+   Int                tmpbuf_used, pc_map_used, verbosity, i;
    Bool (*preamble_fn)(void*,IRSB*);
    VexArch            vex_arch;
    VexArchInfo        vex_archinfo;
@@ -1687,6 +1725,13 @@ Bool VG_(translate) ( ThreadId tid,
    vex_abiinfo.guest_amd64_assume_fs_is_const = True;
 #  endif
 
+#  if defined(VGA_amd64)
+   /* No-redir translations go in a table of their own, which keeps no
+      guest PC maps, so they keep the guest PC up to date as usual. */
+   vex_abiinfo.host_amd64_lazy_guest_pc
+      = VG_(clo_px_lazy_pc) && kind != T_NoRedir;
+#  endif
+
 #  if defined(VGP_ppc32_linux)
    vex_abiinfo.guest_ppc_zap_RZ_at_blr        = False;
    vex_abiinfo.guest_ppc_zap_RZ_at_bl         = NULL;
@@ -1751,6 +1796,10 @@ Bool VG_(translate) ( ThreadId tid,
    vta.host_bytes       = tmpbuf;
    vta.host_bytes_size  = N_TMPBUF;
    vta.host_bytes_used  = &tmpbuf_used;
+   vta.pc_map           = pc_map;
+   vta.pc_map_size      = N_PC_MAP;
+   vta.pc_map_used      = &pc_map_used;
+   pc_map_used          = 0;
    { /* At this point we have to reconcile Vex's view of the
         instrumentation callback - which takes a void* first argument
         - with Valgrind's view, in which the first arg is a
@@ -1814,6 +1863,19 @@ Bool VG_(translate) ( ThreadId tid,
 
    vg_assert(tres.status == VexTransOK);
    vg_assert(tres.n_sc_extents >= 0 && tres.n_sc_extents <= 3);
+
+   n_RA_spills  += tres.n_spills;
+   n_RA_reloads += tres.n_reloads;
+   n_RA_remats  += tres.n_remats;
+   n_RA_moves   += tres.n_moves;
+
+   n_PP_self_moves  += tres.n_pp_self_moves;
+   n_PP_reload_fwds += tres.n_pp_reload_fwds;
+   n_PP_copy_fwds   += tres.n_pp_copy_fwds;
+   n_PP_imm_fwds    += tres.n_pp_imm_fwds;
+   n_PP_zext_folds  += tres.n_pp_zext_folds;
+
+   n_unspec_cc_calls += tres.n_unspec_cc_calls;
    vg_assert(tmpbuf_used <= N_TMPBUF);
    vg_assert(tmpbuf_used > 0);
    } /* END new scope specially for 'seg' */
@@ -1843,7 +1905,10 @@ Bool VG_(translate) ( ThreadId tid,
                                 tmpbuf_used,
                                 tres.n_sc_extents > 0,
                                 tres.offs_profInc,
-                                tres.n_guest_instrs );
+                                tres.n_guest_instrs,
+                                vex_abiinfo.host_amd64_lazy_guest_pc
+                                   ? pc_map : NULL,
+                                pc_map_used );
       } else {
           vg_assert(tres.offs_profInc == -1); /* -1 == unset */
           VG_(add_to_unredir_transtab)( &vge,
@@ -43,6 +43,7 @@
 #include "pub_core_aspacemgr.h"
 #include "pub_core_mallocfree.h" // VG_(out_of_memory_NORETURN)
 #include "pub_core_xarray.h"
+#include "pub_core_oset.h"
 #include "pub_core_dispatch.h"   // For VG_(disp_cp*) addresses
 
 
@@ -63,18 +64,28 @@ static SECno n_sectors = 0;
    provided default. */
 UInt VG_(clo_avg_transtab_entry_size) = 0;
 
+/* Percentage of a sector's code area which may be used to keep the
+   hottest translations of that sector when it is recycled.  0 means
+   to dump the whole sector, as a plain FIFO would do. */
+UInt VG_(clo_transtab_keep_hot) = 20;
+
+/* Memory budget in MB for the TT/TC.  0 means that the number of
+   sectors is fixed to VG_(clo_num_transtab_sectors).  Otherwise, the
+   number of sectors is adjusted at run time within the budget, see
+   autosize_transtab. */
+UInt VG_(clo_transtab_max_mb) = 0;
+
 /*------------------ CONSTANTS ------------------*/
 /* Number of entries in hash table of each sector.  This needs to be a prime
    number to work properly, it must be <= 65535 (so that a TTE index
-   fits in a UShort, leaving room for 0xFFFF(EC2TTE_DELETED, HTT_DELETED)
+   fits in a UShort, leaving room for 0xFFFF (HTT_DELETED)
    to denote 'deleted') and  0xFFFE (HTT_EMPTY) to denote 'Empty' in the
    hash table.
    It is strongly recommended not to change this.
    65521 is the largest prime <= 65535. */
 #define N_HTTES_PER_SECTOR /*10007*/ /*30011*/ /*40009*/ 65521
 
-#define EC2TTE_DELETED  0xFFFF /* 16-bit special value */
-#define HTT_DELETED     EC2TTE_DELETED
+#define HTT_DELETED     0xFFFF /* 16-bit special value */
 #define HTT_EMPTY       0XFFFE
 
 // HTTno is the Sector->htt hash table index. Must be the same type as TTEno.
@@ -89,18 +100,9 @@ typedef UShort HTTno;
 #define N_TTES_PER_SECTOR \
            ((N_HTTES_PER_SECTOR * SECTOR_TT_LIMIT_PERCENT) / 100)
 
-/* Equivalence classes for fast address range deletion.  There are 1 +
-   2^ECLASS_WIDTH bins.  The highest one, ECLASS_MISC, describes an
-   address range which does not fall cleanly within any specific bin.
-   Note that ECLASS_SHIFT + ECLASS_WIDTH must be < 32.
-   ECLASS_N must fit in a EclassNo. */
-#define ECLASS_SHIFT 13
-#define ECLASS_WIDTH 9
-#define ECLASS_MISC  (1 << ECLASS_WIDTH)
-#define ECLASS_N     (1 + ECLASS_MISC)
-STATIC_ASSERT(ECLASS_SHIFT + ECLASS_WIDTH < 32);
-
-typedef UShort EClassNo;
+/* Size of the pools from which the guest extent index allocates its
+   nodes. */
+#define GUEST_EXTENT_POOL_SIZE 1000
 
 /*------------------ TYPES ------------------*/
 
@@ -168,12 +170,17 @@ typedef
    struct {
       union {
          struct {
-            /* Profiling only: the count and weight (arbitrary meaning) for
-               this translation.  Weight is a property of the translation
+            /* The count and weight (arbitrary meaning) for this
+               translation.  Weight is a property of the translation
                itself and computed once when the translation is created.
-               Count is an entry count for the translation and is
-               incremented by 1 every time the translation is used, if we
-               are profiling. */
+               If we are profiling, count is an entry count for the
+               translation and is incremented by 1 every time the
+               translation is used.  If we are not profiling, count is
+               instead incremented each time VG_(search_transtab) finds
+               this translation, i.e. each time it is reached via a
+               fast-cache miss or is the target of a chaining request.
+               Either way, it is used to decide which translations are
+               hot enough to survive the recycling of their sector. */
             ULong    count;
             UShort   weight;
          } prof; // if status == InUse
@@ -195,20 +202,6 @@ typedef
          redirection. */
       Addr entry;
 
-      /* Address range summary info: these are pointers back to
-         eclass[] entries in the containing Sector.  Those entries in
-         turn point back here -- the two structures are mutually
-         redundant but both necessary to make fast deletions work.
-         The eclass info is similar to, and derived from, this entry's
-         'vge' field, but it is not the same */
-      UShort   n_tte2ec;      // # tte2ec pointers (1 to 3)
-      EClassNo tte2ec_ec[3];  // for each, the eclass #
-      UInt     tte2ec_ix[3];  // and the index within the eclass.
-      // for i in 0 .. n_tte2ec-1
-      //    sec->ec2tte[ tte2ec_ec[i] ][ tte2ec_ix[i] ] 
-      // should be the index 
-      // of this TTEntry in the containing Sector's tt array.
-
       /* Admin information for chaining.  'in_edges' is a set of the
          patch points which jump to this translation -- hence are
          predecessors in the control flow graph.  'out_edges' points
@@ -377,6 +370,20 @@ typedef
    }
    HostExtent;
 
+/* An index entry giving the guest address range covered by one of
+   the (up to 3) extents of an InUse translation.  The first four
+   fields are the key, so that entries are ordered by guest start
+   address, and are unique. */
+typedef
+   struct {
+      Addr   base;  /* guest start address of the extent */
+      SECno  sNo;   /* sector number */
+      TTEno  tteNo; /* TTE number in given sector */
+      UShort ix;    /* which of the TTE's vge_base[] this is */
+      UShort len;   /* the extent length, equal to vge_len[ix] */
+   }
+   GuestExtent;
+
 /* Finally, a sector itself.  Each sector contains an array of
    TCEntries, which hold code, and an array of TTEntries, containing
    all required administrative info.  Profiling is supported using the
@@ -412,18 +419,14 @@ typedef
       /* A list of Empty/Deleted entries, chained by tte->next_empty_tte */
       TTEno empty_tt_list;
 
-      /* Expandable arrays of tt indices for each of the ECLASS_N
-         address range equivalence classes.  These hold indices into
-         the containing sector's tt array, which in turn should point
-         back here. */
-      Int     ec2tte_size[ECLASS_N];
-      Int     ec2tte_used[ECLASS_N];
-      TTEno*  ec2tte[ECLASS_N];
-
       /* The host extents.  The [start, +len) ranges are constructed
          in strictly non-overlapping order, so we can binary search
          them at any time. */
       XArray* host_extents; /* XArray* of HostExtent */
+
+      /* The value of sector_fill_seq when this sector last became
+         the youngest sector. */
+      ULong fill_seq;
    }
    Sector;
 
@@ -432,11 +435,12 @@ typedef
 
 /* The root data structure is an array of sectors.  The index of the
    youngest sector is recorded, and new translations are put into that
-   sector.  When it fills up, we move along to the next sector and
-   start to fill that up, wrapping around at the end of the array.
-   That way, once all N_TC_SECTORS have been bought into use for the
-   first time, and are full, we then re-use the oldest sector,
-   endlessly. 
+   sector.  When it fills up, we move along to a sector never used
+   before if n_sectors_target allows it, and start to fill that up.
+   That way, once n_sectors_target sectors have been bought into use
+   for the first time, and are full, we then re-use the oldest sector,
+   endlessly.  Without auto-sizing, this is the same as moving along
+   to the next sector and wrapping around at the end of the array.
 
    When running, youngest sector should be between >= 0 and <
    N_TC_SECTORS.  The initial  value indicates the TT/TC system is
@@ -449,6 +453,56 @@ static Int    youngest_sector = INV_SNO;
    at startup and does not change. */
 static Int    tc_sector_szQ = 0;
 
+/* The total number of bytes mmap-ed for a sector, also computed once
+   at startup. */
+static SizeT  sector_szB = 0;
+
+/* The number of sectors which may be allocated at the moment, and
+   the number of sectors actually allocated.  n_sectors_target is
+   always <= n_sectors.  It is equal to n_sectors, unless the TT/TC
+   is auto-sized (VG_(clo_transtab_max_mb) > 0), in which case
+   n_sectors is the maximum number of sectors fitting in the budget
+   and n_sectors_target varies between MIN_N_SECTORS and n_sectors. */
+static SECno  n_sectors_target = 0;
+static SECno  n_sectors_allocated = 0;
+
+/* Bumped each time a sector becomes the youngest sector.  The oldest
+   sector is the allocated one with the smallest fill_seq. */
+static ULong  sector_fill_seq = 0;
+
+/* Auto-sizing works by looking at the proportion of new translations
+   which re-translate code dumped because a sector was recycled.  Each
+   time the youngest sector is full, if more than
+   TRANSTAB_GROW_RETRANS_PCT percent of the translations made since
+   the previous time were re-translations, one sector is added (if
+   the budget allows it).  If less than TRANSTAB_SHRINK_RETRANS_PCT
+   percent were, TRANSTAB_SHRINK_FILLS times in a row, the least used
+   sector is released, see release_excess_sectors. */
+#define TRANSTAB_GROW_RETRANS_PCT   10
+#define TRANSTAB_SHRINK_RETRANS_PCT 1
+#define TRANSTAB_SHRINK_FILLS       4
+
+/* Approximate set of the entry addresses of dumped translations,
+   used to recognise re-translations.  It is direct-mapped: each slot
+   holds the low 32 bits of the entry address of the translation
+   dumped last among those mapping to it, and is cleared when a
+   translation of that address is added.  A later dump mapping to the
+   same slot makes a re-translation go unnoticed, but new code is not
+   mistaken for re-translated code, as it would be with a bit per
+   slot once most slots have seen a dump.  That kept the measured
+   re-translation rate of programs running lots of new code above
+   TRANSTAB_SHRINK_RETRANS_PCT, so the transtab never shrank.
+   Allocated by VG_(init_tt_tc). */
+#define N_DUMPED_ENTRIES (1 << 16)
+static UInt* dumped_entries = NULL;
+
+/* Number of new translations and of re-translations since the
+   youngest sector was last declared full, and number of consecutive
+   fills with a low re-translation rate. */
+static ULong win_new_count     = 0;
+static ULong win_retrans_count = 0;
+static UInt  n_low_retrans_fills = 0;
+
 
 /* A list of sector numbers, in the order which they should be
    searched to find translations.  This is an optimisation to be used
@@ -457,6 +511,31 @@ static Int    tc_sector_szQ = 0;
 static SECno sector_search_order[MAX_N_SECTORS];
 
 
+/* The guest extent index: an OSet of GuestExtent, holding one entry
+   for each extent of each InUse translation, in all sectors.  It is
+   used to find the translations intersecting a range to discard in
+   O(log n + k) time, whatever the size of the range.  As entries are
+   ordered by start address only, a range [a, a+len) intersects the
+   extents starting between a - guest_extent_max_len + 1 and
+   a + len - 1, guest_extent_max_len being at least the length of
+   the longest extent in the index.
+
+   To keep guest_extent_max_len close to that length as translations
+   come and go, the extents are counted by length class:
+   guest_extent_len_count[b] is the number of indexed extents whose
+   length has its highest bit set at position b.  guest_extent_max_len
+   is the largest length in the highest non-empty class, hence is less
+   than twice the length of the longest indexed extent. */
+#define N_GUEST_EXTENT_LEN_CLASSES 16
+static OSet*  guest_extents = NULL;
+static UShort guest_extent_max_len = 0;
+static UInt   guest_extent_len_count[N_GUEST_EXTENT_LEN_CLASSES];
+
+/* Translations found by VG_(discard_translations), kept here so as
+   to not iterate over guest_extents while deleting from it. */
+static XArray* discard_victims = NULL; /* XArray* of GuestExtent */
+
+
 /* Fast helper for the TC.  A direct-mapped cache which holds a set of
    recently used (guest address, host address) pairs.  This array is
    referred to directly from m_dispatch/dispatch-<platform>.S.
@@ -508,6 +587,17 @@ static ULong n_dump_count = 0;
 static ULong n_dump_osize = 0;
 static ULong n_sectors_recycled = 0;
 
+/* Number/osize/tsize of hot translations kept when their sector
+   was recycled. */
+static ULong n_keep_count = 0;
+static ULong n_keep_osize = 0;
+static ULong n_keep_tsize = 0;
+
+/* Number of translations of code which was dumped before, and number
+   of sectors released by the auto-sizing. */
+static ULong n_retrans_count    = 0;
+static ULong n_sectors_released = 0;
+
 /* Number/osize of translations discarded due to requests to do so. */
 static ULong n_disc_count = 0;
 static ULong n_disc_osize = 0;
@@ -786,6 +876,151 @@ Bool HostExtent__is_dead (const HostExtent* hx, const Sector* sec)
 #undef LDEBUG
 }
 
+/* With --px-lazy-pc=yes, each translation's guest PC map is stored in
+   the tc just after its code, at the next 8-byte boundary:
+
+      UInt n_entries, UInt n_bases
+      Addr base[n_bases]       -- the translation's guest extents
+      UInt entry[n_entries]
+
+   Each entry holds the offset in the host code from which it applies
+   in bits 31..16, the index of a guest extent in bits 15..14 and the
+   offset of the guest insn in that extent in bits 13..0.  Extent
+   index 3 marks host code which belongs to no guest insn.  The map is
+   only found through the host extent of the code, which stays valid
+   for as long as the code itself, even if the TTEntry is deleted. */
+#define PC_MAP_NO_INSN 0xC000
+
+static inline const UInt* HostExtent__pc_map ( const HostExtent* hx )
+{
+   return (const UInt*)(hx->start + VG_ROUNDUP(hx->len, 8));
+}
+
+static UInt pc_map_szB ( UInt n_entries, UInt n_bases )
+{
+   return 8 + n_bases * sizeof(Addr) + n_entries * sizeof(UInt);
+}
+
+/* How many bytes of tc does the translation at hx take up? */
+static UInt HostExtent__tc_szB ( const HostExtent* hx )
+{
+   if (!VG_(clo_px_lazy_pc))
+      return hx->len;
+   const UInt* map = HostExtent__pc_map(hx);
+   return VG_ROUNDUP(hx->len, 8) + pc_map_szB(map[0], map[1]);
+}
+
+static void store_pc_map ( /*OUT*/UChar* dst, const VexGuestExtents* vge,
+                           const VexGuestPCMapEntry* pc_map, Int n_pc_map )
+{
+   UInt* hdr     = (UInt*)dst;
+   Addr* bases   = (Addr*)(dst + 8);
+   UInt* entries = (UInt*)(dst + 8 + vge->n_used * sizeof(Addr));
+   Int   i, e;
+
+   vg_assert(VG_IS_8_ALIGNED(dst));
+   hdr[0] = n_pc_map;
+   hdr[1] = vge->n_used;
+   for (e = 0; e < vge->n_used; e++)
+      bases[e] = vge->base[e];
+   for (i = 0; i < n_pc_map; i++) {
+      Addr pc    = pc_map[i].guest_pc;
+      UInt where = PC_MAP_NO_INSN;
+      vg_assert(pc_map[i].host_offs < 0x10000);
+      vg_assert(i == 0 || pc_map[i].host_offs > pc_map[i-1].host_offs);
+      if (pc != 0) {
+         for (e = 0; e < vge->n_used; e++) {
+            if (pc >= vge->base[e] && pc - vge->base[e] < vge->len[e])
+               break;
+         }
+         vg_assert(e < vge->n_used);
+         vg_assert(pc - vge->base[e] < 0x4000);
+         where = (e << 14) | (UInt)(pc - vge->base[e]);
+      }
+      entries[i] = (pc_map[i].host_offs << 16) | where;
+   }
+}
+
+/* A small cache of recent answers of VG_(search_transtab_guest_pc)
+   which found a guest insn.  Helpers which take stack traces tend to
+   be called from the same few call sites over and over.  Flushed
+   along with the fast cache, which covers every case where host code
+   is overwritten or moved. */
+#define N_PC_MAP_CACHE 256
+static struct { Addr hcode; Addr guest_pc; } pc_map_cache[N_PC_MAP_CACHE];
+
+static ULong n_pc_map_lookups = 0;
+static ULong n_pc_map_cache_hits = 0;
+
+static Bool lookup_pc_map ( /*OUT*/Addr* guest_pc, Addr hcode )
+{
+   SECno i;
+
+   for (i = 0; i < n_sectors; i++) {
+      SECno sno = sector_search_order[i];
+      if (UNLIKELY(sno == INV_SNO))
+         return False;
+
+      HostExtent key;
+      VG_(memset)(&key, 0, sizeof(key));
+      key.start = (void*)hcode;
+      key.len = 1;
+      Word firstW = -1, lastW = -1;
+      Bool found  = VG_(lookupXA_UNSAFE)(
+                       sectors[sno].host_extents, &key, &firstW, &lastW,
+                       HostExtent__cmpOrd );
+      if (!found)
+         continue;
+
+      const HostExtent* hx = VG_(indexXA)(sectors[sno].host_extents, firstW);
+      const UInt* map     = HostExtent__pc_map(hx);
+      const Addr* bases   = (const Addr*)(map + 2);
+      const UInt* entries = (const UInt*)(bases + map[1]);
+      UInt offs = (UChar*)hcode - hx->start;
+      /* Find the last entry at or before offs. */
+      Int lo = 0, hi = (Int)map[0] - 1, best = -1;
+      while (lo <= hi) {
+         Int mid = (lo + hi) / 2;
+         if ((entries[mid] >> 16) <= offs) {
+            best = mid;
+            lo = mid + 1;
+         } else {
+            hi = mid - 1;
+         }
+      }
+      if (best < 0 || (entries[best] & 0xC000) == PC_MAP_NO_INSN)
+         *guest_pc = 0;
+      else
+         *guest_pc = bases[(entries[best] >> 14) & 3]
+                     + (entries[best] & 0x3FFF);
+      return True;
+   }
+   return False;
+}
+
+Bool VG_(search_transtab_guest_pc) ( /*OUT*/Addr* guest_pc, Addr hcode )
+{
+   vg_assert(init_done);
+   if (!VG_(clo_px_lazy_pc))
+      return False;
+
+   n_pc_map_lookups++;
+   UInt ix = (hcode ^ (hcode >> 8)) & (N_PC_MAP_CACHE - 1);
+   if (pc_map_cache[ix].hcode == hcode) {
+      n_pc_map_cache_hits++;
+      *guest_pc = pc_map_cache[ix].guest_pc;
+      return True;
+   }
+
+   if (!lookup_pc_map(guest_pc, hcode))
+      return False;
+   if (*guest_pc != 0) {
+      pc_map_cache[ix].hcode    = hcode;
+      pc_map_cache[ix].guest_pc = *guest_pc;
+   }
+   return True;
+}
+
 static __attribute__((noinline))
 Bool find_TTEntry_from_hcode( /*OUT*/SECno* from_sNo,
                               /*OUT*/TTEno* from_tteNo,
@@ -1052,282 +1287,213 @@ void unchain_in_preparation_for_deletion ( VexArch arch_host,
 }
 
 
-/*-------------------------------------------------------------*/
-/*--- Address-range equivalence class stuff                 ---*/
-/*-------------------------------------------------------------*/
-
-/* Return equivalence class number for a range. */
-
-static EClassNo range_to_eclass ( Addr start, UInt len )
-{
-   UInt mask   = (1 << ECLASS_WIDTH) - 1;
-   UInt lo     = (UInt)start;
-   UInt hi     = lo + len - 1;
-   UInt loBits = (lo >> ECLASS_SHIFT) & mask;
-   UInt hiBits = (hi >> ECLASS_SHIFT) & mask;
-   if (loBits == hiBits) {
-      vg_assert(loBits < ECLASS_N-1);
-      return loBits;
-   } else {
-      return ECLASS_MISC;
-   }
-}
-
-
-/* Calculates the equivalence class numbers for any VexGuestExtent.
-   These are written in *eclasses, which must be big enough to hold 3
-   Ints.  The number written, between 1 and 3, is returned.  The
-   eclasses are presented in order, and any duplicates are removed.
-*/
-
-static 
-Int vexGuestExtents_to_eclasses ( /*OUT*/EClassNo* eclasses,
-                                  const TTEntryH* tteH )
+/* The specified block is about to be moved to another place in the
+   TC.  Undo all the chained jumps it contains, so that its code is
+   back in the state in which it was created, and can be copied. */
+static
+void unchain_out_edges ( VexArch arch_host, VexEndness endness_host,
+                         SECno here_sNo, TTEno here_tteNo )
 {
+   UWord     i, j, n, m;
+   Int       evCheckSzB = LibVEX_evCheckSzB(arch_host);
+   TTEntryC* here_tteC  = index_tteC(here_sNo, here_tteNo);
+   vg_assert(index_tteH(here_sNo, here_tteNo)->status == InUse);
 
-#  define SWAP(_lv1,_lv2) \
-      do { Int t = _lv1; _lv1 = _lv2; _lv2 = t; } while (0)
-
-   UInt i, j, n_ec;
-   EClassNo r;
-
-   vg_assert(tteH->vge_n_used >= 1 && tteH->vge_n_used <= 3);
-
-   n_ec = 0;
-   for (i = 0; i < tteH->vge_n_used; i++) {
-      r = range_to_eclass( tteH->vge_base[i], tteH->vge_len[i] );
-      if (r == ECLASS_MISC) 
-         goto bad;
-      /* only add if we haven't already seen it */
-      for (j = 0; j < n_ec; j++)
-         if (eclasses[j] == r)
-            break;
-      if (j == n_ec)
-         eclasses[n_ec++] = r;
-   }
-
-   if (n_ec == 1)
-      return 1;
-
-   if (n_ec == 2) {
-      /* sort */
-      if (eclasses[0] > eclasses[1])
-         SWAP(eclasses[0], eclasses[1]);
-      return 2;
+   n = OutEdgeArr__size(&here_tteC->out_edges);
+   for (i = 0; i < n; i++) {
+      OutEdge* oe = OutEdgeArr__index(&here_tteC->out_edges, i);
+      // Find the corresponding entry in the "to" node's in_edges,
+      // undo the chaining, and remove it.
+      TTEntryC* to_tteC = index_tteC(oe->to_sNo, oe->to_tteNo);
+      m = InEdgeArr__size(&to_tteC->in_edges);
+      vg_assert(m > 0); // it must have at least one entry
+      for (j = 0; j < m; j++) {
+         InEdge* ie = InEdgeArr__index(&to_tteC->in_edges, j);
+         if (ie->from_sNo == here_sNo && ie->from_tteNo == here_tteNo
+             && ie->from_offs == oe->from_offs)
+           break;
+      }
+      vg_assert(j < m); // "ie must be findable"
+      UChar* to_slow_EP = (UChar*)to_tteC->tcptr;
+      UChar* to_fast_EP = to_slow_EP + evCheckSzB;
+      unchain_one(arch_host, endness_host,
+                  InEdgeArr__index(&to_tteC->in_edges, j),
+                  to_fast_EP, to_slow_EP);
+      InEdgeArr__deleteIndex(&to_tteC->in_edges, j);
    }
 
-   if (n_ec == 3) {
-      /* sort */
-      if (eclasses[0] > eclasses[2])
-         SWAP(eclasses[0], eclasses[2]);
-      if (eclasses[0] > eclasses[1])
-         SWAP(eclasses[0], eclasses[1]);
-      if (eclasses[1] > eclasses[2])
-         SWAP(eclasses[1], eclasses[2]);
-      return 3;
-   }
+   OutEdgeArr__makeEmpty(&here_tteC->out_edges);
+}
 
-   /* NOTREACHED */
-   vg_assert(0);
 
-  bad:
-   eclasses[0] = ECLASS_MISC;
-   return 1;
+/*-------------------------------------------------------------*/
+/*--- The guest extent index                                ---*/
+/*-------------------------------------------------------------*/
 
-#  undef SWAP
+/* Ordering of the guest extent index: by guest start address, then by
+   translation and extent number. */
+
+static Word cmp_GuestExtent ( const void* keyV, const void* elemV )
+{
+   const GuestExtent* key  = (const GuestExtent*)keyV;
+   const GuestExtent* elem = (const GuestExtent*)elemV;
+   if (key->base < elem->base) return -1;
+   if (key->base > elem->base) return 1;
+   if (key->sNo < elem->sNo) return -1;
+   if (key->sNo > elem->sNo) return 1;
+   if (key->tteNo < elem->tteNo) return -1;
+   if (key->tteNo > elem->tteNo) return 1;
+   if (key->ix < elem->ix) return -1;
+   if (key->ix > elem->ix) return 1;
+   return 0;
 }
 
 
-/* Add tteno to the set of entries listed for equivalence class ec in
-   this sector.  Returns used location in eclass array. */
+/* The length class of an extent of length len, see
+   guest_extent_len_count. */
 
-static 
-UInt addEClassNo ( /*MOD*/Sector* sec, EClassNo ec, TTEno tteno )
+static inline UInt guest_extent_len_class ( UShort len )
 {
-   Int    old_sz, new_sz, i, r;
-   TTEno  *old_ar, *new_ar;
+   UInt b = 0;
+   vg_assert(len > 0);
+   while (len >> (b + 1))
+      b++;
+   return b;
+}
 
-   vg_assert(ec >= 0 && ec < ECLASS_N);
-   vg_assert(tteno < N_TTES_PER_SECTOR);
+/* Recompute guest_extent_max_len after the number of extents of some
+   length class changed. */
 
-   if (DEBUG_TRANSTAB) VG_(printf)("ec %d  gets %d\n", ec, (Int)tteno);
+static void update_guest_extent_max_len ( void )
+{
+   Int b;
+   for (b = N_GUEST_EXTENT_LEN_CLASSES - 1; b >= 0; b--) {
+      if (guest_extent_len_count[b] > 0) {
+         guest_extent_max_len = (UShort)((2U << b) - 1);
+         return;
+      }
+   }
+   guest_extent_max_len = 0;
+}
 
-   if (sec->ec2tte_used[ec] >= sec->ec2tte_size[ec]) {
+/* Add the extents of the InUse translation (sNo, tteNo) to the guest
+   extent index. */
 
-      vg_assert(sec->ec2tte_used[ec] == sec->ec2tte_size[ec]);
+static void add_guest_extents ( SECno sNo, TTEno tteNo )
+{
+   const TTEntryH* tteH = &sectors[sNo].ttH[tteNo];
+   UShort i;
 
-      old_sz = sec->ec2tte_size[ec];
-      old_ar = sec->ec2tte[ec];
-      new_sz = old_sz==0 ? 8 : old_sz<64 ? 2*old_sz : (3*old_sz)/2;
-      new_ar = ttaux_malloc("transtab.aECN.1",
-                            new_sz * sizeof(TTEno));
-      for (i = 0; i < old_sz; i++)
-         new_ar[i] = old_ar[i];
-      if (old_ar)
-         ttaux_free(old_ar);
-      sec->ec2tte_size[ec] = new_sz;
-      sec->ec2tte[ec] = new_ar;
+   vg_assert(tteH->status == InUse);
+   vg_assert(tteH->vge_n_used >= 1 && tteH->vge_n_used <= 3);
 
-      if (DEBUG_TRANSTAB) VG_(printf)("expand ec %d to %d\n", ec, new_sz);
+   for (i = 0; i < tteH->vge_n_used; i++) {
+      GuestExtent* ge
+         = VG_(OSetGen_AllocNode)(guest_extents, sizeof(GuestExtent));
+      ge->base  = tteH->vge_base[i];
+      ge->sNo   = sNo;
+      ge->tteNo = tteNo;
+      ge->ix    = i;
+      ge->len   = tteH->vge_len[i];
+      if (guest_extent_len_count[guest_extent_len_class(ge->len)]++ == 0
+          && ge->len > guest_extent_max_len)
+         update_guest_extent_max_len();
+      VG_(OSetGen_Insert)(guest_extents, ge);
    }
-
-   /* Common case */
-   r = sec->ec2tte_used[ec]++;
-   vg_assert(r >= 0 && r < sec->ec2tte_size[ec]);
-   sec->ec2tte[ec][r] = tteno;
-   return (UInt)r;
 }
 
 
-/* 'vge' is being added to 'sec' at TT entry 'tteno'.  Add appropriate
-   eclass entries to 'sec'. */
+/* Remove the extents of the translation (sNo, tteNo) from the guest
+   extent index.  Its TTEntryH must still describe them. */
 
-static 
-void upd_eclasses_after_add ( /*MOD*/Sector* sec, TTEno tteno )
+static void del_guest_extents ( SECno sNo, TTEno tteNo )
 {
-   Int i, r;
-   EClassNo eclasses[3];
-   vg_assert(tteno >= 0 && tteno < N_TTES_PER_SECTOR);
+   const TTEntryH* tteH = &sectors[sNo].ttH[tteNo];
+   GuestExtent     key;
+   UShort          i;
 
-   TTEntryH* tteH = &sec->ttH[tteno];
-   r = vexGuestExtents_to_eclasses( eclasses, tteH );
-   vg_assert(r >= 1 && r <= 3);
+   vg_assert(tteH->vge_n_used >= 1 && tteH->vge_n_used <= 3);
 
-   TTEntryC* tteC = &sec->ttC[tteno];
-   tteC->n_tte2ec = r;
-   for (i = 0; i < r; i++) {
-      tteC->tte2ec_ec[i] = eclasses[i];
-      tteC->tte2ec_ix[i] = addEClassNo( sec, eclasses[i], tteno );
+   for (i = 0; i < tteH->vge_n_used; i++) {
+      key.base  = tteH->vge_base[i];
+      key.sNo   = sNo;
+      key.tteNo = tteNo;
+      key.ix    = i;
+      GuestExtent* ge = VG_(OSetGen_Remove)(guest_extents, &key);
+      vg_assert(ge != NULL);
+      vg_assert(ge->len == tteH->vge_len[i]);
+      if (--guest_extent_len_count[guest_extent_len_class(ge->len)] == 0
+          && ge->len > (guest_extent_max_len >> 1))
+         update_guest_extent_max_len();
+      VG_(OSetGen_FreeNode)(guest_extents, ge);
    }
 }
 
 
-/* Check the eclass info in 'sec' to ensure it is consistent.  Returns
-   True if OK, False if something's not right.  Expensive. */
+/* Check that the guest extent index holds exactly the extents of the
+   InUse translations of all sectors.  Returns True if OK, False if
+   something's not right.  Expensive. */
 
-static Bool sanity_check_eclasses_in_sector ( const Sector* sec )
+static Bool sanity_check_guest_extents ( void )
 {
 #  define BAD(_str) do { whassup = (_str); goto bad; } while (0)
 
    const HChar* whassup = NULL;
-   Int      j, k, n, ec_idx;
-   EClassNo i;
-   EClassNo ec_num;
-   TTEno    tteno;
-   ULong*   tce;
-
-   /* Basic checks on this sector */
-   if (sec->tt_n_inuse < 0 || sec->tt_n_inuse > N_TTES_PER_SECTOR)
-      BAD("invalid sec->tt_n_inuse");
-   tce = sec->tc_next;
-   if (tce < &sec->tc[0] || tce > &sec->tc[tc_sector_szQ])
-      BAD("sec->tc_next points outside tc");
-
-   /* For each eclass ... */
-   for (i = 0; i < ECLASS_N; i++) {
-      if (sec->ec2tte_size[i] == 0 && sec->ec2tte[i] != NULL)
-         BAD("ec2tte_size/ec2tte mismatch(1)");
-      if (sec->ec2tte_size[i] != 0 && sec->ec2tte[i] == NULL)
-         BAD("ec2tte_size/ec2tte mismatch(2)");
-      if (sec->ec2tte_used[i] < 0 
-          || sec->ec2tte_used[i] > sec->ec2tte_size[i])
-         BAD("implausible ec2tte_used");
-      if (sec->ec2tte_used[i] == 0)
-         continue;
+   SECno        sno;
+   TTEno        tteno;
+   UInt         i, n_ext = 0;
+   UInt         len_count[N_GUEST_EXTENT_LEN_CLASSES];
+   GuestExtent  key;
 
-      /* For each tt reference in each eclass .. ensure the reference
-         is to a valid tt entry, and that the entry's address ranges
-         really include this eclass. */
+   VG_(memset)(len_count, 0, sizeof(len_count));
 
-      for (j = 0; j < sec->ec2tte_used[i]; j++) {
-         tteno = sec->ec2tte[i][j];
-         if (tteno == EC2TTE_DELETED)
-            continue;
-         if (tteno >= N_TTES_PER_SECTOR)
-            BAD("implausible tteno");
-         TTEntryC* tteC = &sec->ttC[tteno];
-         TTEntryH* tteH = &sec->ttH[tteno];
+   for (sno = 0; sno < n_sectors; sno++) {
+      const Sector* sec = &sectors[sno];
+      if (sec->tc == NULL)
+         continue;
+      if (sec->tt_n_inuse < 0 || sec->tt_n_inuse > N_TTES_PER_SECTOR)
+         BAD("invalid sec->tt_n_inuse");
+      if (sec->tc_next < &sec->tc[0] || sec->tc_next > &sec->tc[tc_sector_szQ])
+         BAD("sec->tc_next points outside tc");
+
+      for (tteno = 0; tteno < N_TTES_PER_SECTOR; tteno++) {
+         const TTEntryH* tteH = &sec->ttH[tteno];
          if (tteH->status != InUse)
-            BAD("tteno points to non-inuse tte");
-         if (tteC->n_tte2ec < 1 || tteC->n_tte2ec > 3)
-            BAD("tteC->n_tte2ec out of range");
-         /* Exactly least one of tte->eclasses[0 .. tte->n_eclasses-1]
-            must equal i.  Inspect tte's eclass info. */
-         n = 0;
-         for (k = 0; k < tteC->n_tte2ec; k++) {
-            if (k < tteC->n_tte2ec-1
-                && tteC->tte2ec_ec[k] >= tteC->tte2ec_ec[k+1])
-               BAD("tteC->tte2ec_ec[..] out of order");
-            ec_num = tteC->tte2ec_ec[k];
-            if (ec_num < 0 || ec_num >= ECLASS_N)
-               BAD("tteC->tte2ec_ec[..] out of range");
-            if (ec_num != i)
-               continue;
-            ec_idx = tteC->tte2ec_ix[k];
-            if (ec_idx < 0 || ec_idx >= sec->ec2tte_used[i])
-               BAD("tteC->tte2ec_ix[..] out of range");
-            if (ec_idx == j)
-               n++;
+            continue;
+         if (tteH->vge_n_used < 1 || tteH->vge_n_used > 3)
+            BAD("tteH->vge_n_used out of range");
+         for (i = 0; i < tteH->vge_n_used; i++) {
+            key.base  = tteH->vge_base[i];
+            key.sNo   = sno;
+            key.tteNo = tteno;
+            key.ix    = i;
+            const GuestExtent* ge = VG_(OSetGen_Lookup)(guest_extents, &key);
+            if (ge == NULL)
+               BAD("extent of InUse tte not in guest_extents");
+            if (ge->len != tteH->vge_len[i])
+               BAD("guest_extents len mismatch");
+            if (ge->len > guest_extent_max_len)
+               BAD("extent longer than guest_extent_max_len");
+            len_count[guest_extent_len_class(ge->len)]++;
+            n_ext++;
          }
-         if (n != 1)
-            BAD("tteno does not point back at eclass");
       }
    }
 
-   /* That establishes that for each forward pointer from TTEntrys
-      there is a corresponding backward pointer from the eclass[]
-      arrays.  However, it doesn't rule out the possibility of other,
-      bogus pointers in the eclass[] arrays.  So do those similarly:
-      scan through them and check the TTEntryies they point at point
-      back. */
-
-   for (tteno = 0; tteno < N_TTES_PER_SECTOR; tteno++) {
-
-      TTEntryC* tteC = &sec->ttC[tteno];
-      TTEntryH* tteH = &sec->ttH[tteno];
-      if (tteH->status == Empty || tteH->status == Deleted) {
-         if (tteC->n_tte2ec != 0)
-            BAD("tteC->n_tte2ec nonzero for unused tte");
-         continue;
-      }
-
-      vg_assert(tteH->status == InUse);
-
-      if (tteC->n_tte2ec < 1 || tteC->n_tte2ec > 3)
-         BAD("tteC->n_tte2ec out of range(2)");
-
-      for (j = 0; j < tteC->n_tte2ec; j++) {
-         ec_num = tteC->tte2ec_ec[j];
-         if (ec_num < 0 || ec_num >= ECLASS_N)
-            BAD("tteC->tte2ec_ec[..] out of range");
-         ec_idx = tteC->tte2ec_ix[j];
-         if (ec_idx < 0 || ec_idx >= sec->ec2tte_used[ec_num])
-            BAD("tteC->tte2ec_ix[..] out of range(2)");
-         if (sec->ec2tte[ec_num][ec_idx] != tteno)
-            BAD("ec2tte does not point back to tte");
-      }
+   /* Every extent of every InUse entry is in the index.  If the index
+      has no more elements than that, they are all accounted for. */
+   if (VG_(OSetGen_Size)(guest_extents) != n_ext)
+      BAD("guest_extents has entries for non-InUse ttes");
+   for (i = 0; i < N_GUEST_EXTENT_LEN_CLASSES; i++) {
+      if (len_count[i] != guest_extent_len_count[i])
+         BAD("guest_extent_len_count mismatch");
    }
 
    return True;
 
   bad:
    if (whassup)
-      VG_(debugLog)(0, "transtab", "eclass sanity fail: %s\n", whassup);
-
-#  if 0
-   VG_(printf)("eclass = %d\n", i);
-   VG_(printf)("tteno = %d\n", (Int)tteno);
-   switch (tte->status) {
-      case InUse:   VG_(printf)("InUse\n"); break;
-      case Deleted: VG_(printf)("Deleted\n"); break;
-      case Empty:   VG_(printf)("Empty\n"); break;
-   }
-   if (tte->status != Empty) {
-      for (k = 0; k < tte->vge.n_used; k++)
-         VG_(printf)("0x%lx %u\n", tte->vge.base[k], (UInt)tte->vge.len[k]);
-   }
-#  endif
-
+      VG_(debugLog)(0, "transtab", "guest extent sanity fail: %s\n", whassup);
    return False;
 
 #  undef BAD
@@ -1381,7 +1547,6 @@ static Bool sanity_check_sector_search_order ( void )
 static Bool sanity_check_all_sectors ( void )
 {
    SECno   sno;
-   Bool    sane;
    Sector* sec;
    for (sno = 0; sno < n_sectors; sno++) {
       Int i;
@@ -1390,9 +1555,6 @@ static Bool sanity_check_all_sectors ( void )
       sec = &sectors[sno];
       if (sec->tc == NULL)
          continue;
-      sane = sanity_check_eclasses_in_sector( sec );
-      if (!sane)
-         return False;
       szhxa = VG_(sizeXA)(sec->host_extents);
       for (i = 0; i < szhxa; i++) {
          const HostExtent* hx = VG_(indexXA)(sec->host_extents, i);
@@ -1407,7 +1569,9 @@ static Bool sanity_check_all_sectors ( void )
          return False;
       }
    }
-   
+
+   if ( !sanity_check_guest_extents() )
+      return False;
    if ( !sanity_check_redir_tt_tc() )
       return False;
    if ( !sanity_check_sector_search_order() )
@@ -1483,6 +1647,8 @@ static void invalidateFastCache ( void )
 
    vg_assert(j == VG_TT_FAST_SIZE);
    n_fast_flushes++;
+
+   VG_(memset)(pc_map_cache, 0, sizeof(pc_map_cache));
 }
 
 
@@ -1504,6 +1670,275 @@ static void add_to_empty_tt_list (SECno sNo, TTEno tteno)
    sectors[sNo].empty_tt_list = tteno;
 }
 
+/* Point an htt entry of sector sNo to the tt slot tteno. */
+static void add_to_htt (SECno sNo, TTEno tteno)
+{
+   HTTno htti = HASH_TT(sectors[sNo].ttC[tteno].entry);
+   vg_assert(htti >= 0 && htti < N_HTTES_PER_SECTOR);
+   while (True) {
+      if (sectors[sNo].htt[htti] == HTT_EMPTY
+          || sectors[sNo].htt[htti] == HTT_DELETED)
+         break;
+      htti++;
+      if (htti >= N_HTTES_PER_SECTOR)
+         htti = 0;
+   }
+   sectors[sNo].htt[htti] = tteno;
+}
+
+
+/* Support for keeping the hottest translations of a sector being
+   recycled.  Rather than dumping them and having to re-translate
+   them (nearly) straight away, their host code is compacted at the
+   start of the sector's tc, and their tt slots are kept.
+
+   This relies on the host code of a translation being relocatable
+   once all its chained jumps have been undone: all the backends
+   generate absolute addresses for calls to helpers and to the
+   dispatcher, and use relative branches only within a translation.
+   The tt slot number is kept unchanged so that a profile counter
+   patched into the host code (LibVEX_PatchProfInc) stays valid. */
+
+typedef
+   struct {
+      ULong score;
+      TTEno tteNo;
+      UInt  len;
+   }
+   HotCandidate;
+
+static Int HotCandidate__cmpScore ( const void* v1, const void* v2 )
+{
+   const HotCandidate* c1 = v1;
+   const HotCandidate* c2 = v2;
+   /* Hottest first. */
+   if (c1->score > c2->score) return -1;
+   if (c1->score < c2->score) return 1;
+   return 0;
+}
+
+/* Select the translations of sector sno that should be kept when the
+   sector is recycled.  Returns NULL if none should be kept, otherwise
+   an array of N_TTES_PER_SECTOR Bools, to be freed with ttaux_free. */
+static Bool* select_hot_translations ( SECno sno )
+{
+   Sector* sec = &sectors[sno];
+   Word    i, n_hx;
+   UInt    n_cands, n_kept;
+   ULong   budgetQ, usedQ;
+
+   if (VG_(clo_transtab_keep_hot) == 0)
+      return NULL;
+
+   budgetQ = ((ULong)tc_sector_szQ * VG_(clo_transtab_keep_hot)) / 100;
+   n_hx    = VG_(sizeXA)(sec->host_extents);
+   if (n_hx == 0)
+      return NULL;
+
+   HotCandidate* cands
+      = ttaux_malloc("transtab.select_hot_translations.1",
+                     n_hx * sizeof(HotCandidate));
+   n_cands = 0;
+   for (i = 0; i < n_hx; i++) {
+      const HostExtent* hx = VG_(indexXA)(sec->host_extents, i);
+      const TTEntryC*   tteC = &sec->ttC[hx->tteNo];
+      if (HostExtent__is_dead(hx, sec) || (UChar*)tteC->tcptr != hx->start)
+         continue;
+      vg_assert(sec->ttH[hx->tteNo].status == InUse);
+      /* A translation which has been chained to from other blocks
+         is likely to be on a hot path, even if it is rarely looked
+         up, so count the in-edges too. */
+      ULong score = tteC->usage.prof.count
+                    + InEdgeArr__size(&tteC->in_edges);
+      if (score < 2)
+         continue;
+      cands[n_cands].score = score;
+      cands[n_cands].tteNo = hx->tteNo;
+      cands[n_cands].len   = HostExtent__tc_szB(hx);
+      n_cands++;
+   }
+
+   VG_(ssort)(cands, n_cands, sizeof(HotCandidate), HotCandidate__cmpScore);
+
+   Bool* keep = NULL;
+   usedQ  = 0;
+   n_kept = 0;
+   for (i = 0; i < n_cands; i++) {
+      ULong reqdQ = (cands[i].len + 7) >> 3;
+      if (usedQ + reqdQ > budgetQ)
+         break;
+      /* Leave room for at least as many new translations as are
+         kept, so the sector doesn't immediately become full again. */
+      if (2 * (n_kept + 1) > N_TTES_PER_SECTOR)
+         break;
+      if (keep == NULL) {
+         keep = ttaux_malloc("transtab.select_hot_translations.2",
+                             N_TTES_PER_SECTOR * sizeof(Bool));
+         VG_(memset)(keep, 0, N_TTES_PER_SECTOR * sizeof(Bool));
+      }
+      keep[cands[i].tteNo] = True;
+      usedQ += reqdQ;
+      n_kept++;
+   }
+
+   ttaux_free(cands);
+   return keep;
+}
+
+/* Move the host code of the kept translations of sector sno to the
+   start of its tc, and rebuild the host extents and hash table for
+   them.  The chained jumps from and to the kept translations must
+   have been undone already, and the hash table must be empty.  The
+   host extents are still the ones from before the recycling, and are
+   in increasing host address order, so the code can be moved down in
+   place. */
+static void compact_hot_translations ( SECno sno, const Bool* keep )
+{
+   Sector* sec   = &sectors[sno];
+   ULong*  dst   = sec->tc;
+   Word    n_hx  = VG_(sizeXA)(sec->host_extents);
+   Word    i, w  = 0;
+
+   sec->tt_n_inuse = 0;
+   for (i = 0; i < n_hx; i++) {
+      HostExtent* hx   = VG_(indexXA)(sec->host_extents, i);
+      TTEno       tteNo = hx->tteNo;
+      TTEntryC*   tteC = &sec->ttC[tteNo];
+      if (!keep[tteNo] || sec->ttH[tteNo].status != InUse
+          || (UChar*)tteC->tcptr != hx->start)
+         continue;
+      UInt tc_szB = HostExtent__tc_szB(hx);
+      vg_assert((UChar*)dst <= hx->start);
+      VG_(memmove)(dst, hx->start, tc_szB);
+      VG_(invalidate_icache)(dst, hx->len);
+      tteC->tcptr = dst;
+      if (!VG_(clo_profyle_sbs))
+         /* Age the kept translations, so that they get dumped
+            eventually if they are not used anymore. */
+         tteC->usage.prof.count /= 2;
+
+      HostExtent* hx_w = VG_(indexXA)(sec->host_extents, w);
+      hx_w->start = (UChar*)dst;
+      hx_w->len   = hx->len;
+      hx_w->tteNo = tteNo;
+      w++;
+
+      add_to_htt(sno, tteNo);
+
+      dst += (tc_szB + 7) >> 3;
+      sec->tt_n_inuse++;
+      n_keep_count++;
+      n_keep_osize += TTEntryH__osize(&sec->ttH[tteNo]);
+      n_keep_tsize += hx_w->len;
+   }
+   VG_(dropTailXA)(sec->host_extents, n_hx - w);
+
+   sec->tc_next = dst;
+
+   if (VG_(clo_stats) || VG_(debugLog_getLevel)() >= 1)
+      VG_(dmsg)("transtab: " "keep     %d hot translations "
+                "(%lu bytes) in sector %d\n",
+                sec->tt_n_inuse, (UWord)(8 * (dst - sec->tc)), sno);
+}
+
+static inline UInt dumped_entries_ix ( Addr entry )
+{
+   UWord k = (UWord)entry;
+   k ^= k >> 16;
+   return (UInt)(k & (N_DUMPED_ENTRIES - 1));
+}
+
+static void note_dumped ( Addr entry )
+{
+   dumped_entries[dumped_entries_ix(entry)] = (UInt)entry;
+}
+
+/* Returns True if entry looks like the entry address of a dumped
+   translation, and forgets about it. */
+static Bool check_and_clear_dumped ( Addr entry )
+{
+   UInt ix = dumped_entries_ix(entry);
+   if (dumped_entries[ix] == (UInt)entry) {
+      dumped_entries[ix] = 0;
+      return True;
+   }
+   return False;
+}
+
+/* Dump all the translations of the in-use sector sno, except the
+   ones marked in keep (if not NULL), which are moved to the start of
+   the sector. */
+static void empty_sector ( SECno sno, const Bool* keep )
+{
+   Sector* sec = &sectors[sno];
+
+   vg_assert(sec->ttC != NULL);
+   vg_assert(sec->ttH != NULL);
+   vg_assert(sec->tc_next != NULL);
+
+   VexArch     arch_host = VexArch_INVALID;
+   VexArchInfo archinfo_host;
+   VG_(bzero_inline)(&archinfo_host, sizeof(archinfo_host));
+   VG_(machine_get_VexArchInfo)( &arch_host, &archinfo_host );
+   VexEndness endness_host = archinfo_host.endness;
+
+   /* Undo the own chained jumps of the translations to be kept,
+      before anything moves. */
+   if (keep) {
+      for (TTEno ei = 0; ei < N_TTES_PER_SECTOR; ei++) {
+         if (keep[ei])
+            unchain_out_edges(arch_host, endness_host, sno, ei);
+      }
+   }
+
+   /* Visit each just-about-to-be-abandoned translation. */
+   if (DEBUG_TRANSTAB) VG_(printf)("QQQ unlink-entire-sector: %d START\n",
+                                   sno);
+   sec->empty_tt_list = HTT_EMPTY;
+   for (TTEno ei = 0; ei < N_TTES_PER_SECTOR; ei++) {
+      if (sec->ttH[ei].status == InUse) {
+         unchain_in_preparation_for_deletion(arch_host,
+                                             endness_host, sno, ei);
+         if (keep && keep[ei]) {
+            /* It stays in the same tt slot, so its guest extent
+               index entries remain valid. */
+            continue;
+         }
+         del_guest_extents(sno, ei);
+         n_dump_count++;
+         n_dump_osize += TTEntryH__osize(&sec->ttH[ei]);
+         note_dumped(sec->ttC[ei].entry);
+         /* Tell the tool too. */
+         if (VG_(needs).superblock_discards) {
+            VexGuestExtents vge_tmp;
+            TTEntryH__to_VexGuestExtents( &vge_tmp, &sec->ttH[ei] );
+            VG_TDICT_CALL( tool_discard_superblock_info,
+                           sec->ttC[ei].entry, vge_tmp );
+         }
+      }
+      sec->ttH[ei].status = Empty;
+      add_to_empty_tt_list(sno, ei);
+   }
+   for (HTTno hi = 0; hi < N_HTTES_PER_SECTOR; hi++)
+      sec->htt[hi] = HTT_EMPTY;
+
+   if (DEBUG_TRANSTAB) VG_(printf)("QQQ unlink-entire-sector: %d END\n",
+                                   sno);
+
+   /* Move the kept translations to the start of the sector, and
+      empty out the rest of the host extents array. */
+   vg_assert(sec->host_extents != NULL);
+   if (keep) {
+      compact_hot_translations(sno, keep);
+   } else {
+      VG_(dropTailXA)(sec->host_extents,
+                      VG_(sizeXA)(sec->host_extents));
+      vg_assert(VG_(sizeXA)(sec->host_extents) == 0);
+      sec->tc_next = sec->tc;
+      sec->tt_n_inuse = 0;
+   }
+}
+
 static void initialiseSector ( SECno sno )
 {
    UInt i;
@@ -1524,17 +1959,12 @@ static void initialiseSector ( SECno sno )
       vg_assert(sec->ttH == NULL);
       vg_assert(sec->tc_next == NULL);
       vg_assert(sec->tt_n_inuse == 0);
-      for (EClassNo e = 0; e < ECLASS_N; e++) {
-         vg_assert(sec->ec2tte_size[e] == 0);
-         vg_assert(sec->ec2tte_used[e] == 0);
-         vg_assert(sec->ec2tte[e] == NULL);
-      }
       vg_assert(sec->host_extents == NULL);
 
       if (VG_(clo_stats) || VG_(debugLog_getLevel)() >= 1)
          VG_(dmsg)("transtab: " "allocate sector %d\n", sno);
 
-      sres = VG_(am_mmap_anon_float_valgrind)( 8 * tc_sector_szQ );
+      sres = VG_(am_mmap_anon_float_valgrind_huge)( 8 * tc_sector_szQ );
       if (sr_isError(sres)) {
          VG_(out_of_memory_NORETURN)("initialiseSector(TC)", 
                                      8 * tc_sector_szQ );
@@ -1562,8 +1992,7 @@ static void initialiseSector ( SECno sno )
 
       sec->empty_tt_list = HTT_EMPTY;
       for (TTEno ei = 0; ei < N_TTES_PER_SECTOR; ei++) {
-         sec->ttH[ei].status   = Empty;
-         sec->ttC[ei].n_tte2ec = 0;
+         sec->ttH[ei].status = Empty;
          add_to_empty_tt_list(sno, ei);
       }
 
@@ -1592,6 +2021,10 @@ static void initialiseSector ( SECno sno )
       vg_assert(i >= 0 && i < n_sectors);
       sector_search_order[i] = sno;
 
+      sec->tc_next = sec->tc;
+      sec->tt_n_inuse = 0;
+      n_sectors_allocated++;
+
       if (VG_(clo_verbosity) > 2)
          VG_(message)(Vg_DebugMsg, "TT/TC: initialise sector %d\n", sno);
 
@@ -1602,66 +2035,11 @@ static void initialiseSector ( SECno sno )
          VG_(dmsg)("transtab: " "recycle  sector %d\n", sno);
       n_sectors_recycled++;
 
-      vg_assert(sec->ttC != NULL);
-      vg_assert(sec->ttH != NULL);
-      vg_assert(sec->tc_next != NULL);
-      n_dump_count += sec->tt_n_inuse;
-
-      VexArch     arch_host = VexArch_INVALID;
-      VexArchInfo archinfo_host;
-      VG_(bzero_inline)(&archinfo_host, sizeof(archinfo_host));
-      VG_(machine_get_VexArchInfo)( &arch_host, &archinfo_host );
-      VexEndness endness_host = archinfo_host.endness;
-
-      /* Visit each just-about-to-be-abandoned translation. */
-      if (DEBUG_TRANSTAB) VG_(printf)("QQQ unlink-entire-sector: %d START\n",
-                                      sno);
-      sec->empty_tt_list = HTT_EMPTY;
-      for (TTEno ei = 0; ei < N_TTES_PER_SECTOR; ei++) {
-         if (sec->ttH[ei].status == InUse) {
-            vg_assert(sec->ttC[ei].n_tte2ec >= 1);
-            vg_assert(sec->ttC[ei].n_tte2ec <= 3);
-            n_dump_osize += TTEntryH__osize(&sec->ttH[ei]);
-            /* Tell the tool too. */
-            if (VG_(needs).superblock_discards) {
-               VexGuestExtents vge_tmp;
-               TTEntryH__to_VexGuestExtents( &vge_tmp, &sec->ttH[ei] );
-               VG_TDICT_CALL( tool_discard_superblock_info,
-                              sec->ttC[ei].entry, vge_tmp );
-            }
-            unchain_in_preparation_for_deletion(arch_host,
-                                                endness_host, sno, ei);
-         } else {
-            vg_assert(sec->ttC[ei].n_tte2ec == 0);
-         }
-         sec->ttH[ei].status   = Empty;
-         sec->ttC[ei].n_tte2ec = 0;
-         add_to_empty_tt_list(sno, ei);
-      }
-      for (HTTno hi = 0; hi < N_HTTES_PER_SECTOR; hi++)
-         sec->htt[hi] = HTT_EMPTY;
-
-      if (DEBUG_TRANSTAB) VG_(printf)("QQQ unlink-entire-sector: %d END\n",
-                                      sno);
-
-      /* Free up the eclass structures. */
-      for (EClassNo e = 0; e < ECLASS_N; e++) {
-         if (sec->ec2tte_size[e] == 0) {
-            vg_assert(sec->ec2tte_used[e] == 0);
-            vg_assert(sec->ec2tte[e] == NULL);
-         } else {
-            vg_assert(sec->ec2tte[e] != NULL);
-            ttaux_free(sec->ec2tte[e]);
-            sec->ec2tte[e] = NULL;
-            sec->ec2tte_size[e] = 0;
-            sec->ec2tte_used[e] = 0;
-         }
-      }
-
-      /* Empty out the host extents array. */
-      vg_assert(sec->host_extents != NULL);
-      VG_(dropTailXA)(sec->host_extents, VG_(sizeXA)(sec->host_extents));
-      vg_assert(VG_(sizeXA)(sec->host_extents) == 0);
+      /* Find out which translations are hot enough to be kept. */
+      Bool* keep = select_hot_translations(sno);
+      empty_sector(sno, keep);
+      if (keep)
+         ttaux_free(keep);
 
       /* Sanity check: ensure it is already in
          sector_search_order[]. */
@@ -1676,8 +2054,54 @@ static void initialiseSector ( SECno sno )
          VG_(message)(Vg_DebugMsg, "TT/TC: recycle sector %d\n", sno);
    }
 
-   sec->tc_next = sec->tc;
-   sec->tt_n_inuse = 0;
+   sec->fill_seq = ++sector_fill_seq;
+
+   invalidateFastCache();
+
+   { Bool sane = sanity_check_sector_search_order();
+     vg_assert(sane);
+   }
+}
+
+/* Dump all the translations of the allocated sector sno, and give its
+   memory back to aspacem.  The sector can be initialised again
+   later. */
+static void releaseSector ( SECno sno )
+{
+   SECno   i;
+   Sector* sec = &sectors[sno];
+
+   vg_assert(isValidSector(sno));
+   vg_assert(sno != youngest_sector);
+   vg_assert(sec->tc != NULL);
+
+   if (VG_(clo_stats) || VG_(debugLog_getLevel)() >= 1)
+      VG_(dmsg)("transtab: " "release  sector %d\n", sno);
+   n_sectors_released++;
+
+   empty_sector(sno, NULL);
+
+   VG_(deleteXA)(sec->host_extents);
+   (void)VG_(am_munmap_valgrind)((Addr)sec->tc, 8 * tc_sector_szQ);
+   (void)VG_(am_munmap_valgrind)((Addr)sec->ttC,
+                                 N_TTES_PER_SECTOR * sizeof(TTEntryC));
+   (void)VG_(am_munmap_valgrind)((Addr)sec->ttH,
+                                 N_TTES_PER_SECTOR * sizeof(TTEntryH));
+   (void)VG_(am_munmap_valgrind)((Addr)sec->htt,
+                                 N_HTTES_PER_SECTOR * sizeof(TTEno));
+   VG_(memset)(sec, 0, sizeof(*sec));
+   n_sectors_allocated--;
+
+   /* Remove it from the sector_search_order, keeping the others in
+      the same order. */
+   for (i = 0; i < n_sectors; i++) {
+      if (sector_search_order[i] == sno)
+         break;
+   }
+   vg_assert(i < n_sectors);
+   for (/* */; i+1 < n_sectors; i++)
+      sector_search_order[i] = sector_search_order[i+1];
+   sector_search_order[n_sectors-1] = INV_SNO;
 
    invalidateFastCache();
 
@@ -1686,6 +2110,143 @@ static void initialiseSector ( SECno sno )
    }
 }
 
+/* Return how much the translations of the allocated sector sno have
+   been used, scored the same way as by select_hot_translations. */
+static ULong sector_heat ( SECno sno )
+{
+   const Sector* sec  = &sectors[sno];
+   ULong         heat = 0;
+   TTEno         i;
+
+   for (i = 0; i < N_TTES_PER_SECTOR; i++) {
+      if (sec->ttH[i].status != InUse)
+         continue;
+      heat += sec->ttC[i].usage.prof.count
+              + InEdgeArr__size(&sec->ttC[i].in_edges);
+   }
+   return heat;
+}
+
+/* Return the allocated sector, other than the youngest one, whose
+   translations have been used least.  Ties go to the oldest. */
+static SECno coldest_sector ( void )
+{
+   SECno sno, coldest = INV_SNO;
+   ULong heat, coldest_heat = 0;
+
+   for (sno = 0; sno < n_sectors; sno++) {
+      if (sectors[sno].tc == NULL || sno == youngest_sector)
+         continue;
+      heat = sector_heat(sno);
+      if (coldest == INV_SNO || heat < coldest_heat
+          || (heat == coldest_heat
+              && sectors[sno].fill_seq < sectors[coldest].fill_seq)) {
+         coldest      = sno;
+         coldest_heat = heat;
+      }
+   }
+   vg_assert(coldest != INV_SNO);
+   return coldest;
+}
+
+/* Return the allocated sector that became the youngest sector
+   longest ago. */
+static SECno oldest_sector ( void )
+{
+   SECno sno, oldest = INV_SNO;
+   for (sno = 0; sno < n_sectors; sno++) {
+      if (sectors[sno].tc == NULL)
+         continue;
+      if (oldest == INV_SNO
+          || sectors[sno].fill_seq < sectors[oldest].fill_seq)
+         oldest = sno;
+   }
+   vg_assert(oldest != INV_SNO);
+   return oldest;
+}
+
+/* Called when the youngest sector is full, to adjust
+   n_sectors_target according to the re-translation rate observed
+   while it was filled. */
+static void autosize_transtab ( void )
+{
+   UInt retrans_pct = win_new_count == 0
+                      ? 0 : (UInt)((100 * win_retrans_count) / win_new_count);
+
+   if (n_sectors_allocated < n_sectors_target) {
+      /* Still bringing sectors into use for the first time, nothing
+         was dumped, so there is no pressure to measure. */
+   } else if (retrans_pct > TRANSTAB_GROW_RETRANS_PCT) {
+      n_low_retrans_fills = 0;
+      if (n_sectors_target < n_sectors) {
+         n_sectors_target++;
+         if (VG_(clo_stats) || VG_(debugLog_getLevel)() >= 1)
+            VG_(dmsg)("transtab: " "grow     to %d sectors "
+                      "(%u%% re-translations)\n",
+                      n_sectors_target, retrans_pct);
+      }
+   } else if (retrans_pct < TRANSTAB_SHRINK_RETRANS_PCT
+              && n_sectors_recycled >= n_sectors_allocated) {
+      n_low_retrans_fills++;
+      if (n_low_retrans_fills >= TRANSTAB_SHRINK_FILLS
+          && n_sectors_target > MIN_N_SECTORS) {
+         n_low_retrans_fills = 0;
+         n_sectors_target--;
+         if (VG_(clo_stats) || VG_(debugLog_getLevel)() >= 1)
+            VG_(dmsg)("transtab: " "shrink   to %d sectors "
+                      "(%u%% re-translations)\n",
+                      n_sectors_target, retrans_pct);
+      }
+   } else {
+      n_low_retrans_fills = 0;
+   }
+
+   win_new_count     = 0;
+   win_retrans_count = 0;
+}
+
+/* The youngest sector is full.  Choose the sector to fill next: a
+   sector never used before if n_sectors_target allows it, otherwise
+   the oldest sector, which will be recycled.  If the transtab has to
+   shrink, that is done later by release_excess_sectors, so as not to
+   dump the translations of two sectors at once. */
+static SECno choose_next_youngest_sector ( void )
+{
+   SECno sno;
+
+   if (VG_(clo_transtab_max_mb) > 0)
+      autosize_transtab();
+
+   if (n_sectors_allocated < n_sectors_target) {
+      for (sno = 0; sno < n_sectors; sno++) {
+         if (sectors[sno].tc == NULL)
+            return sno;
+      }
+      vg_assert(0);
+   }
+
+   return oldest_sector();
+}
+
+/* Called after a translation has been added to the youngest sector.
+   If there are more sectors allocated than n_sectors_target, release
+   the coldest ones once the youngest sector is half full: by then the
+   translations of the sector recycled last which are still in use
+   have been made again, and the use counts tell which sector is not
+   needed anymore. */
+static void release_excess_sectors ( void )
+{
+   const Sector* sec = &sectors[youngest_sector];
+
+   if (LIKELY(n_sectors_allocated <= n_sectors_target))
+      return;
+   if (2 * sec->tt_n_inuse < N_TTES_PER_SECTOR
+       && 2 * (sec->tc_next - sec->tc) < tc_sector_szQ)
+      return;
+   while (n_sectors_allocated > n_sectors_target)
+      releaseSector(coldest_sector());
+}
+
 /* Add a translation of vge to TT/TC.  The translation is temporarily
    in code[0 .. code_len-1].
 
@@ -1698,9 +2259,12 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
                            UInt             code_len,
                            Bool             is_self_checking,
                            Int              offs_profInc,
-                           UInt             n_guest_instrs )
+                           UInt             n_guest_instrs,
+                           const VexGuestPCMapEntry* pc_map,
+                           Int              n_pc_map )
 {
    Int    tcAvailQ, reqdQ, y;
+   UInt   tc_szB;
    ULong  *tcptr, *tcptr2;
    UChar* srcP;
    UChar* dstP;
@@ -1723,6 +2287,11 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
    n_in_osize += vge_osize(vge);
    if (is_self_checking)
       n_in_sc_count++;
+   win_new_count++;
+   if (check_and_clear_dumped(entry)) {
+      n_retrans_count++;
+      win_retrans_count++;
+   }
 
    y = youngest_sector;
    vg_assert(isValidSector(y));
@@ -1731,7 +2300,12 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
       initialiseSector(y);
 
    /* Try putting the translation in this sector. */
-   reqdQ = (code_len + 7) >> 3;
+   vg_assert((pc_map != NULL) == VG_(clo_px_lazy_pc));
+   if (pc_map != NULL)
+      tc_szB = VG_ROUNDUP(code_len, 8) + pc_map_szB(n_pc_map, vge->n_used);
+   else
+      tc_szB = code_len;
+   reqdQ = (tc_szB + 7) >> 3;
 
    /* Will it fit in tc? */
    tcAvailQ = ((ULong*)(&sectors[y].tc[tc_sector_szQ]))
@@ -1757,9 +2331,7 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
                    y, tt_loading_pct, tc_loading_pct,
                    8 * (tc_sector_szQ - tcAvailQ)/sectors[y].tt_n_inuse);
       }
-      youngest_sector++;
-      if (youngest_sector >= n_sectors)
-         youngest_sector = 0;
+      youngest_sector = choose_next_youngest_sector();
       y = youngest_sector;
       initialiseSector(y);
    }
@@ -1781,6 +2353,8 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
    dstP = (UChar*)tcptr;
    srcP = (UChar*)code;
    VG_(memcpy)(dstP, srcP, code_len);
+   if (pc_map != NULL)
+      store_pc_map(dstP + VG_ROUNDUP(code_len, 8), vge, pc_map, n_pc_map);
    sectors[y].tc_next += reqdQ;
    sectors[y].tt_n_inuse++;
 
@@ -1803,17 +2377,7 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
    sectors[y].ttH[tteix].status = InUse;
 
    // Point an htt entry to the tt slot
-   HTTno htti = HASH_TT(entry);
-   vg_assert(htti >= 0 && htti < N_HTTES_PER_SECTOR);
-   while (True) {
-      if (sectors[y].htt[htti] == HTT_EMPTY
-          || sectors[y].htt[htti] == HTT_DELETED)
-         break;
-      htti++;
-      if (htti >= N_HTTES_PER_SECTOR)
-         htti = 0;
-   }
-   sectors[y].htt[htti] = tteix;
+   add_to_htt(y, tteix);
 
    /* Patch in the profile counter location, if necessary. */
    if (offs_profInc != -1) {
@@ -1855,8 +2419,10 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
    /* Update the fast-cache. */
    setFastCacheEntry( entry, tcptr );
 
-   /* Note the eclass numbers for this translation. */
-   upd_eclasses_after_add( &sectors[y], tteix );
+   /* Note the guest address ranges of this translation. */
+   add_guest_extents( y, tteix );
+
+   release_excess_sectors();
 }
 
 
@@ -1896,6 +2462,8 @@ Bool VG_(search_transtab) ( /*OUT*/Addr*  res_hcode,
          if (tti < N_TTES_PER_SECTOR
              && sectors[sno].ttC[tti].entry == guest_addr) {
             /* found it */
+            if (!VG_(clo_profyle_sbs))
+               sectors[sno].ttC[tti].usage.prof.count++;
             if (upd_cache)
                setFastCacheEntry( 
                   guest_addr, sectors[sno].ttC[tti].tcptr );
@@ -1971,14 +2539,12 @@ Bool overlaps ( Addr start, ULong range, const TTEntryH* tteH )
 }
 
 
-/* Delete a tt entry, and update all the eclass data accordingly. */
+/* Delete a tt entry, and update the guest extent index
+   accordingly. */
 
 static void delete_tte ( /*MOD*/Sector* sec, SECno secNo, TTEno tteno,
                          VexArch arch_host, VexEndness endness_host )
 {
-   Int      i, ec_idx;
-   EClassNo ec_num;
-
    /* sec and secNo are mutually redundant; cross-check. */
    vg_assert(sec == &sectors[secNo]);
 
@@ -1986,23 +2552,12 @@ static void delete_tte ( /*MOD*/Sector* sec, SECno secNo, TTEno tteno,
    TTEntryC* tteC = &sec->ttC[tteno];
    TTEntryH* tteH = &sec->ttH[tteno];
    vg_assert(tteH->status == InUse);
-   vg_assert(tteC->n_tte2ec >= 1 && tteC->n_tte2ec <= 3);
 
    /* Unchain .. */
    unchain_in_preparation_for_deletion(arch_host, endness_host, secNo, tteno);
 
-   /* Deal with the ec-to-tte links first. */
-   for (i = 0; i < tteC->n_tte2ec; i++) {
-      ec_num = tteC->tte2ec_ec[i];
-      ec_idx = tteC->tte2ec_ix[i];
-      vg_assert(ec_num >= 0 && ec_num < ECLASS_N);
-      vg_assert(ec_idx >= 0);
-      vg_assert(ec_idx < sec->ec2tte_used[ec_num]);
-      /* Assert that the two links point at each other. */
-      vg_assert(sec->ec2tte[ec_num][ec_idx] == tteno);
-      /* "delete" the pointer back to here. */
-      sec->ec2tte[ec_num][ec_idx] = EC2TTE_DELETED;
-   }
+   /* Deal with the guest extent index first. */
+   del_guest_extents(secNo, tteno);
 
    /* Now fix up this TTEntry. */
    /* Mark the entry as deleted in htt.
@@ -2019,9 +2574,8 @@ static void delete_tte ( /*MOD*/Sector* sec, SECno secNo, TTEno tteno,
          k = 0;
    }
    vg_assert(j < N_HTTES_PER_SECTOR);
-   sec->htt[k]    = HTT_DELETED;
-   tteH->status   = Deleted;
-   tteC->n_tte2ec = 0;
+   sec->htt[k]  = HTT_DELETED;
+   tteH->status = Deleted;
    add_to_empty_tt_list(secNo, tteno);
 
    /* Stats .. */
@@ -2038,81 +2592,16 @@ static void delete_tte ( /*MOD*/Sector* sec, SECno secNo, TTEno tteno,
 }
 
 
-/* Delete translations from sec which intersect specified range, but
-   only consider translations in the specified eclass. */
-
-static 
-Bool delete_translations_in_sector_eclass ( /*MOD*/Sector* sec, SECno secNo,
-                                            Addr guest_start, ULong range,
-                                            EClassNo ec,
-                                            VexArch arch_host,
-                                            VexEndness endness_host )
-{
-   Int      i;
-   TTEno    tteno;
-   Bool     anyDeld = False;
-
-   vg_assert(ec >= 0 && ec < ECLASS_N);
-
-   for (i = 0; i < sec->ec2tte_used[ec]; i++) {
-
-      tteno = sec->ec2tte[ec][i];
-      if (tteno == EC2TTE_DELETED) {
-         /* already deleted */
-         continue;
-      }
-
-      vg_assert(tteno < N_TTES_PER_SECTOR);
-
-      TTEntryH* tteH = &sec->ttH[tteno];
-      vg_assert(tteH->status == InUse);
-
-      if (overlaps( guest_start, range, tteH )) {
-         anyDeld = True;
-         delete_tte( sec, secNo, tteno, arch_host, endness_host );
-      }
-
-   }
-
-   return anyDeld;
-}
-
-
-/* Delete translations from sec which intersect specified range, the
-   slow way, by inspecting all translations in sec. */
-
-static 
-Bool delete_translations_in_sector ( /*MOD*/Sector* sec, SECno secNo,
-                                     Addr guest_start, ULong range,
-                                     VexArch arch_host,
-                                     VexEndness endness_host )
-{
-   TTEno i;
-   Bool  anyDeld = False;
-
-   for (i = 0; i < N_TTES_PER_SECTOR; i++) {
-      /* The entire and only purpose of splitting TTEntry into cold
-         and hot parts (TTEntryC and TTEntryH) is to make this search
-         loop run as fast as possible, by avoiding having to pull all
-         of the cold data up the memory hierarchy. */
-      if (UNLIKELY(sec->ttH[i].status == InUse
-                   && overlaps( guest_start, range, &sec->ttH[i] ))) {
-         anyDeld = True;
-         delete_tte( sec, secNo, i, arch_host, endness_host );
-      }
-   }
-
-   return anyDeld;
-} 
-
-
 void VG_(discard_translations) ( Addr guest_start, ULong range,
                                  const HChar* who )
 {
-   Sector* sec;
-   SECno   sno;
-   EClassNo ec;
-   Bool    anyDeleted = False;
+   Sector*      sec;
+   SECno        sno;
+   Word         i, n;
+   GuestExtent  key;
+   GuestExtent* ge;
+   Addr         last;
+   Bool         anyDeleted = False;
 
    vg_assert(init_done);
 
@@ -2135,71 +2624,43 @@ void VG_(discard_translations) ( Addr guest_start, ULong range,
    VG_(machine_get_VexArchInfo)( &arch_host, &archinfo_host );
    VexEndness endness_host = archinfo_host.endness;
 
-   /* There are two different ways to do this.
-
-      If the range fits within a single address-range equivalence
-      class, as will be the case for a cache line sized invalidation,
-      then we only have to inspect the set of translations listed in
-      that equivalence class, and also in the "sin-bin" equivalence
-      class ECLASS_MISC.
-
-      Otherwise, the invalidation is of a larger range and probably
-      results from munmap.  In this case it's (probably!) faster just
-      to inspect all translations, dump those we don't want, and
-      regenerate the equivalence class information (since modifying it
-      in-situ is even more expensive).
-   */
-
-   /* First off, figure out if the range falls within a single class, 
-      and if so which one. */
-
-   ec = ECLASS_MISC;
-   if (range <= (1ULL << ECLASS_SHIFT))
-      ec = range_to_eclass( guest_start, (UInt)range );
-
-   /* if ec is ECLASS_MISC then we aren't looking at just a single
-      class, so use the slow scheme.  Else use the fast scheme,
-      examining 'ec' and ECLASS_MISC. */
-
-   if (ec != ECLASS_MISC) {
-
-      VG_(debugLog)(2, "transtab",
-                       "                    FAST, ec = %d\n", ec);
-
-      /* Fast scheme */
-      vg_assert(ec >= 0 && ec < ECLASS_MISC);
-
-      for (sno = 0; sno < n_sectors; sno++) {
-         sec = &sectors[sno];
-         if (sec->tc == NULL)
-            continue;
-         anyDeleted |= delete_translations_in_sector_eclass( 
-                          sec, sno, guest_start, range, ec, 
-                          arch_host, endness_host
-                       );
-         anyDeleted |= delete_translations_in_sector_eclass( 
-                          sec, sno, guest_start, range, ECLASS_MISC,
-                          arch_host, endness_host
-                       );
-      }
-
-   } else {
+   /* Find the indexed extents intersecting [guest_start, last],
+      which are among those starting in [guest_start
+      - guest_extent_max_len, last], and note their translations.
+      They can't be deleted during the walk, as that modifies
+      guest_extents. */
+   if (range - 1 > (ULong)(~guest_start))
+      last = ~(Addr)0;
+   else
+      last = guest_start + (Addr)(range - 1);
 
-      /* slow scheme */
+   key.base  = guest_start > guest_extent_max_len
+                  ? guest_start - guest_extent_max_len : 0;
+   key.sNo   = 0;
+   key.tteNo = 0;
+   key.ix    = 0;
 
-      VG_(debugLog)(2, "transtab",
-                       "                    SLOW, ec = %d\n", ec);
+   VG_(dropTailXA)(discard_victims, VG_(sizeXA)(discard_victims));
+   VG_(OSetGen_ResetIterAt)(guest_extents, &key);
+   while ((ge = VG_(OSetGen_Next)(guest_extents)) != NULL
+          && ge->base <= last) {
+      if (overlap1(guest_start, range, ge->base, ge->len))
+         VG_(addToXA)(discard_victims, ge);
+   }
 
-      for (sno = 0; sno < n_sectors; sno++) {
-         sec = &sectors[sno];
-         if (sec->tc == NULL)
-            continue;
-         anyDeleted |= delete_translations_in_sector( 
-                          sec, sno, guest_start, range,
-                          arch_host, endness_host
-                       );
-      }
+   n = VG_(sizeXA)(discard_victims);
+   VG_(debugLog)(2, "transtab",
+                    "                    %ld extents to discard\n", n);
 
+   for (i = 0; i < n; i++) {
+      ge  = VG_(indexXA)(discard_victims, i);
+      sec = &sectors[ge->sNo];
+      /* A translation with several extents in the range is listed
+         once per extent. */
+      if (sec->ttH[ge->tteNo].status != InUse)
+         continue;
+      anyDeleted = True;
+      delete_tte( sec, ge->sNo, ge->tteNo, arch_host, endness_host );
    }
 
    if (anyDeleted)
@@ -2210,7 +2671,7 @@ void VG_(discard_translations) ( Addr guest_start, ULong range,
 
    /* Post-deletion sanity check */
    if (VG_(clo_sanity_level) >= 4) {
-      TTEno i;
+      TTEno tteno;
       Bool  sane = sanity_check_all_sectors();
       vg_assert(sane);
       /* But now, also check the requested address range isn't
@@ -2219,8 +2680,8 @@ void VG_(discard_translations) ( Addr guest_start, ULong range,
          sec = &sectors[sno];
          if (sec->tc == NULL)
             continue;
-         for (i = 0; i < N_TTES_PER_SECTOR; i++) {
-            TTEntryH* tteH = &sec->ttH[i];
+         for (tteno = 0; tteno < N_TTES_PER_SECTOR; tteno++) {
+            TTEntryH* tteH = &sec->ttH[tteno];
             if (tteH->status != InUse)
                continue;
             vg_assert(!overlaps( guest_start, range, tteH ));
@@ -2430,7 +2891,7 @@ void VG_(init_tt_tc) ( void )
    vg_assert(sizeof(TTEno) == 2);
    vg_assert(N_TTES_PER_SECTOR <= N_HTTES_PER_SECTOR);
    vg_assert(N_HTTES_PER_SECTOR < INV_TTE);
-   vg_assert(N_HTTES_PER_SECTOR < EC2TTE_DELETED);
+   vg_assert(N_HTTES_PER_SECTOR < HTT_DELETED);
    vg_assert(N_HTTES_PER_SECTOR < HTT_EMPTY);
    /* check fast cache entries really are 2 words long */
    vg_assert(sizeof(Addr) == sizeof(void*));
@@ -2485,9 +2946,39 @@ void VG_(init_tt_tc) ( void )
    vg_assert(tc_sector_szQ >= 2 * N_TTES_PER_SECTOR);
    vg_assert(tc_sector_szQ <= 100 * N_TTES_PER_SECTOR);
 
+   /* With huge pages, make the tc areas a whole number of huge pages
+      rather than leave the rest of the last one unused. */
+   if (VG_(clo_huge_pages) != Vg_HugePagesNo)
+      tc_sector_szQ = VG_ROUNDUP(tc_sector_szQ,
+                                 VG_(am_hugepage_szB)() / 8);
+
+   sector_szB = 8 * tc_sector_szQ
+                + N_TTES_PER_SECTOR * (sizeof(TTEntryC) + sizeof(TTEntryH))
+                + N_HTTES_PER_SECTOR * sizeof(TTEno);
+
    n_sectors = VG_(clo_num_transtab_sectors);
    vg_assert(n_sectors >= MIN_N_SECTORS);
    vg_assert(n_sectors <= MAX_N_SECTORS);
+   n_sectors_target = n_sectors;
+
+   if (VG_(clo_transtab_max_mb) > 0) {
+      /* Auto-sizing: as many sectors as fit in the budget can be
+         used, starting with VG_(clo_num_transtab_sectors). */
+      ULong max_n = ((ULong)VG_(clo_transtab_max_mb) * 1024 * 1024)
+                    / sector_szB;
+      if (max_n < MIN_N_SECTORS) {
+         VG_(umsg)("Warning: --transtab-max-mb=%u is too small for %d "
+                   "sectors of %lu bytes, using %d sectors\n",
+                   VG_(clo_transtab_max_mb), MIN_N_SECTORS,
+                   (UWord)sector_szB, MIN_N_SECTORS);
+         max_n = MIN_N_SECTORS;
+      }
+      if (max_n > MAX_N_SECTORS)
+         max_n = MAX_N_SECTORS;
+      n_sectors = (SECno)max_n;
+      if (n_sectors_target > n_sectors)
+         n_sectors_target = n_sectors;
+   }
 
    /* Initialise the sectors, even the ones we aren't going to use.
       Set all fields to zero. */
@@ -2500,6 +2991,23 @@ void VG_(init_tt_tc) ( void )
    for (i = 0; i < MAX_N_SECTORS; i++)
       sector_search_order[i] = INV_SNO;
 
+   /* Create the (empty) guest extent index. */
+   guest_extents
+      = VG_(OSetGen_Create_With_Pool)( offsetof(GuestExtent, base),
+                                       cmp_GuestExtent,
+                                       ttaux_malloc,
+                                       "transtab.init_tt_tc(guest_extents)",
+                                       ttaux_free,
+                                       GUEST_EXTENT_POOL_SIZE,
+                                       sizeof(GuestExtent) );
+   discard_victims
+      = VG_(newXA)(ttaux_malloc, "transtab.init_tt_tc(discard_victims)",
+                   ttaux_free, sizeof(GuestExtent));
+   dumped_entries
+      = ttaux_malloc("transtab.init_tt_tc(dumped_entries)",
+                     N_DUMPED_ENTRIES * sizeof(UInt));
+   VG_(memset)(dumped_entries, 0, N_DUMPED_ENTRIES * sizeof(UInt));
+
    /* Initialise the fast cache. */
    invalidateFastCache();
 
@@ -2519,6 +3027,10 @@ void VG_(init_tt_tc) ( void )
          "TT/TC: cache: %d sectors of %'d bytes each = %'d total TC\n", 
           n_sectors, 8 * tc_sector_szQ,
           n_sectors * 8 * tc_sector_szQ );
+      if (VG_(clo_transtab_max_mb) > 0)
+         VG_(message)(Vg_DebugMsg,
+            "TT/TC: cache: auto-sized within %u MB, initially %d sectors\n",
+            VG_(clo_transtab_max_mb), n_sectors_target);
       VG_(message)(Vg_DebugMsg,
          "TT/TC: table: %'d tables[%d] of C %'d + H %'d bytes each "
          "= %'d total TT\n",
@@ -2571,6 +3083,35 @@ UInt VG_(get_bbs_discarded_or_dumped) ( void )
    return n_disc_count + n_dump_count;
 }
 
+ULong VG_(get_n_sectors_recycled) ( void )
+{
+   return n_sectors_recycled;
+}
+
+void VG_(print_tt_tc_sizes) ( void )
+{
+   if (VG_(clo_transtab_max_mb) > 0)
+      VG_(printf)("transtab: auto-sized within %u MB: "
+                  "target %d sectors, max %d sectors\n",
+                  VG_(clo_transtab_max_mb), n_sectors_target, n_sectors);
+   else
+      VG_(printf)("transtab: fixed size: %d sectors\n", n_sectors);
+   VG_(printf)("transtab: %d sectors allocated of %'lu bytes each "
+               "= %'lu bytes, youngest sector %d\n",
+               n_sectors_allocated, (UWord)sector_szB,
+               (UWord)(n_sectors_allocated * sector_szB), youngest_sector);
+   VG_(printf)("transtab: %'llu sectors recycled, %'llu sectors released\n",
+               n_sectors_recycled, n_sectors_released);
+   VG_(printf)("transtab: %'llu translations, %'llu re-translations "
+               "(%3.1f%%), %'llu kept hot\n",
+               n_in_count, n_retrans_count,
+               100.0 * safe_idiv(n_retrans_count, n_in_count),
+               n_keep_count);
+   VG_(printf)("transtab: since youngest sector started: "
+               "%'llu translations, %'llu re-translations\n",
+               win_new_count, win_retrans_count);
+}
+
 void VG_(print_tt_tc_stats) ( void )
 {
    VG_(message)(Vg_DebugMsg,
@@ -2592,19 +3133,21 @@ void VG_(print_tt_tc_stats) ( void )
                 " transtab: dumped     %'llu (%'llu -> ?" "?) "
                 "(sectors recycled %'llu)\n",
                 n_dump_count, n_dump_osize, n_sectors_recycled );
+   VG_(message)(Vg_DebugMsg,
+                " transtab: kept hot   %'llu (%'llu -> %'llu)\n",
+                n_keep_count, n_keep_osize, n_keep_tsize );
+   VG_(message)(Vg_DebugMsg,
+                " transtab: retrans    %'llu (%3.1f%% of new) "
+                "(sectors released %'llu)\n",
+                n_retrans_count, 100.0 * safe_idiv(n_retrans_count, n_in_count),
+                n_sectors_released );
    VG_(message)(Vg_DebugMsg,
                 " transtab: discarded  %'llu (%'llu -> ?" "?)\n",
                 n_disc_count, n_disc_osize );
-
-   if (DEBUG_TRANSTAB) {
-      VG_(printf)("\n");
-      for (EClassNo e = 0; e < ECLASS_N; e++) {
-         VG_(printf)(" %4d", sectors[0].ec2tte_used[e]);
-         if (e % 16 == 15)
-            VG_(printf)("\n");
-      }
-      VG_(printf)("\n\n");
-   }
+   if (VG_(clo_px_lazy_pc))
+      VG_(message)(Vg_DebugMsg,
+                   " transtab: guest PC   %'llu lookups (%'llu cached)\n",
+                   n_pc_map_lookups, n_pc_map_cache_hits );
 }
 
 /*------------------------------------------------------------*/
@@ -242,6 +242,23 @@ extern SysRes VG_(am_mmap_anon_float_client) ( SizeT length, Int prot );
    itself more address space when needed. */
 extern SysRes VG_(am_mmap_anon_float_valgrind)( SizeT cszB );
 
+/* The size, and alignment, of the huge pages used for V's own
+   mappings when --huge-pages is given: the size of the transparent
+   huge pages of the kernel.  0 if the platform has no huge pages. */
+extern SizeT VG_(am_hugepage_szB) ( void );
+
+/* The largest huge page size worth using for V's own mappings.
+   Bigger huge pages, such as the 512MB ones of arm64 kernels with 64KB
+   pages, would waste too much memory on partly used mappings. */
+#define VG_MAX_HUGEPAGE_SZB (32 * 1024 * 1024)
+
+/* As VG_(am_mmap_anon_float_valgrind), but, as requested by
+   --huge-pages, tries to back the mapping with huge pages.  The length
+   is then rounded up to a multiple of VG_(am_hugepage_szB)(), and the
+   mapping is aligned on it.  Falls back to a normal mapping when huge pages are
+   not available. */
+extern SysRes VG_(am_mmap_anon_float_valgrind_huge)( SizeT cszB );
+
 /* Map privately a file at an unconstrained address for V, and update the
    segment array accordingly.  This is used by V for transiently
    mapping in object files to read their debug info.  */
@@ -53,6 +53,19 @@ typedef
       /* Add a target for an indirect function redirection. */
       VG_USERREQ__ADD_IFUNC_TARGET  = 0x3104,
 
+      /* Made by the string function replacements in
+         shared/vg_replace_strmem.c, asking the core to do a large
+         memory operation in one go.  The core passes each one on to
+         the tool (see VG_(track_bulk_copy) et al), and returns zero if
+         the tool declines it, in which case the replacement does the
+         work itself. */
+      /* dst, src, len: memmove */
+      VG_USERREQ__BULK_COPY         = 0x3105,
+      /* dst, address of the fill byte, len: memset */
+      VG_USERREQ__BULK_FILL         = 0x3106,
+      /* str: returns strlen(str)+1 */
+      VG_USERREQ__BULK_STRLEN       = 0x3107,
+
    } Vg_InternalClientRequest;
 
 
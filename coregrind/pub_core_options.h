@@ -298,6 +298,12 @@ extern Bool  VG_(clo_run_cxx_freeres);
 /* Should we show VEX emulation warnings?  Default: NO */
 extern Bool VG_(clo_show_emwarns);
 
+/* Leave the guest program counter out of the registers kept up to
+   date at memory accesses, and recover it from the guest PC map of
+   the translation at faults and in helper calls instead?  Only
+   supported on amd64.  Default: YES there, NO elsewhere. */
+extern Bool VG_(clo_px_lazy_pc);
+
 /* How much does the stack pointer have to change before tools
    consider a stack switch to have happened?  Default: 2000000 bytes
    NB: must be host-word-sized to be correct (hence Word). */
@@ -325,6 +331,27 @@ extern UInt VG_(clo_num_transtab_sectors);
    provided default. */
 extern UInt VG_(clo_avg_transtab_entry_size);
 
+/* Percentage of a recycled sector's code area used to keep its hottest
+   translations.  0 means to dump all of them. */
+extern UInt VG_(clo_transtab_keep_hot);
+
+/* Memory budget in MB within which the number of sectors of the
+   translation cache is adjusted at run time.  0 means to use
+   VG_(clo_num_transtab_sectors) sectors. */
+extern UInt VG_(clo_transtab_max_mb);
+
+/* Should the translation cache and the tools' shadow memory be
+   backed by huge pages, and how? */
+typedef
+   enum {
+      Vg_HugePagesNo,      // use normal pages (this is the default)
+      Vg_HugePagesMadvise, // 2MB aligned mappings, with MADV_HUGEPAGE
+      Vg_HugePagesHugetlb  // MAP_HUGETLB mappings, else as madvise
+   }
+   VgHugePages;
+
+extern VgHugePages VG_(clo_huge_pages);
+
 /* Only client requested fixed mapping can be done below 
    VG_(clo_aspacem_minAddr). */
 extern Addr VG_(clo_aspacem_minAddr);
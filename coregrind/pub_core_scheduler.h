@@ -115,6 +115,17 @@ extern void VG_(print_scheduler_stats) ( void );
 /* If False, a fault is Valgrind-internal (ie, a bug) */
 extern Bool VG_(in_generated_code);
 
+/* The host stack pointer of generated code (amd64 only). */
+extern Addr VG_(generated_code_sp);
+
+/* With --px-lazy-pc=yes, generated code leaves the guest PC of the
+   running thread out of date.  If tid is running generated code, set
+   its guest PC from the guest PC map of the translation: the one
+   containing host_pc, a faulting host PC, if that is in generated
+   code, else the one making the current helper call.  host_pc may be
+   zero. */
+extern void VG_(sync_lazy_guest_pc) ( ThreadId tid, Addr host_pc );
+
 /* Sanity checks which may be done at any time.  The scheduler decides when. */
 extern void VG_(sanity_check_general) ( Bool force_expensive );
 
@@ -233,6 +233,10 @@ typedef struct {
    void (*track_pre_mem_write)      (CorePart, ThreadId, const HChar*, Addr, SizeT);
    void (*track_post_mem_write)     (CorePart, ThreadId, Addr, SizeT);
 
+   Bool (*track_bulk_copy)  (ThreadId, Addr, Addr, SizeT);
+   Bool (*track_bulk_fill)  (ThreadId, Addr, Addr, SizeT);
+   Bool (*track_bulk_strlen)(ThreadId, Addr, SizeT);
+
    void (*track_pre_reg_read)  (CorePart, ThreadId, const HChar*, PtrdiffT, SizeT);
    void (*track_post_reg_write)(CorePart, ThreadId,               PtrdiffT, SizeT);
    void (*track_post_reg_write_clientcall_return)(ThreadId, PtrdiffT, SizeT,
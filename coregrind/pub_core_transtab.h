@@ -89,7 +89,9 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
                            UInt             code_len,
                            Bool             is_self_checking,
                            Int              offs_profInc,
-                           UInt             n_guest_instrs );
+                           UInt             n_guest_instrs,
+                           const VexGuestPCMapEntry* pc_map,
+                           Int              n_pc_map );
 
 typedef UShort SECno; // SECno type identifies a sector
 typedef UShort TTEno; // TTEno type identifies a TT entry in a sector.
@@ -113,11 +115,29 @@ extern Bool VG_(search_transtab) ( /*OUT*/Addr*  res_hcode,
 extern void VG_(discard_translations) ( Addr  start, ULong range,
                                         const HChar* who );
 
+/* With --px-lazy-pc=yes, find the guest insn to which the host code at
+   hcode belongs, using the guest PC map of its translation.  Returns
+   False if hcode is not in the translation cache.  Otherwise sets
+   *guest_pc to the address of the guest insn, or to zero if the code
+   belongs to no guest insn. */
+extern Bool VG_(search_transtab_guest_pc) ( /*OUT*/Addr* guest_pc,
+                                            Addr hcode );
+
 extern void VG_(print_tt_tc_stats) ( void );
 
+/* Show the current sizes of the TT/TC and how much recycling
+   and re-translation happened so far.  Used by the gdbserver
+   "v.info transtab" monitor command. */
+extern void VG_(print_tt_tc_sizes) ( void );
+
 extern UInt VG_(get_bbs_translated) ( void );
 extern UInt VG_(get_bbs_discarded_or_dumped) ( void );
 
+/* Number of times a full sector was recycled.  Host code of the
+   recycled sector might have been dumped or moved, so host code
+   addresses obtained before a recycling must not be used after. */
+extern ULong VG_(get_n_sectors_recycled) ( void );
+
 /* Add to / search the auxiliary, small, unredirected translation
    table. */
 
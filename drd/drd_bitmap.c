@@ -151,7 +151,6 @@ void DRD_(bm_access_range_load)(struct bitmap* const bm, Addr a1, Addr a2)
       Addr b_start;
       Addr b_end;
       struct bitmap2* bm2;
-      UWord b0;
 
       b_next = first_address_with_higher_msb(b);
       if (b_next > a2)
@@ -179,22 +178,8 @@ void DRD_(bm_access_range_load)(struct bitmap* const bm, Addr a1, Addr a2)
       tl_assert(address_msb(b_start) == address_msb(b_end - 1));
       tl_assert(address_lsb(b_start) <= address_lsb(b_end - 1));
 
-      if (address_lsb(b_start) == 0 && address_lsb(b_end) == 0)
-      {
-         unsigned k;
-
-         for (k = 0; k < BITMAP1_UWORD_COUNT; k++)
-         {
-            bm2->bm1.bm0_r[k] = ~(UWord)0;
-         }
-      }
-      else
-      {
-         for (b0 = address_lsb(b_start); b0 <= address_lsb(b_end - 1); b0++)
-         {
-            bm0_set(bm2->bm1.bm0_r, b0);
-         }
-      }
+      bm0_set_bits(bm2->bm1.bm0_r, address_lsb(b_start),
+                   address_lsb(b_end - 1));
    }
 }
 
@@ -248,7 +233,6 @@ void DRD_(bm_access_range_store)(struct bitmap* const bm,
       Addr b_start;
       Addr b_end;
       struct bitmap2* bm2;
-      UWord b0;
 
       b_next = first_address_with_higher_msb(b);
       if (b_next > a2)
@@ -276,22 +260,8 @@ void DRD_(bm_access_range_store)(struct bitmap* const bm,
       tl_assert(address_msb(b_start) == address_msb(b_end - 1));
       tl_assert(address_lsb(b_start) <= address_lsb(b_end - 1));
 
-      if (address_lsb(b_start) == 0 && address_lsb(b_end) == 0)
-      {
-         unsigned k;
-
-         for (k = 0; k < BITMAP1_UWORD_COUNT; k++)
-         {
-            bm2->bm1.bm0_w[k] = ~(UWord)0;
-         }
-      }
-      else
-      {
-         for (b0 = address_lsb(b_start); b0 <= address_lsb(b_end - 1); b0++)
-         {
-            bm0_set(bm2->bm1.bm0_w, b0);
-         }
-      }
+      bm0_set_bits(bm2->bm1.bm0_w, address_lsb(b_start),
+                   address_lsb(b_end - 1));
    }
 }
 
@@ -348,17 +318,8 @@ Bool DRD_(bm_has_any_load_g)(struct bitmap* const bm)
 
    VG_(OSetGen_ResetIter)(bm->oset);
    for ( ; (bm2 = VG_(OSetGen_Next)(bm->oset)) != NULL; ) {
-      Addr b_start;
-      Addr b_end;
-      UWord b0;
-      const struct bitmap1* const p1 = &bm2->bm1;
-
-      b_start = make_address(bm2->addr, 0);
-      b_end = make_address(bm2->addr + 1, 0);
-
-      for (b0 = address_lsb(b_start); b0 <= address_lsb(b_end - 1); b0++)
-         if (bm0_is_set(p1->bm0_r, b0))
-            return True;
+      if (bm0_is_any_set_in(bm2->bm1.bm0_r, 0, (1U << ADDR_LSB_BITS) - 1))
+         return True;
    }
    return False;
 }
@@ -384,7 +345,6 @@ DRD_(bm_has_any_load)(struct bitmap* const bm, const Addr a1, const Addr a2)
       {
          Addr b_start;
          Addr b_end;
-         UWord b0;
          const struct bitmap1* const p1 = &bm2->bm1;
 
          if (make_address(bm2->addr, 0) < a1)
@@ -404,12 +364,10 @@ DRD_(bm_has_any_load)(struct bitmap* const bm, const Addr a1, const Addr a2)
          tl_assert(b_start < b_end);
          tl_assert(address_lsb(b_start) <= address_lsb(b_end - 1));
 
-         for (b0 = address_lsb(b_start); b0 <= address_lsb(b_end - 1); b0++)
+         if (bm0_is_any_set_in(p1->bm0_r, address_lsb(b_start),
+                               address_lsb(b_end - 1)))
          {
-            if (bm0_is_set(p1->bm0_r, b0))
-            {
-               return True;
-            }
+            return True;
          }
       }
    }
@@ -437,7 +395,6 @@ Bool DRD_(bm_has_any_store)(struct bitmap* const bm,
       {
          Addr b_start;
          Addr b_end;
-         UWord b0;
          const struct bitmap1* const p1 = &bm2->bm1;
 
          if (make_address(bm2->addr, 0) < a1)
@@ -457,12 +414,10 @@ Bool DRD_(bm_has_any_store)(struct bitmap* const bm,
          tl_assert(b_start < b_end);
          tl_assert(address_lsb(b_start) <= address_lsb(b_end - 1));
 
-         for (b0 = address_lsb(b_start); b0 <= address_lsb(b_end - 1); b0++)
+         if (bm0_is_any_set_in(p1->bm0_w, address_lsb(b_start),
+                               address_lsb(b_end - 1)))
          {
-            if (bm0_is_set(p1->bm0_w, b0))
-            {
-               return True;
-            }
+            return True;
          }
       }
    }
@@ -492,7 +447,6 @@ Bool DRD_(bm_has_any_access)(struct bitmap* const bm,
       {
          Addr b_start;
          Addr b_end;
-         UWord b0;
          const struct bitmap1* const p1 = &bm2->bm1;
 
          if (make_address(bm2->addr, 0) < a1)
@@ -512,16 +466,12 @@ Bool DRD_(bm_has_any_access)(struct bitmap* const bm,
          tl_assert(b_start < b_end);
          tl_assert(address_lsb(b_start) <= address_lsb(b_end - 1));
 
-         for (b0 = address_lsb(b_start); b0 <= address_lsb(b_end - 1); b0++)
+         if (bm0_is_any_set_in(p1->bm0_r, address_lsb(b_start),
+                               address_lsb(b_end - 1))
+             || bm0_is_any_set_in(p1->bm0_w, address_lsb(b_start),
+                                  address_lsb(b_end - 1)))
          {
-            /*
-             * Note: the statement below uses a binary or instead of a logical
-             * or on purpose.
-             */
-            if (bm0_is_set(p1->bm0_r, b0) | bm0_is_set(p1->bm0_w, b0))
-            {
-               return True;
-            }
+            return True;
          }
       }
    }
@@ -825,7 +775,6 @@ Bool DRD_(bm_has_conflict_with)(struct bitmap* const bm,
       {
          Addr b_start;
          Addr b_end;
-         UWord b0;
          const struct bitmap1* const p1 = &bm2->bm1;
 
          if (make_address(bm2->addr, 0) < a1)
@@ -845,24 +794,16 @@ Bool DRD_(bm_has_conflict_with)(struct bitmap* const bm,
          tl_assert(b_start < b_end);
          tl_assert(address_lsb(b_start) <= address_lsb(b_end - 1));
 
-         for (b0 = address_lsb(b_start); b0 <= address_lsb(b_end - 1); b0++)
+         if (bm0_is_any_set_in(p1->bm0_w, address_lsb(b_start),
+                               address_lsb(b_end - 1)))
          {
-            if (access_type == eLoad)
-            {
-               if (bm0_is_set(p1->bm0_w, b0))
-               {
-                  return True;
-               }
-            }
-            else
-            {
-               tl_assert(access_type == eStore);
-               if (bm0_is_set(p1->bm0_r, b0)
-                   | bm0_is_set(p1->bm0_w, b0))
-               {
-                  return True;
-               }
-            }
+            return True;
+         }
+         if (access_type == eStore
+             && bm0_is_any_set_in(p1->bm0_r, address_lsb(b_start),
+                                  address_lsb(b_end - 1)))
+         {
+            return True;
          }
       }
    }
@@ -957,10 +898,7 @@ Bool DRD_(bm_equal)(struct bitmap* const lhs, struct bitmap* const rhs)
 
    for ( ; (bm2l = VG_(OSetGen_Next)(lhs->oset)) != 0; )
    {
-      while (bm2l
-             && ! DRD_(bm_has_any_access)(lhs,
-                                          make_address(bm2l->addr, 0),
-                                          make_address(bm2l->addr + 1, 0)))
+      while (bm2l && ! bm1_has_any_access(&bm2l->bm1))
       {
          bm2l = VG_(OSetGen_Next)(lhs->oset);
       }
@@ -974,18 +912,13 @@ Bool DRD_(bm_equal)(struct bitmap* const lhs, struct bitmap* const rhs)
          if (bm2r == 0)
             return False;
       }
-      while (! DRD_(bm_has_any_access)(rhs,
-                                       make_address(bm2r->addr, 0),
-                                       make_address(bm2r->addr + 1, 0)));
+      while (! bm1_has_any_access(&bm2r->bm1));
 
       tl_assert(bm2r);
-      tl_assert(DRD_(bm_has_any_access)(rhs,
-                                        make_address(bm2r->addr, 0),
-                                        make_address(bm2r->addr + 1, 0)));
 
       if (bm2l != bm2r
           && (bm2l->addr != bm2r->addr
-              || VG_(memcmp)(&bm2l->bm1, &bm2r->bm1, sizeof(bm2l->bm1)) != 0))
+              || ! bm1_equal(&bm2l->bm1, &bm2r->bm1)))
       {
          return False;
       }
@@ -994,14 +927,9 @@ Bool DRD_(bm_equal)(struct bitmap* const lhs, struct bitmap* const rhs)
    do
    {
       bm2r = VG_(OSetGen_Next)(rhs->oset);
-   } while (bm2r && ! DRD_(bm_has_any_access)(rhs,
-                                              make_address(bm2r->addr, 0),
-                                              make_address(bm2r->addr + 1, 0)));
+   } while (bm2r && ! bm1_has_any_access(&bm2r->bm1));
    if (bm2r)
    {
-      tl_assert(DRD_(bm_has_any_access)(rhs,
-                                        make_address(bm2r->addr, 0),
-                                        make_address(bm2r->addr + 1, 0)));
       return False;
    }
    return True;
@@ -1141,9 +1069,7 @@ void DRD_(bm_remove_cleared_marked)(struct bitmap* bm)
    for ( ; (bm2 = VG_(OSetGen_Next)(bm->oset)) != 0; )
    {
       const UWord a1 = bm2->addr;
-      if (bm2->recalc
-          && ! DRD_(bm_has_any_access(bm, make_address(a1, 0),
-                                      make_address(a1 + 1, 0))))
+      if (bm2->recalc && ! bm1_has_any_access(&bm2->bm1))
       {
          bm2_remove(bm, a1);
          VG_(OSetGen_ResetIterAt)(bm->oset, &a1);
@@ -1188,6 +1114,8 @@ int DRD_(bm_has_races)(struct bitmap* const lhs, struct bitmap* const rhs)
       for (k = 0; k < BITMAP1_UWORD_COUNT; k++)
       {
          unsigned b;
+         if (bm1_conflict_word(bm1l, bm1r, k) == 0)
+            continue;
          for (b = 0; b < BITS_PER_UWORD; b++)
          {
             UWord const access_mask
@@ -1261,20 +1189,11 @@ ULong DRD_(bm_get_bitmap2_merge_count)(void)
 static
 void bm2_merge(struct bitmap2* const bm2l, const struct bitmap2* const bm2r)
 {
-   unsigned k;
-
    tl_assert(bm2l);
    tl_assert(bm2r);
    tl_assert(bm2l->addr == bm2r->addr);
 
    s_bitmap2_merge_count++;
 
-   for (k = 0; k < BITMAP1_UWORD_COUNT; k++)
-   {
-      bm2l->bm1.bm0_r[k] |= bm2r->bm1.bm0_r[k];
-   }
-   for (k = 0; k < BITMAP1_UWORD_COUNT; k++)
-   {
-      bm2l->bm1.bm0_w[k] |= bm2r->bm1.bm0_w[k];
-   }
+   bm1_merge(&bm2l->bm1, &bm2r->bm1);
 }
@@ -323,6 +323,117 @@ static __inline__ UWord bm0_is_any_set(const UWord* bm0,
    return (bm0[uword_msb(a)] & ((((UWord)1 << size) - 1) << uword_lsb(a)));
 }
 
+/*
+ * The functions below process bitmaps one UWord at a time instead of one
+ * bit at a time. The loops over a whole struct bitmap1 have no dependencies
+ * between iterations such that the compiler can vectorize them.
+ */
+
+/**
+ * Return the bits of bm0[k] that correspond to the addresses in range
+ * [ first << ADDR_IGNORED_BITS .. last << ADDR_IGNORED_BITS ].
+ */
+static __inline__ UWord bm0_word_mask(const UWord k,
+                                      const UWord first, const UWord last)
+{
+   const UWord lo = k == uword_msb(first) ? uword_lsb(first) : 0;
+   const UWord hi = k == uword_msb(last) ? uword_lsb(last)
+                                         : BITS_PER_UWORD - 1;
+
+   return (~(UWord)0 << lo) & (~(UWord)0 >> (BITS_PER_UWORD - 1 - hi));
+}
+
+/**
+ * Set the bits corresponding to all of the addresses in range
+ * [ first << ADDR_IGNORED_BITS .. last << ADDR_IGNORED_BITS ] in bitmap bm0.
+ * Unlike bm0_set_range(), the range may span multiple UWords.
+ */
+static __inline__ void bm0_set_bits(UWord* bm0,
+                                    const UWord first, const UWord last)
+{
+   UWord k;
+
+#ifdef ENABLE_DRD_CONSISTENCY_CHECKS
+   tl_assert(first <= last);
+   tl_assert(address_msb(make_address(0, last)) == 0);
+#endif
+   for (k = uword_msb(first); k <= uword_msb(last); k++)
+      bm0[k] |= bm0_word_mask(k, first, last);
+}
+
+/**
+ * Return true if a bit corresponding to any of the addresses in range
+ * [ first << ADDR_IGNORED_BITS .. last << ADDR_IGNORED_BITS ] is set in bm0.
+ * Unlike bm0_is_any_set(), the range may span multiple UWords.
+ */
+static __inline__ UWord bm0_is_any_set_in(const UWord* bm0,
+                                          const UWord first, const UWord last)
+{
+   UWord k;
+
+#ifdef ENABLE_DRD_CONSISTENCY_CHECKS
+   tl_assert(first <= last);
+   tl_assert(address_msb(make_address(0, last)) == 0);
+#endif
+   for (k = uword_msb(first); k <= uword_msb(last); k++)
+   {
+      if (bm0[k] & bm0_word_mask(k, first, last))
+         return True;
+   }
+   return False;
+}
+
+/** Compute *bm1l |= *bm1r. */
+static __inline__ void bm1_merge(struct bitmap1* const bm1l,
+                                 const struct bitmap1* const bm1r)
+{
+   unsigned k;
+
+   for (k = 0; k < BITMAP1_UWORD_COUNT; k++)
+   {
+      bm1l->bm0_r[k] |= bm1r->bm0_r[k];
+      bm1l->bm0_w[k] |= bm1r->bm0_w[k];
+   }
+}
+
+/** Return True if and only if *bm1l and *bm1r are identical. */
+static __inline__ Bool bm1_equal(const struct bitmap1* const bm1l,
+                                 const struct bitmap1* const bm1r)
+{
+   UWord diff = 0;
+   unsigned k;
+
+   for (k = 0; k < BITMAP1_UWORD_COUNT; k++)
+   {
+      diff |= (bm1l->bm0_r[k] ^ bm1r->bm0_r[k])
+         | (bm1l->bm0_w[k] ^ bm1r->bm0_w[k]);
+   }
+   return diff == 0;
+}
+
+/** Return True if and only if any bit of *bm1 has been set. */
+static __inline__ Bool bm1_has_any_access(const struct bitmap1* const bm1)
+{
+   UWord any = 0;
+   unsigned k;
+
+   for (k = 0; k < BITMAP1_UWORD_COUNT; k++)
+      any |= bm1->bm0_r[k] | bm1->bm0_w[k];
+   return any != 0;
+}
+
+/**
+ * Return the bits of word k for which the accesses recorded in *bm1l and
+ * *bm1r conflict, i.e. for which at least one of both is a store.
+ */
+static __inline__ UWord bm1_conflict_word(const struct bitmap1* const bm1l,
+                                          const struct bitmap1* const bm1r,
+                                          const unsigned k)
+{
+   return (bm1l->bm0_w[k] & (bm1r->bm0_r[k] | bm1r->bm0_w[k]))
+      | (bm1r->bm0_w[k] & bm1l->bm0_r[k]);
+}
+
 
 
 /*********************************************************************/
@@ -688,6 +799,28 @@ void bm_access_aligned_store(struct bitmap* const bm,
                  SCALED_SIZE(size));
 }
 
+/**
+ * Set the load bits mask_r and the store bits mask_w in the bitmap word that
+ * corresponds to the BITS_PER_UWORD addresses starting at a1.
+ */
+static __inline__
+void bm_access_masks(struct bitmap* const bm, const Addr a1,
+                     const UWord mask_r, const UWord mask_w)
+{
+   struct bitmap2* bm2;
+   UWord k;
+
+#ifdef ENABLE_DRD_CONSISTENCY_CHECKS
+   tl_assert(bm);
+   tl_assert(uword_lsb(address_lsb(a1)) == 0);
+#endif
+
+   bm2 = bm2_lookup_or_insert_exclusive(bm, address_msb(a1));
+   k = uword_msb(address_lsb(a1));
+   bm2->bm1.bm0_r[k] |= mask_r;
+   bm2->bm1.bm0_w[k] |= mask_w;
+}
+
 static __inline__
 Bool bm_aligned_load_has_conflict_with(struct bitmap* const bm,
                                        const Addr a, const SizeT size)
@@ -72,6 +72,7 @@ static Bool DRD_(process_cmd_line_option)(const HChar* arg)
    int exclusive_threshold_ms = -1;
    int first_race_only        = -1;
    int report_signal_unlocked = -1;
+   int segment_budget         = -1;
    int segment_merging        = -1;
    int segment_merge_interval = -1;
    int shared_threshold_ms    = -1;
@@ -99,6 +100,7 @@ static Bool DRD_(process_cmd_line_option)(const HChar* arg)
    else if VG_BOOL_CLO(arg, "--free-is-write",       DRD_(g_free_is_write)) {}
    else if VG_BOOL_CLO(arg,"--report-signal-unlocked",report_signal_unlocked)
    {}
+   else if VG_INT_CLO (arg, "--segment-budget",      segment_budget) {}
    else if VG_BOOL_CLO(arg, "--segment-merging",     segment_merging) {}
    else if VG_INT_CLO (arg, "--segment-merging-interval", segment_merge_interval)
    {}
@@ -152,6 +154,8 @@ static Bool DRD_(process_cmd_line_option)(const HChar* arg)
    {
       DRD_(rwlock_set_shared_threshold)(shared_threshold_ms);
    }
+   if (segment_budget != -1)
+      DRD_(thread_set_segment_budget)(segment_budget);
    if (segment_merging != -1)
       DRD_(thread_set_segment_merging)(segment_merging);
    if (segment_merge_interval != -1)
@@ -218,6 +222,9 @@ static void DRD_(print_usage)(void)
 "                              pthread_cond_signal() where the mutex associated\n"
 "                              with the signal via pthread_cond_wait() is not\n"
 "                              locked at the time the signal is sent [yes].\n"
+"    --segment-budget=<n>      Examine at most n segments per segment merging\n"
+"                              step and continue the pass at the next segment\n"
+"                              creation. 0 means no limit [0].\n"
 "    --segment-merging=yes|no  Controls segment merging [yes].\n"
 "        Segment merging is an algorithm to limit memory usage of the\n"
 "        data race detection algorithm. Disabling segment merging may\n"
@@ -330,6 +337,31 @@ static void drd_post_mem_write(const CorePart part,
    }
 }
 
+/* Bulk memcpy/memset/strlen performed by the string function replacements. */
+static Bool drd_bulk_copy(const ThreadId tid, const Addr dst, const Addr src,
+                          const SizeT len)
+{
+   DRD_(thread_set_vg_running_tid)(VG_(get_running_tid)());
+   DRD_(trace_load)(src, len);
+   DRD_(trace_store)(dst, len);
+   return True;
+}
+
+static Bool drd_bulk_fill(const ThreadId tid, const Addr dst, const Addr val,
+                          const SizeT len)
+{
+   DRD_(thread_set_vg_running_tid)(VG_(get_running_tid)());
+   DRD_(trace_store)(dst, len);
+   return True;
+}
+
+static Bool drd_bulk_strlen(const ThreadId tid, const Addr str, const SizeT len)
+{
+   DRD_(thread_set_vg_running_tid)(VG_(get_running_tid)());
+   DRD_(trace_load)(str, len);
+   return True;
+}
+
 static __inline__
 void drd_start_using_mem(const Addr a1, const SizeT len,
                          const Bool is_stack_mem)
@@ -793,14 +825,20 @@ static void DRD_(fini)(Int exitcode)
                    "           %llu partial updates because of thread join"
                    " operations.\n",
                    pu_join);
+      VG_(message)(Vg_UserMsg,
+                   "           %llu context switches handled by an incremental"
+                   " update.\n",
+                   DRD_(thread_get_switch_conflict_set_count)());
       VG_(message)(Vg_UserMsg,
                    " segments: created %llu segments, max %llu alive,\n",
                    DRD_(sg_get_segments_created_count)(),
                    DRD_(sg_get_max_segments_alive_count)());
       VG_(message)(Vg_UserMsg,
-                   "           %llu discard points and %llu merges.\n",
+                   "           %llu discard points and %llu merges in"
+                   " %llu merging steps.\n",
                    DRD_(thread_get_discard_ordered_segments_count)(),
-                   DRD_(sg_get_segment_merge_count)());
+                   DRD_(sg_get_segment_merge_count)(),
+                   DRD_(thread_get_merge_step_count)());
       VG_(message)(Vg_UserMsg,
                    "segmnt cr: %llu mutex, %llu rwlock, %llu semaphore and"
                    " %llu barrier.\n",
@@ -850,6 +888,9 @@ void drd_pre_clo_init(void)
    VG_(track_pre_mem_read)         (drd_pre_mem_read);
    VG_(track_pre_mem_read_asciiz)  (drd_pre_mem_read_asciiz);
    VG_(track_post_mem_write)       (drd_post_mem_write);
+   VG_(track_bulk_copy)            (drd_bulk_copy);
+   VG_(track_bulk_fill)            (drd_bulk_fill);
+   VG_(track_bulk_strlen)          (drd_bulk_strlen);
    VG_(track_new_mem_brk)          (drd_start_using_mem_w_tid);
    VG_(track_new_mem_mmap)         (drd_start_using_mem_w_perms);
    VG_(track_new_mem_stack)        (drd_start_using_mem_stack);
@@ -24,6 +24,7 @@
 
 #include "drd_error.h"
 #include "drd_barrier.h"
+#include "drd_bitmap.h"
 #include "drd_clientobj.h"
 #include "drd_cond.h"
 #include "drd_mutex.h"
@@ -49,6 +50,8 @@ static void thread_append_segment(const DrdThreadId tid, Segment* const sg);
 static void thread_discard_segment(const DrdThreadId tid, Segment* const sg);
 static void thread_compute_conflict_set(struct bitmap** conflict_set,
                                         const DrdThreadId tid);
+static void thread_switch_conflict_set(const DrdThreadId old_tid,
+                                       const DrdThreadId new_tid);
 static Bool thread_conflict_set_up_to_date(const DrdThreadId tid);
 
 
@@ -61,6 +64,7 @@ static ULong    s_update_conflict_set_count;
 static ULong    s_update_conflict_set_new_sg_count;
 static ULong    s_update_conflict_set_sync_count;
 static ULong    s_update_conflict_set_join_count;
+static ULong    s_switch_conflict_set_count;
 static ULong    s_conflict_set_bitmap_creation_count;
 static ULong    s_conflict_set_bitmap2_creation_count;
 static ThreadId s_vg_running_tid  = VG_INVALID_THREADID;
@@ -68,16 +72,35 @@ DrdThreadId     DRD_(g_drd_running_tid) = DRD_INVALID_THREADID;
 ThreadInfo*     DRD_(g_threadinfo);
 struct bitmap*  DRD_(g_conflict_set);
 Bool DRD_(verify_conflict_set);
+AccessBuf       DRD_(g_access_buf);
 static Bool     s_trace_context_switches = False;
 static Bool     s_trace_conflict_set = False;
 static Bool     s_trace_conflict_set_bm = False;
 static Bool     s_trace_fork_join = False;
 static Bool     s_segment_merging = True;
-static Bool     s_new_segments_since_last_merge;
+static int      s_new_segments_since_last_merge;
 static int      s_segment_merge_interval = 10;
+/*
+ * Maximum number of segments examined by one segment merging step, or zero
+ * if a merging pass may examine all segments at once. A pass that runs out
+ * of budget resumes at s_merge_tid / s_merge_pos upon the next segment
+ * creation, so while it is pending every segment creation pays for one
+ * merging step.
+ */
+static int      s_segment_budget;
+static Bool     s_merge_pending;
+static unsigned s_merge_tid;
+static unsigned s_merge_pos;
+static ULong    s_merge_step_count;
 static unsigned s_join_list_vol = 10;
 static unsigned s_deletion_head;
 static unsigned s_deletion_tail;
+/*
+ * Set when segments have been removed without updating the conflict set of
+ * the running thread, e.g. when deleting a thread. The next context switch
+ * then recomputes the conflict set from scratch.
+ */
+static Bool     s_conflict_set_stale;
 #if defined(VGO_solaris)
 Bool DRD_(ignore_thread_creation) = True;
 #else
@@ -140,6 +163,23 @@ void DRD_(thread_set_segment_merge_interval)(const int i)
    s_segment_merge_interval = i;
 }
 
+/** Get the maximum number of segments examined per segment merging step. */
+int DRD_(thread_get_segment_budget)(void)
+{
+   return s_segment_budget;
+}
+
+/**
+ * Set the maximum number of segments examined per segment merging step.
+ * Zero means no limit. Since a merging step is triggered by the creation of
+ * a segment, a step has to examine at least two segments for a merging pass
+ * to ever catch up with the thread that is creating segments.
+ */
+void DRD_(thread_set_segment_budget)(const int b)
+{
+   s_segment_budget = b <= 0 ? 0 : b < 2 ? 2 : b;
+}
+
 void DRD_(thread_set_join_list_vol)(const int jlv)
 {
    s_join_list_vol = jlv;
@@ -519,6 +559,8 @@ void DRD_(thread_delete)(const DrdThreadId tid, const Bool detached)
 
    tl_assert(DRD_(IsValidDrdThreadId)(tid));
 
+   DRD_(thread_flush_access_buf)();
+
    tl_assert(DRD_(g_threadinfo)[tid].synchr_nesting >= 0);
    for (sg = DRD_(g_threadinfo)[tid].sg_last; sg; sg = sg_prev) {
       sg_prev = sg->thr_prev;
@@ -535,6 +577,7 @@ void DRD_(thread_delete)(const DrdThreadId tid, const Bool detached)
       tl_assert(!DRD_(g_threadinfo)[tid].detached_posix_thread);
    DRD_(g_threadinfo)[tid].sg_first = NULL;
    DRD_(g_threadinfo)[tid].sg_last = NULL;
+   s_conflict_set_stale = True;
 
    tl_assert(!DRD_(IsValidDrdThreadId)(tid));
 }
@@ -763,8 +806,8 @@ void DRD_(thread_set_vg_running_tid)(const ThreadId vg_tid)
 }
 
 /**
- * Update s_vg_running_tid, DRD_(g_drd_running_tid) and recalculate the
- * conflict set.
+ * Update s_vg_running_tid, DRD_(g_drd_running_tid) and bring the conflict
+ * set up to date for the new running thread.
  */
 void DRD_(thread_set_running_tid)(const ThreadId vg_tid,
                                   const DrdThreadId drd_tid)
@@ -774,6 +817,8 @@ void DRD_(thread_set_running_tid)(const ThreadId vg_tid,
 
    if (vg_tid != s_vg_running_tid)
    {
+      const DrdThreadId old_drd_tid = DRD_(g_drd_running_tid);
+
       if (s_trace_context_switches
           && DRD_(g_drd_running_tid) != DRD_INVALID_THREADID)
       {
@@ -783,9 +828,10 @@ void DRD_(thread_set_running_tid)(const ThreadId vg_tid,
                       DRD_(g_drd_running_tid), drd_tid,
                       DRD_(sg_get_segments_alive_count)());
       }
+      DRD_(thread_flush_access_buf)();
       s_vg_running_tid = vg_tid;
       DRD_(g_drd_running_tid) = drd_tid;
-      thread_compute_conflict_set(&DRD_(g_conflict_set), drd_tid);
+      thread_switch_conflict_set(old_drd_tid, drd_tid);
       s_context_switch_count++;
    }
 
@@ -832,6 +878,8 @@ void thread_append_segment(const DrdThreadId tid, Segment* const sg)
    tl_assert(DRD_(sane_ThreadInfo)(&DRD_(g_threadinfo)[tid]));
 #endif
 
+   DRD_(thread_flush_access_buf)();
+
    // add at tail
    sg->thr_prev = DRD_(g_threadinfo)[tid].sg_last;
    sg->thr_next = NULL;
@@ -1089,19 +1137,38 @@ static Bool thread_consistent_segment_ordering(const DrdThreadId tid,
  */
 static void thread_merge_segments(void)
 {
-   unsigned i;
+   unsigned n;
+   int examined = 0;
 
-   s_new_segments_since_last_merge = 0;
+   s_merge_pending = False;
+   s_merge_step_count++;
 
-   for (i = 0; i < DRD_N_THREADS; i++)
+   /*
+    * If --segment-budget has been specified, stop as soon as the budget
+    * has been used up and remember where to resume. Segments that have been
+    * discarded or merged in the meantime only shift the resume position,
+    * which at worst delays merging of a few segments until the next pass.
+    */
+   for (n = 0; n < DRD_N_THREADS; n++)
    {
+      const unsigned i = (s_merge_tid + n) % DRD_N_THREADS;
+      unsigned pos = 0;
       Segment* sg;
 
 #ifdef ENABLE_DRD_CONSISTENCY_CHECKS
       tl_assert(DRD_(sane_ThreadInfo)(&DRD_(g_threadinfo)[i]));
 #endif
 
-      for (sg = DRD_(g_threadinfo)[i].sg_first; sg; sg = sg->thr_next) {
+      for (sg = DRD_(g_threadinfo)[i].sg_first; sg;
+           sg = sg->thr_next, pos++) {
+         if (n == 0 && pos < s_merge_pos)
+            continue;
+         if (s_segment_budget > 0 && examined++ >= s_segment_budget) {
+            s_merge_tid = i;
+            s_merge_pos = pos;
+            s_merge_pending = True;
+            return;
+         }
          if (DRD_(sg_get_refcnt)(sg) == 1 && sg->thr_next) {
             Segment* const sg_next = sg->thr_next;
             if (DRD_(sg_get_refcnt)(sg_next) == 1
@@ -1119,6 +1186,31 @@ static void thread_merge_segments(void)
       tl_assert(DRD_(sane_ThreadInfo)(&DRD_(g_threadinfo)[i]));
 #endif
    }
+
+   s_merge_tid = 0;
+   s_merge_pos = 0;
+}
+
+/**
+ * Called after a segment has been created. Discards ordered segments once
+ * every s_segment_merge_interval segments, and runs a merging step either
+ * then or while a pass that ran out of budget is pending. A pending pass
+ * thus costs one step per new segment, so the discard step, which computes
+ * the minimum of all vector clocks, is kept at its own interval instead of
+ * running on every resumed step.
+ */
+static void thread_discard_and_merge_segments(void)
+{
+   if (++s_new_segments_since_last_merge >= s_segment_merge_interval)
+   {
+      s_new_segments_since_last_merge = 0;
+      thread_discard_ordered_segments();
+      thread_merge_segments();
+   }
+   else if (s_merge_pending)
+   {
+      thread_merge_segments();
+   }
 }
 
 /**
@@ -1145,12 +1237,8 @@ void DRD_(thread_new_segment)(const DrdThreadId tid)
 
    tl_assert(thread_conflict_set_up_to_date(DRD_(g_drd_running_tid)));
 
-   if (s_segment_merging
-       && ++s_new_segments_since_last_merge >= s_segment_merge_interval)
-   {
-      thread_discard_ordered_segments();
-      thread_merge_segments();
-   }
+   if (s_segment_merging)
+      thread_discard_and_merge_segments();
 }
 
 /** Call this function after thread 'joiner' joined thread 'joinee'. */
@@ -1258,11 +1346,24 @@ void DRD_(thread_new_segment_and_combine_vc)(DrdThreadId tid, const Segment* sg)
 
    thread_combine_vc_sync(tid, sg);
 
-   if (s_segment_merging
-       && ++s_new_segments_since_last_merge >= s_segment_merge_interval)
-   {
-      thread_discard_ordered_segments();
-      thread_merge_segments();
+   if (s_segment_merging)
+      thread_discard_and_merge_segments();
+}
+
+/**
+ * Record the buffered memory accesses of the running thread in the bitmap of
+ * its latest segment. Must be called before that bitmap is read or cleared,
+ * before a new segment is appended and before another thread starts running.
+ */
+void DRD_(thread_flush_access_buf)(void)
+{
+   AccessBuf* const b = &DRD_(g_access_buf);
+
+   if (b->mask_r | b->mask_w) {
+      bm_access_masks(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
+                      b->addr, b->mask_r, b->mask_w);
+      b->mask_r = 0;
+      b->mask_w = 0;
    }
 }
 
@@ -1275,6 +1376,8 @@ void DRD_(thread_stop_using_mem)(const Addr a1, const Addr a2)
 {
    Segment* p;
 
+   DRD_(thread_flush_access_buf)();
+
    for (p = DRD_(g_sg_list); p; p = p->g_next)
       DRD_(bm_clear)(DRD_(sg_bm)(p), a1, a2);
 
@@ -1415,6 +1518,8 @@ void DRD_(thread_report_conflicting_segments)(const DrdThreadId tid,
    tl_assert(0 <= (int)tid && tid < DRD_N_THREADS
              && tid != DRD_INVALID_THREADID);
 
+   DRD_(thread_flush_access_buf)();
+
    for (p = DRD_(g_threadinfo)[tid].sg_first; p; p = p->thr_next) {
       if (DRD_(bm_has)(DRD_(sg_bm)(p), addr, addr + size, access_type))
          thread_report_conflicting_segments_segment(tid, addr, size,
@@ -1544,6 +1649,125 @@ static void thread_compute_conflict_set(struct bitmap** conflict_set,
    }
 }
 
+/**
+ * Bring the conflict set up to date after a context switch from thread
+ * old_tid to thread new_tid. Instead of recomputing the conflict set from
+ * scratch, only apply the difference between the conflict sets of both
+ * threads: the bitmaps of segments that are only unordered to the latest
+ * segment of old_tid are cleared, the bitmaps of segments that are only
+ * unordered to the latest segment of new_tid are merged in, and the bitmap
+ * regions that were cleared are refilled from the segments that are
+ * unordered to both. Fall back to a full recomputation if the two conflict
+ * sets have no segments in common or if the current conflict set may refer
+ * to segments that no longer exist.
+ */
+static void thread_switch_conflict_set(const DrdThreadId old_tid,
+                                       const DrdThreadId new_tid)
+{
+   const Segment* p;
+   const Segment* o;
+   ULong kept = 0, removed = 0;
+   unsigned j;
+
+   tl_assert(0 <= (int)new_tid && new_tid < DRD_N_THREADS
+             && new_tid != DRD_INVALID_THREADID);
+   tl_assert(new_tid == DRD_(g_drd_running_tid));
+
+   p = DRD_(g_threadinfo)[new_tid].sg_last;
+   o = old_tid != DRD_INVALID_THREADID && DRD_(IsValidDrdThreadId)(old_tid)
+      ? DRD_(g_threadinfo)[old_tid].sg_last : NULL;
+
+   if (!DRD_(g_conflict_set) || s_conflict_set_stale || !p || !o
+       || old_tid == new_tid)
+      goto recompute;
+
+   for (j = 0; j < DRD_N_THREADS; j++) {
+      Segment* q;
+
+      if (j == old_tid || ! DRD_(IsValidDrdThreadId)(j))
+         continue;
+
+      for (q = DRD_(g_threadinfo)[j].sg_last; q; q = q->thr_prev) {
+         if (!DRD_(vc_lte)(&q->vc, &o->vc) && !DRD_(vc_lte)(&o->vc, &q->vc)) {
+            if (j != new_tid && !DRD_(vc_lte)(&q->vc, &p->vc)
+                && !DRD_(vc_lte)(&p->vc, &q->vc))
+               kept++;
+            else
+               removed++;
+         }
+      }
+   }
+
+   if (kept == 0)
+      goto recompute;
+
+   if (s_trace_conflict_set) {
+      VG_(message)(Vg_DebugMsg,
+                   "switching conflict set from thread %u to thread %u:"
+                   " %llu segments kept, %llu removed\n",
+                   old_tid, new_tid, kept, removed);
+   }
+
+   if (removed) {
+      DRD_(bm_unmark)(DRD_(g_conflict_set));
+      for (j = 0; j < DRD_N_THREADS; j++) {
+         Segment* q;
+
+         if (j == old_tid || ! DRD_(IsValidDrdThreadId)(j))
+            continue;
+
+         for (q = DRD_(g_threadinfo)[j].sg_last; q; q = q->thr_prev) {
+            if (!DRD_(vc_lte)(&q->vc, &o->vc)
+                && !DRD_(vc_lte)(&o->vc, &q->vc)
+                && (j == new_tid || DRD_(vc_lte)(&q->vc, &p->vc)
+                    || DRD_(vc_lte)(&p->vc, &q->vc)))
+               DRD_(bm_mark)(DRD_(g_conflict_set), DRD_(sg_bm)(q));
+         }
+      }
+      DRD_(bm_clear_marked)(DRD_(g_conflict_set));
+   }
+
+   for (j = 0; j < DRD_N_THREADS; j++) {
+      Segment* q;
+
+      if (j == new_tid || ! DRD_(IsValidDrdThreadId)(j))
+         continue;
+
+      for (q = DRD_(g_threadinfo)[j].sg_last; q; q = q->thr_prev) {
+         Bool in_old_conflict_set;
+
+         if (DRD_(vc_lte)(&q->vc, &p->vc) || DRD_(vc_lte)(&p->vc, &q->vc))
+            continue;
+         in_old_conflict_set = j != old_tid
+            && !DRD_(vc_lte)(&q->vc, &o->vc)
+            && !DRD_(vc_lte)(&o->vc, &q->vc);
+         if (!in_old_conflict_set)
+            DRD_(bm_merge2)(DRD_(g_conflict_set), DRD_(sg_bm)(q));
+         else if (removed)
+            DRD_(bm_merge2_marked)(DRD_(g_conflict_set), DRD_(sg_bm)(q));
+      }
+   }
+
+   if (removed)
+      DRD_(bm_remove_cleared_marked)(DRD_(g_conflict_set));
+
+   s_switch_conflict_set_count++;
+
+   if (s_trace_conflict_set_bm) {
+      VG_(message)(Vg_DebugMsg, "[%u] switched conflict set:\n", new_tid);
+      DRD_(bm_print)(DRD_(g_conflict_set));
+      VG_(message)(Vg_DebugMsg, "[%u] end of switched conflict set.\n",
+                   new_tid);
+   }
+
+   tl_assert(thread_conflict_set_up_to_date(new_tid));
+   return;
+
+recompute:
+   thread_compute_conflict_set(&DRD_(g_conflict_set), new_tid);
+   s_conflict_set_stale = False;
+}
+
 /**
  * Update the conflict set after the vector clock of thread tid has been
  * updated from old_vc to its current value, either because a new segment has
@@ -1671,12 +1895,26 @@ ULong DRD_(thread_get_discard_ordered_segments_count)(void)
    return s_discard_ordered_segments_count;
 }
 
+ULong DRD_(thread_get_merge_step_count)(void)
+{
+   return s_merge_step_count;
+}
+
 /** Return how many times the conflict set has been updated entirely. */
 ULong DRD_(thread_get_compute_conflict_set_count)()
 {
    return s_compute_conflict_set_count;
 }
 
+/**
+ * Return how many times the conflict set has been updated incrementally
+ * because of a context switch.
+ */
+ULong DRD_(thread_get_switch_conflict_set_count)(void)
+{
+   return s_switch_conflict_set_count;
+}
+
 /** Return how many times the conflict set has been updated partially. */
 ULong DRD_(thread_get_update_conflict_set_count)(void)
 {
@@ -109,6 +109,18 @@ typedef struct
 #endif /* VGO_solaris */
 } ThreadInfo;
 
+/**
+ * Load and store bits of the running thread that have not yet been recorded
+ * in the bitmap of its latest segment, for the 8 * sizeof(UWord) bytes
+ * starting at addr.
+ */
+typedef struct
+{
+   Addr  addr;
+   UWord mask_r;
+   UWord mask_w;
+} AccessBuf;
+
 
 /*
  * Local variables of drd_thread.c that are declared here such that these
@@ -128,6 +140,8 @@ extern struct bitmap* DRD_(g_conflict_set);
 extern Bool           DRD_(verify_conflict_set);
 /** Whether activities during thread creation should be ignored. */
 extern Bool           DRD_(ignore_thread_creation);
+/** Accesses of the running thread not yet recorded in its latest segment. */
+extern AccessBuf      DRD_(g_access_buf);
 
 
 /* Function declarations. */
@@ -140,6 +154,8 @@ void DRD_(thread_set_trace_fork_join)(const Bool t);
 void DRD_(thread_set_segment_merging)(const Bool m);
 int DRD_(thread_get_segment_merge_interval)(void);
 void DRD_(thread_set_segment_merge_interval)(const int i);
+int DRD_(thread_get_segment_budget)(void);
+void DRD_(thread_set_segment_budget)(const int b);
 void DRD_(thread_set_join_list_vol)(const int jlv);
 
 void DRD_(thread_init)(void);
@@ -192,6 +208,7 @@ void DRD_(thread_new_segment_and_combine_vc)(DrdThreadId tid,
 void DRD_(thread_update_conflict_set)(const DrdThreadId tid,
                                       const VectorClock* const old_vc);
 
+void DRD_(thread_flush_access_buf)(void);
 void DRD_(thread_stop_using_mem)(const Addr a1, const Addr a2);
 void DRD_(thread_set_record_loads)(const DrdThreadId tid, const Bool enabled);
 void DRD_(thread_set_record_stores)(const DrdThreadId tid, const Bool enabled);
@@ -207,7 +224,9 @@ void DRD_(thread_report_conflicting_segments)(const DrdThreadId tid,
 ULong DRD_(thread_get_context_switch_count)(void);
 ULong DRD_(thread_get_report_races_count)(void);
 ULong DRD_(thread_get_discard_ordered_segments_count)(void);
+ULong DRD_(thread_get_merge_step_count)(void);
 ULong DRD_(thread_get_compute_conflict_set_count)(void);
+ULong DRD_(thread_get_switch_conflict_set_count)(void);
 ULong DRD_(thread_get_update_conflict_set_count)(void);
 ULong DRD_(thread_get_update_conflict_set_new_sg_count)(void);
 ULong DRD_(thread_get_update_conflict_set_sync_count)(void);
@@ -371,4 +390,38 @@ Segment* DRD_(running_thread_get_segment)(void)
    return DRD_(thread_get_segment)(DRD_(g_drd_running_tid));
 }
 
+/**
+ * Record that the running thread accessed [ addr, addr + size [. Consecutive
+ * accesses that fall within the same bitmap word are combined in the access
+ * buffer, and the buffer is only written to the bitmap of the latest segment
+ * of the running thread when an access falls in another word or before that
+ * bitmap is used. Accesses that span more than one bitmap word are recorded
+ * immediately.
+ */
+static __inline__
+void DRD_(running_thread_buffer_access)(const Addr addr, const SizeT size,
+                                        const BmAccessTypeT access_type)
+{
+   const UWord bits_per_uword = 8 * sizeof(UWord);
+   const Addr  word_addr = addr & ~(Addr)(bits_per_uword - 1);
+   const UWord lsb = addr & (bits_per_uword - 1);
+   UWord mask;
+
+   if (UNLIKELY(size >= bits_per_uword || lsb + size > bits_per_uword)) {
+      DRD_(bm_access_range)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
+                            addr, addr + size, access_type);
+      return;
+   }
+
+   if (word_addr != DRD_(g_access_buf).addr) {
+      DRD_(thread_flush_access_buf)();
+      DRD_(g_access_buf).addr = word_addr;
+   }
+   mask = (((UWord)1 << size) - 1) << lsb;
+   if (access_type == eLoad)
+      DRD_(g_access_buf).mask_r |= mask;
+   else
+      DRD_(g_access_buf).mask_w |= mask;
+}
+
 #endif /* __THREAD_H */
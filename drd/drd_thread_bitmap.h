@@ -34,7 +34,7 @@
 static __inline__
 Bool bm_access_load_1_triggers_conflict(const Addr a1)
 {
-   DRD_(bm_access_load_1)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1);
+   DRD_(running_thread_buffer_access)(a1, 1, eLoad);
    return DRD_(bm_load_1_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                             a1);
 }
@@ -42,16 +42,14 @@ Bool bm_access_load_1_triggers_conflict(const Addr a1)
 static __inline__
 Bool bm_access_load_2_triggers_conflict(const Addr a1)
 {
+   DRD_(running_thread_buffer_access)(a1, 2, eLoad);
    if ((a1 & 1) == 0)
    {
-      bm_access_aligned_load(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1, 2);
       return bm_aligned_load_has_conflict_with(DRD_(thread_get_conflict_set)(),
                                                a1, 2);
    }
    else
    {
-      DRD_(bm_access_range)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
-                            a1, a1 + 2, eLoad);
       return DRD_(bm_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                         a1, a1 + 2, eLoad);
    }
@@ -60,16 +58,14 @@ Bool bm_access_load_2_triggers_conflict(const Addr a1)
 static __inline__
 Bool bm_access_load_4_triggers_conflict(const Addr a1)
 {
+   DRD_(running_thread_buffer_access)(a1, 4, eLoad);
    if ((a1 & 3) == 0)
    {
-      bm_access_aligned_load(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1, 4);
       return bm_aligned_load_has_conflict_with(DRD_(thread_get_conflict_set)(),
                                                a1, 4);
    }
    else
    {
-      DRD_(bm_access_range)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
-                            a1, a1 + 4, eLoad);
       return DRD_(bm_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                         a1, a1 + 4, eLoad);
    }
@@ -78,23 +74,14 @@ Bool bm_access_load_4_triggers_conflict(const Addr a1)
 static __inline__
 Bool bm_access_load_8_triggers_conflict(const Addr a1)
 {
+   DRD_(running_thread_buffer_access)(a1, 8, eLoad);
    if ((a1 & 7) == 0)
    {
-      bm_access_aligned_load(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1, 8);
       return bm_aligned_load_has_conflict_with(DRD_(thread_get_conflict_set)(),
                                                a1, 8);
    }
-   else if ((a1 & 3) == 0)
-   {
-      bm_access_aligned_load(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1 + 0, 4);
-      bm_access_aligned_load(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1 + 4, 4);
-      return DRD_(bm_has_conflict_with)(DRD_(thread_get_conflict_set)(),
-                                        a1, a1 + 8, eLoad);
-   }
    else
    {
-      DRD_(bm_access_range)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
-                            a1, a1 + 8, eLoad);
       return DRD_(bm_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                         a1, a1 + 8, eLoad);
    }
@@ -103,7 +90,7 @@ Bool bm_access_load_8_triggers_conflict(const Addr a1)
 static __inline__
 Bool bm_access_load_triggers_conflict(const Addr a1, const Addr a2)
 {
-   DRD_(bm_access_range_load)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1, a2);
+   DRD_(running_thread_buffer_access)(a1, a2 - a1, eLoad);
    return DRD_(bm_load_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                           a1, a2);
 }
@@ -111,7 +98,7 @@ Bool bm_access_load_triggers_conflict(const Addr a1, const Addr a2)
 static __inline__
 Bool bm_access_store_1_triggers_conflict(const Addr a1)
 {
-   DRD_(bm_access_store_1)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1);
+   DRD_(running_thread_buffer_access)(a1, 1, eStore);
    return DRD_(bm_store_1_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                              a1);
 }
@@ -119,16 +106,14 @@ Bool bm_access_store_1_triggers_conflict(const Addr a1)
 static __inline__
 Bool bm_access_store_2_triggers_conflict(const Addr a1)
 {
+   DRD_(running_thread_buffer_access)(a1, 2, eStore);
    if ((a1 & 1) == 0)
    {
-      bm_access_aligned_store(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1, 2);
       return bm_aligned_store_has_conflict_with(DRD_(thread_get_conflict_set)(),
                                                 a1, 2);
    }
    else
    {
-      DRD_(bm_access_range)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
-                            a1, a1 + 2, eStore);
       return DRD_(bm_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                         a1, a1 + 2, eStore);
    }
@@ -137,16 +122,14 @@ Bool bm_access_store_2_triggers_conflict(const Addr a1)
 static __inline__
 Bool bm_access_store_4_triggers_conflict(const Addr a1)
 {
+   DRD_(running_thread_buffer_access)(a1, 4, eStore);
    if ((a1 & 3) == 0)
    {
-      bm_access_aligned_store(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1, 4);
       return bm_aligned_store_has_conflict_with(DRD_(thread_get_conflict_set)(),
                                                 a1, 4);
    }
    else
    {
-      DRD_(bm_access_range)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
-                            a1, a1 + 4, eStore);
       return DRD_(bm_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                         a1, a1 + 4, eStore);
    }
@@ -155,25 +138,14 @@ Bool bm_access_store_4_triggers_conflict(const Addr a1)
 static __inline__
 Bool bm_access_store_8_triggers_conflict(const Addr a1)
 {
+   DRD_(running_thread_buffer_access)(a1, 8, eStore);
    if ((a1 & 7) == 0)
    {
-      bm_access_aligned_store(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1, 8);
       return bm_aligned_store_has_conflict_with(DRD_(thread_get_conflict_set)(),
                                                 a1, 8);
    }
-   else if ((a1 & 3) == 0)
-   {
-      bm_access_aligned_store(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
-                              a1 + 0, 4);
-      bm_access_aligned_store(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
-                              a1 + 4, 4);
-      return DRD_(bm_has_conflict_with)(DRD_(thread_get_conflict_set)(),
-                                        a1, a1 + 8, eStore);
-   }
    else
    {
-      DRD_(bm_access_range)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()),
-                            a1, a1 + 8, eStore);
       return DRD_(bm_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                         a1, a1 + 8, eStore);
    }
@@ -182,7 +154,7 @@ Bool bm_access_store_8_triggers_conflict(const Addr a1)
 static __inline__
 Bool bm_access_store_triggers_conflict(const Addr a1, const Addr a2)
 {
-   DRD_(bm_access_range_store)(DRD_(sg_bm)(DRD_(running_thread_get_segment)()), a1, a2);
+   DRD_(running_thread_buffer_access)(a1, a2 - a1, eStore);
    return DRD_(bm_store_has_conflict_with)(DRD_(thread_get_conflict_set)(),
                                            a1, a2);
 }
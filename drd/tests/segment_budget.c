@@ -0,0 +1,56 @@
+/*
+ * Test program that creates many segments through happens-before /
+ * happens-after annotations and that triggers a data race after having done
+ * so. Meant to be run with a small --segment-budget such that segment merging
+ * passes are spread over several steps, and to verify that the data race is
+ * still reported.
+ */
+
+
+#include <stdio.h>
+#include <pthread.h>
+#include "unified_annotations.h"
+
+
+#define NTHREADS 4
+#define NITERS   200
+
+
+static int s_hb;
+static int s_data[NTHREADS];
+static int s_racy;
+
+
+static void* thread_func(void* arg)
+{
+  const int t = *(int*)arg;
+  int i;
+
+  for (i = 0; i < NITERS; i++)
+  {
+    U_ANNOTATE_HAPPENS_BEFORE(&s_hb);
+    U_ANNOTATE_HAPPENS_AFTER(&s_hb);
+    s_data[t]++;
+  }
+  s_racy = t;
+  return NULL;
+}
+
+int main(int argc, char** argv)
+{
+  pthread_t tid[NTHREADS];
+  int arg[NTHREADS];
+  int i;
+
+  for (i = 0; i < NTHREADS; i++)
+  {
+    arg[i] = i;
+    pthread_create(&tid[i], 0, thread_func, &arg[i]);
+  }
+  for (i = 0; i < NTHREADS; i++)
+    pthread_join(tid[i], NULL);
+
+  fprintf(stderr, "Done.\n");
+
+  return 0;
+}
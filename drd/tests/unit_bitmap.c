@@ -319,6 +319,49 @@ void bm_test3(const int outer_loop_step, const int inner_loop_step)
   DRD_(bm_delete)(bm1);
 }
 
+/**
+ * Test whether the functions that query a range of bits agree with a bit by
+ * bit query.
+ */
+void bm_test4(const int outer_loop_step, const int inner_loop_step)
+{
+  Addr i, j, k;
+  struct bitmap* bm;
+
+  const Addr lb = make_address(1, 0) - 3 * BITS_PER_UWORD;
+  const Addr ub = make_address(1, 0) + 3 * BITS_PER_UWORD;
+
+  assert(outer_loop_step >= 1);
+  assert(inner_loop_step >= 1);
+
+  bm = DRD_(bm_new)();
+  for (i = lb; i < ub; i += 37)
+    DRD_(bm_access_load_1)(bm, i);
+  for (i = lb + 5; i < ub; i += 53)
+    DRD_(bm_access_store_1)(bm, i);
+
+  for (i = lb - BITS_PER_UWORD; i < ub; i += outer_loop_step)
+  {
+    for (j = i + 1; j < ub + BITS_PER_UWORD; j += inner_loop_step)
+    {
+      Bool has_load = False, has_store = False;
+
+      for (k = i; k < j; k++)
+      {
+        has_load  |= DRD_(bm_has_1)(bm, k, eLoad);
+        has_store |= DRD_(bm_has_1)(bm, k, eStore);
+      }
+      assert(DRD_(bm_has_any_load)(bm, i, j) == has_load);
+      assert(DRD_(bm_has_any_store)(bm, i, j) == has_store);
+      assert(DRD_(bm_has_any_access)(bm, i, j) == (has_load || has_store));
+      assert(DRD_(bm_load_has_conflict_with)(bm, i, j) == has_store);
+      assert(DRD_(bm_store_has_conflict_with)(bm, i, j)
+             == (has_load || has_store));
+    }
+  }
+  DRD_(bm_delete)(bm);
+}
+
 int main(int argc, char** argv)
 {
   int outer_loop_step = ADDR_GRANULARITY;
@@ -352,6 +395,7 @@ int main(int argc, char** argv)
   bm_test1();
   bm_test2();
   bm_test3(outer_loop_step, inner_loop_step);
+  bm_test4(outer_loop_step, inner_loop_step);
   DRD_(bm_module_cleanup)();
 
   fprintf(stderr, "End of DRD BM unit test.\n");
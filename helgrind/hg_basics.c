@@ -92,6 +92,10 @@ UWord HG_(clo_vts_pruning) = 1;
 
 Bool  HG_(clo_check_stack_refs) = True;
 
+UWord HG_(clo_sample_rate) = 1000000;
+
+UWord HG_(clo_sample_burst) = 10;
+
 /*--------------------------------------------------------------------*/
 /*--- end                                              hg_basics.c ---*/
 /*--------------------------------------------------------------------*/
@@ -136,6 +136,16 @@ extern UWord HG_(clo_vts_pruning);
    the stack, which speeds things up a bit.  Default: True. */
 extern Bool HG_(clo_check_stack_refs); 
 
+/* Sampling of memory accesses.  When below 1000000 (the default),
+   the memory accesses of a superblock are only checked during some
+   executions of it: the fraction of checked executions starts at 100%
+   and is divided by 10 after each burst of HG_(clo_sample_burst)
+   checked executions, down to a floor of HG_(clo_sample_rate) parts
+   per million.  Hence cold code is always checked, while hot code is
+   only sampled.  Synchronisation events are never sampled. */
+extern UWord HG_(clo_sample_rate);
+extern UWord HG_(clo_sample_burst);
+
 #endif /* ! __HG_BASICS_H */
 
 /*--------------------------------------------------------------------*/
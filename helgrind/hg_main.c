@@ -620,7 +620,7 @@ static void initialise_data_structures ( Thr* hbthr_root )
 
    tl_assert(univ_lsets == NULL);
    univ_lsets = HG_(newWordSetU)( HG_(zalloc), "hg.ids.4", HG_(free),
-                                  8/*cacheSize*/ );
+                                  1024/*cacheSize*/ );
    tl_assert(univ_lsets != NULL);
    /* Ensure that univ_lsets is non-empty, with lockset zero being the
       empty lockset.  hg_errors.c relies on the assumption that
@@ -631,7 +631,7 @@ static void initialise_data_structures ( Thr* hbthr_root )
    tl_assert(univ_laog == NULL);
    if (HG_(clo_track_lockorders)) {
       univ_laog = HG_(newWordSetU)( HG_(zalloc), "hg.ids.5 (univ_laog)",
-                                    HG_(free), 24/*cacheSize*/ );
+                                    HG_(free), 1024/*cacheSize*/ );
       tl_assert(univ_laog != NULL);
    }
 
@@ -1886,6 +1886,44 @@ void evh__pre_mem_write ( CorePart part, ThreadId tid, const HChar* s,
       all__sanity_check("evh__pre_mem_write-post");
 }
 
+/* Bulk memcpy/memset/strlen from the string function replacements.
+   The whole range is checked in one go, giving the same race reports
+   as the byte-by-byte accesses the replacement would otherwise do. */
+static
+Bool evh__bulk_copy ( ThreadId tid, Addr dst, Addr src, SizeT len ) {
+   if (SHOW_EVENTS >= 1)
+      VG_(printf)("evh__bulk_copy(ctid=%d, %p, %p, %lu)\n",
+                  (Int)tid, (void*)dst, (void*)src, len );
+   Thread *thr = map_threads_lookup(tid);
+   if (LIKELY(thr->synchr_nesting == 0)) {
+      shadow_mem_cread_range(thr, src, len);
+      shadow_mem_cwrite_range(thr, dst, len);
+   }
+   return True;
+}
+
+static
+Bool evh__bulk_fill ( ThreadId tid, Addr dst, Addr val, SizeT len ) {
+   if (SHOW_EVENTS >= 1)
+      VG_(printf)("evh__bulk_fill(ctid=%d, %p, %lu)\n",
+                  (Int)tid, (void*)dst, len );
+   Thread *thr = map_threads_lookup(tid);
+   if (LIKELY(thr->synchr_nesting == 0))
+      shadow_mem_cwrite_range(thr, dst, len);
+   return True;
+}
+
+static
+Bool evh__bulk_strlen ( ThreadId tid, Addr str, SizeT len ) {
+   if (SHOW_EVENTS >= 1)
+      VG_(printf)("evh__bulk_strlen(ctid=%d, %p, %lu)\n",
+                  (Int)tid, (void*)str, len );
+   Thread *thr = map_threads_lookup(tid);
+   if (LIKELY(thr->synchr_nesting == 0))
+      shadow_mem_cread_range(thr, str, len);
+   return True;
+}
+
 static
 void evh__new_mem_heap ( Addr a, SizeT len, Bool is_inited ) {
    if (SHOW_EVENTS >= 1)
@@ -3531,18 +3569,48 @@ void evh__HG_RTLD_BIND_CLEAR(ThreadId tid, Int flags)
    (2) Cache these add-edge requests and ignore them if said edges
        have already been added to laog.  Invalidate the cache any time
        any edges are deleted from laog.
+
+   (1) is now mostly taken care of by keeping a topological order of
+   the nodes (see below): as long as laog is acyclic, Ln --*--> L1
+   can only hold if ord(Ln) < ord(L1), so the search is only done
+   when some held lock comes later than Ln in the order.
 */
 
 typedef
    struct {
       WordSetID inns; /* in univ_laog */
       WordSetID outs; /* in univ_laog */
+      Word      ord;  /* position in the topological order */
+      UWord     mark; /* scratch, for laog__reorder and laog__recompute_order */
    }
    LAOGLinks;
 
 /* lock order acquisition graph */
 static WordFM* laog = NULL; /* WordFM Lock* LAOGLinks* */
 
+/* Topological order of laog.  While laog_ord_valid holds, every edge
+   src --> dst has src->ord < dst->ord.  It is maintained incrementally
+   when edges are added (Pearce and Kelly, "A Dynamic Topological Sort
+   Algorithm for Directed Acyclic Graphs"): only the nodes whose ord
+   lies between those of dst and src are visited and renumbered.
+   Adding an edge that closes a cycle (which only happens after a lock
+   order error has been reported) invalidates the order.  Deleting
+   edges never breaks a valid order, but can make laog acyclic again,
+   in which case the order is rebuilt from scratch the next time it is
+   needed.  New nodes with no in-edges (resp. out-edges) are placed
+   before (resp. after) every existing node, so that the common case
+   of acquiring a brand new lock needs no renumbering. */
+static Bool  laog_ord_valid = True;
+static Bool  laog_ord_retry = False;
+static Word  laog_ord_min   = -1;
+static Word  laog_ord_max   = 0;
+static UWord laog_mark      = 0;
+
+static UWord stats__laog_dfs_avoided = 0;
+static UWord stats__laog_dfs_done    = 0;
+static UWord stats__laog_reorders    = 0;
+static UWord stats__laog_recomputes  = 0;
+
 /* EXPOSITION ONLY: for each edge in 'laog', record the two places
    where that edge was created, so that we can show the user later if
    we need to. */
@@ -3685,6 +3753,195 @@ static void univ_laog_do_GC ( void ) {
 }
 
 
+static LAOGLinks* laog__links ( Lock* lk ) {
+   UWord      keyW  = 0;
+   LAOGLinks* links = NULL;
+   if (VG_(lookupFM)( laog, &keyW, (UWord*)&links, (UWord)lk )) {
+      tl_assert(links);
+      tl_assert(keyW == (UWord)lk);
+      return links;
+   }
+   return NULL;
+}
+
+/* Scratch space for laog__reorder, kept across calls. */
+static XArray* laog_ord_stack  = NULL; /* of Lock* */
+static XArray* laog_ord_deltaF = NULL; /* of LAOGLinks* */
+static XArray* laog_ord_deltaB = NULL; /* of LAOGLinks* */
+static XArray* laog_ord_pool   = NULL; /* of Word */
+
+static Int cmp_LAOGLinks_by_ord ( const void* v1, const void* v2 ) {
+   const LAOGLinks* l1 = *(LAOGLinks* const *)v1;
+   const LAOGLinks* l2 = *(LAOGLinks* const *)v2;
+   if (l1->ord < l2->ord) return -1;
+   if (l1->ord > l2->ord) return 1;
+   return 0;
+}
+
+static Int cmp_Word ( const void* v1, const void* v2 ) {
+   Word w1 = *(const Word*)v1;
+   Word w2 = *(const Word*)v2;
+   if (w1 < w2) return -1;
+   if (w1 > w2) return 1;
+   return 0;
+}
+
+/* Collect in 'found' the nodes reachable from 'start' (following
+   out-edges if 'fwd', in-edges otherwise) whose ord lies strictly
+   below (if 'fwd') or above (if not 'fwd') 'bound'.  Returns True,
+   leaving 'found' incomplete, if 'stop' is reachable that way. */
+static Bool laog__order_search ( Lock* start, Word bound, Bool fwd,
+                                 XArray* found, LAOGLinks* stop )
+{
+   UWord  ws_size, i;
+   UWord* ws_words;
+   Word   ssz;
+   Lock*  here;
+   LAOGLinks* links;
+
+   laog_mark++;
+   VG_(dropTailXA)( laog_ord_stack, VG_(sizeXA)( laog_ord_stack ) );
+   (void) VG_(addToXA)( laog_ord_stack, &start );
+   links = laog__links( start );
+   links->mark = laog_mark;
+
+   while ((ssz = VG_(sizeXA)( laog_ord_stack )) > 0) {
+      here = *(Lock**) VG_(indexXA)( laog_ord_stack, ssz-1 );
+      VG_(dropTailXA)( laog_ord_stack, 1 );
+      links = laog__links( here );
+      (void) VG_(addToXA)( found, &links );
+      HG_(getPayloadWS)( &ws_words, &ws_size, univ_laog,
+                         fwd ? links->outs : links->inns );
+      for (i = 0; i < ws_size; i++) {
+         LAOGLinks* w = laog__links( (Lock*)ws_words[i] );
+         if (w == stop)
+            return True;
+         if (w->mark == laog_mark)
+            continue;
+         if (fwd ? w->ord >= bound : w->ord <= bound)
+            continue;
+         w->mark = laog_mark;
+         (void) VG_(addToXA)( laog_ord_stack, &ws_words[i] );
+      }
+   }
+   return False;
+}
+
+/* The new edge src --> dst has just been added to laog.  Restore the
+   topological order if the edge goes backwards in it, or invalidate
+   the order if the edge closes a cycle. */
+static void laog__reorder ( Lock* src, Lock* dst )
+{
+   LAOGLinks* srcL = laog__links( src );
+   LAOGLinks* dstL = laog__links( dst );
+   LAOGLinks* links;
+   Word nF, nB, i;
+
+   tl_assert(laog_ord_valid);
+   if (srcL->ord < dstL->ord)
+      return;
+
+   stats__laog_reorders++;
+   if (!laog_ord_stack) {
+      laog_ord_stack  = VG_(newXA)( HG_(zalloc), "hg.laog_ord.1",
+                                    HG_(free), sizeof(Lock*) );
+      laog_ord_deltaF = VG_(newXA)( HG_(zalloc), "hg.laog_ord.2",
+                                    HG_(free), sizeof(LAOGLinks*) );
+      laog_ord_deltaB = VG_(newXA)( HG_(zalloc), "hg.laog_ord.3",
+                                    HG_(free), sizeof(LAOGLinks*) );
+      laog_ord_pool   = VG_(newXA)( HG_(zalloc), "hg.laog_ord.4",
+                                    HG_(free), sizeof(Word) );
+      VG_(setCmpFnXA)( laog_ord_deltaF, cmp_LAOGLinks_by_ord );
+      VG_(setCmpFnXA)( laog_ord_deltaB, cmp_LAOGLinks_by_ord );
+      VG_(setCmpFnXA)( laog_ord_pool, cmp_Word );
+   }
+   VG_(dropTailXA)( laog_ord_deltaF, VG_(sizeXA)( laog_ord_deltaF ) );
+   VG_(dropTailXA)( laog_ord_deltaB, VG_(sizeXA)( laog_ord_deltaB ) );
+   VG_(dropTailXA)( laog_ord_pool,   VG_(sizeXA)( laog_ord_pool ) );
+
+   if (laog__order_search( dst, srcL->ord, True/*fwd*/,
+                           laog_ord_deltaF, srcL )) {
+      laog_ord_valid = False;
+      return;
+   }
+   (void) laog__order_search( src, dstL->ord, False/*fwd*/,
+                              laog_ord_deltaB, NULL );
+
+   /* Hand out the ords of all the visited nodes again, first to the
+      nodes that reach src, then to those reachable from dst, keeping
+      the relative order within each group. */
+   VG_(sortXA)( laog_ord_deltaF );
+   VG_(sortXA)( laog_ord_deltaB );
+   nF = VG_(sizeXA)( laog_ord_deltaF );
+   nB = VG_(sizeXA)( laog_ord_deltaB );
+   for (i = 0; i < nB; i++) {
+      links = *(LAOGLinks**)VG_(indexXA)( laog_ord_deltaB, i );
+      (void) VG_(addToXA)( laog_ord_pool, &links->ord );
+   }
+   for (i = 0; i < nF; i++) {
+      links = *(LAOGLinks**)VG_(indexXA)( laog_ord_deltaF, i );
+      (void) VG_(addToXA)( laog_ord_pool, &links->ord );
+   }
+   VG_(sortXA)( laog_ord_pool );
+   for (i = 0; i < nB; i++) {
+      links = *(LAOGLinks**)VG_(indexXA)( laog_ord_deltaB, i );
+      links->ord = *(Word*)VG_(indexXA)( laog_ord_pool, i );
+   }
+   for (i = 0; i < nF; i++) {
+      links = *(LAOGLinks**)VG_(indexXA)( laog_ord_deltaF, i );
+      links->ord = *(Word*)VG_(indexXA)( laog_ord_pool, nB + i );
+   }
+}
+
+/* Rebuild the topological order from scratch (Kahn's algorithm),
+   using 'mark' as the count of not yet ordered predecessors.  The
+   order becomes valid again iff laog is acyclic. */
+static void laog__recompute_order ( void )
+{
+   XArray*    ready; /* of Lock* */
+   Lock*      me;
+   LAOGLinks* links;
+   UWord      ws_size, i;
+   UWord*     ws_words;
+   Word       n_ordered = 0, ssz;
+
+   stats__laog_recomputes++;
+   ready = VG_(newXA)( HG_(zalloc), "hg.laog_ord.5", HG_(free),
+                       sizeof(Lock*) );
+   VG_(initIterFM)( laog );
+   while (VG_(nextIterFM)( laog, (UWord*)&me, (UWord*)&links )) {
+      links->mark = HG_(cardinalityWS)( univ_laog, links->inns );
+      if (links->mark == 0)
+         (void) VG_(addToXA)( ready, &me );
+   }
+   VG_(doneIterFM)( laog );
+
+   while ((ssz = VG_(sizeXA)( ready )) > 0) {
+      me = *(Lock**) VG_(indexXA)( ready, ssz-1 );
+      VG_(dropTailXA)( ready, 1 );
+      links = laog__links( me );
+      links->ord = n_ordered++;
+      HG_(getPayloadWS)( &ws_words, &ws_size, univ_laog, links->outs );
+      for (i = 0; i < ws_size; i++) {
+         LAOGLinks* w = laog__links( (Lock*)ws_words[i] );
+         tl_assert(w->mark > 0);
+         if (--w->mark == 0)
+            (void) VG_(addToXA)( ready, &ws_words[i] );
+      }
+   }
+   VG_(deleteXA)( ready );
+
+   laog_ord_valid = n_ordered == (Word)VG_(sizeFM)( laog );
+   laog_ord_min   = -1;
+   laog_ord_max   = n_ordered;
+
+   /* Nodes left on a cycle still have a nonzero mark. */
+   VG_(initIterFM)( laog );
+   while (VG_(nextIterFM)( laog, (UWord*)&me, (UWord*)&links ))
+      links->mark = 0;
+   VG_(doneIterFM)( laog );
+}
+
 __attribute__((noinline))
 static void laog__add_edge ( Lock* src, Lock* dst ) {
    UWord      keyW;
@@ -3716,6 +3973,7 @@ static void laog__add_edge ( Lock* src, Lock* dst ) {
       links = HG_(zalloc)("hg.lae.1", sizeof(LAOGLinks));
       links->inns = HG_(emptyWS)( univ_laog );
       links->outs = HG_(singletonWS)( univ_laog, (UWord)dst );
+      links->ord  = laog_ord_min--;
       VG_(addToFM)( laog, (UWord)src, (UWord)links );
    }
    /* Update the in edges for dst */
@@ -3732,11 +3990,15 @@ static void laog__add_edge ( Lock* src, Lock* dst ) {
       links = HG_(zalloc)("hg.lae.2", sizeof(LAOGLinks));
       links->inns = HG_(singletonWS)( univ_laog, (UWord)src );
       links->outs = HG_(emptyWS)( univ_laog );
+      links->ord  = laog_ord_max++;
       VG_(addToFM)( laog, (UWord)dst, (UWord)links );
    }
 
    tl_assert( (presentF && presentR) || (!presentF && !presentR) );
 
+   if (!presentF && laog_ord_valid)
+      laog__reorder( src, dst );
+
    if (!presentF && src->acquired_at && dst->acquired_at) {
       LAOGLinkExposition expo;
       /* If this edge is entering the graph, and we have acquired_at
@@ -3869,6 +4131,9 @@ static void laog__sanity_check ( const HChar* who ) {
                              laog__preds( (Lock*)ws_words[i] ), 
                              (UWord)me ))
             goto bad;
+         if (laog_ord_valid
+             && links->ord >= laog__links( (Lock*)ws_words[i] )->ord)
+            goto bad;
       }
       me = NULL;
       links = NULL;
@@ -3939,6 +4204,36 @@ Lock* laog__do_dfs_from_to ( Lock* src, WordSetID dsts /* univ_lsets */ )
 }
 
 
+/* Cheap pre-check for laog__do_dfs_from_to: returns False only if
+   the topological order proves there is no path in laog from 'src'
+   to any of the elements in 'dsts'. */
+static Bool laog__maybe_path ( Lock* src, WordSetID dsts /* univ_lsets */ )
+{
+   LAOGLinks* srcL;
+   LAOGLinks* dstL;
+   UWord      ws_size, i;
+   UWord*     ws_words;
+
+   if (!laog_ord_valid && laog_ord_retry) {
+      laog_ord_retry = False;
+      laog__recompute_order();
+   }
+   if (!laog_ord_valid)
+      return True;
+
+   srcL = laog__links( src );
+   if (!srcL || HG_(isEmptyWS)( univ_laog, srcL->outs ))
+      return False;
+   HG_(getPayloadWS)( &ws_words, &ws_size, univ_lsets, dsts );
+   for (i = 0; i < ws_size; i++) {
+      dstL = laog__links( (Lock*)ws_words[i] );
+      if (dstL && dstL->ord > srcL->ord)
+         return True;
+   }
+   return False;
+}
+
+
 /* Thread 'thr' is acquiring 'lk'.  Check for inconsistent ordering
    between 'lk' and the locks already held by 'thr' and issue a
    complaint if so.  Also, update the ordering graph appropriately.
@@ -3965,7 +4260,13 @@ static void laog__pre_thread_acquires_lock (
       (rather than after, as we are doing here) at least one of those
       locks.
    */
-   other = laog__do_dfs_from_to(lk, thr->locksetA);
+   if (laog__maybe_path(lk, thr->locksetA)) {
+      stats__laog_dfs_done++;
+      other = laog__do_dfs_from_to(lk, thr->locksetA);
+   } else {
+      stats__laog_dfs_avoided++;
+      other = NULL;
+   }
    if (other) {
       LAOGLinkExposition key, *found;
       /* So we managed to find a path lk --*--> other in the graph,
@@ -4134,6 +4435,11 @@ static void laog__handle_one_lock_deletion ( Lock* lk )
          HG_(free) (links);
       }
    }
+
+   /* Removing edges may have broken the cycles that invalidated the
+      topological order; check that lazily, at the next query. */
+   if (!laog_ord_valid)
+      laog_ord_retry = True;
    /* FIXME ??? What about removing lock lk data from EXPOSITION ??? */
 }
 
@@ -4486,6 +4792,83 @@ static IRExpr* mk_And1 ( IRSB* sbOut, IRExpr* arg1, IRExpr* arg2 )
    return mkexpr(res);
 }
 
+/* Sampling (--sample-rate), after Marino, Musuvathi and Narayanasamy,
+   "LiteRace: Effective Sampling for Lightweight Data-Race Detection".
+   Rather than having two translations of each superblock, one with
+   and one without memory access checks, a single translation calls
+   hg_sample_block on entry, and its result guards all the memory
+   access helpers of the block.  The sampling state is kept per
+   superblock (keyed by its guest address, so that it survives
+   retranslation), with a few slots indexed by thread id so that a
+   block which is hot in one thread is still checked when other
+   threads first run it. */
+
+#define SAMPLER_N_SLOTS 4 /* must be a power of 2 */
+
+typedef
+   struct {
+      UInt burst; /* checked executions left in the current burst */
+      UInt skip;  /* unchecked executions left before the next burst */
+      UInt rate;  /* checked fraction for the next burst, in ppm */
+   }
+   SamplerSlot;
+
+typedef
+   struct _BlockSampler {
+      struct _BlockSampler* next; /* VgHashNode */
+      UWord                 key;  /* guest address of the superblock */
+      SamplerSlot           slot[SAMPLER_N_SLOTS];
+   }
+   BlockSampler;
+
+static VgHashTable* block_samplers = NULL; /* of BlockSampler */
+
+static UWord stats__sample_checked = 0;
+static UWord stats__sample_skipped = 0;
+
+static BlockSampler* get_BlockSampler ( Addr ga )
+{
+   BlockSampler* bs = VG_(HT_lookup)( block_samplers, ga );
+   Int i;
+   if (bs == NULL) {
+      bs = HG_(zalloc)( "hg.gBS.1", sizeof(BlockSampler) );
+      bs->key = ga;
+      for (i = 0; i < SAMPLER_N_SLOTS; i++)
+         bs->slot[i].rate = 1000000;
+      VG_(HT_add_node)( block_samplers, bs );
+   }
+   return bs;
+}
+
+/* Returns nonzero if the memory accesses of this execution of the
+   superblock are to be checked. */
+static VG_REGPARM(1)
+UInt hg_sample_block ( BlockSampler* bs )
+{
+   Thread*      thr = get_current_Thread_in_C_C();
+   SamplerSlot* sl  = &bs->slot[thr->coretid & (SAMPLER_N_SLOTS-1)];
+
+   if (LIKELY(sl->burst > 0)) {
+      sl->burst--;
+      stats__sample_checked++;
+      return 1;
+   }
+   if (LIKELY(sl->skip > 0)) {
+      sl->skip--;
+      stats__sample_skipped++;
+      return 0;
+   }
+   /* Start a new burst, then skip enough executions that the burst
+      makes up 'rate' of the period, then lower the rate. */
+   sl->burst = HG_(clo_sample_burst) - 1;
+   sl->skip  = (UInt)( (ULong)HG_(clo_sample_burst) * (1000000 - sl->rate)
+                       / sl->rate );
+   sl->rate  = sl->rate / 10 > HG_(clo_sample_rate)
+                  ? sl->rate / 10 : HG_(clo_sample_rate);
+   stats__sample_checked++;
+   return 1;
+}
+
 static void instrument_mem_access ( IRSB*   sbOut, 
                                     IRExpr* addr,
                                     Int     szB,
@@ -4727,6 +5110,7 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
    IRStmt* st;
    Bool    inLDSO = False;
    Addr    inLDSOmask4K = 1; /* mismatches on first check */
+   IRExpr* sampled = NULL; /* guard for mem accesses, NULL => True */
 
    // Set to True when SP must be fixed up when taking a stack trace for the
    // mem accesses in the rest of the instruction
@@ -4761,6 +5145,22 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
       i++;
    }
 
+   // When sampling, decide on entry whether this execution of the
+   // block has its memory accesses checked.
+   if (HG_(clo_sample_rate) < 1000000) {
+      BlockSampler* bs = get_BlockSampler( closure->nraddr );
+      IRTemp   res = newIRTemp(bbOut->tyenv, Ity_I32);
+      IRTemp   chk = newIRTemp(bbOut->tyenv, Ity_I1);
+      IRDirty* di
+         = unsafeIRDirty_1_N( res, 1, "hg_sample_block",
+                              VG_(fnptr_to_fnentry)( &hg_sample_block ),
+                              mkIRExprVec_1( mkIRExpr_HWord( (HWord)bs ) ) );
+      addStmtToIRSB( bbOut, IRStmt_Dirty(di) );
+      addStmtToIRSB( bbOut, assign(chk, binop(Iop_CmpNE32, mkexpr(res),
+                                                           mkU32(0))) );
+      sampled = mkexpr(chk);
+   }
+
    // Get the first statement, and initial cia from it
    tl_assert(bbIn->stmts_used > 0);
    tl_assert(i < bbIn->stmts_used);
@@ -4860,7 +5260,7 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
                      * sizeofIRType(typeOfIRExpr(bbIn->tyenv, cas->dataLo)),
                   False/*!isStore*/, fixupSP_needed,
                   hWordTy_szB, goff_SP, goff_SP_s1,
-                  NULL/*no-guard*/
+                  sampled
                );
             }
             break;
@@ -4881,7 +5281,7 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
                      sizeofIRType(dataTy),
                      False/*!isStore*/, fixupSP_needed,
                      hWordTy_szB, goff_SP, goff_SP_s1,
-                     NULL/*no-guard*/
+                     sampled
                   );
                }
             } else {
@@ -4899,7 +5299,7 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
                   sizeofIRType(typeOfIRExpr(bbIn->tyenv, st->Ist.Store.data)),
                   True/*isStore*/, fixupSP_needed,
                   hWordTy_szB, goff_SP, goff_SP_s1,
-                  NULL/*no-guard*/
+                  sampled
                );
             }
             break;
@@ -4913,7 +5313,9 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
             instrument_mem_access( bbOut, addr, sizeofIRType(type),
                                    True/*isStore*/, fixupSP_needed,
                                    hWordTy_szB,
-                                   goff_SP, goff_SP_s1, sg->guard );
+                                   goff_SP, goff_SP_s1,
+                                   sampled ? mk_And1(bbOut, sg->guard, sampled)
+                                           : sg->guard );
             break;
          }
 
@@ -4927,7 +5329,9 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
             instrument_mem_access( bbOut, addr, sizeofIRType(type),
                                    False/*!isStore*/, fixupSP_needed,
                                    hWordTy_szB,
-                                   goff_SP, goff_SP_s1, lg->guard );
+                                   goff_SP, goff_SP_s1,
+                                   sampled ? mk_And1(bbOut, lg->guard, sampled)
+                                           : lg->guard );
             break;
          }
 
@@ -4941,7 +5345,7 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
                      sizeofIRType(data->Iex.Load.ty),
                      False/*!isStore*/, fixupSP_needed,
                      hWordTy_szB, goff_SP, goff_SP_s1,
-                     NULL/*no-guard*/
+                     sampled
                   );
                }
             }
@@ -4963,7 +5367,7 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
                         bbOut, d->mAddr, dataSize,
                         False/*!isStore*/, fixupSP_needed,
                         hWordTy_szB, goff_SP, goff_SP_s1,
-                        NULL/*no-guard*/
+                        sampled
                      );
                   }
                }
@@ -4973,7 +5377,7 @@ IRSB* hg_instrument ( VgCallbackClosure* closure,
                         bbOut, d->mAddr, dataSize,
                         True/*isStore*/, fixupSP_needed,
                         hWordTy_szB, goff_SP, goff_SP_s1,
-                        NULL/*no-guard*/
+                        sampled
                      );
                   }
                }
@@ -5725,6 +6129,7 @@ Bool hg_handle_client_request ( ThreadId tid, UWord* args, UWord* ret)
 static Bool hg_process_cmd_line_option ( const HChar* arg )
 {
    const HChar* tmp_str;
+   double       tmp_dbl;
 
    if      VG_BOOL_CLO(arg, "--track-lockorders",
                             HG_(clo_track_lockorders)) {}
@@ -5777,6 +6182,16 @@ static Bool hg_process_cmd_line_option ( const HChar* arg )
 
    else if VG_BOOL_CLO(arg, "--check-stack-refs",
                             HG_(clo_check_stack_refs)) {}
+
+   else if VG_DBL_CLO(arg, "--sample-rate", tmp_dbl) {
+      if (tmp_dbl < 0.0001 || tmp_dbl > 100) {
+         VG_(fmsg_bad_option)(arg,
+            "--sample-rate must be between 0.0001 and 100.0\n");
+      }
+      HG_(clo_sample_rate) = (UWord)(tmp_dbl * 10000.0 + 0.5);
+   }
+   else if VG_BINT_CLO(arg, "--sample-burst",
+                       HG_(clo_sample_burst), 1, 1000) {}
    else if VG_BOOL_CLO(arg, "--ignore-thread-creation",
                             HG_(clo_ignore_thread_creation)) {}
 
@@ -5802,6 +6217,10 @@ static void hg_print_usage ( void )
 "    --conflict-cache-size=N   size of 'full' history cache [2000000]\n"
 "    --check-stack-refs=no|yes race-check reads and writes on the\n"
 "                              main stack and thread stacks? [yes]\n"
+"    --sample-rate=<m.n>       only check a sample of the memory accesses\n"
+"                              of hot code, down to this percentage [100.0]\n"
+"    --sample-burst=<number>   consecutive executions of a block checked\n"
+"                              in each sample [10]\n"
 "    --ignore-thread-creation=yes|no Ignore activities during thread\n"
 "                              creation [%s]\n",
 HG_(clo_ignore_thread_creation) ? "yes" : "no"
@@ -5881,6 +6300,10 @@ static void hg_print_stats (void)
                   (Int)(laog ? VG_(sizeFM)( laog ) : 0));
       VG_(printf)(" LAOG exposition: %'8d map size\n",
                   (Int)(laog_exposition ? VG_(sizeFM)( laog_exposition ) : 0));
+      VG_(printf)("      LAOG order: %'8lu searches avoided, %'lu done, "
+                  "%'lu reorders, %'lu recomputes\n",
+                  stats__laog_dfs_avoided, stats__laog_dfs_done,
+                  stats__laog_reorders, stats__laog_recomputes);
    }
 
    VG_(printf)("           locks: %'8lu acquires, "
@@ -5888,6 +6311,12 @@ static void hg_print_stats (void)
                stats__lockN_acquires,
                stats__lockN_releases
               );
+   if (HG_(clo_sample_rate) < 1000000) {
+      VG_(printf)("        sampling: %'8lu blocks checked, "
+                  "%'lu skipped (%'u blocks)\n",
+                  stats__sample_checked, stats__sample_skipped,
+                  VG_(HT_count_nodes)( block_samplers ));
+   }
    VG_(printf)("   sanity checks: %'8lu\n", stats__sanity_checks);
 
    VG_(printf)("\n");
@@ -5981,6 +6410,9 @@ static void hg_post_clo_init ( void )
    if (HG_(clo_track_lockorders))
       laog__init();
 
+   if (HG_(clo_sample_rate) < 1000000)
+      block_samplers = VG_(HT_construct)( "hg.block_samplers" );
+
    initialise_data_structures(hbthr_root);
    if (VG_(clo_xtree_memory) == Vg_XTMemory_Full)
       // Activate full xtree memory profiling.
@@ -6088,6 +6520,9 @@ static void hg_pre_clo_init ( void )
    VG_(track_pre_mem_read_asciiz) ( evh__pre_mem_read_asciiz );
    VG_(track_pre_mem_write)       ( evh__pre_mem_write );
    VG_(track_post_mem_write)      (NULL);
+   VG_(track_bulk_copy)           ( evh__bulk_copy );
+   VG_(track_bulk_fill)           ( evh__bulk_fill );
+   VG_(track_bulk_strlen)         ( evh__bulk_strlen );
 
    /////////////////
 
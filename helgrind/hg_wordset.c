@@ -39,7 +39,6 @@
 #include "pub_tool_libcbase.h"
 #include "pub_tool_libcprint.h"
 #include "pub_tool_threadstate.h"
-#include "pub_tool_wordfm.h"
 
 #include "hg_basics.h"
 #include "hg_wordset.h"     /* self */
@@ -52,77 +51,60 @@
 //------------------------------------------------------------------//
 
 typedef
-   struct { UWord arg1; UWord arg2; UWord res; }
+   struct { UWord arg1; UWord arg2; WordSet res; UInt gen; }
    WCacheEnt;
 
-/* Each cache is a fixed sized array of N_WCACHE_STAT_MAX entries.
-   However only the first .dynMax are used.  This is because at some
-   point, expanding the cache further overall gives a slowdown because
-   searching more entries more than negates any performance advantage
-   from caching those entries in the first place.  Hence use .dynMax
-   to allow the size of the cache(s) to be set differently for each
-   different WordSetU. */
-#define N_WCACHE_STAT_MAX 32
+/* Each cache is a direct mapped table of 'size' entries (a power of
+   2), indexed by a hash of the arguments, so that a lookup costs the
+   same however big the cache is.  An entry is only valid if its .gen
+   matches the owning WordSetU's cache_gen: bumping cache_gen (when a
+   WordSet dies, and its number may be given out again) invalidates
+   all the caches of a WordSetU at once. */
 typedef
    struct {
-      WCacheEnt ent[N_WCACHE_STAT_MAX];
-      UWord     dynMax; /* 1 .. N_WCACHE_STAT_MAX inclusive */
-      UWord     inUse;  /* 0 .. dynMax inclusive */
+      WCacheEnt* ent;
+      UWord      mask; /* size - 1 */
    }
    WCache;
 
-#define WCache_INIT(_zzcache,_zzdynmax)                              \
+static inline UWord WCache_hash ( UWord arg1, UWord arg2 )
+{
+   UWord h = arg1 * 0x9E3779B1UL + (arg2 ^ (arg2 >> 7));
+   return h ^ (h >> 13);
+}
+
+#define WCache_INIT(_zzcache,_zzsize)                                \
    do {                                                              \
-      tl_assert((_zzdynmax) >= 1);                                   \
-      tl_assert((_zzdynmax) <= N_WCACHE_STAT_MAX);                   \
-      (_zzcache).dynMax = (_zzdynmax);                               \
-      (_zzcache).inUse = 0;                                          \
+      UWord _sz = 1;                                                 \
+      tl_assert((_zzsize) >= 1);                                     \
+      while (_sz < (UWord)(_zzsize))                                 \
+         _sz *= 2;                                                   \
+      (_zzcache).ent  = wsu->alloc( wsu->cc, _sz * sizeof(WCacheEnt) ); \
+      VG_(memset)( (_zzcache).ent, 0, _sz * sizeof(WCacheEnt) );     \
+      (_zzcache).mask = _sz - 1;                                     \
    } while (0)
 
 #define WCache_LOOKUP_AND_RETURN(_retty,_zzcache,_zzarg1,_zzarg2)    \
    do {                                                              \
-      UWord   _i;                                                    \
-      UWord   _arg1  = (UWord)(_zzarg1);                             \
-      UWord   _arg2  = (UWord)(_zzarg2);                             \
-      WCache* _cache = &(_zzcache);                                  \
-      tl_assert(_cache->dynMax >= 1);                                \
-      tl_assert(_cache->dynMax <= N_WCACHE_STAT_MAX);                \
-      tl_assert(_cache->inUse >= 0);                                 \
-      tl_assert(_cache->inUse <= _cache->dynMax);                    \
-      if (_cache->inUse > 0) {                                       \
-         if (_cache->ent[0].arg1 == _arg1                            \
-             && _cache->ent[0].arg2 == _arg2)                        \
-            return (_retty)_cache->ent[0].res;                       \
-         for (_i = 1; _i < _cache->inUse; _i++) {                    \
-            if (_cache->ent[_i].arg1 == _arg1                        \
-                && _cache->ent[_i].arg2 == _arg2) {                  \
-               WCacheEnt tmp     = _cache->ent[_i-1];                \
-               _cache->ent[_i-1] = _cache->ent[_i];                  \
-               _cache->ent[_i]   = tmp;                              \
-               return (_retty)_cache->ent[_i-1].res;                 \
-            }                                                        \
-         }                                                           \
-      }                                                              \
+      UWord      _arg1 = (UWord)(_zzarg1);                           \
+      UWord      _arg2 = (UWord)(_zzarg2);                           \
+      WCacheEnt* _ent  = &(_zzcache).ent[ WCache_hash(_arg1, _arg2)  \
+                                          & (_zzcache).mask ];       \
+      if (_ent->gen == wsu->cache_gen                                \
+          && _ent->arg1 == _arg1 && _ent->arg2 == _arg2)             \
+         return (_retty)_ent->res;                                   \
    } while (0)
 
 #define WCache_UPDATE(_zzcache,_zzarg1,_zzarg2,_zzresult)            \
    do {                                                              \
-      Word    _i;                                                    \
-      UWord   _arg1  = (UWord)(_zzarg1);                             \
-      UWord   _arg2  = (UWord)(_zzarg2);                             \
-      UWord   _res   = (UWord)(_zzresult);                           \
-      WCache* _cache = &(_zzcache);                                  \
-      tl_assert(_cache->dynMax >= 1);                                \
-      tl_assert(_cache->dynMax <= N_WCACHE_STAT_MAX);                \
-      tl_assert(_cache->inUse >= 0);                                 \
-      tl_assert(_cache->inUse <= _cache->dynMax);                    \
-      if (_cache->inUse < _cache->dynMax)                            \
-         _cache->inUse++;                                            \
-      for (_i = _cache->inUse-1; _i >= 1; _i--)                      \
-         _cache->ent[_i] = _cache->ent[_i-1];                        \
-      _cache->ent[0].arg1 = _arg1;                                   \
-      _cache->ent[0].arg2 = _arg2;                                   \
-      _cache->ent[0].res  = _res;                                    \
+      UWord      _arg1 = (UWord)(_zzarg1);                           \
+      UWord      _arg2 = (UWord)(_zzarg2);                           \
+      WCacheEnt* _ent  = &(_zzcache).ent[ WCache_hash(_arg1, _arg2)  \
+                                          & (_zzcache).mask ];       \
+      _ent->arg1 = _arg1;                                            \
+      _ent->arg2 = _arg2;                                            \
+      _ent->res  = (_zzresult);                                      \
+      _ent->gen  = wsu->cache_gen;                                   \
    } while (0)
 
 
@@ -132,34 +114,49 @@ typedef
 //------------------------------------------------------------------//
 
 typedef
-   struct {
-      WordSetU* owner; /* for sanity checking */
-      UWord*    words;
-      UWord     size; /* Really this should be SizeT */
+   struct _WordVec {
+      WordSetU*        owner; /* for sanity checking */
+      UWord*           words;
+      UWord            size; /* Really this should be SizeT */
+      UWord            hash; /* of size and words, see hash_words */
+      struct _WordVec* next; /* in the vec2ix hash chain */
+      WordSet          ix;   /* index of this WordVec in ix2vec */
    }
    WordVec;
 
 /* ix2vec[0 .. ix2vec_used-1] are pointers to the lock sets (WordVecs)
-   really.  vec2ix is the inverse mapping, mapping WordVec* to the
-   corresponding ix2vec entry number.  The two mappings are mutually
-   redundant. 
+   really.  vec2ix is the inverse mapping, mapping the contents of a
+   WordVec to the corresponding ix2vec entry number: it is a hash table
+   of chained WordVecs, in which the WordVecs are hash-consed, so that
+   each distinct set of words is only ever stored once.  The two
+   mappings are mutually redundant.
 
    If a WordVec WV is marked as dead by HG(dieWS), WV is removed from
    vec2ix. The entry of the dead WVs in ix2vec are used to maintain a
-   linked list of free (to be re-used) ix2vec entries. */
+   linked list of free (to be re-used) ix2vec entries.
+
+   Operations producing a new set build it in 'scratch', so that
+   nothing is allocated when (as is most often the case) the result is
+   already present in vec2ix. */
 struct _WordSetU {
       void*     (*alloc)(const HChar*,SizeT);
       const HChar* cc;
       void      (*dealloc)(void*);
-      WordFM*   vec2ix; /* WordVec-to-WordSet mapping tree */
+      WordVec** vec2ix; /* WordVec-to-WordSet hash table */
+      UWord     vec2ix_size; /* nr of chains, a power of 2 */
+      UWord     vec2ix_used; /* nr of WordVecs in the chains */
       WordVec** ix2vec; /* WordSet-to-WordVec mapping array */
       UWord     ix2vec_size;
       UWord     ix2vec_used;
       WordVec** ix2vec_free;
       WordSet   empty; /* cached, for speed */
+      UWord*    scratch; /* for building new sets */
+      UWord     scratch_size;
       /* Caches for some operations */
+      UInt      cache_gen;
       WCache    cache_addTo;
       WCache    cache_delFrom;
+      WCache    cache_union;
       WCache    cache_intersect;
       WCache    cache_minus;
       /* Stats */
@@ -169,6 +166,7 @@ struct _WordSetU {
       UWord     n_del_uncached;
       UWord     n_die;
       UWord     n_union;
+      UWord     n_union_uncached;
       UWord     n_intersect;
       UWord     n_intersect_uncached;
       UWord     n_minus;
@@ -179,6 +177,7 @@ struct _WordSetU {
       UWord     n_isSingleton;
       UWord     n_anyElementOf;
       UWord     n_isSubsetOf;
+      UWord     n_new_vec;
    };
 
 /* Create a new WordVec of the given size. */
@@ -191,6 +190,9 @@ static WordVec* new_WV_of_size ( WordSetU* wsu, UWord sz )
    wv->owner = wsu;
    wv->words = NULL;
    wv->size = sz;
+   wv->hash = 0;
+   wv->next = NULL;
+   wv->ix = (WordSet)(-1);
    if (sz > 0) {
      wv->words = wsu->alloc( wsu->cc, (SizeT)sz * sizeof(UWord) );
    }
@@ -205,35 +207,81 @@ static void delete_WV ( WordVec* wv )
    }
    dealloc(wv);
 }
-static void delete_WV_for_FM ( UWord wv ) {
-   delete_WV( (WordVec*)wv );
+
+static UWord hash_words ( const UWord* words, UWord size )
+{
+   UWord i;
+   ULong h = size;
+   for (i = 0; i < size; i++)
+      h = (h ^ words[i]) * 0x9E3779B97F4A7C15ULL;
+   return (UWord)(h ^ (h >> 32));
 }
 
-static Word cmp_WordVecs_for_FM ( UWord wv1W, UWord wv2W )
+static Bool same_words ( const WordVec* wv, const UWord* words, UWord size )
 {
-   UWord    i;
-   WordVec* wv1    = (WordVec*)wv1W;
-   WordVec* wv2    = (WordVec*)wv2W;
+   UWord i;
+   if (wv->size != size)
+      return False;
+   for (i = 0; i < size; i++) {
+      if (wv->words[i] != words[i])
+         return False;
+   }
+   return True;
+}
 
-   // WordVecs with smaller size are smaller.
-   if (wv1->size < wv2->size) {
-      return -1;
+/* Make sure 'scratch' can hold at least sz words. */
+static UWord* ensure_scratch ( WordSetU* wsu, UWord sz )
+{
+   if (sz > wsu->scratch_size) {
+      UWord new_sz = wsu->scratch_size == 0 ? 16 : wsu->scratch_size;
+      while (new_sz < sz)
+         new_sz *= 2;
+      if (wsu->scratch)
+         wsu->dealloc(wsu->scratch);
+      wsu->scratch = wsu->alloc( wsu->cc, new_sz * sizeof(UWord) );
+      wsu->scratch_size = new_sz;
    }
-   if (wv1->size > wv2->size) {
-      return 1;
+   return wsu->scratch;
+}
+
+static void vec2ix_insert ( WordSetU* wsu, WordVec* wv )
+{
+   UWord i;
+   if (wsu->vec2ix_used >= wsu->vec2ix_size) {
+      /* Load factor 1 reached.  Double the number of chains. */
+      UWord     new_sz = 2 * wsu->vec2ix_size;
+      WordVec** new_tab = wsu->alloc( wsu->cc, new_sz * sizeof(WordVec*) );
+      VG_(memset)( new_tab, 0, new_sz * sizeof(WordVec*) );
+      for (i = 0; i < wsu->vec2ix_size; i++) {
+         WordVec* e = wsu->vec2ix[i];
+         while (e) {
+            WordVec* nx = e->next;
+            e->next = new_tab[e->hash & (new_sz - 1)];
+            new_tab[e->hash & (new_sz - 1)] = e;
+            e = nx;
+         }
+      }
+      wsu->dealloc(wsu->vec2ix);
+      wsu->vec2ix = new_tab;
+      wsu->vec2ix_size = new_sz;
    }
+   i = wv->hash & (wsu->vec2ix_size - 1);
+   wv->next = wsu->vec2ix[i];
+   wsu->vec2ix[i] = wv;
+   wsu->vec2ix_used++;
+}
 
-   // Sizes are equal => order based on content.
-   for (i = 0; i < wv1->size; i++) {
-      if (wv1->words[i] == wv2->words[i])
-         continue;
-      if (wv1->words[i] < wv2->words[i])
-         return -1;
-      if (wv1->words[i] > wv2->words[i])
-         return 1;
-      tl_assert(0);
+static void vec2ix_remove ( WordSetU* wsu, WordVec* wv )
+{
+   WordVec** link = &wsu->vec2ix[wv->hash & (wsu->vec2ix_size - 1)];
+   while (*link != wv) {
+      tl_assert(*link);
+      link = &(*link)->next;
    }
-   return 0; /* identical */
+   *link = wv->next;
+   wv->next = NULL;
+   tl_assert(wsu->vec2ix_used > 0);
+   wsu->vec2ix_used--;
 }
 
 static void ensure_ix2vec_space ( WordSetU* wsu )
@@ -305,51 +353,53 @@ static WordVec* do_ix2vec_with_dead ( WordSetU* wsu, WordSet ws )
    return wv;
 }
 
-/* See if wv is contained within wsu.  If so, deallocate wv and return
-   the index of the already-present copy.  If not, add wv to both the
-   vec2ix and ix2vec mappings and return its index. 
+/* Return the index of the set made of the 'size' sorted 'words'.  If
+   wsu does not contain it yet, copy it to a new WordVec and add that
+   to both the vec2ix and ix2vec mappings.  'words' is not retained,
+   so can be the scratch area.
 */
-static WordSet add_or_dealloc_WordVec( WordSetU* wsu, WordVec* wv_new )
-{
-   Bool     have;
-   WordVec* wv_old;
-   UWord/*Set*/ ix_old = -1;
-   /* Really WordSet, but need something that can safely be casted to
-      a Word* in the lookupFM.  Making it WordSet (which is 32 bits)
-      causes failures on a 64-bit platform. */
-   tl_assert(wv_new->owner == wsu);
-   have = VG_(lookupFM)( wsu->vec2ix, 
-                         (UWord*)&wv_old, (UWord*)&ix_old,
-                         (UWord)wv_new );
-   if (have) {
-      tl_assert(wv_old != wv_new);
-      tl_assert(wv_old);
-      tl_assert(wv_old->owner == wsu);
-      tl_assert(ix_old < wsu->ix2vec_used);
-      tl_assert(wsu->ix2vec[ix_old] == wv_old);
-      delete_WV( wv_new );
-      return (WordSet)ix_old;
-   } else if (wsu->ix2vec_free) {
-      WordSet ws;
+static WordSet add_or_find_words ( WordSetU* wsu,
+                                   const UWord* words, UWord size )
+{
+   UWord    hash = hash_words( words, size );
+   WordVec* wv;
+   WordSet  ws;
+   UWord    i;
+
+   for (wv = wsu->vec2ix[hash & (wsu->vec2ix_size - 1)]; wv; wv = wv->next) {
+      if (wv->hash == hash && same_words( wv, words, size )) {
+         tl_assert(wv->owner == wsu);
+         tl_assert(wsu->ix2vec[wv->ix] == wv);
+         return wv->ix;
+      }
+   }
+
+   wsu->n_new_vec++;
+   wv = new_WV_of_size( wsu, size );
+   for (i = 0; i < size; i++)
+      wv->words[i] = words[i];
+   wv->hash = hash;
+   vec2ix_insert( wsu, wv );
+
+   if (wsu->ix2vec_free) {
       tl_assert(is_dead(wsu,(WordVec*)wsu->ix2vec_free));
       ws = wsu->ix2vec_free - &(wsu->ix2vec[0]);
       tl_assert(wsu->ix2vec[ws] == NULL || is_dead(wsu,wsu->ix2vec[ws]));
       wsu->ix2vec_free = (WordVec **) wsu->ix2vec[ws];
-      wsu->ix2vec[ws] = wv_new;
-      VG_(addToFM)( wsu->vec2ix, (UWord)wv_new, ws );
-      if (HG_DEBUG) VG_(printf)("aodW %s re-use free %d %p\n", wsu->cc, (Int)ws, wv_new );
-      return ws;
+      wsu->ix2vec[ws] = wv;
+      if (HG_DEBUG) VG_(printf)("aofW %s re-use free %d %p\n", wsu->cc, (Int)ws, wv );
    } else {
       ensure_ix2vec_space( wsu );
       tl_assert(wsu->ix2vec);
       tl_assert(wsu->ix2vec_used < wsu->ix2vec_size);
-      wsu->ix2vec[wsu->ix2vec_used] = wv_new;
-      VG_(addToFM)( wsu->vec2ix, (Word)wv_new, (Word)wsu->ix2vec_used );
-      if (HG_DEBUG) VG_(printf)("aodW %s %d %p\n", wsu->cc, (Int)wsu->ix2vec_used, wv_new  );
+      ws = (WordSet)wsu->ix2vec_used;
+      wsu->ix2vec[ws] = wv;
+      if (HG_DEBUG) VG_(printf)("aofW %s %d %p\n", wsu->cc, (Int)ws, wv  );
       wsu->ix2vec_used++;
       tl_assert(wsu->ix2vec_used <= wsu->ix2vec_size);
-      return (WordSet)(wsu->ix2vec_used - 1);
    }
+   wv->ix = ws;
+   return ws;
 }
 
 
@@ -359,25 +409,27 @@ WordSetU* HG_(newWordSetU) ( void* (*alloc_nofail)( const HChar*, SizeT ),
                              Word  cacheSize )
 {
    WordSetU* wsu;
-   WordVec*  empty;
 
    wsu          = alloc_nofail( cc, sizeof(WordSetU) );
    VG_(memset)( wsu, 0, sizeof(WordSetU) );
    wsu->alloc   = alloc_nofail;
    wsu->cc      = cc;
    wsu->dealloc = dealloc;
-   wsu->vec2ix  = VG_(newFM)( alloc_nofail, cc,
-                              dealloc, cmp_WordVecs_for_FM );
+   wsu->vec2ix_size = 64;
+   wsu->vec2ix_used = 0;
+   wsu->vec2ix  = alloc_nofail( cc, wsu->vec2ix_size * sizeof(WordVec*) );
+   VG_(memset)( wsu->vec2ix, 0, wsu->vec2ix_size * sizeof(WordVec*) );
    wsu->ix2vec_used = 0;
    wsu->ix2vec_size = 0;
    wsu->ix2vec      = NULL;
    wsu->ix2vec_free = NULL;
+   wsu->cache_gen   = 1;
    WCache_INIT(wsu->cache_addTo,     cacheSize);
    WCache_INIT(wsu->cache_delFrom,   cacheSize);
+   WCache_INIT(wsu->cache_union,     cacheSize);
    WCache_INIT(wsu->cache_intersect, cacheSize);
    WCache_INIT(wsu->cache_minus,     cacheSize);
-   empty = new_WV_of_size( wsu, 0 );
-   wsu->empty = add_or_dealloc_WordVec( wsu, empty );
+   wsu->empty = add_or_find_words( wsu, NULL, 0 );
 
    return wsu;
 }
@@ -385,10 +437,26 @@ WordSetU* HG_(newWordSetU) ( void* (*alloc_nofail)( const HChar*, SizeT ),
 void HG_(deleteWordSetU) ( WordSetU* wsu )
 {
    void (*dealloc)(void*) = wsu->dealloc;
+   UWord i;
    tl_assert(wsu->vec2ix);
-   VG_(deleteFM)( wsu->vec2ix, delete_WV_for_FM, NULL/*val-finalizer*/ );
+   for (i = 0; i < wsu->vec2ix_size; i++) {
+      WordVec* wv = wsu->vec2ix[i];
+      while (wv) {
+         WordVec* nx = wv->next;
+         delete_WV( wv );
+         wv = nx;
+      }
+   }
+   dealloc(wsu->vec2ix);
    if (wsu->ix2vec)
       dealloc(wsu->ix2vec);
+   if (wsu->scratch)
+      dealloc(wsu->scratch);
+   dealloc(wsu->cache_addTo.ent);
+   dealloc(wsu->cache_delFrom.ent);
+   dealloc(wsu->cache_union.ent);
+   dealloc(wsu->cache_intersect.ent);
+   dealloc(wsu->cache_minus.ent);
    dealloc(wsu);
 }
 
@@ -459,8 +527,6 @@ void HG_(getPayloadWS) ( /*OUT*/UWord** words, /*OUT*/UWord* nWords,
 void HG_(dieWS) ( WordSetU* wsu, WordSet ws )
 {
    WordVec* wv = do_ix2vec_with_dead( wsu, ws );
-   WordVec* wv_in_vec2ix;
-   UWord/*Set*/ wv_ix = -1;
 
    if (HG_DEBUG) VG_(printf)("dieWS %s %d %p\n", wsu->cc, (Int)ws, wv);
 
@@ -476,20 +542,29 @@ void HG_(dieWS) ( WordSetU* wsu, WordSet ws )
    wsu->ix2vec[ws] = (WordVec*) wsu->ix2vec_free;
    wsu->ix2vec_free = &wsu->ix2vec[ws];
 
-   VG_(delFromFM) ( wsu->vec2ix, 
-                    (UWord*)&wv_in_vec2ix, (UWord*)&wv_ix,
-                    (UWord)wv );
-
-   if (HG_DEBUG) VG_(printf)("dieWS wv_ix %d\n", (Int)wv_ix);
-   tl_assert (wv_ix);
-   tl_assert (wv_ix == ws);
+   if (HG_DEBUG) VG_(printf)("dieWS wv_ix %d\n", (Int)wv->ix);
+   tl_assert (wv->ix == ws);
+   vec2ix_remove( wsu, wv );
 
    delete_WV( wv );
 
-   wsu->cache_addTo.inUse = 0;
-   wsu->cache_delFrom.inUse = 0;
-   wsu->cache_intersect.inUse = 0;
-   wsu->cache_minus.inUse = 0;
+   /* ws may be given out again for another set, so forget all the
+      cached results.  Restart the generations from scratch in the
+      (very unlikely) case they wrap around. */
+   wsu->cache_gen++;
+   if (UNLIKELY(wsu->cache_gen == 0)) {
+      VG_(memset)( wsu->cache_addTo.ent, 0,
+                   (wsu->cache_addTo.mask + 1) * sizeof(WCacheEnt) );
+      VG_(memset)( wsu->cache_delFrom.ent, 0,
+                   (wsu->cache_delFrom.mask + 1) * sizeof(WCacheEnt) );
+      VG_(memset)( wsu->cache_union.ent, 0,
+                   (wsu->cache_union.mask + 1) * sizeof(WCacheEnt) );
+      VG_(memset)( wsu->cache_intersect.ent, 0,
+                   (wsu->cache_intersect.mask + 1) * sizeof(WCacheEnt) );
+      VG_(memset)( wsu->cache_minus.ent, 0,
+                   (wsu->cache_minus.mask + 1) * sizeof(WCacheEnt) );
+      wsu->cache_gen = 1;
+   }
 }
 
 Bool HG_(plausibleWS) ( WordSetU* wsu, WordSet ws )
@@ -520,38 +595,52 @@ Bool HG_(saneWS_SLOW) ( WordSetU* wsu, WordSet ws )
    return True;
 }
 
+/* Binary search for w in the sorted words of wv.  Returns True if
+   found, and in *ix where it is or where it would be inserted. */
+static Bool find_in_WV ( const WordVec* wv, UWord w, /*OUT*/UWord* ix )
+{
+   UWord lo = 0, hi = wv->size;
+   while (lo < hi) {
+      UWord mid = lo + (hi - lo) / 2;
+      if (wv->words[mid] < w)
+         lo = mid + 1;
+      else if (wv->words[mid] > w)
+         hi = mid;
+      else {
+         *ix = mid;
+         return True;
+      }
+   }
+   *ix = lo;
+   return False;
+}
+
 Bool HG_(elemWS) ( WordSetU* wsu, WordSet ws, UWord w )
 {
    UWord    i;
    WordVec* wv = do_ix2vec( wsu, ws );
    wsu->n_elem++;
-   for (i = 0; i < wv->size; i++) {
-      if (wv->words[i] == w)
-         return True;
-   }
-   return False;
+   return find_in_WV( wv, w, &i );
 }
 
 WordSet HG_(doubletonWS) ( WordSetU* wsu, UWord w1, UWord w2 )
 {
-   WordVec* wv;
+   UWord words[2];
    wsu->n_doubleton++;
    if (w1 == w2) {
-      wv = new_WV_of_size(wsu, 1);
-      wv->words[0] = w1;
+      words[0] = w1;
+      return add_or_find_words( wsu, words, 1 );
    }
    else if (w1 < w2) {
-      wv = new_WV_of_size(wsu, 2);
-      wv->words[0] = w1;
-      wv->words[1] = w2;
+      words[0] = w1;
+      words[1] = w2;
    }
    else {
       tl_assert(w1 > w2);
-      wv = new_WV_of_size(wsu, 2);
-      wv->words[0] = w2;
-      wv->words[1] = w1;
+      words[0] = w2;
+      words[1] = w1;
    }
-   return add_or_dealloc_WordVec( wsu, wv );
+   return add_or_find_words( wsu, words, 2 );
 }
 
 WordSet HG_(singletonWS) ( WordSetU* wsu, UWord w )
@@ -587,7 +676,8 @@ void HG_(ppWSUstats) ( WordSetU* wsu, const HChar* name )
                wsu->n_add, wsu->n_add_uncached);
    VG_(printf)("      delFrom      %10lu (%lu uncached)\n", 
                wsu->n_del, wsu->n_del_uncached);
-   VG_(printf)("      union        %10lu\n", wsu->n_union);
+   VG_(printf)("      union        %10lu (%lu uncached)\n",
+               wsu->n_union, wsu->n_union_uncached);
    VG_(printf)("      intersect    %10lu (%lu uncached) "
                "[nb. incl isSubsetOf]\n", 
                wsu->n_intersect, wsu->n_intersect_uncached);
@@ -600,12 +690,14 @@ void HG_(ppWSUstats) ( WordSetU* wsu, const HChar* name )
    VG_(printf)("      anyElementOf %10lu\n",   wsu->n_anyElementOf);
    VG_(printf)("      isSubsetOf   %10lu\n",   wsu->n_isSubsetOf);
    VG_(printf)("      dieWS        %10lu\n",   wsu->n_die);
+   VG_(printf)("      new sets     %10lu (%lu live, %lu hash chains)\n",
+               wsu->n_new_vec, wsu->vec2ix_used, wsu->vec2ix_size);
 }
 
 WordSet HG_(addToWS) ( WordSetU* wsu, WordSet ws, UWord w )
 {
-   UWord    k, j;
-   WordVec* wv_new;
+   UWord    k;
+   UWord*   words;
    WordVec* wv;
    WordSet  result = (WordSet)(-1); /* bogus */
 
@@ -615,27 +707,18 @@ WordSet HG_(addToWS) ( WordSetU* wsu, WordSet ws, UWord w )
 
    /* If already present, this is a no-op. */
    wv = do_ix2vec( wsu, ws );
-   for (k = 0; k < wv->size; k++) {
-      if (wv->words[k] == w) {
-         result = ws;
-         goto out;
-      }
-   }
-   /* Ok, not present.  Build a new one ... */
-   wv_new = new_WV_of_size( wsu, wv->size + 1 );
-   k = j = 0;
-   for (; k < wv->size && wv->words[k] < w; k++) {
-      wv_new->words[j++] = wv->words[k];
-   }
-   wv_new->words[j++] = w;
-   for (; k < wv->size; k++) {
-      tl_assert(wv->words[k] > w);
-      wv_new->words[j++] = wv->words[k];
+   if (find_in_WV( wv, w, &k )) {
+      result = ws;
+      goto out;
    }
-   tl_assert(j == wv_new->size);
+   /* Ok, not present.  Build the new one, inserting w at k ... */
+   words = ensure_scratch( wsu, wv->size + 1 );
+   VG_(memcpy)( words, wv->words, k * sizeof(UWord) );
+   words[k] = w;
+   VG_(memcpy)( &words[k+1], &wv->words[k], (wv->size - k) * sizeof(UWord) );
 
    /* Find any existing copy, or add the new one. */
-   result = add_or_dealloc_WordVec( wsu, wv_new );
+   result = add_or_find_words( wsu, words, wv->size + 1 );
    tl_assert(result != (WordSet)(-1));
 
   out:
@@ -645,8 +728,8 @@ WordSet HG_(addToWS) ( WordSetU* wsu, WordSet ws, UWord w )
 
 WordSet HG_(delFromWS) ( WordSetU* wsu, WordSet ws, UWord w )
 {
-   UWord    i, j, k;
-   WordVec* wv_new;
+   UWord    i;
+   UWord*   words;
    WordSet  result = (WordSet)(-1); /* bogus */
    WordVec* wv = do_ix2vec( wsu, ws );
 
@@ -662,11 +745,7 @@ WordSet HG_(delFromWS) ( WordSetU* wsu, WordSet ws, UWord w )
    wsu->n_del_uncached++;
 
    /* If not already present, this is a no-op. */
-   for (i = 0; i < wv->size; i++) {
-      if (wv->words[i] == w)
-         break;
-   }
-   if (i == wv->size) {
+   if (!find_in_WV( wv, w, &i )) {
       result = ws;
       goto out;
    }
@@ -675,16 +754,12 @@ WordSet HG_(delFromWS) ( WordSetU* wsu, WordSet ws, UWord w )
    tl_assert(i >= 0 && i < wv->size);
    tl_assert(wv->size > 0);
 
-   wv_new = new_WV_of_size( wsu, wv->size - 1 );
-   j = k = 0;
-   for (; j < wv->size; j++) {
-      if (j == i)
-         continue;
-      wv_new->words[k++] = wv->words[j];
-   }
-   tl_assert(k == wv_new->size);
+   words = ensure_scratch( wsu, wv->size - 1 );
+   VG_(memcpy)( words, wv->words, i * sizeof(UWord) );
+   VG_(memcpy)( &words[i], &wv->words[i+1],
+                (wv->size - i - 1) * sizeof(UWord) );
 
-   result = add_or_dealloc_WordVec( wsu, wv_new );
+   result = add_or_find_words( wsu, words, wv->size - 1 );
    if (wv->size == 1) {
       tl_assert(result == wsu->empty);
    }
@@ -696,38 +771,31 @@ WordSet HG_(delFromWS) ( WordSetU* wsu, WordSet ws, UWord w )
 
 WordSet HG_(unionWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
 {
-   UWord    i1, i2, k, sz;
-   WordVec* wv_new;
-   WordVec* wv1 = do_ix2vec( wsu, ws1 );
-   WordVec* wv2 = do_ix2vec( wsu, ws2 );
+   UWord    i1, i2, k;
+   UWord*   words;
+   WordSet  ws_new = (WordSet)(-1); /* bogus */
+   WordVec* wv1;
+   WordVec* wv2;
+
    wsu->n_union++;
-   sz = 0;
-   i1 = i2 = 0;
-   while (1) {
-      if (i1 >= wv1->size || i2 >= wv2->size)
-         break;
-      sz++;
-      if (wv1->words[i1] < wv2->words[i2]) {
-         i1++;
-      } else 
-      if (wv1->words[i1] > wv2->words[i2]) {
-         i2++;
-      } else {
-         i1++;
-         i2++;
-      }
-   }
-   tl_assert(i1 <= wv1->size);
-   tl_assert(i2 <= wv2->size);
-   tl_assert(i1 == wv1->size || i2 == wv2->size);
-   if (i1 == wv1->size && i2 < wv2->size) {
-      sz += (wv2->size - i2);
-   }
-   if (i2 == wv2->size && i1 < wv1->size) {
-      sz += (wv1->size - i1);
+
+   /* Deal with obvious cases fast. */
+   if (ws1 == ws2 || ws2 == wsu->empty)
+      return ws1;
+   if (ws1 == wsu->empty)
+      return ws2;
+
+   /* union(x,y) == union(y,x), so only cache one of the variants. */
+   if (ws1 > ws2) {
+      WordSet wst = ws1; ws1 = ws2; ws2 = wst;
    }
 
-   wv_new = new_WV_of_size( wsu, sz );
+   WCache_LOOKUP_AND_RETURN(WordSet, wsu->cache_union, ws1, ws2);
+   wsu->n_union_uncached++;
+
+   wv1 = do_ix2vec( wsu, ws1 );
+   wv2 = do_ix2vec( wsu, ws2 );
+   words = ensure_scratch( wsu, wv1->size + wv2->size );
    k = 0;
 
    i1 = i2 = 0;
@@ -735,14 +803,14 @@ WordSet HG_(unionWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
       if (i1 >= wv1->size || i2 >= wv2->size)
          break;
       if (wv1->words[i1] < wv2->words[i2]) {
-         wv_new->words[k++] = wv1->words[i1];
+         words[k++] = wv1->words[i1];
          i1++;
       } else 
       if (wv1->words[i1] > wv2->words[i2]) {
-         wv_new->words[k++] = wv2->words[i2];
+         words[k++] = wv2->words[i2];
          i2++;
       } else {
-         wv_new->words[k++] = wv1->words[i1];
+         words[k++] = wv1->words[i1];
          i1++;
          i2++;
       }
@@ -750,33 +818,34 @@ WordSet HG_(unionWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
    tl_assert(i1 <= wv1->size);
    tl_assert(i2 <= wv2->size);
    tl_assert(i1 == wv1->size || i2 == wv2->size);
-   if (i1 == wv1->size && i2 < wv2->size) {
-      while (i2 < wv2->size)
-         wv_new->words[k++] = wv2->words[i2++];
-   }
-   if (i2 == wv2->size && i1 < wv1->size) {
-      while (i1 < wv1->size)
-         wv_new->words[k++] = wv1->words[i1++];
-   }
+   while (i2 < wv2->size)
+      words[k++] = wv2->words[i2++];
+   while (i1 < wv1->size)
+      words[k++] = wv1->words[i1++];
 
-   tl_assert(k == sz);
+   ws_new = add_or_find_words( wsu, words, k );
 
-   return add_or_dealloc_WordVec( wsu, wv_new );
+   tl_assert(ws_new != (WordSet)(-1));
+   WCache_UPDATE(wsu->cache_union, ws1, ws2, ws_new);
+
+   return ws_new;
 }
 
 WordSet HG_(intersectWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
 {
-   UWord    i1, i2, k, sz;
+   UWord    i1, i2, k;
+   UWord*   words;
    WordSet  ws_new = (WordSet)(-1); /* bogus */
-   WordVec* wv_new;
    WordVec* wv1; 
    WordVec* wv2; 
 
    wsu->n_intersect++;
 
-   /* Deal with an obvious case fast. */
+   /* Deal with obvious cases fast. */
    if (ws1 == ws2)
       return ws1;
+   if (ws1 == wsu->empty || ws2 == wsu->empty)
+      return wsu->empty;
 
    /* Since intersect(x,y) == intersect(y,x), convert both variants to
       the same query.  This reduces the number of variants the cache
@@ -790,27 +859,8 @@ WordSet HG_(intersectWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
 
    wv1 = do_ix2vec( wsu, ws1 );
    wv2 = do_ix2vec( wsu, ws2 );
-   sz = 0;
-   i1 = i2 = 0;
-   while (1) {
-      if (i1 >= wv1->size || i2 >= wv2->size)
-         break;
-      if (wv1->words[i1] < wv2->words[i2]) {
-         i1++;
-      } else 
-      if (wv1->words[i1] > wv2->words[i2]) {
-         i2++;
-      } else {
-         sz++;
-         i1++;
-         i2++;
-      }
-   }
-   tl_assert(i1 <= wv1->size);
-   tl_assert(i2 <= wv2->size);
-   tl_assert(i1 == wv1->size || i2 == wv2->size);
-
-   wv_new = new_WV_of_size( wsu, sz );
+   words = ensure_scratch( wsu, wv1->size < wv2->size ? wv1->size
+                                                      : wv2->size );
    k = 0;
 
    i1 = i2 = 0;
@@ -823,7 +873,7 @@ WordSet HG_(intersectWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
       if (wv1->words[i1] > wv2->words[i2]) {
          i2++;
       } else {
-         wv_new->words[k++] = wv1->words[i1];
+         words[k++] = wv1->words[i1];
          i1++;
          i2++;
       }
@@ -832,10 +882,8 @@ WordSet HG_(intersectWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
    tl_assert(i2 <= wv2->size);
    tl_assert(i1 == wv1->size || i2 == wv2->size);
 
-   tl_assert(k == sz);
-
-   ws_new = add_or_dealloc_WordVec( wsu, wv_new );
-   if (sz == 0) {
+   ws_new = add_or_find_words( wsu, words, k );
+   if (k == 0) {
       tl_assert(ws_new == wsu->empty);
    }
 
@@ -847,42 +895,26 @@ WordSet HG_(intersectWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
 
 WordSet HG_(minusWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
 {
-   UWord    i1, i2, k, sz;
+   UWord    i1, i2, k;
+   UWord*   words;
    WordSet  ws_new = (WordSet)(-1); /* bogus */
-   WordVec* wv_new;
    WordVec* wv1;
    WordVec* wv2;
    
    wsu->n_minus++;
+
+   /* Deal with obvious cases fast. */
+   if (ws1 == ws2)
+      return wsu->empty;
+   if (ws1 == wsu->empty || ws2 == wsu->empty)
+      return ws1;
+
    WCache_LOOKUP_AND_RETURN(WordSet, wsu->cache_minus, ws1, ws2);
    wsu->n_minus_uncached++;
 
    wv1 = do_ix2vec( wsu, ws1 );
    wv2 = do_ix2vec( wsu, ws2 );
-   sz = 0;
-   i1 = i2 = 0;
-   while (1) {
-      if (i1 >= wv1->size || i2 >= wv2->size)
-         break;
-      if (wv1->words[i1] < wv2->words[i2]) {
-         sz++;
-         i1++;
-      } else 
-      if (wv1->words[i1] > wv2->words[i2]) {
-         i2++;
-      } else {
-         i1++;
-         i2++;
-      }
-   }
-   tl_assert(i1 <= wv1->size);
-   tl_assert(i2 <= wv2->size);
-   tl_assert(i1 == wv1->size || i2 == wv2->size);
-   if (i2 == wv2->size && i1 < wv1->size) {
-      sz += (wv1->size - i1);
-   }
-
-   wv_new = new_WV_of_size( wsu, sz );
+   words = ensure_scratch( wsu, wv1->size );
    k = 0;
 
    i1 = i2 = 0;
@@ -890,7 +922,7 @@ WordSet HG_(minusWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
       if (i1 >= wv1->size || i2 >= wv2->size)
          break;
       if (wv1->words[i1] < wv2->words[i2]) {
-         wv_new->words[k++] = wv1->words[i1];
+         words[k++] = wv1->words[i1];
          i1++;
       } else 
       if (wv1->words[i1] > wv2->words[i2]) {
@@ -903,15 +935,11 @@ WordSet HG_(minusWS) ( WordSetU* wsu, WordSet ws1, WordSet ws2 )
    tl_assert(i1 <= wv1->size);
    tl_assert(i2 <= wv2->size);
    tl_assert(i1 == wv1->size || i2 == wv2->size);
-   if (i2 == wv2->size && i1 < wv1->size) {
-      while (i1 < wv1->size)
-         wv_new->words[k++] = wv1->words[i1++];
-   }
-
-   tl_assert(k == sz);
+   while (i1 < wv1->size)
+      words[k++] = wv1->words[i1++];
 
-   ws_new = add_or_dealloc_WordVec( wsu, wv_new );
-   if (sz == 0) {
+   ws_new = add_or_find_words( wsu, words, k );
+   if (k == 0) {
       tl_assert(ws_new == wsu->empty);
    }
 
@@ -46,7 +46,9 @@ typedef  struct _WordSetU  WordSetU;  /* opaque */
 
 typedef  UInt              WordSet;   /* opaque, small int index */
 
-/* Allocate and initialise a WordSetU */
+/* Allocate and initialise a WordSetU.  cacheSize is the number of
+   entries (rounded up to a power of 2) of each of the caches that
+   remember the results of recent operations. */
 WordSetU* HG_(newWordSetU) ( void* (*alloc_nofail)( const HChar*, SizeT ),
                              const HChar* cc,
                              void  (*dealloc)(void*),
@@ -204,6 +204,16 @@ typedef
 
 #define ThrID_MAX_VALID ((1 << SCALARTS_N_THRBITS) - 1)
 
+/* A ScalarTS viewed as a 64-bit word, and the bits of that word which
+   hold the thrid field.  The mask is computed in libhb_init, since
+   where the bitfield lands depends on the target's endianness.  If
+   two ScalarTSs have the same thrid, comparing them as unsigned words
+   gives the same answer as comparing their tym fields.  VTS__join and
+   VTS__cmpLEQ use that to handle, a word at a time, the common case
+   where both vector clocks mention the same threads. */
+#define ScalarTS__WORD(_st) (*(ULong*)(_st))
+static ULong scalarts_thrid_mask = 0;
+
 
 
 /////////////////////////////////////////////////////////////////
@@ -591,6 +601,17 @@ static inline Bool is_sane_SecMap ( SecMap* sm ) {
 #define N_WAY_BITS 16
 #define N_WAY_NENT (1 << N_WAY_BITS)
 
+/* The cache is N_SET_WAYS-way set associative.  The ways of a set are
+   kept in most-recently-used order, so the fast path in get_cacheline
+   only needs to look at the first way of a set, and the last way is the
+   one to evict.  Moving a way to the front of its set only moves its
+   CacheWay, not the CacheLine it points at.  Setting N_SET_WAYS_BITS
+   to 0 gives a direct-mapped cache. */
+#define N_SET_WAYS_BITS 2
+#define N_SET_WAYS      (1 << N_SET_WAYS_BITS)
+#define N_SET_BITS      (N_WAY_BITS - N_SET_WAYS_BITS)
+#define N_SET_NENT      (1 << N_SET_BITS)
+
 /* Each tag is the address of the associated CacheLine, rounded down
    to a CacheLine address boundary.  A CacheLine size must be a power
    of 2 and must be 8 or more.  Hence an easy way to initialise the
@@ -598,10 +619,17 @@ static inline Bool is_sane_SecMap ( SecMap* sm ) {
    != 0, eg 1.  This means all queries in the cache initially miss.
    It does however require us to detect and not writeback, any line
    with a bogus tag. */
+typedef
+   struct {
+      Addr       tag;
+      CacheLine* lyn;
+   }
+   CacheWay;
+
 typedef
    struct {
       CacheLine lyns0[N_WAY_NENT];
-      Addr      tags0[N_WAY_NENT];
+      CacheWay  ways0[N_WAY_NENT]; /* N_SET_NENT sets of N_SET_WAYS */
    }
    Cache;
 
@@ -636,6 +664,7 @@ static UWord stats__cache_F_wbacks       = 0; // # F lines written back
 static UWord stats__cache_flushes_invals = 0; // # cache flushes and invals
 static UWord stats__cache_totrefs        = 0; // # total accesses
 static UWord stats__cache_totmisses      = 0; // # misses
+static UWord stats__cache_way_hits       = 0; // # hits not in the MRU way
 static ULong stats__cache_make_New_arange = 0; // total arange made New
 static ULong stats__cache_make_New_inZrep = 0; // arange New'd on Z reps
 static UWord stats__cline_normalises     = 0; // # calls to cacheline_normalise
@@ -663,6 +692,8 @@ static UWord stats__vts__tick            = 0; // # calls to VTS__tick
 static UWord stats__vts__join            = 0; // # calls to VTS__join
 static UWord stats__vts__cmpLEQ          = 0; // # calls to VTS__cmpLEQ
 static UWord stats__vts__cmp_structural  = 0; // # calls to VTS__cmp_structural
+static UWord stats__vts__join_dense      = 0; // # VTS__join done wordwise
+static UWord stats__vts__cmpLEQ_dense    = 0; // # VTS__cmpLEQ done wordwise
 static UWord stats__vts_tab_GC           = 0; // # nr of vts_tab GC
 static UWord stats__vts_pruning          = 0; // # nr of vts pruning
 
@@ -1485,14 +1516,13 @@ void sequentialise_CacheLine ( /*OUT*/CountedSVal* dst,
    *dstUsedP = dstUsed;
 }
 
-/* Write the cacheline 'wix' to backing store.  Where it ends up
-   is determined by its tag field. */
-static __attribute__((noinline)) void cacheline_wback ( UWord wix )
+/* Write the cacheline 'cl' to backing store.  Where it ends up
+   is determined by its tag. */
+static __attribute__((noinline)) void cacheline_wback ( Addr tag,
+                                                        CacheLine* cl )
 {
    Word        i, j, k, m;
-   Addr        tag;
    SecMap*     sm;
-   CacheLine*  cl;
    LineZ* lineZ;
    LineF* lineF;
    Word        zix, fix, csvalsUsed;
@@ -1500,12 +1530,7 @@ static __attribute__((noinline)) void cacheline_wback ( UWord wix )
    SVal        sv;
 
    if (0)
-   VG_(printf)("scache wback line %d\n", (Int)wix);
-
-   tl_assert(wix >= 0 && wix < N_WAY_NENT);
-
-   tag =  cache_shmem.tags0[wix];
-   cl  = &cache_shmem.lyns0[wix];
+   VG_(printf)("scache wback line %#lx\n", tag);
 
    /* The cache line may have been invalidated; if so, ignore it. */
    if (!is_valid_scache_tag(tag))
@@ -1626,25 +1651,17 @@ static __attribute__((noinline)) void cacheline_wback ( UWord wix )
    }
 }
 
-/* Fetch the cacheline 'wix' from the backing store.  The tag
-   associated with 'wix' is assumed to have already been filled in;
-   hence that is used to determine where in the backing store to read
-   from. */
-static __attribute__((noinline)) void cacheline_fetch ( UWord wix )
+/* Fetch into the cacheline 'cl' the contents of the backing store
+   for 'tag'. */
+static __attribute__((noinline)) void cacheline_fetch ( Addr tag,
+                                                        CacheLine* cl )
 {
    Word       i;
-   Addr       tag;
-   CacheLine* cl;
    LineZ*     lineZ;
    LineF*     lineF;
 
    if (0)
-   VG_(printf)("scache fetch line %d\n", (Int)wix);
-
-   tl_assert(wix >= 0 && wix < N_WAY_NENT);
-
-   tag =  cache_shmem.tags0[wix];
-   cl  = &cache_shmem.lyns0[wix];
+   VG_(printf)("scache fetch line %#lx\n", tag);
 
    /* reject nonsense requests */
    tl_assert(is_valid_scache_tag(tag));
@@ -1673,11 +1690,30 @@ static __attribute__((noinline)) void cacheline_fetch ( UWord wix )
    normalise_CacheLine( cl );
 }
 
+/* Returns the set of ways in which the line containing 'a' can be. */
+static inline CacheWay* get_cacheset ( Addr a ) {
+   UWord six = (a >> N_LINE_BITS) & (N_SET_NENT - 1);
+   return &cache_shmem.ways0[six << N_SET_WAYS_BITS];
+}
+
+/* Returns the cacheline for 'tag' if it is in the cache, or NULL.
+   Unlike get_cacheline, this neither fetches the line nor changes the
+   order of the ways. */
+static inline CacheLine* find_cacheline ( Addr tag ) {
+   CacheWay* set = get_cacheset(tag);
+   UWord     w;
+   for (w = 0; w < N_SET_WAYS; w++) {
+      if (set[w].tag == tag)
+         return set[w].lyn;
+   }
+   return NULL;
+}
+
 /* Invalid the cachelines corresponding to the given range, which
    must start and end on a cacheline boundary. */
 static void shmem__invalidate_scache_range (Addr ga, SizeT szB)
 {
-   Word wix;
+   Word six, w;
 
    /* ga must be on a cacheline boundary. */
    tl_assert (is_valid_scache_tag (ga));
@@ -1685,18 +1721,21 @@ static void shmem__invalidate_scache_range (Addr ga, SizeT szB)
    tl_assert (0 == (szB & (N_LINE_ARANGE - 1)));
    
 
-   Word ga_ix = (ga >> N_LINE_BITS) & (N_WAY_NENT - 1);
-   Word nwix = szB / N_LINE_ARANGE;
+   Word ga_six = (ga >> N_LINE_BITS) & (N_SET_NENT - 1);
+   Word nsix = szB / N_LINE_ARANGE;
 
-   if (nwix > N_WAY_NENT)
-      nwix = N_WAY_NENT; // no need to check several times the same entry.
+   if (nsix > N_SET_NENT)
+      nsix = N_SET_NENT; // no need to check several times the same set.
 
-   for (wix = 0; wix < nwix; wix++) {
-      if (address_in_range(cache_shmem.tags0[ga_ix], ga, szB))
-         cache_shmem.tags0[ga_ix] = 1/*INVALID*/;
-      ga_ix++;
-      if (UNLIKELY(ga_ix == N_WAY_NENT))
-         ga_ix = 0;
+   for (six = 0; six < nsix; six++) {
+      CacheWay* set = &cache_shmem.ways0[ga_six << N_SET_WAYS_BITS];
+      for (w = 0; w < N_SET_WAYS; w++) {
+         if (address_in_range(set[w].tag, ga, szB))
+            set[w].tag = 1/*INVALID*/;
+      }
+      ga_six++;
+      if (UNLIKELY(ga_six == N_SET_NENT))
+         ga_six = 0;
    }
 }
 
@@ -1707,14 +1746,14 @@ static void shmem__flush_and_invalidate_scache ( void ) {
    if (0) VG_(printf)("%s","scache flush and invalidate\n");
    tl_assert(!is_valid_scache_tag(1));
    for (wix = 0; wix < N_WAY_NENT; wix++) {
-      tag = cache_shmem.tags0[wix];
+      tag = cache_shmem.ways0[wix].tag;
       if (tag == 1/*INVALID*/) {
          /* already invalid; nothing to do */
       } else {
          tl_assert(is_valid_scache_tag(tag));
-         cacheline_wback( wix );
+         cacheline_wback( tag, cache_shmem.ways0[wix].lyn );
       }
-      cache_shmem.tags0[wix] = 1/*INVALID*/;
+      cache_shmem.ways0[wix].tag = 1/*INVALID*/;
    }
    stats__cache_flushes_invals++;
 }
@@ -1752,10 +1791,10 @@ static inline CacheLine* get_cacheline ( Addr a )
    /* tag is 'a' with the in-line offset masked out, 
       eg a[31]..a[4] 0000 */
    Addr       tag = a & ~(N_LINE_ARANGE - 1);
-   UWord      wix = (a >> N_LINE_BITS) & (N_WAY_NENT - 1);
+   CacheWay*  set = get_cacheset(a);
    stats__cache_totrefs++;
-   if (LIKELY(tag == cache_shmem.tags0[wix])) {
-      return &cache_shmem.lyns0[wix];
+   if (LIKELY(tag == set[0].tag)) {
+      return set[0].lyn;
    } else {
       return get_cacheline_MISS( a );
    }
@@ -1767,31 +1806,51 @@ static __attribute__((noinline))
    /* tag is 'a' with the in-line offset masked out, 
       eg a[31]..a[4] 0000 */
 
-   CacheLine* cl;
-   Addr*      tag_old_p;
+   CacheWay   way;
    Addr       tag = a & ~(N_LINE_ARANGE - 1);
-   UWord      wix = (a >> N_LINE_BITS) & (N_WAY_NENT - 1);
+   CacheWay*  set = get_cacheset(a);
+   UWord      w;
 
-   tl_assert(tag != cache_shmem.tags0[wix]);
+   tl_assert(tag != set[0].tag);
 
-   /* Dump the old line into the backing store. */
-   stats__cache_totmisses++;
+   /* Is the line in one of the other ways ?  Else, the victim is the
+      least recently used way, unless there is an invalid one. */
+   for (w = 1; w < N_SET_WAYS; w++) {
+      if (set[w].tag == tag)
+         break;
+   }
 
-   cl        = &cache_shmem.lyns0[wix];
-   tag_old_p = &cache_shmem.tags0[wix];
+   if (w < N_SET_WAYS) {
+      stats__cache_way_hits++;
+      way = set[w];
+   } else {
+      /* Dump the old line into the backing store. */
+      stats__cache_totmisses++;
+
+      for (w = 0; w < N_SET_WAYS - 1; w++) {
+         if (!is_valid_scache_tag( set[w].tag ))
+            break;
+      }
+      way = set[w];
 
-   if (is_valid_scache_tag( *tag_old_p )) {
-      /* EXPENSIVE and REDUNDANT: callee does it */
+      if (is_valid_scache_tag( way.tag )) {
+         /* EXPENSIVE and REDUNDANT: callee does it */
+         if (CHECK_ZSM)
+            tl_assert(is_sane_CacheLine(way.lyn)); /* EXPENSIVE */
+         cacheline_wback( way.tag, way.lyn );
+      }
+      /* and reload the new one */
+      way.tag = tag;
+      cacheline_fetch( tag, way.lyn );
       if (CHECK_ZSM)
-         tl_assert(is_sane_CacheLine(cl)); /* EXPENSIVE */
-      cacheline_wback( wix );
+         tl_assert(is_sane_CacheLine(way.lyn)); /* EXPENSIVE */
    }
-   /* and reload the new one */
-   *tag_old_p = tag;
-   cacheline_fetch( wix );
-   if (CHECK_ZSM)
-      tl_assert(is_sane_CacheLine(cl)); /* EXPENSIVE */
-   return cl;
+
+   /* Make it the most recently used way. */
+   for (; w > 0; w--)
+      set[w] = set[w-1];
+   set[0] = way;
+   return way.lyn;
 }
 
 static UShort pulldown_to_32 ( /*MOD*/SVal* tree, UWord toff, UShort descr ) {
@@ -1987,7 +2046,12 @@ static void zsm_init ( void )
    /* Invalidate all cache entries. */
    tl_assert(!is_valid_scache_tag(1));
    for (UWord wix = 0; wix < N_WAY_NENT; wix++) {
-      cache_shmem.tags0[wix] = 1/*INVALID*/;
+      cache_shmem.ways0[wix].tag = 1/*INVALID*/;
+      /* Way w of consecutive sets uses consecutive CacheLines, so that
+         sequential accesses walk through the CacheLines in order. */
+      cache_shmem.ways0[wix].lyn
+         = &cache_shmem.lyns0[(wix & (N_SET_WAYS - 1)) * N_SET_NENT
+                              + (wix >> N_SET_WAYS_BITS)];
    }
 
    LineF_pool_allocator = VG_(newPA) (
@@ -2417,7 +2481,29 @@ static void VTS__join ( /*OUT*/VTS* out, VTS* a, VTS* b )
       scalarts_limitations_fail_NORETURN( True/*due_to_nThrs*/ );
    tl_assert(out->sizeTS >= useda + usedb);
 
-   ia = ib = 0;
+   /* Fast path: once a group of threads has synchronised with each
+      other, their vector clocks usually mention exactly the same
+      threads.  For as long as a and b have the same thrid at the same
+      index, the join is just a pointwise word max.  At the first
+      mismatch, drop into the general merge below. */
+   {
+      UInt   i, n = useda < usedb ? useda : usedb;
+      ULong  mask = scalarts_thrid_mask;
+      ULong* wa   = &ScalarTS__WORD(&a->ts[0]);
+      ULong* wb   = &ScalarTS__WORD(&b->ts[0]);
+      ULong* wout = &ScalarTS__WORD(&out->ts[0]);
+      for (i = 0; i < n; i++) {
+         ULong xa = wa[i], xb = wb[i];
+         if (UNLIKELY((xa ^ xb) & mask))
+            break;
+         wout[i] = xa > xb ? xa : xb;
+      }
+      if (i == useda && i == usedb)
+         stats__vts__join_dense++;
+      out->usedTS = i;
+      ncommon = i;
+      ia = ib = i;
+   }
 
    while (1) {
 
@@ -2510,7 +2596,27 @@ static UInt/*ThrID*/ VTS__cmpLEQ ( VTS* a, VTS* b )
    useda = a->usedTS;
    usedb = b->usedTS;
 
-   ia = ib = 0;
+   /* Fast path, as in VTS__join: while the thrids agree, compare
+      whole words. */
+   {
+      Word   i, n = useda < usedb ? useda : usedb;
+      ULong  mask = scalarts_thrid_mask;
+      ULong* wa   = &ScalarTS__WORD(&a->ts[0]);
+      ULong* wb   = &ScalarTS__WORD(&b->ts[0]);
+      for (i = 0; i < n; i++) {
+         ULong xa = wa[i], xb = wb[i];
+         if (UNLIKELY((xa ^ xb) & mask))
+            break;
+         if (UNLIKELY(xa > xb)) {
+            stats__vts__cmpLEQ_dense++;
+            tl_assert(a->ts[i].thrid >= 1024);
+            return a->ts[i].thrid;
+         }
+      }
+      if (i == useda && i == usedb)
+         stats__vts__cmpLEQ_dense++;
+      ia = ib = i;
+   }
 
    while (1) {
 
@@ -2609,15 +2715,12 @@ Word VTS__cmp_structural ( VTS* a, VTS* b )
    ctsb = &b->ts[0]; usedb = b->usedTS;
 
    if (LIKELY(useda == usedb)) {
-      ScalarTS *tmpa = NULL, *tmpb = NULL;
+      ULong *wa = &ScalarTS__WORD(ctsa), *wb = &ScalarTS__WORD(ctsb);
       stats__vts__cmp_structural_slow++;
       /* Same length vectors.  Find the first difference, if any, as
-         fast as possible. */
+         fast as possible, comparing each ScalarTS as a single word. */
       for (i = 0; i < useda; i++) {
-         tmpa = &ctsa[i];
-         tmpb = &ctsb[i];
-         if (LIKELY(tmpa->tym == tmpb->tym
-                    && tmpa->thrid == tmpb->thrid))
+         if (LIKELY(wa[i] == wb[i]))
             continue;
          else
             break;
@@ -2627,10 +2730,8 @@ Word VTS__cmp_structural ( VTS* a, VTS* b )
          return 0;
       } else {
          tl_assert(i >= 0 && i < useda);
-         if (tmpa->tym < tmpb->tym) return -1;
-         if (tmpa->tym > tmpb->tym) return 1;
-         if (tmpa->thrid < tmpb->thrid) return -1;
-         if (tmpa->thrid > tmpb->thrid) return 1;
+         if (wa[i] < wb[i]) return -1;
+         if (wa[i] > wb[i]) return 1;
          /* we just established them as non-identical, hence: */
       }
       /*NOTREACHED*/
@@ -4244,26 +4345,27 @@ static inline SVal Ptr2SVal (void* ptr)
 
    2. A Hash table of OldRefs.  These store information about each old
       ref that we need to record.  Hash table key is the address of the
-      location for which the information is recorded.  For LRU
-      purposes, each OldRef in the hash table is also on a doubly
-      linked list maintaining the order in which the OldRef were most
-      recently accessed.
+      location for which the information is recorded.
       Each OldRef also maintains the stamp at which it was last accessed.
       With these stamps, we can quickly check which of 2 OldRef is the
-      'newest', without having to scan the full list of LRU OldRef.
+      'newest'.
 
       The important part of an OldRef is, however, its acc component.
       This binds a TSW triple (thread, size, R/W) to an RCEC.
 
-      We allocate a maximum of VG_(clo_conflict_cache_size) OldRef.
-      Then we do exact LRU discarding.  For each discarded OldRef we must
-      of course decrement the reference count on the RCEC it
-      refers to, in order that entries from (1) eventually get
-      discarded too.
+      We allocate a maximum of VG_(clo_conflict_cache_size) OldRef,
+      which live in a ring of that many slots.  Once the ring is full,
+      OldRefs are recycled using the CLOCK approximation of LRU (see
+      alloc_or_reuse_OldRef).  This costs no pointer updates when an
+      existing OldRef is touched, and keeps each OldRef small.  For
+      each discarded OldRef we must of course decrement the reference
+      count on the RCEC it refers to, in order that entries from (1)
+      eventually get discarded too.
 */
 
 static UWord stats__evm__lookup_found = 0;
 static UWord stats__evm__lookup_notfound = 0;
+static UWord stats__evm__clock_skips = 0;
 
 static UWord stats__ctxt_eq_tsw_eq_rcec = 0;
 static UWord stats__ctxt_eq_tsw_neq_rcec = 0;
@@ -4769,8 +4871,6 @@ typedef
    struct OldRef {
       struct OldRef *ht_next; // to link hash table nodes together.
       UWord  ga; // hash_table key, == address for which we record an access.
-      struct OldRef *prev; // to refs older than this one
-      struct OldRef *next; // to refs newer that this one
       UWord stamp; // allows to order (by time of access) 2 OldRef
       Thr_n_RCEC acc;
    }
@@ -4796,68 +4896,75 @@ static Word cmp_oldref_tsw (const void* node1, const void* node2 )
 }
 
 
-//////////// BEGIN OldRef pool allocator
-static PoolAlloc* oldref_pool_allocator;
-// Note: We only allocate elements in this pool allocator, we never free them.
-// We stop allocating elements at VG_(clo_conflict_cache_size).
-//////////// END OldRef pool allocator
+//////////// BEGIN OldRef ring
+// The OldRefs live in a ring of HG_(clo_conflict_cache_size) slots.
+// The ring is allocated in chunks of OLDREF_CHUNK slots, as it fills up,
+// so that a small program does not pay for a large --conflict-cache-size.
+// Slots are never freed: once all of them are in use, the OldRef for a
+// new access is obtained by recycling an existing one.
+#define OLDREF_CHUNK_BITS 10
+#define OLDREF_CHUNK      (1 << OLDREF_CHUNK_BITS)
 
-static OldRef mru; 
-static OldRef lru; 
-// A double linked list, chaining all OldREf in a mru/lru order.
-// mru/lru are sentinel nodes.
-// Whenever an oldref is re-used, its position is changed as the most recently
-// used (i.e. pointed to by mru.prev).
-// When a new oldref is needed, it is allocated from the pool
-//  if we have not yet reached --conflict-cache-size.
-// Otherwise, if all oldref have already been allocated,
-// the least recently used (i.e. pointed to by lru.next) is re-used.
-// When an OldRef is used, it is moved as the most recently used entry
-// (i.e. pointed to by mru.prev).
+// Once the ring is full, the hand sweeps around it looking for an OldRef
+// to recycle.  An OldRef which was touched since the hand started its
+// current lap gets a second chance, and is skipped.  So as to bound the
+// cost of a single allocation, the hand recycles the OldRef it is on
+// after skipping OLDREF_MAX_SKIP of them in a row.
+#define OLDREF_MAX_SKIP 8
 
-// Removes r from the double linked list
-// Note: we do not need to test for special cases such as
-// NULL next or prev pointers, because we have sentinel nodes
-// at both sides of the list. So, a node is always forward and
-// backward linked.
-static inline void OldRef_unchain(OldRef *r)
-{
-   r->next->prev = r->prev;
-   r->prev->next = r->next;
-}
+static OldRef** oldref_chunks = NULL;
+static UWord    oldref_hand = 0;
+static UWord    oldref_lap_stamp = 0; // event_map_stamp when the lap began
 
-// Insert new as the newest OldRef
-// Similarly to OldRef_unchain, no need to test for NULL
-// pointers, as e.g. mru.prev is always guaranteed to point
-// to a non NULL node (lru when the list is empty).
-static inline void OldRef_newest(OldRef *new)
+static inline OldRef* OldRef_at ( UWord i )
 {
-   new->next = &mru;
-   new->prev = mru.prev;
-   mru.prev = new;
-   new->prev->next = new;
+   return &oldref_chunks[i >> OLDREF_CHUNK_BITS][i & (OLDREF_CHUNK - 1)];
 }
-
+//////////// END OldRef ring
 
 static VgHashTable* oldrefHT    = NULL; /* Hash table* OldRef* */
 static UWord     oldrefHTN    = 0;    /* # elems in oldrefHT */
 /* Note: the nr of ref in the oldrefHT will always be equal to
-   the nr of elements that were allocated from the OldRef pool allocator
-   as we never free an OldRef : we just re-use them. */
+   the nr of slots of the ring that are in use, as we never free
+   an OldRef : we just re-use them. */
 
+static UWord event_map_stamp = 0; // Used to stamp each OldRef when touched.
 
-/* allocates a new OldRef or re-use the lru one if all allowed OldRef
+/* allocates a new OldRef or re-use an old one if all allowed OldRef
    have already been allocated. */
 static OldRef* alloc_or_reuse_OldRef ( void )
 {
    if (oldrefHTN < HG_(clo_conflict_cache_size)) {
-      oldrefHTN++;
-      return VG_(allocEltPA) ( oldref_pool_allocator );
+      UWord i = oldrefHTN++;
+      if ((i & (OLDREF_CHUNK - 1)) == 0)
+         oldref_chunks[i >> OLDREF_CHUNK_BITS]
+            = HG_(zalloc)( "libhb.alloc_or_reuse_OldRef.1",
+                           OLDREF_CHUNK * sizeof(OldRef) );
+      if (oldrefHTN == HG_(clo_conflict_cache_size))
+         oldref_lap_stamp = event_map_stamp;
+      return OldRef_at(i);
    } else {
       OldRef *oldref_ht;
-      OldRef *oldref = lru.next;
+      OldRef *oldref;
+      UInt   nskip = 0;
+
+      while (True) {
+         oldref = OldRef_at(oldref_hand);
+         oldref_hand++;
+         if (oldref_hand == oldrefHTN) {
+            oldref_hand = 0;
+            oldref_lap_stamp = event_map_stamp;
+         }
+         /* Touched during this lap ?  Stamps are compared relative to
+            oldref_lap_stamp, in case event_map_stamp has cycled. */
+         if (nskip == OLDREF_MAX_SKIP
+             || oldref->stamp - oldref_lap_stamp
+                > event_map_stamp - oldref_lap_stamp)
+            break;
+         nskip++;
+         stats__evm__clock_skips++;
+      }
 
-      OldRef_unchain(oldref);
       oldref_ht = VG_(HT_gen_remove) (oldrefHT, oldref, cmp_oldref_tsw);
       tl_assert (oldref == oldref_ht);
       ctxt__rcdec( oldref->acc.rcec );
@@ -4889,8 +4996,6 @@ static inline Word cmp_nonempty_intervals ( Addr a1, SizeT n1,
    return 0;
 }
 
-static UWord event_map_stamp = 0; // Used to stamp each OldRef when touched.
-
 static void event_map_bind ( Addr a, SizeT szB, Bool isW, Thr* thr )
 {
    OldRef  example;
@@ -4932,9 +5037,6 @@ static void event_map_bind ( Addr a, SizeT szB, Bool isW, Thr* thr )
       ref->stamp = event_map_stamp;
       ref->acc.locksHeldW = locksHeldW;
 
-      OldRef_unchain(ref);
-      OldRef_newest(ref);
-
    } else {
       tl_assert (szB == 4 || szB == 8 ||szB == 1 || szB == 2);
       // We only need to check the size the first time we insert a ref.
@@ -4954,7 +5056,6 @@ static void event_map_bind ( Addr a, SizeT szB, Bool isW, Thr* thr )
       ctxt__rcinc(rcec);
 
       VG_(HT_add_node) ( oldrefHT, ref );
-      OldRef_newest (ref);
    }
    event_map_stamp++;
 }
@@ -5069,33 +5170,57 @@ Bool libhb_event_map_lookup ( /*OUT*/ExeContext** resEC,
 }
 
 
+/* Orders two OldRef* by the time of their last access, oldest first.
+   As in libhb_event_map_lookup, stamps are 'rolled' using
+   event_map_stamp in case it has cycled. */
+static Int cmp_oldref_stamp ( const void* v1, const void* v2 )
+{
+   const OldRef* r1 = *(const OldRef* const*)v1;
+   const OldRef* r2 = *(const OldRef* const*)v2;
+   UWord s1 = r1->stamp - event_map_stamp;
+   UWord s2 = r2->stamp - event_map_stamp;
+   if (s1 < s2) return -1;
+   if (s1 > s2) return  1;
+   return 0;
+}
+
 void libhb_event_map_access_history ( Addr a, SizeT szB, Access_t fn )
 {
-   OldRef *ref = lru.next;
+   OldRef *ref;
    SizeT ref_szB;
+   UWord i;
    Int n;
-      
-   while (ref != &mru) {
+   XArray* refs;
+
+   /* The ring is not kept in access order, so collect the OldRefs
+      overlapping [a, a+szB[ and sort them, oldest first. */
+   refs = VG_(newXA)( HG_(zalloc), "libhb.event_map_access_history.1",
+                      HG_(free), sizeof(OldRef*) );
+   VG_(setCmpFnXA)( refs, cmp_oldref_stamp );
+   for (i = 0; i < oldrefHTN; i++) {
+      ref = OldRef_at(i);
+      if (cmp_nonempty_intervals(a, szB, ref->ga, ref->acc.tsw.szB) == 0)
+         VG_(addToXA)( refs, &ref );
+   }
+   VG_(sortXA)( refs );
+
+   for (i = 0; i < VG_(sizeXA)( refs ); i++) {
+      ref = *(OldRef**)VG_(indexXA)( refs, i );
       ref_szB = ref->acc.tsw.szB;
-      if (cmp_nonempty_intervals(a, szB, ref->ga, ref_szB) == 0) {
-         RCEC* ref_rcec = ref->acc.rcec;
-         for (n = 0; n < N_FRAMES; n++) {
-            if (0 == ref_rcec->frames[n]) {
-               break;
-            }
+      RCEC* ref_rcec = ref->acc.rcec;
+      for (n = 0; n < N_FRAMES; n++) {
+         if (0 == ref_rcec->frames[n]) {
+            break;
          }
-         (*fn)(ref_rcec->frames, n,
-               Thr__from_ThrID(ref->acc.tsw.thrid),
-               ref->ga,
-               ref_szB,
-               ref->acc.tsw.isW,
-               ref->acc.locksHeldW);
       }
-      tl_assert (ref->next == &mru
-                 || ((ref->stamp - event_map_stamp)
-                        < ref->next->stamp - event_map_stamp));
-      ref = ref->next;
+      (*fn)(ref_rcec->frames, n,
+            Thr__from_ThrID(ref->acc.tsw.thrid),
+            ref->ga,
+            ref_szB,
+            ref->acc.tsw.isW,
+            ref->acc.locksHeldW);
    }
+   VG_(deleteXA)( refs );
 }
 
 static void event_map_init ( void )
@@ -5118,30 +5243,20 @@ static void event_map_init ( void )
    for (i = 0; i < N_RCEC_TAB; i++)
       contextTab[i] = NULL;
 
-   /* Oldref pool allocator */
-   oldref_pool_allocator = VG_(newPA)(
-                               sizeof(OldRef),
-                               1000 /* OldRefs per pool */,
-                               HG_(zalloc),
-                               "libhb.event_map_init.3 (OldRef pools)",
-                               HG_(free)
-                            );
+   /* Oldref ring.  Only the chunk table is allocated here, the chunks
+      themselves are allocated as the ring fills up. */
+   tl_assert(!oldref_chunks);
+   oldref_chunks
+      = HG_(zalloc)( "libhb.event_map_init.3 (OldRef ring)",
+                     ((HG_(clo_conflict_cache_size) + OLDREF_CHUNK - 1)
+                      >> OLDREF_CHUNK_BITS) * sizeof(OldRef*) );
 
    /* Oldref hashtable */
    tl_assert(!oldrefHT);
    oldrefHT = VG_(HT_construct) ("libhb.event_map_init.4 (oldref hashtable)");
 
    oldrefHTN = 0;
-   mru.prev = &lru;
-   mru.next = NULL;
-   lru.prev = NULL;
-   lru.next = &mru;
-   mru.acc = (Thr_n_RCEC) {.tsw = {.thrid = 0, 
-                                   .szB = 0, 
-                                   .isW = 0},
-                           .locksHeldW = 0, 
-                           .rcec = NULL};
-   lru.acc = mru.acc;
+   oldref_hand = 0;
 }
 
 static void event_map__check_reference_counts ( void )
@@ -6101,8 +6216,7 @@ static void zsm_sset_range ( Addr a, SizeT len, SVal svNew )
       /* tag is 'a' with the in-line offset masked out, 
          eg a[31]..a[4] 0000 */
       Addr       tag = a & ~(N_LINE_ARANGE - 1);
-      UWord      wix = (a >> N_LINE_BITS) & (N_WAY_NENT - 1);
-      if (LIKELY(tag == cache_shmem.tags0[wix])) {
+      if (LIKELY(find_cacheline(tag) != NULL)) {
          n_New_in_cache++;
       } else {
          n_New_not_in_cache++;
@@ -6144,13 +6258,11 @@ static void zsm_sset_range ( Addr a, SizeT len, SVal svNew )
 
       while (1) {
          Addr tag;
-         UWord wix;
          if (aligned_start >= after_start)
             break;
          tl_assert(get_cacheline_offset(aligned_start) == 0);
          tag = aligned_start & ~(N_LINE_ARANGE - 1);
-         wix = (aligned_start >> N_LINE_BITS) & (N_WAY_NENT - 1);
-         if (tag == cache_shmem.tags0[wix]) {
+         if (find_cacheline(tag) != NULL) {
             UWord i;
             for (i = 0; i < N_LINE_ARANGE / 8; i++)
                zsm_swrite64( aligned_start + i * 8, svNew );
@@ -6539,6 +6651,14 @@ Thr* libhb_init (
    // We will have to have to store a large number of these,
    // so make sure they're the size we expect them to be.
    STATIC_ASSERT(sizeof(ScalarTS) == 8);
+   { ScalarTS st;
+     ScalarTS__WORD(&st) = 0;
+     st.thrid = ThrID_MAX_VALID;
+     scalarts_thrid_mask = ScalarTS__WORD(&st);
+     st.tym = (1ULL << SCALARTS_N_TYMBITS) - 1;
+     tl_assert(ScalarTS__WORD(&st) == ~0ULL);
+     tl_assert(scalarts_thrid_mask != 0 && scalarts_thrid_mask != ~0ULL);
+   }
 
    /* because first 1024 unusable */
    STATIC_ASSERT(SCALARTS_N_THRBITS >= 11);
@@ -6659,8 +6779,10 @@ void libhb_shutdown ( Bool show_stats )
                   stats__secmaps_search, stats__secmaps_search_slow);
 
       VG_(printf)("%s","\n");
-      VG_(printf)("   cache: %'lu totrefs (%'lu misses)\n",
-                  stats__cache_totrefs, stats__cache_totmisses );
+      VG_(printf)("   cache: %'lu totrefs (%'lu misses,"
+                  " %'lu hits in non-MRU ways)\n",
+                  stats__cache_totrefs, stats__cache_totmisses,
+                  stats__cache_way_hits );
       VG_(printf)("   cache: %'14lu Z-fetch,    %'14lu F-fetch\n",
                   stats__cache_Z_fetches, stats__cache_F_fetches );
       VG_(printf)("   cache: %'14lu Z-wback,    %'14lu F-wback\n",
@@ -6719,6 +6841,8 @@ void libhb_shutdown ( Bool show_stats )
       VG_(printf)("%s","\n");
       VG_(printf)("   libhb: VTSops: tick %'lu,  join %'lu,  cmpLEQ %'lu\n",
                   stats__vts__tick, stats__vts__join,  stats__vts__cmpLEQ );
+      VG_(printf)("   libhb: VTSops: wordwise join %'lu,  wordwise cmpLEQ %'lu\n",
+                  stats__vts__join_dense, stats__vts__cmpLEQ_dense );
       VG_(printf)("   libhb: VTSops: cmp_structural %'lu (%'lu slow)\n",
                   stats__vts__cmp_structural, stats__vts__cmp_structural_slow);
       VG_(printf)("   libhb: VTSset: find__or__clone_and_add %'lu"
@@ -6778,6 +6902,8 @@ void libhb_shutdown ( Bool show_stats )
       tl_assert (oldrefHTN == VG_(HT_count_nodes) (oldrefHT));
       VG_(printf)( "   libhb: oldref lookup found=%lu notfound=%lu\n",
                    stats__evm__lookup_found, stats__evm__lookup_notfound);
+      VG_(printf)( "   libhb: oldref recycling skipped %'lu recently"
+                   " used entries\n", stats__evm__clock_skips);
       if (VG_(clo_verbosity) > 1)
          VG_(HT_print_stats) (oldrefHT, cmp_oldref_tsw);
       VG_(printf)( "   libhb: oldref bind tsw/rcec "
@@ -7299,13 +7425,13 @@ UWord libhb_srange_get_abits (Addr a, UChar *abits, SizeT len)
       SVal       sv = SVal_INVALID;
       Addr       b = a + i;
       Addr       tag = b & ~(N_LINE_ARANGE - 1);
-      UWord      wix = (b >> N_LINE_BITS) & (N_WAY_NENT - 1);
+      CacheLine* cl = find_cacheline(tag);
       UWord      cloff = get_cacheline_offset(b);
 
       /* Note: we do not use get_cacheline(b) to avoid creating cachelines
          and/or SecMap for non addressable bytes. */
-      if (tag == cache_shmem.tags0[wix]) {
-         CacheLine copy = cache_shmem.lyns0[wix];
+      if (cl != NULL) {
+         CacheLine copy = *cl;
          /* We work on a copy of the cacheline, as we do not want to
             record the client request as a real read.
             The below is somewhat similar to zsm_sapply08__msmcread but
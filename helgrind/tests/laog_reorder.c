@@ -0,0 +1,50 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+/* Adds a lock order edge which goes backwards in the topological
+   order Helgrind keeps of the lock order graph, but does not close a
+   cycle, so that the order has to be repaired.  Then closes a cycle
+   through that edge, which is only found if the order was repaired
+   correctly. */
+
+static pthread_mutex_t mxA, mxB, mxC, mxD;
+
+int main ( void )
+{
+   int r;
+   r = pthread_mutex_init( &mxA, NULL ); assert(r==0);
+   r = pthread_mutex_init( &mxB, NULL ); assert(r==0);
+   r = pthread_mutex_init( &mxC, NULL ); assert(r==0);
+   r = pthread_mutex_init( &mxD, NULL ); assert(r==0);
+
+   /* The order becomes C A B D. */
+   r = pthread_mutex_lock( &mxA ); assert(r==0);
+   r = pthread_mutex_lock( &mxB ); assert(r==0);
+   r = pthread_mutex_unlock( &mxB ); assert(r==0);
+   r = pthread_mutex_unlock( &mxA ); assert(r==0);
+
+   r = pthread_mutex_lock( &mxC ); assert(r==0);
+   r = pthread_mutex_lock( &mxD ); assert(r==0);
+   r = pthread_mutex_unlock( &mxD ); assert(r==0);
+   r = pthread_mutex_unlock( &mxC ); assert(r==0);
+
+   /* B before C goes against it, so C and D move after B. */
+   r = pthread_mutex_lock( &mxB ); assert(r==0);
+   r = pthread_mutex_lock( &mxC ); assert(r==0);
+   r = pthread_mutex_unlock( &mxC ); assert(r==0);
+   r = pthread_mutex_unlock( &mxB ); assert(r==0);
+
+   /* And this is an error. */
+   r = pthread_mutex_lock( &mxC ); assert(r==0);
+   r = pthread_mutex_lock( &mxB ); assert(r==0);
+   r = pthread_mutex_unlock( &mxB ); assert(r==0);
+   r = pthread_mutex_unlock( &mxC ); assert(r==0);
+
+   r = pthread_mutex_destroy( &mxA ); assert(r==0);
+   r = pthread_mutex_destroy( &mxB ); assert(r==0);
+   r = pthread_mutex_destroy( &mxC ); assert(r==0);
+   r = pthread_mutex_destroy( &mxD ); assert(r==0);
+   return 0;
+}
@@ -0,0 +1,51 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* With --sample-rate, races in rarely executed code must still be
+   reported.  Parent and child both run a hot loop on private memory,
+   which gets sampled, then modify x once with no locking. */
+
+int x = 0;
+
+static long hot_loop ( void )
+{
+   long a[100], s = 0;
+   int  i, r;
+   for (i = 0; i < 100; i++)
+      a[i] = i;
+   for (r = 0; r < 1000; r++)
+      for (i = 0; i < 100; i++)
+         s += a[i] ^ r;
+   return s;
+}
+
+void* child_fn ( void* arg )
+{
+   long s = hot_loop();
+   /* Unprotected relative to parent */
+   x++;
+   return (void*)s;
+}
+
+int main ( void )
+{
+   const struct timespec delay = { 0, 100 * 1000 * 1000 };
+   pthread_t child;
+   if (pthread_create(&child, NULL, child_fn, NULL)) {
+      perror("pthread_create");
+      exit(1);
+   }
+   hot_loop();
+   nanosleep(&delay, 0);
+   /* Unprotected relative to child */
+   x++;
+
+   if (pthread_join(child, NULL)) {
+      perror("pthread join");
+      exit(1);
+   }
+
+   return 0;
+}
@@ -151,7 +151,9 @@ extern const HChar* VG_(am_get_filename)( NSegment const * );
 extern Bool VG_(am_is_valid_for_client) ( Addr start, SizeT len, 
                                           UInt prot );
 
-/* Really just a wrapper around VG_(am_mmap_anon_float_valgrind). */
+/* Really just a wrapper around VG_(am_mmap_anon_float_valgrind).
+   With --huge-pages, the memory comes from huge page mappings, and
+   must never be unmapped. */
 extern void* VG_(am_shadow_alloc)(SizeT size);
 
 /* Unmap the given address range and update the segment array
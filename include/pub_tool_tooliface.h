@@ -621,6 +621,25 @@ void VG_(track_pre_mem_write)      (void(*f)(CorePart part, ThreadId tid,
 void VG_(track_post_mem_write)     (void(*f)(CorePart part, ThreadId tid,
                                              Addr a, SizeT size));
 
+/* These ones are called for the large memory operations that the
+   string function replacements (memcpy, memmove, memset and strlen)
+   hand to the core.  The tool should update its shadow state for the
+   whole operation and return True, in which case the core does the
+   operation natively; or return False, in which case nothing happens
+   and the replacement does the operation itself, one access at a time.
+   A tool that would report errors for the operation must return False,
+   so that they are reported in the usual way.
+
+   bulk_copy:   copy len bytes from src to dst; the ranges may overlap.
+   bulk_fill:   set len bytes at dst to the byte at val.
+   bulk_strlen: read the len bytes at str, the last of which is the
+                terminating zero. */
+void VG_(track_bulk_copy)   (Bool(*f)(ThreadId tid, Addr dst, Addr src,
+                                       SizeT len));
+void VG_(track_bulk_fill)   (Bool(*f)(ThreadId tid, Addr dst, Addr val,
+                                       SizeT len));
+void VG_(track_bulk_strlen) (Bool(*f)(ThreadId tid, Addr str, SizeT len));
+
 /* Register events.  Use VG_(set_shadow_state_area)() to set the shadow regs
    for these events.  */
 void VG_(track_pre_reg_read)  (void(*f)(CorePart part, ThreadId tid,
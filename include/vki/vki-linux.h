@@ -1291,6 +1291,12 @@ struct  vki_seminfo {
 #define VKI_MREMAP_MAYMOVE	1
 #define VKI_MREMAP_FIXED	2
 
+//----------------------------------------------------------------------
+// From linux-4.19/include/uapi/asm-generic/mman-common.h
+//----------------------------------------------------------------------
+
+#define VKI_MADV_HUGEPAGE	14	/* Worth backing with hugepages */
+
 //----------------------------------------------------------------------
 // From linux-2.6.31-rc4/include/linux/futex.h
 //----------------------------------------------------------------------
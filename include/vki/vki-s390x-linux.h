@@ -306,6 +306,7 @@ typedef struct vki_sigaltstack {
 #define VKI_MAP_PRIVATE 	0x0002	/*  */
 #define VKI_MAP_FIXED   	0x0010	/*  */
 #define VKI_MAP_ANONYMOUS	0x0020	/*  */
+#define VKI_MAP_HUGETLB	0x40000	/* create a huge page mapping */
 
 
 //----------------------------------------------------------------------
@@ -4482,6 +4482,75 @@ void mc_post_mem_write(CorePart part, ThreadId tid, Addr a, SizeT len)
    MC_(make_mem_defined)(a, len);
 }
 
+/* Bulk operations from the string function replacements.  These are
+   only taken on when Memcheck has nothing to complain about, so that
+   any errors are reported by the replacement's own loads and stores,
+   exactly as before.  is_range_ok checks that [a, a+len) is
+   addressable and, if needDefined, defined, looking at four bytes at a
+   time where it can. */
+static Bool is_range_ok ( Addr a, SizeT len, Bool needDefined )
+{
+   UWord vabits2, vabits8;
+
+   if (MC_(clo_mc_level) < 2)
+      needDefined = False;
+   while (len > 0) {
+      if (VG_IS_4_ALIGNED(a) && len >= 4) {
+         vabits8 = get_vabits8_for_aligned_word32(a);
+         /* Every byte must be defined, or at least not noaccess (00b). */
+         if (needDefined ? vabits8 != VA_BITS8_DEFINED
+                         : ((vabits8 | (vabits8 >> 1)) & 0x55) != 0x55)
+            return False;
+         a   += 4;
+         len -= 4;
+      } else {
+         vabits2 = get_vabits2(a);
+         if (needDefined ? vabits2 != VA_BITS2_DEFINED
+                         : vabits2 == VA_BITS2_NOACCESS)
+            return False;
+         a++;
+         len--;
+      }
+   }
+   return True;
+}
+
+static Bool mc_bulk_copy ( ThreadId tid, Addr dst, Addr src, SizeT len )
+{
+   Bool  tracking = MC_(clo_mc_level) == 3;
+   SizeT i;
+
+   /* With origin tracking, the origins of undefined bytes have to be
+      copied too, which is only simple if the ranges don't overlap. */
+   if (tracking && !(src+len <= dst || dst+len <= src))
+      return False;
+   if (!is_range_ok(src, len, False) || !is_range_ok(dst, len, False))
+      return False;
+   MC_(copy_address_range_state)(src, dst, len);
+   if (tracking) {
+      for (i = 0; i < len; i++) {
+         if (get_vabits2(dst+i) != VA_BITS2_DEFINED)
+            MC_(helperc_b_store1)( dst+i, MC_(helperc_b_load1)( src+i ) );
+      }
+   }
+   return True;
+}
+
+static Bool mc_bulk_fill ( ThreadId tid, Addr dst, Addr val, SizeT len )
+{
+   /* An undefined fill byte would have to be copied everywhere; just
+      let the replacement do it. */
+   if (!is_range_ok(val, 1, True) || !is_range_ok(dst, len, False))
+      return False;
+   MC_(make_mem_defined)(dst, len);
+   return True;
+}
+
+static Bool mc_bulk_strlen ( ThreadId tid, Addr str, SizeT len )
+{
+   return is_range_ok(str, len, True);
+}
+
 
 /*------------------------------------------------------------*/
 /*--- Register event handlers                              ---*/
@@ -8181,6 +8250,10 @@ static void mc_pre_clo_init(void)
    VG_(track_pre_mem_write)       ( check_mem_is_addressable );
    VG_(track_post_mem_write)      ( mc_post_mem_write );
 
+   VG_(track_bulk_copy)           ( mc_bulk_copy );
+   VG_(track_bulk_fill)           ( mc_bulk_fill );
+   VG_(track_bulk_strlen)         ( mc_bulk_strlen );
+
    VG_(track_post_reg_write)                  ( mc_post_reg_write );
    VG_(track_post_reg_write_clientcall_return)( mc_post_reg_write_clientcall );
 
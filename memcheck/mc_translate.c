@@ -1579,6 +1579,9 @@ static void complainIfUndefined ( MCEnv* mce, IRAtom* atom, IRExpr *guard )
    di = unsafeIRDirty_0_N( nargs/*regparms*/, nm, 
                            VG_(fnptr_to_fnentry)( fn ), args );
    di->guard = cond; // and cond is PCast-to-1(atom#)
+   /* Complaints are hardly ever issued, so the call can be moved
+      out of the hot path. */
+   di->cold = True;
 
    /* If the complaint is to be issued under a guard condition, AND
       that into the guard condition for the helper call. */
@@ -5136,6 +5139,13 @@ IRExpr* expr2vbits_Unop ( MCEnv* mce, IROp op, IRAtom* atom )
       case Iop_Widen16Uto32x4:
       case Iop_Widen32Sto64x2:
       case Iop_Widen32Uto64x2:
+         /* Every result bit is either zero or a copy of one arg bit,
+            so widening the shadow the same way is exact.  The arm64
+            front end widens with these (SXTL, UXTL, SSHLL #0 ..), and
+            used to do so with interleaves and shifts, which were
+            exact too. */
+         return assignNew('V', mce, Ity_V128, unop(op, vatom));
+
       case Iop_F16toF32x4:
          return vectorWidenI64(mce, op, vatom);
 
@@ -0,0 +1,31 @@
+/* As lazy-pc.c, for the 32-byte load and store helpers. */
+
+#include "../../memcheck.h"
+
+__attribute__((noinline))
+static void load32 ( const char* p )
+{
+   __asm__ __volatile__("nop; nop; nop");
+   __asm__ __volatile__("vmovdqu (%0), %%ymm0" : : "r"(p) : "xmm0");
+}
+
+__attribute__((noinline))
+static void store32 ( char* p )
+{
+   __asm__ __volatile__("nop; nop; nop");
+   __asm__ __volatile__("vmovdqu %%ymm0, (%0)" : : "r"(p) : "memory");
+}
+
+static char noaccess[512] __attribute__((aligned(64)));
+
+/* Volatile, so that the compiler does not specialise the functions
+   above for this argument. */
+static char* volatile noaccess_p = noaccess;
+
+int main ( void )
+{
+   VALGRIND_MAKE_MEM_NOACCESS(noaccess, sizeof(noaccess));
+   load32(noaccess_p);
+   store32(noaccess_p);
+   return 0;
+}
@@ -0,0 +1,58 @@
+/* Checks that errors found in Memcheck's helpers are reported at the
+   right instruction when the guest PC is only brought up to date on
+   demand (--px-lazy-pc=yes, the default on amd64).  Each access is
+   preceded by other instructions of the same superblock, so that a
+   stale guest PC would show up as a wrong line number. */
+
+#include "../../memcheck.h"
+
+__attribute__((noinline))
+static void load16 ( const char* p )
+{
+   __asm__ __volatile__("nop; nop; nop");
+   __asm__ __volatile__("movdqu (%0), %%xmm0" : : "r"(p) : "xmm0");
+}
+
+__attribute__((noinline))
+static void store16 ( char* p )
+{
+   __asm__ __volatile__("nop; nop; nop");
+   __asm__ __volatile__("movdqu %%xmm0, (%0)" : : "r"(p) : "memory");
+}
+
+__attribute__((noinline))
+static void fxsave_to ( char* p )
+{
+   __asm__ __volatile__("nop; nop; nop");
+   __asm__ __volatile__("fxsave64 (%0)" : : "r"(p) : "memory");
+}
+
+static char buf[512] __attribute__((aligned(64)));
+static char noaccess[512] __attribute__((aligned(64)));
+
+/* Volatile, so that the compiler does not specialise the functions
+   above for these arguments. */
+static char* volatile buf_p = buf;
+static char* volatile noaccess_p = noaccess;
+
+int main ( void )
+{
+   char* undef_ptr;
+
+   VALGRIND_MAKE_MEM_NOACCESS(noaccess, sizeof(noaccess));
+
+   /* An undefined address, reported from a dirty helper. */
+   undef_ptr = buf_p;
+   VALGRIND_MAKE_MEM_UNDEFINED(&undef_ptr, sizeof(undef_ptr));
+   load16(undef_ptr);
+
+   /* Unaddressable 16-byte accesses, reported from the vector load
+      and store helpers. */
+   load16(noaccess_p);
+   store16(noaccess_p);
+
+   /* Unaddressable memory written by an insn done in a dirty helper. */
+   fxsave_to(noaccess_p);
+
+   return 0;
+}
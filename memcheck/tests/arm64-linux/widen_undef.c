@@ -0,0 +1,73 @@
+/* Checks that Memcheck tracks definedness exactly, bit by bit, through
+   the SXTL/UXTL family of vector widens.  The inputs are partially
+   defined bytes, and the V bits of the results are printed. */
+
+#include <stdio.h>
+#include "../../memcheck.h"
+
+typedef  unsigned char  UChar;
+
+static UChar in[16] __attribute__((aligned(16)));
+static UChar out[16] __attribute__((aligned(16)));
+
+#define GEN_WIDEN(_name, _insn)                      \
+   static void _name ( void )                        \
+   {                                                 \
+      __asm__ __volatile__(                          \
+         "ldr q0, [%0]\n\t"                          \
+         _insn "\n\t"                                \
+         "str q1, [%1]\n\t"                          \
+         : : "r"(in), "r"(out) : "v0", "v1", "memory"); \
+   }
+
+GEN_WIDEN(t_uxtl_8h,   "uxtl v1.8h, v0.8b")
+GEN_WIDEN(t_sxtl_8h,   "sxtl v1.8h, v0.8b")
+GEN_WIDEN(t_uxtl_4s,   "uxtl v1.4s, v0.4h")
+GEN_WIDEN(t_sxtl_4s,   "sxtl v1.4s, v0.4h")
+GEN_WIDEN(t_uxtl_2d,   "uxtl v1.2d, v0.2s")
+GEN_WIDEN(t_sxtl_2d,   "sxtl v1.2d, v0.2s")
+GEN_WIDEN(t_ushll_8h,  "ushll v1.8h, v0.8b, #0")
+GEN_WIDEN(t_sshll_4s,  "sshll v1.4s, v0.4h, #0")
+GEN_WIDEN(t_uxtl2_8h,  "uxtl2 v1.8h, v0.16b")
+GEN_WIDEN(t_sxtl2_8h,  "sxtl2 v1.8h, v0.16b")
+
+static void show_vbits ( const char* name )
+{
+   UChar vbits[16];
+   int i;
+   if (VALGRIND_GET_VBITS(out, vbits, 16) != 1) {
+      printf("%-8s: can't get V bits\n", name);
+      return;
+   }
+   printf("%-8s:", name);
+   for (i = 15; i >= 0; i--)
+      printf("%s%02x", (i % 8) == 7 ? " " : "", (unsigned)vbits[i]);
+   printf("\n");
+}
+
+int main ( void )
+{
+   UChar undef[16];
+   int i;
+
+   for (i = 0; i < 16; i++)
+      in[i] = 0x11 * i;
+   VALGRIND_MAKE_MEM_UNDEFINED(undef, sizeof(undef));
+   in[1]  = undef[1] & 0x7F;   /* all but the sign bit undefined */
+   in[2]  = undef[2] | 0x7F;   /* only the sign bit undefined */
+   in[5]  = undef[5];          /* all undefined */
+   in[9]  = undef[9] & 0x0F;   /* low nibble undefined */
+   in[13] = undef[13] | 0x7F;  /* only the sign bit undefined */
+
+   t_uxtl_8h();  show_vbits("uxtl.8h");
+   t_sxtl_8h();  show_vbits("sxtl.8h");
+   t_uxtl_4s();  show_vbits("uxtl.4s");
+   t_sxtl_4s();  show_vbits("sxtl.4s");
+   t_uxtl_2d();  show_vbits("uxtl.2d");
+   t_sxtl_2d();  show_vbits("sxtl.2d");
+   t_ushll_8h(); show_vbits("ushll.8h");
+   t_sshll_4s(); show_vbits("sshll.4s");
+   t_uxtl2_8h(); show_vbits("uxtl2.8h");
+   t_sxtl2_8h(); show_vbits("sxtl2.8h");
+   return 0;
+}
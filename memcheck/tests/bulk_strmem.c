@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Large memcpy/memset/strlen calls are handed to memcheck as a whole
+// range rather than done byte by byte.  Check that doing so neither
+// loses V bits nor hides errors the byte-by-byte versions would report.
+#define N 4096
+
+int main ( void )
+{
+   char *a = malloc(N), *b = malloc(N), *u = malloc(N), *s = malloc(1000);
+   size_t len;
+
+   // All defined: no errors.
+   memset(a, 'x', N - 1);
+   a[N - 1] = 0;
+   memcpy(b, a, N);
+   len = strlen(b);
+   printf("len %zu\n", len);
+
+   // Copying undefined bytes is fine, but they stay undefined.
+   memcpy(b, u, N);
+   if (b[N / 2] == 'x')
+      printf("b[N/2] is 'x'\n");
+
+   // An undefined byte well past the start of the string.
+   memset(u, 'y', N - 1);
+   u[N - 1] = 0;
+   u[N - 100] = b[N / 2];
+   len = strlen(u);
+   printf("len %s\n", len > 0 ? "nonzero" : "zero");
+
+   // A string running off the end of its block.
+   memset(s, 'z', 1000);
+   len = strlen(s);
+   printf("len %s\n", len >= 1000 ? "at least 1000" : "short");
+
+   free(a);
+   free(b);
+   free(u);
+   free(s);
+   return 0;
+}
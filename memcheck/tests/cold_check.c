@@ -0,0 +1,42 @@
+// The calls that report undefined values are marked as cold, and the
+// amd64 and arm64 back ends emit them out of line, after the hot code
+// of the translation.  Check that the failing checks are reported,
+// and that the hot code carries on correctly after each such call,
+// with the values that were live across the call intact.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../memcheck.h"
+
+#define N 1000
+
+static int n_big;
+
+__attribute__((noinline))
+static int step(int x, int u, int a, int b, int c)
+{
+   int r = a * 3 + b * 5 + c * 7;
+   if (u > N / 2)
+      n_big++;
+   return r + x + a + b + c;
+}
+
+int main(void)
+{
+   int* u = malloc(N * sizeof(int));
+   long sum = 0;
+   int i;
+
+   for (i = 0; i < N; i++)
+      u[i] = i;
+   // Every fourth value is undefined, but still known to the program.
+   for (i = 0; i < N; i += 4)
+      (void) VALGRIND_MAKE_MEM_UNDEFINED(&u[i], sizeof(int));
+
+   for (i = 0; i < N; i++)
+      sum += step(i, u[i], i + 1, i + 2, i + 3);
+
+   printf("sum %ld, %d big\n", sum, n_big);
+   free(u);
+   return 0;
+}
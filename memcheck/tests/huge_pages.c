@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../memcheck.h"
+
+/* Touches enough memory for Memcheck to need a few hundred secondary
+   maps, which with --huge-pages are carved out of huge page mappings,
+   and checks that their V bits are right. */
+
+#define N_CHUNKS  512
+#define CHUNK_SZB 65536
+
+int main ( void )
+{
+   char* buf = malloc(N_CHUNKS * CHUNK_SZB);
+   unsigned char vbits[2];
+   int i, n_defined = 0, n_undefined = 0;
+
+   (void) VALGRIND_MAKE_MEM_UNDEFINED(buf, N_CHUNKS * CHUNK_SZB);
+   for (i = 0; i < N_CHUNKS; i++)
+      buf[i * CHUNK_SZB] = i;
+
+   for (i = 0; i < N_CHUNKS; i++) {
+      if (VALGRIND_GET_VBITS(&buf[i * CHUNK_SZB], vbits, 2) != 1) {
+         fprintf(stderr, "VALGRIND_GET_VBITS failed\n");
+         return 1;
+      }
+      if (vbits[0] == 0x00)
+         n_defined++;
+      if (vbits[1] == 0xff)
+         n_undefined++;
+   }
+   printf("%d chunks written, %d undefined after them\n",
+          n_defined, n_undefined);
+
+   free(buf);
+   return 0;
+}
@@ -0,0 +1,282 @@
+/* Checks the V256 operations for which the amd64 back end generates
+   256-bit AVX2 code on AVX2 hosts, rather than pairs of 128-bit
+   operations.  The last tests mix them with 128-bit SSE code in the
+   same block, and keep more 256-bit values live than there are
+   256-bit registers for them, so that some get spilled. */
+
+#include <stdio.h>
+#include <string.h>
+
+typedef  unsigned char           UChar;
+typedef  unsigned int            UInt;
+typedef  unsigned long long int  ULong;
+
+typedef  union { UChar u8[32]; UInt u32[8]; ULong u64[4];
+                 float f32[8]; double f64[4]; }  YMM;
+
+#define N_VECS 4
+
+static YMM ivecs[N_VECS] __attribute__((aligned(32)));
+static YMM fvecs[N_VECS] __attribute__((aligned(32)));
+static YMM dvecs[N_VECS] __attribute__((aligned(32)));
+
+static UChar randUChar ( void )
+{
+   static UInt seed = 80021;
+   seed = 1103515245 * seed + 12345;
+   return (seed >> 17) & 0xFF;
+}
+
+static void init_vecs ( void )
+{
+   int i, j;
+   for (i = 0; i < N_VECS; i++) {
+      for (j = 0; j < 32; j++)
+         ivecs[i].u8[j] = randUChar();
+      /* Values near the saturation limits and equal lanes, so that
+         the saturating ops and the compares have work to do. */
+      if (i == 1) {
+         ivecs[i].u8[3]  = 0x7F;
+         ivecs[i].u8[17] = 0x80;
+         ivecs[i].u32[5] = ivecs[0].u32[5];
+      }
+      if (i == 2)
+         ivecs[i].u64[2] = ivecs[0].u64[2];
+      for (j = 0; j < 8; j++)
+         fvecs[i].f32[j] = (float)(ivecs[i].u8[j] - 128) / 4.0f;
+      for (j = 0; j < 4; j++)
+         dvecs[i].f64[j] = (double)(ivecs[i].u8[j + 8] - 128) / 8.0;
+   }
+   fvecs[2].f32[6] = fvecs[0].f32[6];
+   dvecs[3].f64[1] = dvecs[1].f64[1];
+}
+
+static void showYMM ( const YMM* vec )
+{
+   int i;
+   for (i = 31; i >= 0; i--) {
+      printf("%02x", (UInt)vec->u8[i]);
+      if (i > 0 && 0 == (i & 7)) printf(".");
+   }
+}
+
+/* r = insn %ymm(b), %ymm(a) */
+#define GEN_BINARY(_name, _insn)                                 \
+   static void _name ( const YMM* a, const YMM* b, YMM* r )      \
+   {                                                             \
+      __asm__ __volatile__(                                      \
+         "vmovdqu (%0), %%ymm8\n\t"                              \
+         "vmovdqu (%1), %%ymm9\n\t"                              \
+         _insn " %%ymm9, %%ymm8, %%ymm10\n\t"                    \
+         "vmovdqu %%ymm10, (%2)\n\t"                             \
+         : : "r"(a), "r"(b), "r"(r)                              \
+         : "xmm8", "xmm9", "xmm10", "memory");                   \
+   }
+
+/* r = insn $imm, %ymm(a) */
+#define GEN_SHIFT(_name, _insn, _imm)                            \
+   static void _name ( const YMM* a, const YMM* b, YMM* r )      \
+   {                                                             \
+      (void)b;                                                   \
+      __asm__ __volatile__(                                      \
+         "vmovdqu (%0), %%ymm8\n\t"                              \
+         _insn " $" #_imm ", %%ymm8, %%ymm10\n\t"                \
+         "vmovdqu %%ymm10, (%1)\n\t"                             \
+         : : "r"(a), "r"(r)                                      \
+         : "xmm8", "xmm10", "memory");                           \
+   }
+
+GEN_BINARY(t_vpand,     "vpand")
+GEN_BINARY(t_vpor,      "vpor")
+GEN_BINARY(t_vpxor,     "vpxor")
+GEN_BINARY(t_vpandn,    "vpandn")
+GEN_BINARY(t_vpaddb,    "vpaddb")
+GEN_BINARY(t_vpaddw,    "vpaddw")
+GEN_BINARY(t_vpaddd,    "vpaddd")
+GEN_BINARY(t_vpaddq,    "vpaddq")
+GEN_BINARY(t_vpsubb,    "vpsubb")
+GEN_BINARY(t_vpsubw,    "vpsubw")
+GEN_BINARY(t_vpsubd,    "vpsubd")
+GEN_BINARY(t_vpsubq,    "vpsubq")
+GEN_BINARY(t_vpaddsb,   "vpaddsb")
+GEN_BINARY(t_vpaddsw,   "vpaddsw")
+GEN_BINARY(t_vpaddusb,  "vpaddusb")
+GEN_BINARY(t_vpaddusw,  "vpaddusw")
+GEN_BINARY(t_vpsubsb,   "vpsubsb")
+GEN_BINARY(t_vpsubsw,   "vpsubsw")
+GEN_BINARY(t_vpsubusb,  "vpsubusb")
+GEN_BINARY(t_vpsubusw,  "vpsubusw")
+GEN_BINARY(t_vpmullw,   "vpmullw")
+GEN_BINARY(t_vpmulhuw,  "vpmulhuw")
+GEN_BINARY(t_vpmulhw,   "vpmulhw")
+GEN_BINARY(t_vpavgb,    "vpavgb")
+GEN_BINARY(t_vpavgw,    "vpavgw")
+GEN_BINARY(t_vpminub,   "vpminub")
+GEN_BINARY(t_vpmaxub,   "vpmaxub")
+GEN_BINARY(t_vpminsw,   "vpminsw")
+GEN_BINARY(t_vpmaxsw,   "vpmaxsw")
+GEN_BINARY(t_vpcmpeqb,  "vpcmpeqb")
+GEN_BINARY(t_vpcmpeqw,  "vpcmpeqw")
+GEN_BINARY(t_vpcmpeqd,  "vpcmpeqd")
+GEN_BINARY(t_vpcmpeqq,  "vpcmpeqq")
+GEN_BINARY(t_vpcmpgtb,  "vpcmpgtb")
+GEN_BINARY(t_vpcmpgtw,  "vpcmpgtw")
+GEN_BINARY(t_vpcmpgtd,  "vpcmpgtd")
+GEN_BINARY(t_vpcmpgtq,  "vpcmpgtq")
+
+GEN_SHIFT(t_vpsllw,  "vpsllw", 5)
+GEN_SHIFT(t_vpslld,  "vpslld", 13)
+GEN_SHIFT(t_vpsllq,  "vpsllq", 35)
+GEN_SHIFT(t_vpsrlw,  "vpsrlw", 3)
+GEN_SHIFT(t_vpsrld,  "vpsrld", 17)
+GEN_SHIFT(t_vpsrlq,  "vpsrlq", 40)
+GEN_SHIFT(t_vpsraw,  "vpsraw", 7)
+GEN_SHIFT(t_vpsrad,  "vpsrad", 21)
+
+GEN_BINARY(t_vaddps,    "vaddps")
+GEN_BINARY(t_vsubps,    "vsubps")
+GEN_BINARY(t_vmulps,    "vmulps")
+GEN_BINARY(t_vdivps,    "vdivps")
+GEN_BINARY(t_vminps,    "vminps")
+GEN_BINARY(t_vmaxps,    "vmaxps")
+GEN_BINARY(t_vaddpd,    "vaddpd")
+GEN_BINARY(t_vsubpd,    "vsubpd")
+GEN_BINARY(t_vmulpd,    "vmulpd")
+GEN_BINARY(t_vdivpd,    "vdivpd")
+GEN_BINARY(t_vminpd,    "vminpd")
+GEN_BINARY(t_vmaxpd,    "vmaxpd")
+
+/* Builds a 256-bit value from two 128-bit halves, and splits it
+   again, the high half going through a 128-bit SSE add. */
+static void t_halves ( const YMM* a, const YMM* b, YMM* r )
+{
+   __asm__ __volatile__(
+      "vmovdqu (%0), %%ymm8\n\t"
+      "vmovdqu (%1), %%ymm9\n\t"
+      "vinserti128 $1, %%xmm9, %%ymm8, %%ymm10\n\t"
+      "vpaddd %%ymm8, %%ymm10, %%ymm10\n\t"
+      "vextracti128 $1, %%ymm10, %%xmm11\n\t"
+      "paddd %%xmm8, %%xmm11\n\t"
+      "vinserti128 $0, %%xmm11, %%ymm10, %%ymm10\n\t"
+      "vmovdqu %%ymm10, (%2)\n\t"
+      : : "r"(a), "r"(b), "r"(r)
+      : "xmm8", "xmm9", "xmm10", "xmm11", "memory");
+}
+
+/* 256-bit ops interleaved with 128-bit SSE integer, float and
+   conversion ops, in one block. */
+static void t_mixed ( const YMM* a, const YMM* b, YMM* r )
+{
+   __asm__ __volatile__(
+      "vmovdqu (%0), %%ymm8\n\t"
+      "vmovdqu (%1), %%ymm9\n\t"
+      "movdqu (%0), %%xmm1\n\t"
+      "movdqu 16(%1), %%xmm2\n\t"
+      "vpaddw %%ymm9, %%ymm8, %%ymm10\n\t"
+      "paddw %%xmm2, %%xmm1\n\t"
+      "pshufd $0x1b, %%xmm1, %%xmm3\n\t"
+      "vpxor %%ymm10, %%ymm9, %%ymm11\n\t"
+      "psubq %%xmm3, %%xmm2\n\t"
+      "movl 8(%0), %%eax\n\t"
+      "cvtsi2sdl %%eax, %%xmm4\n\t"
+      "sqrtsd %%xmm4, %%xmm4\n\t"
+      "cvtsd2ss %%xmm4, %%xmm5\n\t"
+      "vpslld $3, %%ymm11, %%ymm11\n\t"
+      "punpcklbw %%xmm2, %%xmm3\n\t"
+      "vpcmpgtw %%ymm8, %%ymm11, %%ymm12\n\t"
+      "vpand %%ymm12, %%ymm10, %%ymm10\n\t"
+      "vmovdqu %%ymm10, (%2)\n\t"
+      "movdqu %%xmm3, 32(%2)\n\t"
+      "movsd %%xmm4, 48(%2)\n\t"
+      "movss %%xmm5, 56(%2)\n\t"
+      "movl $0, 60(%2)\n\t"
+      : : "r"(a), "r"(b), "r"(r)
+      : "rax", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5",
+        "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "memory");
+}
+
+/* Twelve 256-bit values live at once. */
+static void t_pressure ( const YMM* a, const YMM* b, YMM* r )
+{
+   __asm__ __volatile__(
+      "vmovdqu (%0), %%ymm0\n\t"
+      "vmovdqu (%1), %%ymm1\n\t"
+      "vpaddb  %%ymm1, %%ymm0, %%ymm2\n\t"
+      "vpsubw  %%ymm1, %%ymm0, %%ymm3\n\t"
+      "vpxor   %%ymm2, %%ymm3, %%ymm4\n\t"
+      "vpaddq  %%ymm4, %%ymm0, %%ymm5\n\t"
+      "vpor    %%ymm5, %%ymm1, %%ymm6\n\t"
+      "vpsrlq  $9, %%ymm6, %%ymm7\n\t"
+      "vpmullw %%ymm7, %%ymm2, %%ymm8\n\t"
+      "vpavgb  %%ymm8, %%ymm3, %%ymm9\n\t"
+      "vpminub %%ymm9, %%ymm4, %%ymm10\n\t"
+      "vpsubd  %%ymm10, %%ymm5, %%ymm11\n\t"
+      "vpaddd  %%ymm0, %%ymm11, %%ymm11\n\t"
+      "vpxor   %%ymm1, %%ymm11, %%ymm11\n\t"
+      "vpaddd  %%ymm2, %%ymm11, %%ymm11\n\t"
+      "vpxor   %%ymm3, %%ymm11, %%ymm11\n\t"
+      "vpaddd  %%ymm4, %%ymm11, %%ymm11\n\t"
+      "vpxor   %%ymm5, %%ymm11, %%ymm11\n\t"
+      "vpaddd  %%ymm6, %%ymm11, %%ymm11\n\t"
+      "vpxor   %%ymm7, %%ymm11, %%ymm11\n\t"
+      "vpaddd  %%ymm8, %%ymm11, %%ymm11\n\t"
+      "vpxor   %%ymm9, %%ymm11, %%ymm11\n\t"
+      "vpaddd  %%ymm10, %%ymm11, %%ymm11\n\t"
+      "vmovdqu %%ymm11, (%2)\n\t"
+      : : "r"(a), "r"(b), "r"(r)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6",
+        "xmm7", "xmm8", "xmm9", "xmm10", "xmm11", "memory");
+}
+
+typedef  void (*TestFn)( const YMM*, const YMM*, YMM* );
+
+typedef  enum { Int, F32, F64 }  Kind;
+
+typedef  struct { const char* name; TestFn fn; Kind kind; int nres; }  Test;
+
+#define T(_name, _kind) { #_name, t_##_name, _kind, 1 }
+
+static const Test tests[] = {
+   T(vpand, Int), T(vpor, Int), T(vpxor, Int), T(vpandn, Int),
+   T(vpaddb, Int), T(vpaddw, Int), T(vpaddd, Int), T(vpaddq, Int),
+   T(vpsubb, Int), T(vpsubw, Int), T(vpsubd, Int), T(vpsubq, Int),
+   T(vpaddsb, Int), T(vpaddsw, Int), T(vpaddusb, Int), T(vpaddusw, Int),
+   T(vpsubsb, Int), T(vpsubsw, Int), T(vpsubusb, Int), T(vpsubusw, Int),
+   T(vpmullw, Int), T(vpmulhuw, Int), T(vpmulhw, Int),
+   T(vpavgb, Int), T(vpavgw, Int),
+   T(vpminub, Int), T(vpmaxub, Int), T(vpminsw, Int), T(vpmaxsw, Int),
+   T(vpcmpeqb, Int), T(vpcmpeqw, Int), T(vpcmpeqd, Int), T(vpcmpeqq, Int),
+   T(vpcmpgtb, Int), T(vpcmpgtw, Int), T(vpcmpgtd, Int), T(vpcmpgtq, Int),
+   T(vpsllw, Int), T(vpslld, Int), T(vpsllq, Int),
+   T(vpsrlw, Int), T(vpsrld, Int), T(vpsrlq, Int),
+   T(vpsraw, Int), T(vpsrad, Int),
+   T(vaddps, F32), T(vsubps, F32), T(vmulps, F32), T(vdivps, F32),
+   T(vminps, F32), T(vmaxps, F32),
+   T(vaddpd, F64), T(vsubpd, F64), T(vmulpd, F64), T(vdivpd, F64),
+   T(vminpd, F64), T(vmaxpd, F64),
+   T(halves, Int), { "mixed", t_mixed, Int, 2 }, T(pressure, Int)
+};
+
+int main ( void )
+{
+   static YMM res[2] __attribute__((aligned(32)));
+   const YMM* vecs;
+   int i, j, k;
+
+   init_vecs();
+   for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+      vecs = tests[i].kind == F32 ? fvecs
+             : tests[i].kind == F64 ? dvecs : ivecs;
+      printf("%s\n", tests[i].name);
+      for (j = 0; j < N_VECS; j++) {
+         memset(res, 0x55, sizeof(res));
+         tests[i].fn(&vecs[j], &vecs[(j + 1) % N_VECS], &res[0]);
+         for (k = 0; k < tests[i].nres; k++) {
+            printf("  ");
+            showYMM(&res[k]);
+            printf("\n");
+         }
+      }
+   }
+   return 0;
+}
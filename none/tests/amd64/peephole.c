@@ -0,0 +1,119 @@
+/* Exercises the peephole rewrites done on register allocated amd64
+   code.  Each function below produces one of the instruction pairs the
+   rewrites merge, and the results are printed so that any code
+   rewritten wrongly shows up as a difference from the native run. */
+
+#include <stdio.h>
+
+typedef  unsigned long long int  ULong;
+
+/* Calls and returns.  Without iropt, the block ending in a return or
+   an indirect call stores the target to the guest %rip and loads it
+   straight back for the jump, and reload forwarding turns the load
+   into a register copy. */
+__attribute__((noinline))
+static ULong rotate ( ULong a, ULong n )
+{
+   return (a << (n & 63)) | (a >> (-n & 63));
+}
+
+static ULong (* volatile rotate_ptr) ( ULong, ULong ) = rotate;
+
+/* Widening multiplies by constants.  The instruction selector loads the
+   constant into a register and then copies it to %rax, and immediate
+   forwarding turns that into a single move of the constant. */
+static void mul_by_const ( ULong a, /*OUT*/ULong* hi, /*OUT*/ULong* lo )
+{
+   ULong h, l;
+   __asm__ __volatile__(
+      "movq %2, %%rax\n\t"
+      "movl $8, %%ecx\n\t"
+      "mulq %%rcx\n\t"
+      "movq $0x12345678, %%rcx\n\t"
+      "mulq %%rcx\n\t"
+      "movq %%rdx, %0\n\t"
+      "movq %%rax, %1\n\t"
+      : "=r"(h), "=r"(l) : "r"(a)
+      : "rax", "rcx", "rdx", "cc");
+   *hi = h;
+   *lo = l;
+}
+
+/* More live values than there are registers, so that the allocator
+   spills, reloads and rematerialises around the constants. */
+static void pressure ( ULong* arr )
+{
+   __asm__ __volatile__(
+      "movq   0(%0), %%rax\n\t"
+      "movq   8(%0), %%rbx\n\t"
+      "movq  16(%0), %%rcx\n\t"
+      "movq  24(%0), %%rdx\n\t"
+      "movq  32(%0), %%rsi\n\t"
+      "movq  40(%0), %%r8\n\t"
+      "movq  48(%0), %%r9\n\t"
+      "movq  56(%0), %%r10\n\t"
+      "movq  64(%0), %%r11\n\t"
+      "movq  72(%0), %%r12\n\t"
+      "movq  80(%0), %%r13\n\t"
+      "movq  88(%0), %%r14\n\t"
+      "movq  96(%0), %%r15\n\t"
+      "imulq %%rbx, %%rax\n\t"
+      "imulq %%rcx, %%rbx\n\t"
+      "imulq %%rdx, %%rcx\n\t"
+      "imulq %%rsi, %%rdx\n\t"
+      "imulq %%r8,  %%rsi\n\t"
+      "imulq %%r9,  %%r8\n\t"
+      "imulq %%r10, %%r9\n\t"
+      "imulq %%r11, %%r10\n\t"
+      "imulq %%r12, %%r11\n\t"
+      "imulq %%r13, %%r12\n\t"
+      "imulq %%r14, %%r13\n\t"
+      "imulq %%r15, %%r14\n\t"
+      "imulq %%rax, %%r15\n\t"
+      "movq  $0x1234567, 104(%0)\n\t"
+      "addq  $0x7654321, %%rax\n\t"
+      "andq  $0x0ff0ff0, %%rbx\n\t"
+      "xorq  $-17, %%rcx\n\t"
+      "cmpq  $99, %%rdx\n\t"
+      "adcq  %%rsi, %%rax\n\t"
+      "movq  %%rax, 112(%0)\n\t"
+      "movq  %%rbx, 120(%0)\n\t"
+      "movq  %%rcx, 128(%0)\n\t"
+      "movq  %%rdx, 136(%0)\n\t"
+      "movq  %%rsi, 144(%0)\n\t"
+      "movq  %%r8,  152(%0)\n\t"
+      "movq  %%r9,  160(%0)\n\t"
+      "movq  %%r10, 168(%0)\n\t"
+      "movq  %%r11, 176(%0)\n\t"
+      "movq  %%r12, 184(%0)\n\t"
+      "movq  %%r13, 192(%0)\n\t"
+      "movq  %%r14, 200(%0)\n\t"
+      "movq  %%r15, 208(%0)\n\t"
+      : : "D"(arr)
+      : "rax", "rbx", "rcx", "rdx", "rsi", "r8", "r9", "r10", "r11",
+        "r12", "r13", "r14", "r15", "memory", "cc");
+}
+
+int main ( void )
+{
+   ULong arr[27], hi, lo;
+   int i;
+
+   for (i = 0; i < 4; i++)
+      printf("rotate        %016llx %016llx\n",
+             rotate(0x0123456789abcdefULL, 4 * i + 1),
+             rotate_ptr(0xfedcba9876543210ULL, 60 - 8 * i));
+
+   for (i = 0; i < 4; i++) {
+      mul_by_const(0xfedcba9876543210ULL >> i, &hi, &lo);
+      printf("mul_by_const  %016llx %016llx\n", hi, lo);
+   }
+
+   for (i = 0; i < 13; i++)
+      arr[i] = 0x0123456789abcdefULL * (i + 3);
+   pressure(arr);
+   for (i = 13; i < 27; i++)
+      printf("pressure      %016llx\n", arr[i]);
+
+   return 0;
+}
@@ -0,0 +1,162 @@
+/* Check REP-prefixed string instructions, in particular around the
+   boundaries of the unrolled and vectorised parts of their
+   translations: short and long counts, overlapping copies, both
+   directions and all element sizes. */
+
+#include <stdio.h>
+#include <string.h>
+
+typedef  unsigned long long int  ULong;
+typedef  unsigned char           UChar;
+
+#define BUF_SIZE 4096
+
+static UChar buf1[BUF_SIZE];
+
+static const ULong counts[]
+   = { 0, 1, 7, 8, 9, 15, 16, 17, 63, 64, 65, 72, 73, 200 };
+
+#define N_COUNTS (sizeof(counts) / sizeof(counts[0]))
+
+static void fill ( UChar* p, int seed )
+{
+   int i;
+   for (i = 0; i < BUF_SIZE; i++)
+      p[i] = (UChar)(i * 7 + seed * 13 + (i >> 5));
+}
+
+static unsigned int cksum ( const UChar* p )
+{
+   unsigned int i, h = 0;
+   for (i = 0; i < BUF_SIZE; i++)
+      h = (h * 31) ^ p[i];
+   return h;
+}
+
+/* Run insn with RSI/RDI/RCX/RAX set up, and the direction flag as
+   given.  Results come back in the same registers, plus the flags. */
+#define GEN_REP(fn, insn)                                              \
+   static void fn ( int dirn, ULong* rsi, ULong* rdi, ULong* rcx,      \
+                    ULong* rax, ULong* rflags )                        \
+   {                                                                   \
+      ULong si = *rsi, di = *rdi, cx = *rcx, ax = *rax, fl;            \
+      if (dirn)                                                        \
+         __asm__ __volatile__("std");                                  \
+      __asm__ __volatile__(                                            \
+         insn "\n\t"                                                   \
+         "pushfq\n\t"                                                  \
+         "popq %4\n\t"                                                 \
+         "cld"                                                         \
+         : "+S"(si), "+D"(di), "+c"(cx), "+a"(ax), "=r"(fl)            \
+         : : "memory", "cc");                                          \
+      *rsi = si; *rdi = di; *rcx = cx; *rax = ax; *rflags = fl;        \
+   }
+
+GEN_REP(rep_movsb, "rep movsb")
+GEN_REP(rep_movsw, "rep movsw")
+GEN_REP(rep_movsl, "rep movsl")
+GEN_REP(rep_movsq, "rep movsq")
+GEN_REP(rep_stosb, "rep stosb")
+GEN_REP(rep_stosw, "rep stosw")
+GEN_REP(rep_stosl, "rep stosl")
+GEN_REP(rep_stosq, "rep stosq")
+GEN_REP(repe_cmpsb, "repe cmpsb")
+GEN_REP(repe_cmpsw, "repe cmpsw")
+GEN_REP(repe_cmpsl, "repe cmpsl")
+GEN_REP(repe_cmpsq, "repe cmpsq")
+GEN_REP(repne_scasb, "repne scasb")
+GEN_REP(repne_scasw, "repne scasw")
+GEN_REP(repne_scasl, "repne scasl")
+GEN_REP(repne_scasq, "repne scasq")
+
+typedef  void (*RepFn)(int, ULong*, ULong*, ULong*, ULong*, ULong*);
+
+static const struct { const char* name; RepFn fn; int sz; } tests[] = {
+   { "rep movsb",   rep_movsb,   1 }, { "rep movsw",   rep_movsw,   2 },
+   { "rep movsl",   rep_movsl,   4 }, { "rep movsq",   rep_movsq,   8 },
+   { "rep stosb",   rep_stosb,   1 }, { "rep stosw",   rep_stosw,   2 },
+   { "rep stosl",   rep_stosl,   4 }, { "rep stosq",   rep_stosq,   8 },
+   { "repe cmpsb",  repe_cmpsb,  1 }, { "repe cmpsw",  repe_cmpsw,  2 },
+   { "repe cmpsl",  repe_cmpsl,  4 }, { "repe cmpsq",  repe_cmpsq,  8 },
+   { "repne scasb", repne_scasb, 1 }, { "repne scasw", repne_scasw, 2 },
+   { "repne scasl", repne_scasl, 4 }, { "repne scasq", repne_scasq, 8 }
+};
+
+#define N_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+/* Source and destination offsets into buf1, chosen to give
+   non-overlapping and overlapping copies in both directions. */
+static const struct { int src; int dst; } copy_offs[] = {
+   { 512, 8 }, { 100, 101 }, { 100, 103 }, { 100, 140 }, { 100, 95 },
+   { 300, 300 }, { 101, 333 }
+};
+
+#define N_COPY_OFFS (sizeof(copy_offs) / sizeof(copy_offs[0]))
+
+/* The flags are only shown for CMPS and SCAS, since the others leave
+   them alone. */
+static void show ( const char* name, int dirn, ULong count, int o1, int o2,
+                   ULong rsi, ULong rdi, ULong rcx, ULong rflags,
+                   int showFlags )
+{
+   printf("%-11s %c cnt=%3llu %4d %4d: rsi%+6lld rdi%+6lld rcx=%3llu ",
+          name, dirn ? 'b' : 'f', count, o1, o2,
+          (long long)(rsi - (ULong)&buf1[o1]),
+          (long long)(rdi - (ULong)&buf1[o2]), rcx);
+   if (showFlags)
+      printf("zc=%d%d ", (int)(rflags >> 6) & 1, (int)rflags & 1);
+   else
+      printf("zc=-- ");
+   printf("buf1=%08x\n", cksum(buf1));
+}
+
+int main ( void )
+{
+   unsigned int t, c, o;
+   int dirn;
+
+   for (t = 0; t < N_TESTS; t++) {
+      int sz = tests[t].sz;
+      for (dirn = 0; dirn < 2; dirn++) {
+         for (c = 0; c < N_COUNTS; c++) {
+            for (o = 0; o < N_COPY_OFFS; o++) {
+               /* When going backwards, start at the top end of the
+                  ranges so that the same bytes are covered. */
+               int  adj = dirn ? ((int)counts[c] - 1) * sz : 0;
+               int  so  = copy_offs[o].src + (adj > 0 ? adj : 0);
+               int  dof = copy_offs[o].dst + (adj > 0 ? adj : 0);
+               ULong rsi = (ULong)&buf1[so];
+               ULong rdi = (ULong)&buf1[dof];
+               ULong rcx = counts[c];
+               ULong rax = 0x8877665544332211ULL + o;
+               ULong rflags;
+               fill(buf1, o);
+               if (t >= 8 && t < 12) {
+                  /* CMPS: make the two ranges equal up to a point
+                     that depends on o, then different. */
+                  int k;
+                  for (k = 0; k < (int)(counts[c] * sz); k++) {
+                     int dk = dirn ? -k : k;
+                     if (so + dk < 0 || dof + dk < 0
+                         || so + dk >= BUF_SIZE || dof + dk >= BUF_SIZE)
+                        break;
+                     if (k == (int)(o * 17 + sz))
+                        break;
+                     buf1[dof + dk] = buf1[so + dk];
+                  }
+               }
+               if (t >= 12) {
+                  /* SCAS: plant the value being looked for at a
+                     point that depends on o. */
+                  int k = (int)(o * 23) * (dirn ? -1 : 1);
+                  memcpy(&buf1[dof + k], &rax, sz);
+               }
+               tests[t].fn(dirn, &rsi, &rdi, &rcx, &rax, &rflags);
+               show(tests[t].name, dirn, counts[c], so, dof,
+                    rsi, rdi, rcx, rflags, t >= 8);
+            }
+         }
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,131 @@
+/* Tests for the vector test-bits compares (CMTST) and the lane widening
+   instructions (SXTL/UXTL and their "2" forms), with fixed inputs so that
+   the results are easy to check by hand.  The same-register forms of
+   CMTST are included since they are what "compare not equal to zero"
+   becomes. */
+
+#include <stdio.h>
+
+typedef  unsigned long long int  ULong;
+
+typedef  struct { ULong lo; ULong hi; }  V128;
+
+static const V128 inputs[4] = {
+   { 0x0123456789abcdefULL, 0xfedcba9876543210ULL },
+   { 0x00ff00ff80000001ULL, 0x8000000000000000ULL },
+   { 0x0000000000000000ULL, 0xffffffffffffffffULL },
+   { 0x7f80017fff000100ULL, 0x0000800100007fffULL }
+};
+
+static void show ( const char* name, int i, int j, V128* res )
+{
+   if (j >= 0)
+      printf("%-28s [%d,%d]  %016llx %016llx\n", name, i, j, res->hi, res->lo);
+   else
+      printf("%-28s [%d]    %016llx %016llx\n", name, i, res->hi, res->lo);
+}
+
+/* Binary: v20 = insn(v18, v19) */
+#define GEN_BINARY(fn, insn)                                     \
+   __attribute__((noinline))                                     \
+   static void fn ( V128* res, const V128* a, const V128* b )    \
+   {                                                             \
+      __asm__ __volatile__(                                      \
+         "ldr q18, [%1]; ldr q19, [%2]; "                        \
+         "movi v20.16b, #0x55; "                                 \
+         insn "; str q20, [%0]"                                  \
+         : : "r"(res), "r"(a), "r"(b)                            \
+         : "memory", "v18", "v19", "v20");                       \
+   }
+
+/* Unary: v20 = insn(v18) */
+#define GEN_UNARY(fn, insn)                                      \
+   __attribute__((noinline))                                     \
+   static void fn ( V128* res, const V128* a )                   \
+   {                                                             \
+      __asm__ __volatile__(                                      \
+         "ldr q18, [%1]; "                                       \
+         "movi v20.16b, #0x55; "                                 \
+         insn "; str q20, [%0]"                                  \
+         : : "r"(res), "r"(a)                                    \
+         : "memory", "v18", "v20");                              \
+   }
+
+GEN_BINARY(cmtst_16b,  "cmtst v20.16b, v18.16b, v19.16b")
+GEN_BINARY(cmtst_8h,   "cmtst v20.8h, v18.8h, v19.8h")
+GEN_BINARY(cmtst_4s,   "cmtst v20.4s, v18.4s, v19.4s")
+GEN_BINARY(cmtst_2d,   "cmtst v20.2d, v18.2d, v19.2d")
+GEN_BINARY(cmtst_8b,   "cmtst v20.8b, v18.8b, v19.8b")
+GEN_BINARY(cmtst_d,    "cmtst d20, d18, d19")
+
+GEN_UNARY(cmtst_16b_same, "cmtst v20.16b, v18.16b, v18.16b")
+GEN_UNARY(cmtst_8h_same,  "cmtst v20.8h, v18.8h, v18.8h")
+GEN_UNARY(cmtst_4s_same,  "cmtst v20.4s, v18.4s, v18.4s")
+GEN_UNARY(cmtst_2d_same,  "cmtst v20.2d, v18.2d, v18.2d")
+
+GEN_UNARY(sxtl_8h,   "sxtl v20.8h, v18.8b")
+GEN_UNARY(sxtl_4s,   "sxtl v20.4s, v18.4h")
+GEN_UNARY(sxtl_2d,   "sxtl v20.2d, v18.2s")
+GEN_UNARY(uxtl_8h,   "uxtl v20.8h, v18.8b")
+GEN_UNARY(uxtl_4s,   "uxtl v20.4s, v18.4h")
+GEN_UNARY(uxtl_2d,   "uxtl v20.2d, v18.2s")
+GEN_UNARY(sxtl2_8h,  "sxtl2 v20.8h, v18.16b")
+GEN_UNARY(sxtl2_4s,  "sxtl2 v20.4s, v18.8h")
+GEN_UNARY(sxtl2_2d,  "sxtl2 v20.2d, v18.4s")
+GEN_UNARY(uxtl2_8h,  "uxtl2 v20.8h, v18.16b")
+GEN_UNARY(uxtl2_4s,  "uxtl2 v20.4s, v18.8h")
+GEN_UNARY(uxtl2_2d,  "uxtl2 v20.2d, v18.4s")
+
+typedef  void (*BinFn)(V128*, const V128*, const V128*);
+typedef  void (*UnFn)(V128*, const V128*);
+
+static const struct { const char* name; BinFn fn; } bin_tests[] = {
+   { "cmtst v.16b, v.16b, v.16b", cmtst_16b },
+   { "cmtst v.8h, v.8h, v.8h",    cmtst_8h },
+   { "cmtst v.4s, v.4s, v.4s",    cmtst_4s },
+   { "cmtst v.2d, v.2d, v.2d",    cmtst_2d },
+   { "cmtst v.8b, v.8b, v.8b",    cmtst_8b },
+   { "cmtst d, d, d",             cmtst_d }
+};
+
+static const struct { const char* name; UnFn fn; } un_tests[] = {
+   { "cmtst v.16b, vX.16b, vX.16b", cmtst_16b_same },
+   { "cmtst v.8h, vX.8h, vX.8h",    cmtst_8h_same },
+   { "cmtst v.4s, vX.4s, vX.4s",    cmtst_4s_same },
+   { "cmtst v.2d, vX.2d, vX.2d",    cmtst_2d_same },
+   { "sxtl v.8h, v.8b",             sxtl_8h },
+   { "sxtl v.4s, v.4h",             sxtl_4s },
+   { "sxtl v.2d, v.2s",             sxtl_2d },
+   { "uxtl v.8h, v.8b",             uxtl_8h },
+   { "uxtl v.4s, v.4h",             uxtl_4s },
+   { "uxtl v.2d, v.2s",             uxtl_2d },
+   { "sxtl2 v.8h, v.16b",           sxtl2_8h },
+   { "sxtl2 v.4s, v.8h",            sxtl2_4s },
+   { "sxtl2 v.2d, v.4s",            sxtl2_2d },
+   { "uxtl2 v.8h, v.16b",           uxtl2_8h },
+   { "uxtl2 v.4s, v.8h",            uxtl2_4s },
+   { "uxtl2 v.2d, v.4s",            uxtl2_2d }
+};
+
+#define N_ELEMS(_arr) (sizeof(_arr) / sizeof((_arr)[0]))
+
+int main ( void )
+{
+   unsigned int t, i, j;
+   V128 res;
+
+   for (t = 0; t < N_ELEMS(bin_tests); t++)
+      for (i = 0; i < N_ELEMS(inputs); i++)
+         for (j = 0; j < N_ELEMS(inputs); j++) {
+            bin_tests[t].fn(&res, &inputs[i], &inputs[j]);
+            show(bin_tests[t].name, i, j, &res);
+         }
+
+   for (t = 0; t < N_ELEMS(un_tests); t++)
+      for (i = 0; i < N_ELEMS(inputs); i++) {
+         un_tests[t].fn(&res, &inputs[i]);
+         show(un_tests[t].name, i, -1, &res);
+      }
+
+   return 0;
+}
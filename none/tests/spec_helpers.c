@@ -0,0 +1,314 @@
+/* Checks the specialisations of the amd64 and arm64 condition code
+   helpers against the helpers themselves.  For every helper, thunk
+   operation and condition, the helper call is handed to the guest's
+   spechelper with the thunk fields as IR temporaries, the IR that comes
+   back is evaluated for a set of thunk values, and the result is
+   compared with what the helper computes from the same values. */
+
+#include "libvex_basictypes.h"
+#include "libvex_ir.h"
+#include "libvex.h"
+#include "main_util.h"          // vexSetAllocModeTEMP_and_clear
+#include "guest_amd64_defs.h"
+#include "guest_arm64_defs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N_TEMPS 3
+
+typedef  struct { ULong hi, lo; }  Val;
+
+/* Values of the IR temporaries standing for the thunk fields. */
+static ULong temp_val[N_TEMPS];
+
+static Bool eval_failed;
+
+static __attribute__((noreturn)) void failure_exit ( void )
+{
+   fprintf(stderr, "VEX failure\n");
+   exit(1);
+}
+
+static void log_bytes ( const HChar* bytes, SizeT nbytes )
+{
+   fwrite(bytes, 1, nbytes, stdout);
+}
+
+static Val mk ( ULong lo )
+{
+   Val v = { 0, lo };
+   return v;
+}
+
+static Val eval ( const IRExpr* e )
+{
+   Val a, b;
+   switch (e->tag) {
+      case Iex_Const:
+         switch (e->Iex.Const.con->tag) {
+            case Ico_U1:  return mk(e->Iex.Const.con->Ico.U1);
+            case Ico_U8:  return mk(e->Iex.Const.con->Ico.U8);
+            case Ico_U16: return mk(e->Iex.Const.con->Ico.U16);
+            case Ico_U32: return mk(e->Iex.Const.con->Ico.U32);
+            case Ico_U64: return mk(e->Iex.Const.con->Ico.U64);
+            default:      break;
+         }
+         break;
+      case Iex_RdTmp:
+         if (e->Iex.RdTmp.tmp < N_TEMPS)
+            return mk(temp_val[e->Iex.RdTmp.tmp]);
+         break;
+      case Iex_ITE:
+         return eval(e->Iex.ITE.cond).lo ? eval(e->Iex.ITE.iftrue)
+                                         : eval(e->Iex.ITE.iffalse);
+      case Iex_Unop:
+         a = eval(e->Iex.Unop.arg);
+         switch (e->Iex.Unop.op) {
+            case Iop_1Uto32:  case Iop_1Uto64:
+               return mk(a.lo & 1);
+            case Iop_8Uto32:  case Iop_64to8:
+               return mk((UChar)a.lo);
+            case Iop_16Uto32: case Iop_64to16:
+               return mk((UShort)a.lo);
+            case Iop_64to32:
+               return mk((UInt)a.lo);
+            case Iop_Not64:
+               return mk(~a.lo);
+            case Iop_128HIto64:
+               return mk(a.hi);
+            default:
+               break;
+         }
+         break;
+      case Iex_Binop: {
+         IROp op = e->Iex.Binop.op;
+         a = eval(e->Iex.Binop.arg1);
+         b = eval(e->Iex.Binop.arg2);
+         switch (op) {
+            case Iop_Add64: return mk(a.lo + b.lo);
+            case Iop_Sub64: return mk(a.lo - b.lo);
+            case Iop_Sub32: return mk((UInt)(a.lo - b.lo));
+            case Iop_Mul64: return mk(a.lo * b.lo);
+            case Iop_And64: return mk(a.lo & b.lo);
+            case Iop_And32: return mk((UInt)(a.lo & b.lo));
+            case Iop_Or64:  return mk(a.lo | b.lo);
+            case Iop_Or32:  return mk((UInt)(a.lo | b.lo));
+            case Iop_Xor64: return mk(a.lo ^ b.lo);
+            case Iop_Xor32: return mk((UInt)(a.lo ^ b.lo));
+            case Iop_Shl64: return mk(a.lo << b.lo);
+            case Iop_Shr64: return mk(a.lo >> b.lo);
+            case Iop_Shr32: return mk((UInt)a.lo >> b.lo);
+            case Iop_Sar64: return mk((ULong)((Long)a.lo >> b.lo));
+            case Iop_MullU64: {
+               unsigned __int128 r = (unsigned __int128)a.lo * b.lo;
+               Val v = { (ULong)(r >> 64), (ULong)r };
+               return v;
+            }
+            case Iop_MullS64: {
+               __int128 r = (__int128)(Long)a.lo * (Long)b.lo;
+               Val v = { (ULong)(r >> 64), (ULong)r };
+               return v;
+            }
+            case Iop_CmpEQ8:    return mk((UChar)a.lo == (UChar)b.lo);
+            case Iop_CmpNE8:    return mk((UChar)a.lo != (UChar)b.lo);
+            case Iop_CmpEQ16:   return mk((UShort)a.lo == (UShort)b.lo);
+            case Iop_CmpNE16:   return mk((UShort)a.lo != (UShort)b.lo);
+            case Iop_CmpEQ32:   return mk((UInt)a.lo == (UInt)b.lo);
+            case Iop_CmpNE32:   return mk((UInt)a.lo != (UInt)b.lo);
+            case Iop_CmpLT32U:  return mk((UInt)a.lo < (UInt)b.lo);
+            case Iop_CmpLE32U:  return mk((UInt)a.lo <= (UInt)b.lo);
+            case Iop_CmpLT32S:  return mk((Int)a.lo < (Int)b.lo);
+            case Iop_CmpLE32S:  return mk((Int)a.lo <= (Int)b.lo);
+            case Iop_CmpEQ64:   return mk(a.lo == b.lo);
+            case Iop_CmpNE64:   return mk(a.lo != b.lo);
+            case Iop_CmpLT64U:  return mk(a.lo < b.lo);
+            case Iop_CmpLE64U:  return mk(a.lo <= b.lo);
+            case Iop_CmpLT64S:  return mk((Long)a.lo < (Long)b.lo);
+            case Iop_CmpLE64S:  return mk((Long)a.lo <= (Long)b.lo);
+            default:
+               break;
+         }
+         break;
+      }
+      default:
+         break;
+   }
+   if (!eval_failed) {
+      printf("can't evaluate: ");
+      ppIRExpr((IRExpr*)e);
+      printf("\n");
+   }
+   eval_failed = True;
+   return mk(0);
+}
+
+/* Thunk values: 0 and 1, which must come first, the sign bits of each
+   size and their neighbours, all ones, and a few others. */
+static const ULong values[] = {
+   0x0ULL, 0x1ULL, 0x7FULL, 0x80ULL, 0xFFULL, 0x7FFFULL, 0x8000ULL,
+   0xFFFFULL, 0x7FFFFFFFULL, 0x80000000ULL, 0xFFFFFFFFULL,
+   0x7FFFFFFFFFFFFFFFULL, 0x8000000000000000ULL, 0xFFFFFFFFFFFFFFFFULL,
+   0x1F, 0x20, 0x3F, 0x40, 0x8D5ULL, 0x12345678ULL, 0xF0000000ULL,
+   0x0123456789ABCDEFULL, 0xFEDCBA9876543210ULL
+};
+#define N_VALUES (sizeof(values) / sizeof(values[0]))
+
+/* Which thunk operations have the old carry flag as the last field. */
+static Bool amd64_carry_in ( ULong op )
+{
+   return (op >= AMD64G_CC_OP_ADCB && op <= AMD64G_CC_OP_SBBQ)
+          || (op >= AMD64G_CC_OP_INCB && op <= AMD64G_CC_OP_DECQ);
+}
+
+static Bool arm64_carry_in ( ULong op )
+{
+   return op >= ARM64G_CC_OP_ADC32 && op <= ARM64G_CC_OP_SBC64;
+}
+
+/* How many calls were specialised, and how many results differed. */
+static UInt n_calls, n_specialised, n_wrong;
+
+typedef  ULong (*Helper) ( ULong, ULong, ULong, ULong, ULong );
+
+/* Check one call.  FIXED are the leading arguments, which the guest
+   code always passes as constants; the thunk fields follow, as
+   temporaries.  If CARRY_IN, the last thunk field is a carry flag, and
+   only 0 and 1 are valid values for it. */
+static void check ( const HChar* name, Helper helper,
+                    IRExpr* (*spechelper)(const HChar*, IRExpr**,
+                                          IRStmt**, Int),
+                    const ULong* fixed, Int n_fixed, Bool carry_in )
+{
+   IRExpr* args[6];
+   IRExpr* spec;
+   Int i, j, k, l;
+   Int n_last = carry_in ? 2 : N_VALUES;
+
+   vexSetAllocModeTEMP_and_clear();
+   for (i = 0; i < n_fixed; i++)
+      args[i] = IRExpr_Const(IRConst_U64(fixed[i]));
+   for (i = 0; i < N_TEMPS; i++)
+      args[n_fixed + i] = IRExpr_RdTmp(i);
+   args[n_fixed + N_TEMPS] = NULL;
+
+   n_calls++;
+   spec = spechelper(name, args, NULL, 0);
+   if (spec == NULL)
+      return;
+   n_specialised++;
+
+   for (j = 0; j < N_VALUES; j++) {
+      for (k = 0; k < N_VALUES; k++) {
+         for (l = 0; l < n_last; l++) {
+            ULong expected, got;
+            temp_val[0] = values[j];
+            temp_val[1] = values[k];
+            temp_val[2] = values[l];
+            eval_failed = False;
+            got = eval(spec).lo;
+            if (eval_failed) {
+               n_wrong++;
+               return;
+            }
+            expected = n_fixed == 2
+               ? helper(fixed[0], fixed[1], values[j], values[k], values[l])
+               : helper(fixed[0], values[j], values[k], values[l], 0);
+            if (got != expected) {
+               printf("%s(", name);
+               for (i = 0; i < n_fixed; i++)
+                  printf("%llu, ", fixed[i]);
+               printf("0x%llx, 0x%llx, 0x%llx): helper 0x%llx,"
+                      " specialised 0x%llx\n",
+                      values[j], values[k], values[l], expected, got);
+               n_wrong++;
+               return;
+            }
+         }
+      }
+   }
+}
+
+static void report ( const HChar* name )
+{
+   printf("%-28s %4u calls, %4u specialised, %u wrong\n",
+          name, n_calls, n_specialised, n_wrong);
+   n_calls = n_specialised = n_wrong = 0;
+}
+
+/* The helpers take their arguments in different orders; these put
+   them into the order check() uses. */
+static ULong amd64_cond ( ULong cond, ULong op,
+                          ULong dep1, ULong dep2, ULong ndep )
+{
+   return amd64g_calculate_condition(cond, op, dep1, dep2, ndep);
+}
+
+static ULong amd64_c ( ULong op, ULong dep1, ULong dep2, ULong ndep,
+                       ULong unused )
+{
+   return amd64g_calculate_rflags_c(op, dep1, dep2, ndep);
+}
+
+static ULong arm64_cond ( ULong cond_n_op, ULong dep1, ULong dep2,
+                          ULong dep3, ULong unused )
+{
+   return arm64g_calculate_condition(cond_n_op, dep1, dep2, dep3);
+}
+
+static ULong arm64_c ( ULong op, ULong dep1, ULong dep2, ULong dep3,
+                       ULong unused )
+{
+   return arm64g_calculate_flag_c(op, dep1, dep2, dep3);
+}
+
+static ULong arm64_nzcv ( ULong op, ULong dep1, ULong dep2, ULong dep3,
+                          ULong unused )
+{
+   return arm64g_calculate_flags_nzcv(op, dep1, dep2, dep3);
+}
+
+int main ( void )
+{
+   VexControl vcon;
+   ULong cond, op, fixed[2];
+
+   LibVEX_default_VexControl(&vcon);
+   LibVEX_Init(failure_exit, log_bytes, 0, &vcon);
+
+   for (cond = AMD64CondO; cond <= AMD64CondNLE; cond++) {
+      for (op = AMD64G_CC_OP_COPY; op < AMD64G_CC_OP_NUMBER; op++) {
+         fixed[0] = cond;
+         fixed[1] = op;
+         check("amd64g_calculate_condition", amd64_cond,
+               guest_amd64_spechelper, fixed, 2, amd64_carry_in(op));
+      }
+   }
+   report("amd64g_calculate_condition");
+
+   for (op = AMD64G_CC_OP_COPY; op < AMD64G_CC_OP_NUMBER; op++)
+      check("amd64g_calculate_rflags_c", amd64_c,
+            guest_amd64_spechelper, &op, 1, amd64_carry_in(op));
+   report("amd64g_calculate_rflags_c");
+
+   for (cond = ARM64CondEQ; cond <= ARM64CondNV; cond++) {
+      for (op = ARM64G_CC_OP_COPY; op < ARM64G_CC_OP_NUMBER; op++) {
+         fixed[0] = (cond << 4) | op;
+         check("arm64g_calculate_condition", arm64_cond,
+               guest_arm64_spechelper, fixed, 1, arm64_carry_in(op));
+      }
+   }
+   report("arm64g_calculate_condition");
+
+   for (op = ARM64G_CC_OP_COPY; op < ARM64G_CC_OP_NUMBER; op++)
+      check("arm64g_calculate_flag_c", arm64_c,
+            guest_arm64_spechelper, &op, 1, arm64_carry_in(op));
+   report("arm64g_calculate_flag_c");
+
+   for (op = ARM64G_CC_OP_COPY; op < ARM64G_CC_OP_NUMBER; op++)
+      check("arm64g_calculate_flags_nzcv", arm64_nzcv,
+            guest_arm64_spechelper, &op, 1, arm64_carry_in(op));
+   report("arm64g_calculate_flags_nzcv");
+
+   return 0;
+}
@@ -0,0 +1,12 @@
+// Check the output of the v.info transtab monitor command when the
+// size of the translation cache is adjusted with --transtab-max-mb.
+
+#include <stdio.h>
+#include "valgrind.h"
+
+int main(void)
+{
+   fprintf(stderr, "v.info transtab:\n");
+   (void) VALGRIND_MONITOR_COMMAND("v.info transtab");
+   return 0;
+}
@@ -0,0 +1,108 @@
+// This artificial program mimics the code churn of a JIT compiler.  It
+// keeps a lot of small "compiled" functions in an executable buffer,
+// and keeps regenerating some of them, telling Valgrind about it with
+// VALGRIND_DISCARD_TRANSLATIONS, like JITs do.  Every now and then, it
+// also throws away a whole "code page" at once, as a JIT does when it
+// frees a code cache region.
+//
+// It's a stress test for the discarding of translations: with many
+// translations live, each discard has to find the few translations it
+// hits, whatever the size of the discarded range.
+//
+// The functions are only really generated and run on x86 and amd64.
+// Elsewhere, only the discards are done.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "tests/sys_mman.h"
+#include "../include/valgrind.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#define RUN_CODE  1
+#else
+#define RUN_CODE  0
+#endif
+
+#define SLOT_SIZE   32        // Bytes of code per function
+#define N_SLOTS     8192      // Number of functions in the buffer
+#define PAGE_SLOTS  1024      // Functions per code page
+#define N_ROUNDS    40000
+#define N_CALLS     16        // Functions called per round
+#define PAGE_EVERY  50        // Rounds between two code page discards
+
+static unsigned char* buf;
+static int vals[N_SLOTS];
+
+static unsigned int seed = 12345;
+
+static unsigned int next_rand(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return (seed >> 16) & 0x7fff;
+}
+
+// "Compile" function number slot, returning v:  mov $v, %eax ; ret
+static void gen(int slot, int v)
+{
+   unsigned char* p = &buf[SLOT_SIZE * slot];
+   vals[slot] = v;
+   p[0] = 0xB8;
+   memcpy(&p[1], &v, sizeof(v));
+   p[5] = 0xC3;
+}
+
+static void regen(int slot, int n_slots, int v)
+{
+   int i;
+   for (i = 0; i < n_slots; i++)
+      gen(slot + i, v + i);
+   VALGRIND_DISCARD_TRANSLATIONS(&buf[SLOT_SIZE * slot], SLOT_SIZE * n_slots);
+}
+
+static int call(int slot)
+{
+#if RUN_CODE
+   int (*fn)(void) = (void*)&buf[SLOT_SIZE * slot];
+   return fn();
+#else
+   return vals[slot];
+#endif
+}
+
+int main(void)
+{
+   int i, j, slot;
+   long long sum = 0, expected = 0;
+
+   buf = mmap(0, SLOT_SIZE * N_SLOTS,
+              PROT_EXEC|PROT_WRITE|PROT_READ,
+              MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+   assert(buf != (unsigned char*)MAP_FAILED);
+
+   // Warm up: compile and run everything once.
+   regen(0, N_SLOTS, 0);
+   for (i = 0; i < N_SLOTS; i++) {
+      sum      += call(i);
+      expected += vals[i];
+   }
+
+   for (i = 0; i < N_ROUNDS; i++) {
+      if (i % PAGE_EVERY == 0) {
+         slot = (next_rand() % (N_SLOTS / PAGE_SLOTS)) * PAGE_SLOTS;
+         regen(slot, PAGE_SLOTS, i);
+      } else {
+         regen(next_rand() % N_SLOTS, 1, i);
+      }
+      for (j = 0; j < N_CALLS; j++) {
+         slot = next_rand() % N_SLOTS;
+         sum      += call(slot);
+         expected += vals[slot];
+      }
+   }
+
+   assert(sum == expected);
+   printf("sum = %lld\n", sum);
+   return 0;
+}
@@ -0,0 +1,79 @@
+// This artificial program mimics a data parallel computation on large
+// shared arrays of records.  A few threads each fill their own stripe of
+// an array, wait on a barrier, copy the stripe of a neighbour thread into
+// a second array, wait again and then reduce their own stripe of that
+// array.
+//
+// It's a stress test for the access bitmaps of DRD: every phase touches
+// megabytes of memory, records are copied with accesses that are wider
+// than a machine word, and the conflict set of each thread covers the
+// stripes of all the other threads.
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_THREADS   4
+#define N_RECORDS   (1 << 16)     // Records per array
+#define N_ROUNDS    20
+
+struct record {
+   double v[6];
+};
+
+static struct record* a;
+static struct record* b;
+static double sums[N_THREADS];
+static pthread_barrier_t barrier;
+
+static void* worker(void* arg)
+{
+   const int t = (int)(long)arg;
+   const int len = N_RECORDS / N_THREADS;
+   struct record* const mine = a + t * len;
+   const struct record* const next = a + ((t + 1) % N_THREADS) * len;
+   struct record r;
+   int round, i, j;
+
+   for (round = 0; round < N_ROUNDS; round++) {
+      for (j = 0; j < 6; j++)
+         r.v[j] = round + t + j;
+      for (i = 0; i < len; i++)
+         memcpy(&mine[i], &r, sizeof(r));
+      pthread_barrier_wait(&barrier);
+      for (i = 0; i < len; i++)
+         b[t * len + i] = next[i];
+      pthread_barrier_wait(&barrier);
+      for (i = 0; i < len; i++)
+         sums[t] += b[t * len + i].v[i % 6];
+      pthread_barrier_wait(&barrier);
+   }
+   return NULL;
+}
+
+int main(void)
+{
+   pthread_t tid[N_THREADS];
+   double total = 0;
+   int t;
+
+   a = malloc(N_RECORDS * sizeof(*a));
+   b = malloc(N_RECORDS * sizeof(*b));
+   assert(a && b);
+   pthread_barrier_init(&barrier, NULL, N_THREADS);
+
+   for (t = 0; t < N_THREADS; t++)
+      pthread_create(&tid[t], NULL, worker, (void*)(long)t);
+   for (t = 0; t < N_THREADS; t++) {
+      pthread_join(tid[t], NULL);
+      total += sums[t];
+   }
+
+   pthread_barrier_destroy(&barrier);
+   free(a);
+   free(b);
+   printf("total: %.0f\n", total);
+   return 0;
+}
@@ -0,0 +1,116 @@
+// This artificial program runs some typical vectorised loops -- integer
+// arithmetic, saturating byte arithmetic, compares and masking, shifts,
+// and single precision multiply-adds -- using 256-bit AVX2 instructions.
+//
+// It's a stress test for the code generated for 256-bit vector
+// operations.  Almost all the time is spent in a handful of hot blocks,
+// so translation cost doesn't matter.
+//
+// The AVX2 loops are only used on amd64 CPUs that have AVX2.  Elsewhere,
+// plain C versions of the same loops are run instead, which makes the
+// results meaningless but keeps the program runnable everywhere.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__) \
+    && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HAVE_AVX2_CODE 1
+#include <immintrin.h>
+#else
+#define HAVE_AVX2_CODE 0
+#endif
+
+#define N        4096          // Elements per array
+#define N_ROUNDS 100000
+
+static int            ia[N] __attribute__((aligned(32)));
+static int            ib[N] __attribute__((aligned(32)));
+static unsigned char  ba[N] __attribute__((aligned(32)));
+static unsigned char  bb[N] __attribute__((aligned(32)));
+static float          fa[N] __attribute__((aligned(32)));
+static float          fb[N] __attribute__((aligned(32)));
+
+static void round_c(void)
+{
+   int i;
+   for (i = 0; i < N; i++) {
+      int x = ia[i] * 3 + ib[i];
+      if (x < -100000) x = -100000;
+      if (x > 100000) x = 100000;
+      ia[i] = x ^ (ib[i] >> 2);
+   }
+   for (i = 0; i < N; i++) {
+      unsigned s = ba[i] + bb[i];
+      s = s > 255 ? 255 : s;
+      ba[i] = (s == bb[i]) ? 0 : (s & 0x7F);
+   }
+   for (i = 0; i < N; i++)
+      fa[i] = fa[i] * 0.5f + fb[i];
+}
+
+#if HAVE_AVX2_CODE
+__attribute__((target("avx2")))
+static void round_avx2(void)
+{
+   int i;
+   const __m256i three = _mm256_set1_epi32(3);
+   const __m256i lo    = _mm256_set1_epi32(-100000);
+   const __m256i hi    = _mm256_set1_epi32(100000);
+   const __m256i m7f   = _mm256_set1_epi8(0x7F);
+   const __m256  half  = _mm256_set1_ps(0.5f);
+
+   for (i = 0; i < N; i += 8) {
+      __m256i a = _mm256_load_si256((const __m256i*)&ia[i]);
+      __m256i b = _mm256_load_si256((const __m256i*)&ib[i]);
+      __m256i x = _mm256_add_epi32(_mm256_mullo_epi32(a, three), b);
+      x = _mm256_min_epi32(_mm256_max_epi32(x, lo), hi);
+      x = _mm256_xor_si256(x, _mm256_srai_epi32(b, 2));
+      _mm256_store_si256((__m256i*)&ia[i], x);
+   }
+   for (i = 0; i < N; i += 32) {
+      __m256i a  = _mm256_load_si256((const __m256i*)&ba[i]);
+      __m256i b  = _mm256_load_si256((const __m256i*)&bb[i]);
+      __m256i s  = _mm256_adds_epu8(a, b);
+      __m256i eq = _mm256_cmpeq_epi8(s, b);
+      s = _mm256_andnot_si256(eq, _mm256_and_si256(s, m7f));
+      _mm256_store_si256((__m256i*)&ba[i], s);
+   }
+   for (i = 0; i < N; i += 8) {
+      __m256 a = _mm256_load_ps(&fa[i]);
+      __m256 b = _mm256_load_ps(&fb[i]);
+      _mm256_store_ps(&fa[i], _mm256_add_ps(_mm256_mul_ps(a, half), b));
+   }
+}
+#endif
+
+int main(void)
+{
+   int i, r;
+   unsigned int sum = 0;
+   void (*round)(void) = round_c;
+
+#if HAVE_AVX2_CODE
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      round = round_avx2;
+#endif
+
+   for (i = 0; i < N; i++) {
+      ia[i] = i * 7 - N;
+      ib[i] = (i * 13) % 1000 - 500;
+      ba[i] = (unsigned char)(i * 5);
+      bb[i] = (unsigned char)(i * 11);
+      fa[i] = (float)i;
+      fb[i] = (float)(i % 17);
+   }
+
+   for (r = 0; r < N_ROUNDS; r++)
+      round();
+
+   for (i = 0; i < N; i++)
+      sum += (unsigned int)ia[i] + ba[i] + (unsigned int)fa[i];
+   printf("%s: sum = %u\n", round == round_c ? "C" : "AVX2", sum);
+   return 0;
+}
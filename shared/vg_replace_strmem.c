@@ -35,6 +35,7 @@
 #include "pub_tool_redir.h"
 #include "pub_tool_tooliface.h"
 #include "pub_tool_clreq.h"
+#include "coregrind/pub_core_clreq.h"   // VG_USERREQ__BULK_*
 
 /* ---------------------------------------------------------------------
    We have our own versions of these functions for two reasons:
@@ -179,6 +180,25 @@ static inline void my_exit ( int x )
 #define VALGRIND_CHECK_VALUE_IS_DEFINED(__lvalue) 1
 #endif
 
+// Large memcpy/memmove/memset/strlen operations are handed to the core,
+// which asks the tool to update its shadow state for the whole range
+// in one go and then does the operation natively.  That is far cheaper
+// than doing it here, where every access is instrumented.  If the tool
+// declines (typically because it would report an error) the request
+// returns zero and the operation is done here as usual.  BULK_MIN_LEN
+// is roughly where the request starts to pay for itself.
+#define BULK_MIN_LEN 512
+
+#define BULK_COPY(dst, src, len)                                 \
+   VALGRIND_DO_CLIENT_REQUEST_EXPR(0, VG_USERREQ__BULK_COPY,     \
+                                   dst, src, len, 0, 0)
+#define BULK_FILL(dst, valp, len)                                \
+   VALGRIND_DO_CLIENT_REQUEST_EXPR(0, VG_USERREQ__BULK_FILL,     \
+                                   dst, valp, len, 0, 0)
+#define BULK_STRLEN(str)                                         \
+   VALGRIND_DO_CLIENT_REQUEST_EXPR(0, VG_USERREQ__BULK_STRLEN,   \
+                                   str, 0, 0, 0, 0)
+
 
 /*---------------------- strrchr ----------------------*/
 
@@ -453,7 +473,14 @@ static inline void my_exit ( int x )
       ( const char* str )  \
    { \
       SizeT i = 0; \
-      while (str[i] != 0) i++; \
+      while (str[i] != 0) { \
+         i++; \
+         if (UNLIKELY(i == BULK_MIN_LEN)) { \
+            SizeT n = BULK_STRLEN(str + i); \
+            if (n > 0) \
+               return i + n - 1; \
+         } \
+      } \
       return i; \
    }
 
@@ -948,6 +975,9 @@ static inline void my_exit ( int x )
       if (do_ol_check && is_overlap(dst, src, len, len)) \
          RECORD_OVERLAP_ERROR("memcpy", dst, src, len); \
       \
+      if (len >= BULK_MIN_LEN && BULK_COPY(dst, src, len)) \
+         return dst; \
+      \
       const Addr WS = sizeof(UWord); /* 8 or 4 */ \
       const Addr WM = WS - 1;        /* 7 or 3 */ \
       \
@@ -1210,6 +1240,13 @@ static inline void my_exit ( int x )
    void* VG_REPLACE_FUNCTION_EZZ(20210,soname,fnname) \
             (void *s, Int c, SizeT n) \
    { \
+      if (n >= BULK_MIN_LEN) { \
+         /* The core needs to see the fill byte in memory, so that \
+            the tool can tell whether it is defined. */ \
+         volatile UChar cb = (UChar)c; \
+         if (BULK_FILL(s, &cb, n)) \
+            return s; \
+      } \
       if (sizeof(void*) == 8) { \
          Addr  a  = (Addr)s;   \
          ULong c8 = (c & 0xFF); \